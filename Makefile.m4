@@ -12,18 +12,42 @@ LIBAVJS_VERSION=$(LIBAVJS_VERSION_BASE).$(FFMPEG_VERSION)$(LIBAVJS_VERSION_SUFFI
 LIBAVJS_VERSION_SHORT=$(LIBAVJS_VERSION_BASE).$(FFMPEG_VERSION_MAJOR)
 EMCC=emcc
 MINIFIER=node_modules/.bin/terser
+# Optimization profile: size (the default) or speed. Set LTO=1 to also use
+# link-time optimization. Profiles share their build directories, so clean
+# (make clean) when switching.
+PROFILE=size
+LTO=
+ifeq ($(PROFILE),speed)
+OPTFLAGS=-O3
+else
 OPTFLAGS=-Oz
+endif
 EMFTFLAGS=-Lbuild/inst/base/lib -lemfiberthreads
 THRFLAGS=-pthread $(EMFTFLAGS)
+# The SIMD target only gains from autovectorization, which -Oz disables, so it's
+# optimized for speed
+SIMDOPTFLAGS=-O3
+SIMDFLAGS=-msimd128 $(SIMDOPTFLAGS) -Lbuild/inst/simd/lib -lemfiberthreads
+ifeq ($(LTO),1)
+OPTFLAGS+=-flto
+SIMDOPTFLAGS+=-flto
+endif
 ES6FLAGS=-sEXPORT_ES6=1 -sUSE_ES6_IMPORT_META=1
+# Imports that suspend the WebAssembly code until a promise resolves. With
+# Asyncify, every function that may be on the stack when they suspend is
+# instrumented to unwind and rewind it. With JSPI (JavaScript Promise
+# Integration), the engine suspends the stack itself, so the code isn't
+# instrumented, but only the exports listed in JSPI_EXPORTS may suspend.
+SUSPENDING_IMPORTS=['libavjs_wait_reader', 'jsfetch_open_js', 'jsfetch_read_js', 'jsfetch_seek_js', 'jsfetch_block_open_js', 'jsfetch_block_read_js']
+ASYNCIFYFLAGS=-s ASYNCIFY -s "ASYNCIFY_IMPORTS=$(SUSPENDING_IMPORTS)"
+JSPIFLAGS=-s JSPI -s "JSPI_IMPORTS=$(SUSPENDING_IMPORTS)" \
+	-s "JSPI_EXPORTS=@build/jspi-exports-$(*).json"
 EFLAGS=\
 	`tools/memory-init-file-emcc.sh` \
 	--pre-js src/pre.js \
 	-s "EXPORT_NAME='LibAVFactory'" \
 	-s MODULARIZE=1 \
 	-s STACK_SIZE=1048576 \
-	-s ASYNCIFY \
-	-s "ASYNCIFY_IMPORTS=['libavjs_wait_reader', 'jsfetch_open_js', 'jsfetch_read_js', 'jsfetch_seek_js']" \
 	-s INITIAL_MEMORY=25165824 \
 	-s ALLOW_MEMORY_GROWTH=1 \
 	-s WASM_BIGINT=0
@@ -66,6 +90,14 @@ build-%: \
 	dist/libav-$(LIBAVJS_VERSION)-%.thr.mjs \
 	dist/libav-$(LIBAVJS_VERSION)-%.dbg.thr.js \
 	dist/libav-$(LIBAVJS_VERSION)-%.dbg.thr.mjs \
+	dist/libav-$(LIBAVJS_VERSION)-%.simd.js \
+	dist/libav-$(LIBAVJS_VERSION)-%.simd.mjs \
+	dist/libav-$(LIBAVJS_VERSION)-%.dbg.simd.js \
+	dist/libav-$(LIBAVJS_VERSION)-%.dbg.simd.mjs \
+	dist/libav-$(LIBAVJS_VERSION)-%.jspi.js \
+	dist/libav-$(LIBAVJS_VERSION)-%.jspi.mjs \
+	dist/libav-$(LIBAVJS_VERSION)-%.dbg.jspi.js \
+	dist/libav-$(LIBAVJS_VERSION)-%.dbg.jspi.mjs \
 	dist/libav.types.d.ts
 	true
 
@@ -94,7 +126,8 @@ dist/libav.types.d.ts: build/libav.types.d.ts
 # Use: buildrule(target file name, debug infix, target inst name, extra link flags, target file suffix)
 define([[[buildrule]]], [[[
 dist/libav-$(LIBAVJS_VERSION)-%.$2$1.$5: build/ffmpeg-$(FFMPEG_VERSION)/build-$3-%/libavformat/libavformat.a \
-	build/exports-%.json src/pre.js build/post-%.js build/extern-post.$5 \
+	build/exports-%.json build/jspi-exports-%.json src/pre.js build/post-%.js \
+	build/extern-post.$5 \
         src/bindings.c src/b-*.c
 	mkdir -p $(@).d
 	$(EMCC) $(OPTFLAGS) $(EFLAGS) \
@@ -135,20 +168,30 @@ dist/libav-$(LIBAVJS_VERSION)-%.$2$1.$5: build/ffmpeg-$(FFMPEG_VERSION)/build-$3
 ]]])
 
 # asm.js version
-buildrule(asm, [[[]]], base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) -s WASM=0]]], js)
-buildrule(asm, [[[]]], base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) $(ES6FLAGS) -s WASM=0]]], mjs)
-buildrule(asm, dbg., base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) -g2 -s WASM=0]]], js)
-buildrule(asm, dbg., base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) -g2 $(ES6FLAGS) -s WASM=0]]], mjs)
+buildrule(asm, [[[]]], base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) $(ASYNCIFYFLAGS) -s WASM=0]]], js)
+buildrule(asm, [[[]]], base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) $(ASYNCIFYFLAGS) $(ES6FLAGS) -s WASM=0]]], mjs)
+buildrule(asm, dbg., base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) $(ASYNCIFYFLAGS) -g2 -s WASM=0]]], js)
+buildrule(asm, dbg., base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) $(ASYNCIFYFLAGS) -g2 $(ES6FLAGS) -s WASM=0]]], mjs)
 # wasm version with no added features
-buildrule(wasm, [[[]]], base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS)]]], js)
-buildrule(wasm, [[[]]], base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) $(ES6FLAGS)]]], mjs)
-buildrule(wasm, dbg., base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) -gsource-map]]], js)
-buildrule(wasm, dbg., base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) -gsource-map $(ES6FLAGS)]]], mjs)
+buildrule(wasm, [[[]]], base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) $(ASYNCIFYFLAGS)]]], js)
+buildrule(wasm, [[[]]], base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) $(ASYNCIFYFLAGS) $(ES6FLAGS)]]], mjs)
+buildrule(wasm, dbg., base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) $(ASYNCIFYFLAGS) -gsource-map]]], js)
+buildrule(wasm, dbg., base, [[[$(EFLAGS_NTHR) $(EMFTFLAGS) $(ASYNCIFYFLAGS) -gsource-map $(ES6FLAGS)]]], mjs)
 # wasm + threads
-buildrule(thr, [[[]]], thr, [[[$(EFLAGS_THR) $(THRFLAGS) -sPTHREAD_POOL_SIZE=navigator.hardwareConcurrency]]], js)
-buildrule(thr, [[[]]], thr, [[[$(EFLAGS_THR) $(ES6FLAGS) $(THRFLAGS) -sPTHREAD_POOL_SIZE=navigator.hardwareConcurrency]]], mjs)
-buildrule(thr, dbg., thr, [[[$(EFLAGS_THR) -gsource-map $(THRFLAGS) -sPTHREAD_POOL_SIZE=navigator.hardwareConcurrency]]], js)
-buildrule(thr, dbg., thr, [[[$(EFLAGS_THR) -gsource-map $(ES6FLAGS) $(THRFLAGS) -sPTHREAD_POOL_SIZE=navigator.hardwareConcurrency]]], mjs)
+buildrule(thr, [[[]]], thr, [[[$(EFLAGS_THR) $(THRFLAGS) $(ASYNCIFYFLAGS) -sPTHREAD_POOL_SIZE=Module.pthreadPoolSize]]], js)
+buildrule(thr, [[[]]], thr, [[[$(EFLAGS_THR) $(ES6FLAGS) $(THRFLAGS) $(ASYNCIFYFLAGS) -sPTHREAD_POOL_SIZE=Module.pthreadPoolSize]]], mjs)
+buildrule(thr, dbg., thr, [[[$(EFLAGS_THR) -gsource-map $(THRFLAGS) $(ASYNCIFYFLAGS) -sPTHREAD_POOL_SIZE=Module.pthreadPoolSize]]], js)
+buildrule(thr, dbg., thr, [[[$(EFLAGS_THR) -gsource-map $(ES6FLAGS) $(THRFLAGS) $(ASYNCIFYFLAGS) -sPTHREAD_POOL_SIZE=Module.pthreadPoolSize]]], mjs)
+# wasm + SIMD
+buildrule(simd, [[[]]], simd, [[[$(EFLAGS_NTHR) $(SIMDFLAGS) $(ASYNCIFYFLAGS)]]], js)
+buildrule(simd, [[[]]], simd, [[[$(EFLAGS_NTHR) $(SIMDFLAGS) $(ASYNCIFYFLAGS) $(ES6FLAGS)]]], mjs)
+buildrule(simd, dbg., simd, [[[$(EFLAGS_NTHR) $(SIMDFLAGS) $(ASYNCIFYFLAGS) -gsource-map]]], js)
+buildrule(simd, dbg., simd, [[[$(EFLAGS_NTHR) $(SIMDFLAGS) $(ASYNCIFYFLAGS) -gsource-map $(ES6FLAGS)]]], mjs)
+# wasm + SIMD, suspending with JSPI instead of Asyncify
+buildrule(jspi, [[[]]], simd, [[[$(EFLAGS_NTHR) $(SIMDFLAGS) $(JSPIFLAGS)]]], js)
+buildrule(jspi, [[[]]], simd, [[[$(EFLAGS_NTHR) $(SIMDFLAGS) $(JSPIFLAGS) $(ES6FLAGS)]]], mjs)
+buildrule(jspi, dbg., simd, [[[$(EFLAGS_NTHR) $(SIMDFLAGS) $(JSPIFLAGS) -gsource-map]]], js)
+buildrule(jspi, dbg., simd, [[[$(EFLAGS_NTHR) $(SIMDFLAGS) $(JSPIFLAGS) -gsource-map $(ES6FLAGS)]]], mjs)
 
 # Built source files
 build/exports-%.json: configs/configs/%/components.txt funcs.json \
@@ -156,6 +199,11 @@ build/exports-%.json: configs/configs/%/components.txt funcs.json \
 	mkdir -p build
 	./tools/mk-exports.js $(*) > $@
 
+build/jspi-exports-%.json: configs/configs/%/components.txt funcs.json \
+	tools/mk-exports.js
+	mkdir -p build
+	./tools/mk-exports.js $(*) async > $@
+
 build/frontend-$(LIBAVJS_VERSION)-%.js: configs/configs/%/components.txt \
 	funcs.json src/frontend.in.js tools/mk-frontend.js
 	mkdir -p build
@@ -196,6 +244,10 @@ build/inst/thr/cflags.txt:
 	mkdir -p build/inst/thr
 	echo -pthread -gsource-map > $@
 
+build/inst/simd/cflags.txt:
+	mkdir -p build/inst/simd
+	echo -msimd128 $(SIMDOPTFLAGS) -gsource-map > $@
+
 RELEASE_VARIANTS=\
 	default default-cli opus opus-af flac flac-af wav wav-af obsolete webm \
 	webm-cli webm-vp9 webm-vp9-cli vp8-opus vp8-opus-avf vp9-opus \
@@ -314,9 +366,16 @@ distclean: clean
 print-version:
 	@printf '%s\n' "$(LIBAVJS_VERSION)"
 
+print-optflags:
+	@printf '%s\n' "$(OPTFLAGS)"
+
+print-release-variants:
+	@printf '%s\n' "$(RELEASE_VARIANTS)"
+
 .PRECIOUS: \
 	build/ffmpeg-$(FFMPEG_VERSION)/build-%/libavformat/libavformat.a \
 	build/exports-%.json \
+	build/jspi-exports-%.json \
 	build/post-%.js \
 	dist/libav.types.d.ts \
 	dist/libav-$(LIBAVJS_VERSION)-%.js \
@@ -338,4 +397,12 @@ print-version:
 	dist/libav-$(LIBAVJS_VERSION)-%.thr.js \
 	dist/libav-$(LIBAVJS_VERSION)-%.thr.mjs \
 	dist/libav-$(LIBAVJS_VERSION)-%.dbg.thr.js \
-	dist/libav-$(LIBAVJS_VERSION)-%.dbg.thr.mjs
+	dist/libav-$(LIBAVJS_VERSION)-%.dbg.thr.mjs \
+	dist/libav-$(LIBAVJS_VERSION)-%.simd.js \
+	dist/libav-$(LIBAVJS_VERSION)-%.simd.mjs \
+	dist/libav-$(LIBAVJS_VERSION)-%.dbg.simd.js \
+	dist/libav-$(LIBAVJS_VERSION)-%.dbg.simd.mjs \
+	dist/libav-$(LIBAVJS_VERSION)-%.jspi.js \
+	dist/libav-$(LIBAVJS_VERSION)-%.jspi.mjs \
+	dist/libav-$(LIBAVJS_VERSION)-%.dbg.jspi.js \
+	dist/libav-$(LIBAVJS_VERSION)-%.dbg.jspi.mjs
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/* Get the input files in place, and set up the measurement utilities. This
+ * always runs first. */
+
+for (const file of [
+    ["bbb.webm", "bbb_input.webm"],
+    ["bbb.mp4", "bbb_input.mp4"]
+]) {
+    const content = await h.readFile(`files/${file[1]}`);
+    h.files.push({
+        name: file[0],
+        content: new Blob([content])
+    });
+}
+
+/* Measure f, which returns how many items it processed, running it repeatedly
+ * for at least the minimum time. If given, opts.setup is run before each call,
+ * and its result passed to f, and opts.teardown after, both outside of the
+ * timing. Records and returns the items per second. */
+h.bench.measure = async function(name, f, opts) {
+    opts = opts || {};
+    const minTime = this.minTime * 1000;
+    let count = 0, time = 0;
+    do {
+        const state = opts.setup ? await opts.setup() : void 0;
+        const start = performance.now();
+        count += await f(state);
+        time += performance.now() - start;
+        if (opts.teardown)
+            await opts.teardown(state);
+    } while (time < minTime);
+    const ret = count * 1000 / time;
+    this.record(name, ret);
+    return ret;
+};
+
+// Find the first stream of this type
+h.bench.findStream = function(streams, type) {
+    for (const stream of streams) {
+        if (stream.codec_type === type)
+            return stream;
+    }
+    throw new Error(`Could not find a stream of type ${type}`);
+};
+
+/* Read all of the packets of this type from a file. The stream's codecpar is
+ * copied out, since the demuxer is closed. */
+h.bench.readPackets = async function(libav, file, type) {
+    const [fmt_ctx, streams] = await libav.ff_init_demuxer_file(file);
+    const stream = this.findStream(streams, type);
+    stream.codecpar = await libav.ff_copyout_codecpar(stream.codecpar);
+    const pkt = await libav.av_packet_alloc();
+    const [res, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt);
+    await libav.av_packet_free_js(pkt);
+    await libav.avformat_close_input_js(fmt_ctx);
+    if (res !== libav.AVERROR_EOF)
+        throw new Error(`Failed to read ${file}`);
+    return [stream, packets[stream.index]];
+};
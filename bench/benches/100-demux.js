@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+// Demuxing: packets per second through ff_read_frame_multi
+
+const libav = await h.LibAV();
+
+for (const file of ["bbb.webm", "bbb.mp4"]) {
+    const format = file.replace(/.*\./, "");
+    await h.bench.measure(`demux.${format}.packets_per_sec`, async state => {
+        const [res, packets] =
+            await libav.ff_read_frame_multi(state.fmt_ctx, state.pkt);
+        if (res !== libav.AVERROR_EOF)
+            throw new Error(`Failed to read ${file}`);
+        let count = 0;
+        for (const idx in packets)
+            count += packets[idx].length;
+        return count;
+    }, {
+        setup: async () => {
+            const [fmt_ctx] = await libav.ff_init_demuxer_file(file);
+            const pkt = await libav.av_packet_alloc();
+            return {fmt_ctx, pkt};
+        },
+        teardown: async state => {
+            await libav.av_packet_free_js(state.pkt);
+            await libav.avformat_close_input_js(state.fmt_ctx);
+        }
+    });
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+// Decoding: frames per second through ff_decode_multi, for audio and video
+
+const libav = await h.LibAV();
+
+for (const [kind, type] of [
+    ["audio", libav.AVMEDIA_TYPE_AUDIO],
+    ["video", libav.AVMEDIA_TYPE_VIDEO]
+]) {
+    const [stream, packets] =
+        await h.bench.readPackets(libav, "bbb.webm", type);
+    const codec = await libav.avcodec_get_name(stream.codec_id);
+
+    await h.bench.measure(`decode.${kind}.${codec}.fps`, async state => {
+        const frames = await libav.ff_decode_multi(
+            state[1], state[2], state[3], packets, true);
+        return frames.length;
+    }, {
+        setup: () => libav.ff_init_decoder(stream.codec_id, stream.codecpar),
+        teardown: state => libav.ff_free_decoder(state[1], state[2], state[3])
+    });
+}
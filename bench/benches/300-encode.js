@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+// Encoding: frames per second through ff_encode_multi, for audio and video
+
+const libav = await h.LibAV();
+
+// Audio: ten seconds of a stereo sine wave
+{
+    const init = () => libav.ff_init_encoder("libopus", {
+        ctx: {
+            bit_rate: 128000,
+            sample_fmt: libav.AV_SAMPLE_FMT_FLT,
+            sample_rate: 48000,
+            channel_layout: 3
+        },
+        time_base: [1, 48000]
+    });
+    const frameSize = (await init().then(async enc => {
+        await libav.ff_free_encoder(enc[1], enc[2], enc[3]);
+        return enc[4];
+    })) || 960;
+
+    const frames = [];
+    let t = 0;
+    const tincr = 2 * Math.PI * 440 / 48000;
+    for (let pts = 0; pts < 480000; pts += frameSize) {
+        const data = new Float32Array(frameSize * 2);
+        for (let i = 0; i < data.length; i += 2) {
+            data[i] = data[i + 1] = Math.sin(t);
+            t += tincr;
+        }
+        frames.push({
+            data,
+            channel_layout: 3,
+            format: libav.AV_SAMPLE_FMT_FLT,
+            pts,
+            sample_rate: 48000
+        });
+    }
+
+    await h.bench.measure("encode.audio.libopus.fps", async state => {
+        await libav.ff_encode_multi(state[1], state[2], state[3], frames, true);
+        return frames.length;
+    }, {
+        setup: init,
+        teardown: state => libav.ff_free_encoder(state[1], state[2], state[3])
+    });
+}
+
+// Video: the first second of the video, encoded for realtime
+{
+    const [stream, packets] = await h.bench.readPackets(
+        libav, "bbb.webm", libav.AVMEDIA_TYPE_VIDEO);
+    const [, c, pkt, frame] =
+        await libav.ff_init_decoder(stream.codec_id, stream.codecpar);
+    const frames = (await libav.ff_decode_multi(c, pkt, frame, packets, true))
+        .slice(0, 60);
+    await libav.ff_free_decoder(c, pkt, frame);
+
+    await h.bench.measure("encode.video.libvpx.fps", async state => {
+        await libav.ff_encode_multi(state[1], state[2], state[3], frames, true);
+        return frames.length;
+    }, {
+        setup: () => libav.ff_init_encoder("libvpx", {
+            ctx: {
+                bit_rate: 2000000,
+                pix_fmt: frames[0].format,
+                width: frames[0].width,
+                height: frames[0].height
+            },
+            options: {
+                deadline: "realtime",
+                "cpu-used": "8"
+            }
+        }),
+        teardown: state => libav.ff_free_encoder(state[1], state[2], state[3])
+    });
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+// Filtering: audio frames per second through ff_filter_multi
+
+const libav = await h.LibAV();
+
+const [stream, packets] = await h.bench.readPackets(
+    libav, "bbb.webm", libav.AVMEDIA_TYPE_AUDIO);
+const [, c, pkt, frame] =
+    await libav.ff_init_decoder(stream.codec_id, stream.codecpar);
+const frames = await libav.ff_decode_multi(c, pkt, frame, packets, true);
+await libav.ff_free_decoder(c, pkt, frame);
+
+const settings = {
+    sample_rate: frames[0].sample_rate,
+    sample_fmt: frames[0].format,
+    channel_layout: frames[0].channel_layout || 3
+};
+const tmpFrame = await libav.av_frame_alloc();
+
+for (const [name, filter] of [
+    ["anull", "anull"],
+    ["volume", "volume=0.5"],
+    ["aresample", "aresample=44100"]
+]) {
+    const output = Object.assign({}, settings);
+    if (name === "aresample")
+        output.sample_rate = 44100;
+    await h.bench.measure(`filter.audio.${name}.fps`, async state => {
+        await libav.ff_filter_multi(state[1], state[2], tmpFrame, frames, true);
+        return frames.length;
+    }, {
+        setup: () => libav.ff_init_filter_graph(filter, settings, output),
+        teardown: state => libav.avfilter_graph_free_js(state[0])
+    });
+}
+
+await libav.av_frame_free_js(tmpFrame);
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+// Muxing: packets per second through ff_write_multi, into a writer device
+
+const libav = await h.LibAV();
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+const pkt = await libav.av_packet_alloc();
+const [, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt, {
+    unify: true
+});
+const allPackets = packets[0];
+let bytes = 0;
+for (const p of allPackets)
+    bytes += p.data.length;
+
+await libav.mkwriterdev("bench-mux.webm");
+const prevOnwrite = libav.onwrite;
+libav.onwrite = () => {};
+
+const rate = await h.bench.measure("mux.webm.packets_per_sec", async state => {
+    await libav.ff_write_multi(state[0], pkt, allPackets);
+    await libav.av_write_trailer(state[0]);
+    return allPackets.length;
+}, {
+    setup: async () => {
+        const ret = await libav.ff_init_muxer({
+            filename: "bench-mux.webm",
+            format_name: "webm",
+            open: true,
+            codecpars: true
+        }, streams.map(s => [s.codecpar, s.time_base_num, s.time_base_den]));
+        await libav.avformat_write_header(ret[0], 0);
+        return ret;
+    },
+    teardown: state => libav.ff_free_muxer(state[0], state[2])
+});
+h.bench.record("mux.webm.mib_per_sec",
+    rate * bytes / allPackets.length / 1048576);
+
+libav.onwrite = prevOnwrite;
+await libav.unlink("bench-mux.webm");
+await libav.av_packet_free_js(pkt);
+await libav.avformat_close_input_js(fmt_ctx);
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/* Call overhead: the latency of a trivial call, one at a time, and the
+ * throughput of packets copied in and out, with many calls in flight. In the
+ * worker and threads modes, this is the round-trip time to the worker. */
+
+const libav = await h.LibAV();
+
+const calls = await h.bench.measure("call.trivial.calls_per_sec", async () => {
+    for (let i = 0; i < 1000; i++)
+        await libav.av_get_bytes_per_sample(libav.AV_SAMPLE_FMT_FLT);
+    return 1000;
+});
+h.bench.record("call.trivial.latency_us", 1000000 / calls);
+
+const pkt = await libav.av_packet_alloc();
+for (const size of [188, 65536]) {
+    const data = new Uint8Array(size);
+    await h.bench.measure(`call.packet_${size}.round_trips_per_sec`, async () => {
+        const ps = [];
+        for (let i = 0; i < 100; i++) {
+            ps.push(libav.ff_copyin_packet(pkt, {data}));
+            ps.push(libav.ff_copyout_packet(pkt));
+        }
+        await Promise.all(ps);
+        return 100;
+    });
+}
+await libav.av_packet_free_js(pkt);
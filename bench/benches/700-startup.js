@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/* Startup: the latency of creating an instance, both compiling the
+ * WebAssembly module itself and with a precompiled module, and of resetting an
+ * instance after probing a file. */
+
+const opts = h.libAVOpts || {};
+
+// Create and terminate instances, with these extra options
+async function startup(name, extra) {
+    const ret = await h.bench.measure(`startup.${name}.per_sec`, async () => {
+        const libav = await LibAV.LibAV(Object.assign({}, opts, extra));
+        libav.terminate();
+        return 1;
+    });
+    h.bench.record(`startup.${name}.latency_us`, 1000000 / ret);
+}
+
+// Compile every time
+const wasmmodules = LibAV.wasmmodules;
+LibAV.wasmmodules = {};
+await startup("compile", {});
+LibAV.wasmmodules = wasmmodules;
+
+// Reuse a compiled module
+const wasmmodule = await LibAV.compile(opts);
+if (wasmmodule)
+    await startup("precompiled", {wasmmodule});
+
+// Probe and reset
+const libav = await LibAV.LibAV(Object.assign({}, opts, {wasmmodule}));
+const file = h.files.find(x => x.name === "bbb.webm");
+const resets = await h.bench.measure("startup.reset.per_sec", async () => {
+    await libav.ff_reset();
+    return 1;
+}, {
+    setup: async () => {
+        await libav.mkreadaheadfile(file.name, file.content);
+        const [fmt_ctx] = await libav.ff_init_demuxer_file(file.name);
+        return fmt_ctx;
+    }
+});
+h.bench.record("startup.reset.latency_us", 1000000 / resets);
+libav.terminate();
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Segmented transcoding: frames per second through pool.transcode, with one
+ * instance and with four, so the speedup from transcoding segments in parallel
+ * can be compared. */
+
+const opts = h.libAVOpts || {};
+const libav = await h.LibAV();
+const file = h.files.find(x => x.name === "bbb.webm");
+const [, packets] = await h.bench.readPackets(
+    libav, file.name, libav.AVMEDIA_TYPE_VIDEO);
+
+const rates = {};
+for (const size of [1, 4]) {
+    const pool = await LibAV.pool(Object.assign({}, opts, {size}));
+    try {
+        await Promise.all(pool.instances.map(
+            x => x.mkreadaheadfile(file.name, file.content)));
+        rates[size] = await h.bench.measure(
+            `transcode.segmented.x${size}.fps`, async () => {
+                await pool.transcode({
+                    input: file.name,
+                    output: "tmp.webm",
+                    codec: "libvpx",
+                    ctx: {bit_rate: 2000000},
+                    options: {deadline: "realtime", "cpu-used": "8"}
+                });
+                return packets.length;
+            });
+    } finally {
+        pool.terminate();
+    }
+}
+h.bench.record("transcode.segmented.speedup", rates[4] / rates[1]);
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/* JSPI: frames per second through ff_decode_multi and ff_encode_multi for
+ * video, with the jspi target and with the same code suspending with Asyncify
+ * (the simd target), in one run so that they can be compared directly. Only
+ * run for the jspi target. */
+
+const opts = h.libAVOpts || {};
+if (LibAV.target(opts) !== "jspi")
+    return;
+const file = h.files.find(x => x.name === "bbb.webm");
+
+const rates = {};
+for (const [name, targetOpts] of [
+    ["jspi", opts],
+    ["asyncify", Object.assign({}, opts, {yesjspi: false})]
+]) {
+    const libav = await LibAV.LibAV(targetOpts);
+    try {
+        await libav.mkreadaheadfile(file.name, file.content);
+        const [stream, packets] = await h.bench.readPackets(
+            libav, file.name, libav.AVMEDIA_TYPE_VIDEO);
+        rates[name] = {};
+
+        rates[name].decode = await h.bench.measure(
+            `jspi.decode.video.${name}.fps`, async state => {
+                const frames = await libav.ff_decode_multi(
+                    state[1], state[2], state[3], packets, true);
+                return frames.length;
+            }, {
+                setup: () => libav.ff_init_decoder(
+                    stream.codec_id, stream.codecpar),
+                teardown: state => libav.ff_free_decoder(
+                    state[1], state[2], state[3])
+            });
+
+        const [, c, pkt, frame] =
+            await libav.ff_init_decoder(stream.codec_id, stream.codecpar);
+        const frames = (await libav.ff_decode_multi(
+            c, pkt, frame, packets, true)).slice(0, 60);
+        await libav.ff_free_decoder(c, pkt, frame);
+
+        rates[name].encode = await h.bench.measure(
+            `jspi.encode.video.${name}.fps`, async state => {
+                await libav.ff_encode_multi(
+                    state[1], state[2], state[3], frames, true);
+                return frames.length;
+            }, {
+                setup: () => libav.ff_init_encoder("libvpx", {
+                    ctx: {
+                        bit_rate: 2000000,
+                        pix_fmt: frames[0].format,
+                        width: frames[0].width,
+                        height: frames[0].height
+                    },
+                    options: {
+                        deadline: "realtime",
+                        "cpu-used": "8"
+                    }
+                }),
+                teardown: state => libav.ff_free_encoder(
+                    state[1], state[2], state[3])
+            });
+    } finally {
+        libav.terminate();
+    }
+}
+h.bench.record("jspi.decode.video.speedup",
+    rates.jspi.decode / rates.asyncify.decode);
+h.bench.record("jspi.encode.video.speedup",
+    rates.jspi.encode / rates.asyncify.encode);
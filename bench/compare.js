@@ -0,0 +1,61 @@
+#!/usr/bin/env node
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * Compare two sets of benchmark results from node-bench.js. Use:
+ *   node bench/compare.js <before.json> <after.json>
+ * Prints each result in both, with the speedup as a percentage. All results are
+ * rates (higher is better), except for latencies (*_us), where lower is
+ * better, so those are inverted to get the speedup.
+ */
+
+const fs = require("fs");
+
+if (process.argv.length < 4) {
+    console.error("Use: compare.js <before.json> <after.json>");
+    process.exit(1);
+}
+const before = JSON.parse(fs.readFileSync(process.argv[2], "utf8"));
+const after = JSON.parse(fs.readFileSync(process.argv[3], "utf8"));
+
+function fmt(x) {
+    if (typeof x !== "number")
+        return "-";
+    return x >= 100 ? x.toFixed(0) : x.toPrecision(3);
+}
+
+const rows = [["Target", "Benchmark", "Before", "After", "Change"]];
+for (const target of Object.keys(after.results)) {
+    const b = before.results[target] || {};
+    const a = after.results[target];
+    const names = Object.keys(Object.assign({}, b, a)).sort();
+    for (const name of names) {
+        let change = "";
+        if (typeof b[name] === "number" && typeof a[name] === "number" &&
+            b[name] > 0 && a[name] > 0) {
+            const pct = (/_us$/.test(name) ?
+                b[name] / a[name] :
+                a[name] / b[name]) * 100 - 100;
+            change = (pct >= 0 ? "+" : "") + pct.toFixed(1) + "%";
+        }
+        rows.push([target, name, fmt(b[name]), fmt(a[name]), change]);
+    }
+}
+
+const widths = rows[0].map((_, i) => Math.max.apply(Math, rows.map(r => r[i].length)));
+for (const row of rows)
+    console.log(row.map((x, i) => x.padEnd(widths[i])).join("  ").trimEnd());
@@ -0,0 +1,135 @@
+#!/usr/bin/env node
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Benchmark comparing encoding small audio frames with the send/receive loop
+ * in JavaScript, one exported call at a time (the old way), against
+ * ff_encode_multi, which runs that loop in C. Build the `all` variant first,
+ * then run `node bench/encode.js [frames]`.
+ */
+
+const nbFrames = +process.argv[2] || 2000;
+
+// Encode frames with the loop on the JS side, as ff_encode_multi used to
+function encodeJS(libav, c, frame, pkt, frames) {
+    const outPackets = [];
+    const tbNum = libav.AVCodecContext_time_base_num_sync(c);
+    const tbDen = libav.AVCodecContext_time_base_den_sync(c);
+
+    function receive() {
+        while (true) {
+            const ret = libav.avcodec_receive_packet_sync(c, pkt);
+            if (ret === -libav.EAGAIN || ret === libav.AVERROR_EOF)
+                return;
+            if (ret < 0)
+                throw new Error("Error encoding audio frame: " + libav.ff_error_sync(ret));
+            libav.AVPacket_time_base_s_sync(pkt, tbNum, tbDen);
+            outPackets.push(libav.ff_copyout_packet_sync(pkt));
+            libav.av_packet_unref_sync(pkt);
+        }
+    }
+
+    for (const f of frames) {
+        libav.ff_copyin_frame_sync(frame, f);
+        const fnum = libav.AVFrame_time_base_num_sync(frame);
+        if (fnum) {
+            libav.ff_frame_rescale_ts_js_sync(frame,
+                fnum, libav.AVFrame_time_base_den_sync(frame),
+                tbNum, tbDen);
+        }
+        const ret = libav.avcodec_send_frame_sync(c, frame);
+        if (ret < 0)
+            throw new Error("Error sending the frame to the encoder: " + libav.ff_error_sync(ret));
+        libav.av_frame_unref_sync(frame);
+        receive();
+    }
+    libav.avcodec_send_frame_sync(c, 0);
+    receive();
+    return outPackets;
+}
+
+async function bench(libav, codec, sampleFmt, frameSize, planar, native) {
+    const [, c, frame, pkt, frame_size] =
+        await libav.ff_init_encoder(codec, {
+            ctx: {
+                bit_rate: 128000,
+                sample_fmt: sampleFmt,
+                sample_rate: 48000,
+                channel_layout: 4,
+                channels: 1
+            },
+            time_base: [1, 48000]
+        });
+    frameSize = frame_size || frameSize;
+
+    const frames = [];
+    let t = 0;
+    const tincr = 2 * Math.PI * 440 / 48000;
+    for (let i = 0; i < nbFrames; i++) {
+        const samples = new Float32Array(frameSize);
+        for (let j = 0; j < frameSize; j++) {
+            samples[j] = Math.sin(t);
+            t += tincr;
+        }
+        frames.push({
+            data: planar ? [samples] : samples,
+            channel_layout: 4,
+            format: sampleFmt,
+            pts: i * frameSize,
+            sample_rate: 48000,
+            time_base_num: 1,
+            time_base_den: 48000
+        });
+    }
+
+    const start = performance.now();
+    let packets;
+    if (native)
+        packets = libav.ff_encode_multi_sync(c, frame, pkt, frames, true);
+    else
+        packets = encodeJS(libav, c, frame, pkt, frames);
+    const ms = performance.now() - start;
+
+    await libav.ff_free_encoder(c, frame, pkt);
+    const fps = nbFrames * 1000 / ms;
+    console.log(`${codec}, ${native ? "native loop" : "JS loop"}: ` +
+        `${fps.toFixed(0)} frames/sec (${packets.length} packets)`);
+    return fps;
+}
+
+async function main() {
+    LibAV = {};
+    require("../dist/libav-all.dbg.js");
+    const libav = await LibAV.LibAV({nothreads: true});
+    if (libav.libavjsMode !== "direct")
+        throw new Error("This benchmark needs the direct (non-worker) mode");
+
+    for (const [codec, sampleFmt, frameSize, planar] of [
+        ["libopus", libav.AV_SAMPLE_FMT_FLT, 960, false],
+        ["aac", libav.AV_SAMPLE_FMT_FLTP, 1024, true]
+    ]) {
+        const before = await bench(libav, codec, sampleFmt, frameSize, planar, false);
+        const after = await bench(libav, codec, sampleFmt, frameSize, planar, true);
+        console.log(`${codec} speedup: ${(after / before).toFixed(2)}x`);
+    }
+
+    libav.terminate();
+}
+
+main().catch(ex => {
+    console.error(ex);
+    process.exit(1);
+});
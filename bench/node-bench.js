@@ -0,0 +1,174 @@
+#!/usr/bin/env node
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Run the benchmark suite (benches/*.js) on the test harness, and write the
+ * results as JSON. Options:
+ *   --variant <variant>: Variant to benchmark (default all).
+ *   --dbg: Use the debug build.
+ *   --targets <targets>: Comma-separated list of targets to benchmark, of
+ *     jspi, simd, wasm, thr, and asm (default jspi,simd,wasm,thr). jspi
+ *     needs JSPI, so node --experimental-wasm-jspi.
+ *   --time <seconds>: Minimum time to spend on each measurement (default 1).
+ *   --only <regex>: Only run the benchmarks whose filenames match.
+ *   -o <file>: Write the results to this file instead of stdout.
+ * Use compare.js to compare the results of two runs.
+ */
+
+const fs = require("fs/promises");
+const path = require("path");
+
+const targetOpts = {
+    jspi: {yesjspi: true},
+    simd: {},
+    wasm: {nosimd: true},
+    thr: {yesthreads: true},
+    asm: {nowasm: true}
+};
+
+const options = {
+    variant: "all",
+    dbg: false,
+    targets: ["jspi", "simd", "wasm", "thr"],
+    time: 1,
+    only: null,
+    output: null
+};
+const args = process.argv.slice(2);
+for (let i = 0; i < args.length; i++) {
+    const arg = args[i];
+    switch (arg) {
+        case "--variant":
+            options.variant = args[++i];
+            break;
+
+        case "--dbg":
+            options.dbg = true;
+            break;
+
+        case "--targets":
+            options.targets = args[++i].split(",");
+            for (const t of options.targets) {
+                if (!targetOpts[t]) {
+                    console.error(`Unrecognized target ${t}`);
+                    process.exit(1);
+                }
+            }
+            break;
+
+        case "--time":
+            options.time = +args[++i];
+            break;
+
+        case "--only":
+            options.only = new RegExp(args[++i]);
+            break;
+
+        case "-o":
+            options.output = args[++i];
+            break;
+
+        default:
+            console.error(`Unrecognized argument ${arg}`);
+            process.exit(1);
+    }
+}
+
+async function main() {
+    // The harness expects to be run from the tests directory
+    process.chdir(path.join(__dirname, "..", "tests"));
+    const harness = require("../tests/harness.js");
+    harness.options.toImport = path.join(__dirname, "..", "dist",
+        `libav-${options.variant}${options.dbg ? ".dbg" : ""}.js`);
+    harness.printStatus = x => {
+        process.stderr.write("\x1b[K" + x + "\r");
+    };
+
+    let list = (await fs.readdir(path.join(__dirname, "benches")))
+        .filter(x => /\.js$/.test(x)).sort();
+    await harness.loadTests(list, path.join(__dirname, "benches"));
+    if (options.only) {
+        harness.tests = harness.tests.filter(
+            (x, idx) => idx === 0 || options.only.test(x.name));
+    }
+
+    const out = {
+        version: null,
+        variant: options.variant,
+        dbg: options.dbg,
+        node: process.version,
+        date: new Date().toISOString(),
+        results: {}
+    };
+
+    harness.bench = {
+        minTime: options.time,
+        results: null,
+
+        // Record a result under a stable name
+        record: function(name, value) {
+            this.results[name] = value;
+        }
+    };
+
+    let fails = 0;
+    for (const target of options.targets) {
+        if (harness.libav) {
+            harness.libav.terminate();
+            harness.libav = null;
+        }
+        harness.files = [];
+        harness.libAVOpts = targetOpts[target];
+        harness.bench.results = {};
+
+        /* Make sure this target is actually available. This loads LibAV, but
+         * the instance has no files yet, so the benchmarks get a new one. */
+        await harness.LibAV();
+        harness.libav.terminate();
+        harness.libav = null;
+        out.version = LibAV.VER;
+        if (LibAV.target(harness.libAVOpts) !== target) {
+            harness.printErr(`\nTarget ${target} is not supported here`);
+            continue;
+        }
+        out.results[target] = harness.bench.results;
+
+        let idx = 0;
+        for (const bench of harness.tests) {
+            idx++;
+            harness.printStatus(
+                `${target} ${idx}/${harness.tests.length}: ${bench.name}`);
+            try {
+                await bench.func(harness);
+            } catch (ex) {
+                harness.printErr("\n" +
+                    `Error in benchmark ${bench.name}\n` +
+                    `Target: ${target}\n` +
+                    `Error: ${ex}\n${ex.stack}`);
+                fails++;
+            }
+        }
+    }
+    harness.printStatus("");
+
+    const json = JSON.stringify(out, null, 2) + "\n";
+    if (options.output)
+        await fs.writeFile(options.output, json);
+    else
+        process.stdout.write(json);
+    process.exit(fails ? 1 : 0);
+}
+main();
@@ -0,0 +1,85 @@
+#!/usr/bin/env node
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Benchmark comparing the threads mode's postMessage transport against its
+ * shared-memory ring transport (the `ring` option). Reports the latency of
+ * trivial calls, one at a time, and the throughput of packets copied in and
+ * out, with many calls in flight. Build the `all` variant (including the
+ * threaded build) first, then run `node bench/ring.js [iterations]`.
+ */
+
+const iterations = +process.argv[2] || 10000;
+
+async function bench(ring) {
+    const libav = await LibAV.LibAV({yesthreads: true, ring});
+    if (libav.libavjsMode !== "threads")
+        throw new Error("This benchmark needs the threads mode");
+    const name = ring ? "ring" : "postMessage";
+    const ret = {};
+
+    // Latency: one trivial call at a time
+    let start = performance.now();
+    for (let i = 0; i < iterations; i++)
+        await libav.av_get_bytes_per_sample(libav.AV_SAMPLE_FMT_FLT);
+    ret.latency = (performance.now() - start) * 1000 / iterations;
+    console.log(`${name}: ${ret.latency.toFixed(2)}us per call`);
+
+    // Throughput: round trips of packets, all in flight at once
+    const pkt = await libav.av_packet_alloc();
+    for (const size of [188, 4096, 65536]) {
+        const data = new Uint8Array(size);
+        const count = Math.max(100, Math.floor(iterations * 188 / size));
+        start = performance.now();
+        const ps = [];
+        for (let i = 0; i < count; i++) {
+            ps.push(libav.ff_copyin_packet(pkt, {data}));
+            ps.push(libav.ff_copyout_packet(pkt));
+        }
+        await Promise.all(ps);
+        const s = (performance.now() - start) / 1000;
+        const mbps = size * count * 2 / s / 1048576;
+        ret[size] = mbps;
+        console.log(`${name}, ${size}-byte packets: ` +
+            `${(count / s).toFixed(0)} round trips/sec, ` +
+            `${mbps.toFixed(1)}MiB/sec`);
+    }
+    await libav.av_packet_free_js(pkt);
+
+    libav.terminate();
+    return ret;
+}
+
+async function main() {
+    LibAV = {};
+    require("../dist/libav-all.dbg.js");
+    if (!LibAV.isThreadingSupported())
+        throw new Error("This benchmark needs threads");
+
+    const post = await bench(false);
+    const ring = await bench(true);
+    console.log(`Latency speedup: ${(post.latency / ring.latency).toFixed(2)}x`);
+    for (const size of [188, 4096, 65536]) {
+        console.log(`${size}-byte throughput speedup: ` +
+            `${(ring[size] / post[size]).toFixed(2)}x`);
+    }
+    process.exit(0);
+}
+
+main().catch(ex => {
+    console.error(ex);
+    process.exit(1);
+});
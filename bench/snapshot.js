@@ -0,0 +1,140 @@
+#!/usr/bin/env node
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Microbenchmark comparing copying out frames and packets with one call per
+ * field (the old way) against copying them out through a single snapshot
+ * record (what ff_copyout_frame and ff_copyout_packet do now). Build the `all`
+ * variant first, then run `node bench/snapshot.js [iterations]`.
+ */
+
+const fs = require("fs");
+
+const iterations = +process.argv[2] || 100;
+
+// Copy out an audio frame one field at a time, as ff_copyout_frame used to
+function copyoutFrameAccessors(libav, frame) {
+    const nb_samples = libav.AVFrame_nb_samples_sync(frame);
+    const channels = libav.AVFrame_channels_sync(frame);
+    const format = libav.AVFrame_format_sync(frame);
+    const outFrame = {
+        data: [],
+        channel_layout: libav.AVFrame_channel_layout_sync(frame),
+        channels,
+        format,
+        nb_samples,
+        pts: libav.AVFrame_pts_sync(frame),
+        ptshi: libav.AVFrame_ptshi_sync(frame),
+        best_effort_timestamp: libav.AVFrame_best_effort_timestamp_sync(frame),
+        best_effort_timestamphi: libav.AVFrame_best_effort_timestamphi_sync(frame),
+        time_base_num: libav.AVFrame_time_base_num_sync(frame),
+        time_base_den: libav.AVFrame_time_base_den_sync(frame),
+        sample_rate: libav.AVFrame_sample_rate_sync(frame)
+    };
+    for (let ci = 0; ci < channels; ci++) {
+        outFrame.data.push(libav.copyout_f32_sync(
+            libav.AVFrame_data_a_sync(frame, ci), nb_samples));
+    }
+    return outFrame;
+}
+
+// Copy out a packet one field at a time, as ff_copyout_packet used to
+function copyoutPacketAccessors(libav, pkt) {
+    const data = libav.copyout_u8_sync(
+        libav.AVPacket_data_sync(pkt), libav.AVPacket_size_sync(pkt));
+    return {
+        data,
+        pts: libav.AVPacket_pts_sync(pkt),
+        ptshi: libav.AVPacket_ptshi_sync(pkt),
+        dts: libav.AVPacket_dts_sync(pkt),
+        dtshi: libav.AVPacket_dtshi_sync(pkt),
+        time_base_num: libav.AVPacket_time_base_num_sync(pkt),
+        time_base_den: libav.AVPacket_time_base_den_sync(pkt),
+        stream_index: libav.AVPacket_stream_index_sync(pkt),
+        flags: libav.AVPacket_flags_sync(pkt),
+        duration: libav.AVPacket_duration_sync(pkt),
+        durationhi: libav.AVPacket_durationhi_sync(pkt),
+        side_data: libav.AVPacket_side_data_sync(pkt) ? [] : null
+    };
+}
+
+function time(name, count, f) {
+    const start = performance.now();
+    for (let i = 0; i < iterations; i++)
+        f();
+    const ms = performance.now() - start;
+    const per = ms * 1000 / (iterations * count);
+    console.log(`${name}: ${per.toFixed(3)}us per item`);
+    return per;
+}
+
+async function main() {
+    LibAV = {};
+    require("../dist/libav-all.dbg.js");
+    const libav = await LibAV.LibAV({nothreads: true});
+    if (libav.libavjsMode !== "direct")
+        throw new Error("This benchmark needs the direct (non-worker) mode");
+
+    await libav.writeFile("input.webm",
+        fs.readFileSync(`${__dirname}/../tests/files/bbb_input.webm`));
+    const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("input.webm");
+    const stream = streams.find(
+        s => s.codec_type === libav.AVMEDIA_TYPE_AUDIO);
+    const [, c, pkt, frame] =
+        await libav.ff_init_decoder(stream.codec_id, stream.codecpar);
+    const [, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt, {
+        copyoutPacket: "ptr"
+    });
+    await libav.avformat_close_input_js(fmt_ctx);
+    const pktPtrs = packets[stream.index];
+
+    // Decode copies of the packets, since decoding consumes them
+    const decodePkts = pktPtrs.map(p => libav.av_packet_clone_sync(p));
+    const framePtrs = await libav.ff_decode_multi(c, pkt, frame, decodePkts, {
+        fin: true,
+        copyoutFrame: "ptr"
+    });
+
+    console.log(`${pktPtrs.length} packets, ${framePtrs.length} frames, ` +
+        `${iterations} iterations`);
+
+    const pa = time("Packets, per-field accessors", pktPtrs.length, () => {
+        for (const p of pktPtrs) copyoutPacketAccessors(libav, p);
+    });
+    const ps = time("Packets, snapshot", pktPtrs.length, () => {
+        for (const p of pktPtrs) libav.ff_copyout_packet_sync(p);
+    });
+    const fa = time("Frames, per-field accessors", framePtrs.length, () => {
+        for (const f of framePtrs) copyoutFrameAccessors(libav, f);
+    });
+    const fs_ = time("Frames, snapshot", framePtrs.length, () => {
+        for (const f of framePtrs) libav.ff_copyout_frame_sync(f);
+    });
+    console.log(`Packet speedup: ${(pa / ps).toFixed(2)}x`);
+    console.log(`Frame speedup: ${(fa / fs_).toFixed(2)}x`);
+
+    for (const p of pktPtrs)
+        await libav.av_packet_free_js(p);
+    for (const f of framePtrs)
+        await libav.av_frame_free_js(f);
+    await libav.ff_free_decoder(c, pkt, frame);
+    libav.terminate();
+}
+
+main().catch(ex => {
+    console.error(ex);
+    process.exit(1);
+});
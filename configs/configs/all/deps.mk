@@ -1,20 +1,30 @@
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-all/ffbuild/config.mak: build/inst/base/lib/pkgconfig/opus.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-all/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/opus.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-all/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/opus.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-all/ffbuild/config.mak: build/inst/base/lib/pkgconfig/vorbis.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-all/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/vorbis.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-all/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/vorbis.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-all/ffbuild/config.mak: build/inst/base/lib/libmp3lame.a
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-all/ffbuild/config.mak: build/inst/thr/lib/libmp3lame.a
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-all/ffbuild/config.mak: build/inst/simd/lib/libmp3lame.a
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-all/ffbuild/config.mak: build/inst/base/lib/pkgconfig/vpx.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-all/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/vpx.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-all/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/vpx.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-all/ffbuild/config.mak: build/inst/base/lib/pkgconfig/aom.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-all/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/aom.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-all/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/aom.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-all/ffbuild/config.mak: build/inst/base/lib/pkgconfig/openh264.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-all/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/openh264.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-all/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/openh264.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-all/ffbuild/config.mak: build/inst/base/lib/pkgconfig/aom.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-all/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/aom.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-all/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/aom.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-all/ffbuild/config.mak: build/inst/base/lib/pkgconfig/zlib.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-all/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/zlib.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-all/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/zlib.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-all/ffbuild/config.mak: build/inst/base/lib/pkgconfig/opus.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-all/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/opus.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-all/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/opus.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-all/ffbuild/config.mak: build/inst/base/lib/pkgconfig/vorbis.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-all/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/vorbis.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-all/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/vorbis.pc
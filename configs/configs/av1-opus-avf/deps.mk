@@ -1,4 +1,6 @@
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-av1-opus-avf/ffbuild/config.mak: build/inst/base/lib/pkgconfig/opus.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-av1-opus-avf/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/opus.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-av1-opus-avf/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/opus.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-av1-opus-avf/ffbuild/config.mak: build/inst/base/lib/pkgconfig/aom.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-av1-opus-avf/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/aom.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-av1-opus-avf/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/aom.pc
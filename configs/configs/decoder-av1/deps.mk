@@ -1,2 +1,3 @@
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-decoder-av1/ffbuild/config.mak: build/inst/base/lib/pkgconfig/aom.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-decoder-av1/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/aom.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-decoder-av1/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/aom.pc
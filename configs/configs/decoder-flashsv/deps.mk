@@ -1,2 +1,3 @@
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-decoder-flashsv/ffbuild/config.mak: build/inst/base/lib/pkgconfig/zlib.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-decoder-flashsv/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/zlib.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-decoder-flashsv/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/zlib.pc
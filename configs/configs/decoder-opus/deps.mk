@@ -1,2 +1,3 @@
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-decoder-opus/ffbuild/config.mak: build/inst/base/lib/pkgconfig/opus.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-decoder-opus/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/opus.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-decoder-opus/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/opus.pc
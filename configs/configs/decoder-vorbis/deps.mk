@@ -1,2 +1,3 @@
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-decoder-vorbis/ffbuild/config.mak: build/inst/base/lib/pkgconfig/vorbis.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-decoder-vorbis/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/vorbis.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-decoder-vorbis/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/vorbis.pc
@@ -1,2 +1,3 @@
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-decoder-vp9/ffbuild/config.mak: build/inst/base/lib/pkgconfig/vpx.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-decoder-vp9/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/vpx.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-decoder-vp9/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/vpx.pc
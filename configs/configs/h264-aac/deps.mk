@@ -1,2 +1,3 @@
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-h264-aac/ffbuild/config.mak: build/inst/base/lib/pkgconfig/openh264.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-h264-aac/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/openh264.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-h264-aac/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/openh264.pc
@@ -1,4 +1,6 @@
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-vp8-opus-avf/ffbuild/config.mak: build/inst/base/lib/pkgconfig/opus.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-vp8-opus-avf/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/opus.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-vp8-opus-avf/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/opus.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-base-vp8-opus-avf/ffbuild/config.mak: build/inst/base/lib/pkgconfig/vpx.pc
 build/ffmpeg-$(FFMPEG_VERSION)/build-thr-vp8-opus-avf/ffbuild/config.mak: build/inst/thr/lib/pkgconfig/vpx.pc
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-vp8-opus-avf/ffbuild/config.mak: build/inst/simd/lib/pkgconfig/vpx.pc
@@ -47,7 +47,7 @@ function addFragment(out, part) {
         // Add any dependencies
         try {
             const deps = fs.readFileSync(`fragments/${part}/deps.txt`, "utf8").split("\n");
-            for (const target of ["base", "thr"]) {
+            for (const target of ["base", "thr", "simd"]) {
                 for (const dep of deps) {
                     if (!dep) continue;
                     out["deps.mk"].write(
@@ -22,7 +22,7 @@ build/ffmpeg-$(FFMPEG_VERSION)/build-%/libavformat/libavformat.a: \
 	cd build/ffmpeg-$(FFMPEG_VERSION)/build-$* && $(MAKE)
 
 # General build rule for any target
-# Use: buildrule(target name, extra deps, configure flags, CFLAGS)
+# Use: buildrule(target name, extra deps, configure flags, CFLAGS, extra optflags)
 
 
 # Base (asm.js and wasm)
@@ -36,7 +36,7 @@ build/ffmpeg-$(FFMPEG_VERSION)/build-base-%/ffbuild/config.mak: build/inst/base/
 	emconfigure env PKG_CONFIG_PATH="$(PWD)/build/inst/base/lib/pkgconfig" \
 		../configure $(FFMPEG_CONFIG) \
                 --enable-pthreads --arch=emscripten \
-		--optflags="$(OPTFLAGS)" \
+		--optflags="$(OPTFLAGS) " \
 		--extra-cflags="-I$(PWD)/build/inst/base/include -lemfiberthreads" \
 		--extra-ldflags="-L$(PWD)/build/inst/base/lib -lemfiberthreads -s INITIAL_MEMORY=25165824" \
 		`cat ../../../configs/configs/$(*)/ffmpeg-config.txt`
@@ -59,7 +59,7 @@ build/ffmpeg-$(FFMPEG_VERSION)/build-thr-%/ffbuild/config.mak: build/inst/thr/li
 	emconfigure env PKG_CONFIG_PATH="$(PWD)/build/inst/thr/lib/pkgconfig" \
 		../configure $(FFMPEG_CONFIG) \
                 --enable-pthreads --arch=emscripten \
-		--optflags="$(OPTFLAGS)" \
+		--optflags="$(OPTFLAGS) " \
 		--extra-cflags="-I$(PWD)/build/inst/thr/include -lemfiberthreads $(THRFLAGS)" \
 		--extra-ldflags="-L$(PWD)/build/inst/thr/lib -lemfiberthreads $(THRFLAGS) -s INITIAL_MEMORY=25165824" \
 		`cat ../../../configs/configs/$(*)/ffmpeg-config.txt`
@@ -71,11 +71,34 @@ part-install-thr-%: build/ffmpeg-$(FFMPEG_VERSION)/build-thr-%/libavformat/libav
 	cd build/ffmpeg-$(FFMPEG_VERSION)/build-thr-$(*) ; \
 	$(MAKE) install prefix="$(PWD)/build/inst/thr"
 
+# wasm + SIMD
+
+build/ffmpeg-$(FFMPEG_VERSION)/build-simd-%/ffbuild/config.mak: build/inst/simd/include/pthread.h \
+	build/ffmpeg-$(FFMPEG_VERSION)/PATCHED \
+	configs/configs/%/ffmpeg-config.txt | \
+	build/inst/simd/cflags.txt
+	mkdir -p build/ffmpeg-$(FFMPEG_VERSION)/build-simd-$(*) && \
+	cd build/ffmpeg-$(FFMPEG_VERSION)/build-simd-$(*) && \
+	emconfigure env PKG_CONFIG_PATH="$(PWD)/build/inst/simd/lib/pkgconfig" \
+		../configure $(FFMPEG_CONFIG) \
+                --enable-pthreads --arch=emscripten \
+		--optflags="$(OPTFLAGS) $(SIMDOPTFLAGS)" \
+		--extra-cflags="-I$(PWD)/build/inst/simd/include -lemfiberthreads -msimd128" \
+		--extra-ldflags="-L$(PWD)/build/inst/simd/lib -lemfiberthreads -msimd128 -s INITIAL_MEMORY=25165824" \
+		`cat ../../../configs/configs/$(*)/ffmpeg-config.txt`
+	sed 's/--extra-\(cflags\|ldflags\)='\''[^'\'']*'\''//g' < build/ffmpeg-$(FFMPEG_VERSION)/build-simd-$(*)/config.h > build/ffmpeg-$(FFMPEG_VERSION)/build-simd-$(*)/config.h.tmp
+	mv build/ffmpeg-$(FFMPEG_VERSION)/build-simd-$(*)/config.h.tmp build/ffmpeg-$(FFMPEG_VERSION)/build-simd-$(*)/config.h
+	touch $(@)
+
+part-install-simd-%: build/ffmpeg-$(FFMPEG_VERSION)/build-simd-%/libavformat/libavformat.a
+	cd build/ffmpeg-$(FFMPEG_VERSION)/build-simd-$(*) ; \
+	$(MAKE) install prefix="$(PWD)/build/inst/simd"
+
 
 # All dependencies
 include configs/configs/*/deps.mk
 
-install-%: part-install-base-% part-install-thr-%
+install-%: part-install-base-% part-install-thr-% part-install-simd-%
 	true
 
 extract: build/ffmpeg-$(FFMPEG_VERSION)/PATCHED
@@ -106,5 +129,7 @@ ffmpeg-release:
 	build/ffmpeg-$(FFMPEG_VERSION)/build-base-%/ffbuild/config.mak \
 	build/ffmpeg-$(FFMPEG_VERSION)/build-thr-%/libavformat/libavformat.a \
 	build/ffmpeg-$(FFMPEG_VERSION)/build-thr-%/ffbuild/config.mak \
+	build/ffmpeg-$(FFMPEG_VERSION)/build-simd-%/libavformat/libavformat.a \
+	build/ffmpeg-$(FFMPEG_VERSION)/build-simd-%/ffbuild/config.mak \
 	build/ffmpeg-$(FFMPEG_VERSION)/PATCHED \
 	build/ffmpeg-$(FFMPEG_VERSION)/configure
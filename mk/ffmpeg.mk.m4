@@ -22,7 +22,7 @@ build/ffmpeg-$(FFMPEG_VERSION)/build-%/libavformat/libavformat.a: \
 	cd build/ffmpeg-$(FFMPEG_VERSION)/build-$* && $(MAKE)
 
 # General build rule for any target
-# Use: buildrule(target name, extra deps, configure flags, CFLAGS)
+# Use: buildrule(target name, extra deps, configure flags, CFLAGS, extra optflags)
 define([[[buildrule]]], [[[
 build/ffmpeg-$(FFMPEG_VERSION)/build-$1-%/ffbuild/config.mak: $2 \
 	build/ffmpeg-$(FFMPEG_VERSION)/PATCHED \
@@ -33,7 +33,7 @@ build/ffmpeg-$(FFMPEG_VERSION)/build-$1-%/ffbuild/config.mak: $2 \
 	emconfigure env PKG_CONFIG_PATH="$(PWD)/build/inst/$1/lib/pkgconfig" \
 		../configure $(FFMPEG_CONFIG) \
                 $3 \
-		--optflags="$(OPTFLAGS)" \
+		--optflags="$(OPTFLAGS) $5" \
 		--extra-cflags="-I$(PWD)/build/inst/$1/include $4" \
 		--extra-ldflags="-L$(PWD)/build/inst/$1/lib $4 -s INITIAL_MEMORY=25165824" \
 		`cat ../../../configs/configs/$(*)/ffmpeg-config.txt`
@@ -50,11 +50,13 @@ part-install-$1-%: build/ffmpeg-$(FFMPEG_VERSION)/build-$1-%/libavformat/libavfo
 buildrule(base, build/inst/base/include/pthread.h, [[[--enable-pthreads --arch=emscripten]]], [[[-lemfiberthreads]]])
 # wasm + threads
 buildrule(thr, build/inst/thr/lib/libemfiberthreads.a, [[[--enable-pthreads --arch=emscripten]]], [[[-lemfiberthreads $(THRFLAGS)]]])
+# wasm + SIMD
+buildrule(simd, build/inst/simd/include/pthread.h, [[[--enable-pthreads --arch=emscripten]]], [[[-lemfiberthreads -msimd128]]], [[[$(SIMDOPTFLAGS)]]])
 
 # All dependencies
 include configs/configs/*/deps.mk
 
-install-%: part-install-base-% part-install-thr-%
+install-%: part-install-base-% part-install-thr-% part-install-simd-%
 	true
 
 extract: build/ffmpeg-$(FFMPEG_VERSION)/PATCHED
@@ -85,5 +87,7 @@ ffmpeg-release:
 	build/ffmpeg-$(FFMPEG_VERSION)/build-base-%/ffbuild/config.mak \
 	build/ffmpeg-$(FFMPEG_VERSION)/build-thr-%/libavformat/libavformat.a \
 	build/ffmpeg-$(FFMPEG_VERSION)/build-thr-%/ffbuild/config.mak \
+	build/ffmpeg-$(FFMPEG_VERSION)/build-simd-%/libavformat/libavformat.a \
+	build/ffmpeg-$(FFMPEG_VERSION)/build-simd-%/ffbuild/config.mak \
 	build/ffmpeg-$(FFMPEG_VERSION)/PATCHED \
 	build/ffmpeg-$(FFMPEG_VERSION)/configure
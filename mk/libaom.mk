@@ -21,8 +21,8 @@ build/libaom-$(LIBAOM_VERSION)/build-base/Makefile: build/libaom-$(LIBAOM_VERSIO
 	cd build/libaom-$(LIBAOM_VERSION)/build-base && \
 		emcmake cmake ../../libaom-$(LIBAOM_VERSION) \
 		-DCMAKE_INSTALL_PREFIX="$(PWD)/build/inst/base" \
-		-DCMAKE_C_FLAGS="-Oz `cat $(PWD)/build/inst/base/cflags.txt`" \
-		-DCMAKE_CXX_FLAGS="-Oz `cat $(PWD)/build/inst/base/cflags.txt`" \
+		-DCMAKE_C_FLAGS="$(OPTFLAGS) `cat $(PWD)/build/inst/base/cflags.txt`" \
+		-DCMAKE_CXX_FLAGS="$(OPTFLAGS) `cat $(PWD)/build/inst/base/cflags.txt`" \
 		-DAOM_TARGET_CPU=generic \
 		-DCMAKE_BUILD_TYPE=Release \
 		-DENABLE_DOCS=0 \
@@ -40,8 +40,8 @@ build/libaom-$(LIBAOM_VERSION)/build-thr/Makefile: build/libaom-$(LIBAOM_VERSION
 	cd build/libaom-$(LIBAOM_VERSION)/build-thr && \
 		emcmake cmake ../../libaom-$(LIBAOM_VERSION) \
 		-DCMAKE_INSTALL_PREFIX="$(PWD)/build/inst/thr" \
-		-DCMAKE_C_FLAGS="-Oz `cat $(PWD)/build/inst/thr/cflags.txt`" \
-		-DCMAKE_CXX_FLAGS="-Oz `cat $(PWD)/build/inst/thr/cflags.txt`" \
+		-DCMAKE_C_FLAGS="$(OPTFLAGS) `cat $(PWD)/build/inst/thr/cflags.txt`" \
+		-DCMAKE_CXX_FLAGS="$(OPTFLAGS) `cat $(PWD)/build/inst/thr/cflags.txt`" \
 		-DAOM_TARGET_CPU=generic \
 		-DCMAKE_BUILD_TYPE=Release \
 		-DENABLE_DOCS=0 \
@@ -52,6 +52,25 @@ build/libaom-$(LIBAOM_VERSION)/build-thr/Makefile: build/libaom-$(LIBAOM_VERSION
 		
 	touch $(@)
 
+# SIMD
+
+build/libaom-$(LIBAOM_VERSION)/build-simd/Makefile: build/libaom-$(LIBAOM_VERSION)/PATCHED | build/inst/simd/cflags.txt
+	mkdir -p build/libaom-$(LIBAOM_VERSION)/build-simd
+	cd build/libaom-$(LIBAOM_VERSION)/build-simd && \
+		emcmake cmake ../../libaom-$(LIBAOM_VERSION) \
+		-DCMAKE_INSTALL_PREFIX="$(PWD)/build/inst/simd" \
+		-DCMAKE_C_FLAGS="$(OPTFLAGS) `cat $(PWD)/build/inst/simd/cflags.txt`" \
+		-DCMAKE_CXX_FLAGS="$(OPTFLAGS) `cat $(PWD)/build/inst/simd/cflags.txt`" \
+		-DAOM_TARGET_CPU=generic \
+		-DCMAKE_BUILD_TYPE=Release \
+		-DENABLE_DOCS=0 \
+		-DENABLE_TESTS=0 \
+		-DENABLE_EXAMPLES=0 \
+		-DCONFIG_RUNTIME_CPU_DETECT=0 \
+		-DCONFIG_WEBM_IO=0 \
+		-DCONFIG_MULTITHREAD=0
+	touch $(@)
+
 
 extract: build/libaom-$(LIBAOM_VERSION)/PATCHED
 
@@ -18,7 +18,7 @@ build/libvpx-$(LIBVPX_VERSION)/build-%/Makefile: build/libvpx-$(LIBVPX_VERSION)/
 		emconfigure ../../libvpx-$(LIBVPX_VERSION)/configure \
 			--prefix="$(PWD)/build/inst/$*" \
 			--target=generic-gnu \
-			--extra-cflags="-Oz `cat $(PWD)/build/inst/$*/cflags.txt`" \
+			--extra-cflags="$(OPTFLAGS) `cat $(PWD)/build/inst/$*/cflags.txt`" \
 			--enable-static --disable-shared \
 			--disable-webm-io \
 			--disable-examples --disable-tools --disable-docs
@@ -18,8 +18,8 @@ build/SVT-AV1-v$(SVT_AV1_VERSION)/build-$1/Makefile: build/SVT-AV1-v$(SVT_AV1_VE
 	cd build/SVT-AV1-v$(SVT_AV1_VERSION)/build-$1 && \
 		emcmake cmake ../../SVT-AV1-v$(SVT_AV1_VERSION) \
 		-DCMAKE_INSTALL_PREFIX="$(PWD)/build/inst/$1" \
-		-DCMAKE_C_FLAGS="-Oz `cat $(PWD)/build/inst/$1/cflags.txt`" \
-		-DCMAKE_CXX_FLAGS="-Oz `cat $(PWD)/build/inst/$1/cflags.txt`" \
+		-DCMAKE_C_FLAGS="$(OPTFLAGS) `cat $(PWD)/build/inst/$1/cflags.txt`" \
+		-DCMAKE_CXX_FLAGS="$(OPTFLAGS) `cat $(PWD)/build/inst/$1/cflags.txt`" \
 		-DCMAKE_BUILD_TYPE=Release \
                 $2
 	touch $(@)
@@ -29,6 +29,8 @@ build/SVT-AV1-v$(SVT_AV1_VERSION)/build-$1/Makefile: build/SVT-AV1-v$(SVT_AV1_VE
 buildrule(base, [[[]]])
 # Threaded
 buildrule(thr, [[[]]])
+# SIMD
+buildrule(simd, [[[]]])
 
 #extract: build/SVT-AV1-v$(SVT_AV1_VERSION)/PATCHED
 
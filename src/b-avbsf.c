@@ -32,3 +32,48 @@ AVBSFContext *av_bsf_list_parse_str_js(const char *str) {
     }
     return ret;
 }
+
+/* Native driver for ff_bsf_multi. Like ff_encode_multi_c (b-avcodec.c), but
+ * bitstream filtering packets. */
+int ff_bsf_multi_c(
+    AVBSFContext *bsf, AVPacket *pkt,
+    AVPacket **in, int nb_in, int32_t *status, int flags,
+    FFPool *in_pool, FFPool *out_pool, FFMultiOutput *out
+) {
+    int i, ret;
+
+    for (i = 0; i <= nb_in; i++) {
+        if (i < nb_in) {
+            ff_packet_multi_in(in_pool, pkt, in[i]);
+            ret = av_bsf_send_packet(bsf, pkt);
+        } else if (flags & FF_MULTI_FIN) {
+            av_bsf_flush(bsf);
+            ret = 0;
+        } else {
+            break;
+        }
+        status[i] = ret;
+        if (ret < 0)
+            goto fail;
+        av_packet_unref(pkt);
+
+        while (1) {
+            ret = av_bsf_receive_packet(bsf, pkt);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                break;
+            else if (ret < 0)
+                goto fail;
+            ret = ff_packet_multi_out(out_pool, pkt, out);
+            if (ret < 0)
+                goto fail;
+        }
+    }
+
+    return 0;
+
+fail:
+    // Release the inputs not yet reached
+    if (i + 1 < nb_in)
+        ff_packet_multi_in_drop(in_pool, in + i + 1, nb_in - i - 1);
+    return ret;
+}
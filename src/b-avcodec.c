@@ -51,6 +51,9 @@ BL(int64_t, rc_min_rate)
 B(int, sample_fmt)
 B(int, sample_rate)
 B(int, strict_std_compliance)
+B(int, thread_count)
+B(int, thread_type)
+B(int, active_thread_type)
 B(int, qmax)
 B(int, qmin)
 B(int, width)
@@ -166,11 +169,493 @@ enum AVPacketSideDataType AVPacketSideData_type(AVPacketSideData *a, int idx) {
     return a[idx].type;
 }
 
+/* Packet snapshot layout. Must match PACKET_SNAP in p-avfcbridge.in.js. */
+#define PACKET_SNAPSHOT_VERSION 1
+enum {
+    PACKET_SNAP_VERSION = 0,
+    PACKET_SNAP_SET = 1,
+    PACKET_SNAP_PTS = 2, /* 64-bit */
+    PACKET_SNAP_DTS = 4, /* 64-bit */
+    PACKET_SNAP_DURATION = 6, /* 64-bit */
+    PACKET_SNAP_POS = 8, /* 64-bit */
+    PACKET_SNAP_STREAM_INDEX = 10,
+    PACKET_SNAP_FLAGS = 11,
+    PACKET_SNAP_DATA = 12,
+    PACKET_SNAP_DATA_SIZE = 13,
+    PACKET_SNAP_SIDE_DATA = 14,
+    PACKET_SNAP_SIDE_DATA_ELEMS = 15,
+    PACKET_SNAP_TIME_BASE_NUM = 16,
+    PACKET_SNAP_TIME_BASE_DEN = 17,
+    PACKET_SNAP_SIZE = 18
+};
+
+/* Bits of PACKET_SNAP_SET */
+#define PACKET_SNAP_SET_PTS             0x01
+#define PACKET_SNAP_SET_DTS             0x02
+#define PACKET_SNAP_SET_DURATION        0x04
+#define PACKET_SNAP_SET_STREAM_INDEX    0x08
+#define PACKET_SNAP_SET_FLAGS           0x10
+#define PACKET_SNAP_SET_TIME_BASE_NUM   0x20
+#define PACKET_SNAP_SET_TIME_BASE_DEN   0x40
+
+/* Fill in a snapshot of this packet's metadata and data pointers */
+void ff_packet_snapshot(AVPacket *pkt, int32_t *snap)
+{
+    snap[PACKET_SNAP_VERSION] = PACKET_SNAPSHOT_VERSION;
+    snap[PACKET_SNAP_SET] = 0;
+    SNAP64(snap, PACKET_SNAP_PTS, pkt->pts);
+    SNAP64(snap, PACKET_SNAP_DTS, pkt->dts);
+    SNAP64(snap, PACKET_SNAP_DURATION, pkt->duration);
+    SNAP64(snap, PACKET_SNAP_POS, pkt->pos);
+    snap[PACKET_SNAP_STREAM_INDEX] = pkt->stream_index;
+    snap[PACKET_SNAP_FLAGS] = pkt->flags;
+    snap[PACKET_SNAP_DATA] = (int32_t) (intptr_t) pkt->data;
+    snap[PACKET_SNAP_DATA_SIZE] = pkt->size;
+    snap[PACKET_SNAP_SIDE_DATA] = (int32_t) (intptr_t) pkt->side_data;
+    snap[PACKET_SNAP_SIDE_DATA_ELEMS] = pkt->side_data_elems;
+#if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(59, 4, 100)
+    snap[PACKET_SNAP_TIME_BASE_NUM] = pkt->time_base.num;
+    snap[PACKET_SNAP_TIME_BASE_DEN] = pkt->time_base.den;
+#else
+    snap[PACKET_SNAP_TIME_BASE_NUM] = 1;
+    snap[PACKET_SNAP_TIME_BASE_DEN] = 1000;
+#endif
+}
+
+/* Apply the fields of a snapshot selected by its set mask to this packet. The
+ * data and side data are never applied. */
+void ff_packet_snapshot_apply(AVPacket *pkt, const int32_t *snap)
+{
+    int32_t set = snap[PACKET_SNAP_SET];
+    if (set & PACKET_SNAP_SET_PTS)
+        pkt->pts = UNSNAP64(snap, PACKET_SNAP_PTS);
+    if (set & PACKET_SNAP_SET_DTS)
+        pkt->dts = UNSNAP64(snap, PACKET_SNAP_DTS);
+    if (set & PACKET_SNAP_SET_DURATION)
+        pkt->duration = UNSNAP64(snap, PACKET_SNAP_DURATION);
+    if (set & PACKET_SNAP_SET_STREAM_INDEX)
+        pkt->stream_index = snap[PACKET_SNAP_STREAM_INDEX];
+    if (set & PACKET_SNAP_SET_FLAGS)
+        pkt->flags = snap[PACKET_SNAP_FLAGS];
+#if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(59, 4, 100)
+    if (set & PACKET_SNAP_SET_TIME_BASE_NUM)
+        pkt->time_base.num = snap[PACKET_SNAP_TIME_BASE_NUM];
+    if (set & PACKET_SNAP_SET_TIME_BASE_DEN)
+        pkt->time_base.den = snap[PACKET_SNAP_TIME_BASE_DEN];
+#endif
+}
+
+/* Packet pools (see FFPool in bindings.c) */
+FFPool *ff_packet_pool_alloc(void)
+{
+    return av_mallocz(sizeof(FFPool));
+}
+
+static void ff_packet_pool_freer(void *pkt)
+{
+    av_packet_free((AVPacket **) &pkt);
+}
+
+void ff_packet_pool_free(FFPool *pool)
+{
+    ff_pool_free(pool, ff_packet_pool_freer);
+}
+
+/* Get an empty packet from the pool */
+AVPacket *ff_packet_pool_acquire(FFPool *pool)
+{
+    AVPacket *ret = ff_pool_get(pool);
+    if (!ret) {
+        ret = av_packet_alloc();
+        if (ret)
+            ff_pool_allocated(pool);
+    }
+    return ret;
+}
+
+/* Unreference a packet and return it to the pool */
+void ff_packet_pool_release(FFPool *pool, AVPacket *pkt)
+{
+    av_packet_unref(pkt);
+    if (!ff_pool_put(pool, pkt))
+        av_packet_free(&pkt);
+}
+
+/* Like av_packet_clone, but with the new packet from the pool */
+AVPacket *ff_packet_pool_clone(FFPool *pool, const AVPacket *src)
+{
+    AVPacket *ret = ff_packet_pool_acquire(pool);
+    if (!ret)
+        return NULL;
+    if (av_packet_ref(ret, src) < 0) {
+        ff_packet_pool_release(pool, ret);
+        return NULL;
+    }
+    return ret;
+}
+
+/* Replace this packet's data with an uninitialized buffer of the given size
+ * from the pool. The rest of the packet is left alone. */
+int ff_packet_pool_set_size(FFPool *pool, AVPacket *pkt, int size)
+{
+    AVBufferRef *buf;
+    if (size < 0)
+        return AVERROR(EINVAL);
+    buf = ff_pool_buffer(pool, size + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!buf)
+        return AVERROR(ENOMEM);
+    memset(buf->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    av_buffer_unref(&pkt->buf);
+    pkt->buf = buf;
+    pkt->data = buf->data;
+    pkt->size = size;
+    return 0;
+}
+
+void ff_packet_pool_stats(FFPool *pool, int32_t *stats)
+{
+    ff_pool_stats(pool, stats);
+}
+
+/* Move an input packet of a multi driver into pkt, then release the input
+ * packet to the pool, or free it if there's no pool */
+static void ff_packet_multi_in(FFPool *pool, AVPacket *pkt, AVPacket *in)
+{
+    av_packet_unref(pkt);
+    av_packet_move_ref(pkt, in);
+    if (pool)
+        ff_packet_pool_release(pool, in);
+    else
+        av_packet_free(&in);
+}
+
+/* Release the input packets of a multi driver that it stopped before reaching,
+ * to the pool, or free them if there's no pool */
+static void ff_packet_multi_in_drop(FFPool *pool, AVPacket **in, int nb)
+{
+    int i;
+    for (i = 0; i < nb; i++) {
+        if (pool)
+            ff_packet_pool_release(pool, in[i]);
+        else
+            av_packet_free(&in[i]);
+    }
+}
+
+/* Move pkt into a new packet (from the pool, if given) in a multi driver's
+ * output */
+static int ff_packet_multi_out(FFPool *pool, AVPacket *pkt, FFMultiOutput *out)
+{
+    AVPacket *ret = pool ? ff_packet_pool_acquire(pool) : av_packet_alloc();
+    if (!ret)
+        return AVERROR(ENOMEM);
+    av_packet_move_ref(ret, pkt);
+    if (ff_multi_output_push(out, ret) < 0) {
+        if (pool)
+            ff_packet_pool_release(pool, ret);
+        else
+            av_packet_free(&ret);
+        return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
+/* Codec parameters snapshot layout. Must match CODECPAR_SNAP in
+ * p-avfcbridge.in.js. */
+#define CODECPAR_SNAPSHOT_VERSION 1
+enum {
+    CODECPAR_SNAP_VERSION = 0,
+    CODECPAR_SNAP_SET = 1,
+    CODECPAR_SNAP_BIT_RATE = 2, /* 64-bit */
+    CODECPAR_SNAP_CHANNEL_LAYOUT = 4, /* 64-bit */
+    CODECPAR_SNAP_CODEC_TYPE = 6,
+    CODECPAR_SNAP_CODEC_ID = 7,
+    CODECPAR_SNAP_CODEC_TAG = 8,
+    CODECPAR_SNAP_FORMAT = 9,
+    CODECPAR_SNAP_PROFILE = 10,
+    CODECPAR_SNAP_LEVEL = 11,
+    CODECPAR_SNAP_WIDTH = 12,
+    CODECPAR_SNAP_HEIGHT = 13,
+    CODECPAR_SNAP_COLOR_RANGE = 14,
+    CODECPAR_SNAP_COLOR_PRIMARIES = 15,
+    CODECPAR_SNAP_COLOR_TRC = 16,
+    CODECPAR_SNAP_COLOR_SPACE = 17,
+    CODECPAR_SNAP_CHROMA_LOCATION = 18,
+    CODECPAR_SNAP_SAMPLE_RATE = 19,
+    CODECPAR_SNAP_CHANNELS = 20,
+    CODECPAR_SNAP_EXTRADATA = 21,
+    CODECPAR_SNAP_EXTRADATA_SIZE = 22,
+    CODECPAR_SNAP_CODED_SIDE_DATA = 23,
+    CODECPAR_SNAP_NB_CODED_SIDE_DATA = 24,
+    CODECPAR_SNAP_FRAMERATE_NUM = 25,
+    CODECPAR_SNAP_FRAMERATE_DEN = 26,
+    CODECPAR_SNAP_SIZE = 27
+};
+
+/* Bits of CODECPAR_SNAP_SET */
+#define CODECPAR_SNAP_SET_BIT_RATE          0x00001
+#define CODECPAR_SNAP_SET_CHANNEL_LAYOUT    0x00002
+#define CODECPAR_SNAP_SET_CHANNELS          0x00004
+#define CODECPAR_SNAP_SET_CHROMA_LOCATION   0x00008
+#define CODECPAR_SNAP_SET_CODEC_ID          0x00010
+#define CODECPAR_SNAP_SET_CODEC_TAG         0x00020
+#define CODECPAR_SNAP_SET_CODEC_TYPE        0x00040
+#define CODECPAR_SNAP_SET_COLOR_PRIMARIES   0x00080
+#define CODECPAR_SNAP_SET_COLOR_RANGE       0x00100
+#define CODECPAR_SNAP_SET_COLOR_SPACE       0x00200
+#define CODECPAR_SNAP_SET_COLOR_TRC         0x00400
+#define CODECPAR_SNAP_SET_FORMAT            0x00800
+#define CODECPAR_SNAP_SET_HEIGHT            0x01000
+#define CODECPAR_SNAP_SET_LEVEL             0x02000
+#define CODECPAR_SNAP_SET_PROFILE           0x04000
+#define CODECPAR_SNAP_SET_SAMPLE_RATE       0x08000
+#define CODECPAR_SNAP_SET_WIDTH             0x10000
+#define CODECPAR_SNAP_SET_FRAMERATE         0x20000
+
+/* Fill in a snapshot of these codec parameters */
+void ff_codecpar_snapshot(AVCodecParameters *codecpar, int32_t *snap)
+{
+    snap[CODECPAR_SNAP_VERSION] = CODECPAR_SNAPSHOT_VERSION;
+    snap[CODECPAR_SNAP_SET] = 0;
+    SNAP64(snap, CODECPAR_SNAP_BIT_RATE, codecpar->bit_rate);
+    SNAP64(snap, CODECPAR_SNAP_CHANNEL_LAYOUT, SNAP_CHL_MASK(codecpar));
+    snap[CODECPAR_SNAP_CODEC_TYPE] = codecpar->codec_type;
+    snap[CODECPAR_SNAP_CODEC_ID] = codecpar->codec_id;
+    snap[CODECPAR_SNAP_CODEC_TAG] = (int32_t) codecpar->codec_tag;
+    snap[CODECPAR_SNAP_FORMAT] = codecpar->format;
+    snap[CODECPAR_SNAP_PROFILE] = codecpar->profile;
+    snap[CODECPAR_SNAP_LEVEL] = codecpar->level;
+    snap[CODECPAR_SNAP_WIDTH] = codecpar->width;
+    snap[CODECPAR_SNAP_HEIGHT] = codecpar->height;
+    snap[CODECPAR_SNAP_COLOR_RANGE] = codecpar->color_range;
+    snap[CODECPAR_SNAP_COLOR_PRIMARIES] = codecpar->color_primaries;
+    snap[CODECPAR_SNAP_COLOR_TRC] = codecpar->color_trc;
+    snap[CODECPAR_SNAP_COLOR_SPACE] = codecpar->color_space;
+    snap[CODECPAR_SNAP_CHROMA_LOCATION] = codecpar->chroma_location;
+    snap[CODECPAR_SNAP_SAMPLE_RATE] = codecpar->sample_rate;
+    snap[CODECPAR_SNAP_CHANNELS] = SNAP_CHL_CHANNELS(codecpar);
+    snap[CODECPAR_SNAP_EXTRADATA] = (int32_t) (intptr_t) codecpar->extradata;
+    snap[CODECPAR_SNAP_EXTRADATA_SIZE] = codecpar->extradata_size;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(60, 30, 100)
+    snap[CODECPAR_SNAP_CODED_SIDE_DATA] =
+        (int32_t) (intptr_t) codecpar->coded_side_data;
+    snap[CODECPAR_SNAP_NB_CODED_SIDE_DATA] = codecpar->nb_coded_side_data;
+#else
+    snap[CODECPAR_SNAP_CODED_SIDE_DATA] = 0;
+    snap[CODECPAR_SNAP_NB_CODED_SIDE_DATA] = 0;
+#endif
+#if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(60, 10, 100)
+    snap[CODECPAR_SNAP_FRAMERATE_NUM] = codecpar->framerate.num;
+    snap[CODECPAR_SNAP_FRAMERATE_DEN] = codecpar->framerate.den;
+#else
+    snap[CODECPAR_SNAP_FRAMERATE_NUM] = 60;
+    snap[CODECPAR_SNAP_FRAMERATE_DEN] = 1;
+#endif
+}
+
+/* Apply the fields of a snapshot selected by its set mask to these codec
+ * parameters. Extradata and side data are never applied. */
+void ff_codecpar_snapshot_apply(
+    AVCodecParameters *codecpar, const int32_t *snap
+) {
+    int32_t set = snap[CODECPAR_SNAP_SET];
+    if (set & CODECPAR_SNAP_SET_BIT_RATE)
+        codecpar->bit_rate = UNSNAP64(snap, CODECPAR_SNAP_BIT_RATE);
+    if (set & CODECPAR_SNAP_SET_CHANNEL_LAYOUT) {
+        SNAP_CHL_MASK_S(codecpar,
+            UNSNAP64(snap, CODECPAR_SNAP_CHANNEL_LAYOUT));
+    }
+    if (set & CODECPAR_SNAP_SET_CHANNELS)
+        SNAP_CHL_CHANNELS(codecpar) = snap[CODECPAR_SNAP_CHANNELS];
+    if (set & CODECPAR_SNAP_SET_CHROMA_LOCATION)
+        codecpar->chroma_location = snap[CODECPAR_SNAP_CHROMA_LOCATION];
+    if (set & CODECPAR_SNAP_SET_CODEC_ID)
+        codecpar->codec_id = snap[CODECPAR_SNAP_CODEC_ID];
+    if (set & CODECPAR_SNAP_SET_CODEC_TAG)
+        codecpar->codec_tag = (uint32_t) snap[CODECPAR_SNAP_CODEC_TAG];
+    if (set & CODECPAR_SNAP_SET_CODEC_TYPE)
+        codecpar->codec_type = snap[CODECPAR_SNAP_CODEC_TYPE];
+    if (set & CODECPAR_SNAP_SET_COLOR_PRIMARIES)
+        codecpar->color_primaries = snap[CODECPAR_SNAP_COLOR_PRIMARIES];
+    if (set & CODECPAR_SNAP_SET_COLOR_RANGE)
+        codecpar->color_range = snap[CODECPAR_SNAP_COLOR_RANGE];
+    if (set & CODECPAR_SNAP_SET_COLOR_SPACE)
+        codecpar->color_space = snap[CODECPAR_SNAP_COLOR_SPACE];
+    if (set & CODECPAR_SNAP_SET_COLOR_TRC)
+        codecpar->color_trc = snap[CODECPAR_SNAP_COLOR_TRC];
+    if (set & CODECPAR_SNAP_SET_FORMAT)
+        codecpar->format = snap[CODECPAR_SNAP_FORMAT];
+    if (set & CODECPAR_SNAP_SET_HEIGHT)
+        codecpar->height = snap[CODECPAR_SNAP_HEIGHT];
+    if (set & CODECPAR_SNAP_SET_LEVEL)
+        codecpar->level = snap[CODECPAR_SNAP_LEVEL];
+    if (set & CODECPAR_SNAP_SET_PROFILE)
+        codecpar->profile = snap[CODECPAR_SNAP_PROFILE];
+    if (set & CODECPAR_SNAP_SET_SAMPLE_RATE)
+        codecpar->sample_rate = snap[CODECPAR_SNAP_SAMPLE_RATE];
+    if (set & CODECPAR_SNAP_SET_WIDTH)
+        codecpar->width = snap[CODECPAR_SNAP_WIDTH];
+#if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(60, 10, 100)
+    if (set & CODECPAR_SNAP_SET_FRAMERATE) {
+        codecpar->framerate.num = snap[CODECPAR_SNAP_FRAMERATE_NUM];
+        codecpar->framerate.den = snap[CODECPAR_SNAP_FRAMERATE_DEN];
+    }
+#endif
+}
+
 #if LIBAVJS_FULL_AVCODEC
 int avcodec_open2_js(
     AVCodecContext *avctx, const AVCodec *codec, AVDictionary *options
 ) {
-    return avcodec_open2(avctx, codec, &options);
+    int ret = avcodec_open2(avctx, codec, &options);
+    // Anything left over was not used
+    av_dict_free(&options);
+    return ret;
+}
+
+/* Most threads to use by default. Frame threading adds a frame of delay per
+ * thread, so more than this is rarely worth it. */
+#define FF_MAX_AUTO_THREADS 16
+
+/* Number of threads to decode with by default (see ff_init_decoder). In the
+ * threaded build, video decoders that support threading of any kind (frame and
+ * slice threading for FFmpeg's own, such as H.264, HEVC, and VP9, and their
+ * own threads for libaom and dav1d) get one per core. Everything else gets
+ * one, since audio decoders gain nothing from threads, and without real
+ * threads, neither does anything else. */
+int ff_decoder_auto_threads(const AVCodec *codec)
+{
+#ifdef __EMSCRIPTEN_PTHREADS__
+    int cores = emscripten_num_logical_cores();
+    if (codec->type != AVMEDIA_TYPE_VIDEO ||
+        !(codec->capabilities & (AV_CODEC_CAP_FRAME_THREADS |
+                                 AV_CODEC_CAP_SLICE_THREADS |
+                                 AV_CODEC_CAP_OTHER_THREADS)))
+        return 1;
+    if (cores > FF_MAX_AUTO_THREADS)
+        cores = FF_MAX_AUTO_THREADS;
+    return (cores > 1) ? cores : 1;
+#else
+    return 1;
+#endif
+}
+
+/* Native driver for ff_encode_multi. Encodes the nb_in frames in, taking
+ * ownership of them (releasing them to in_pool if given), and puts the
+ * resulting packets (from out_pool if given) in out. status gets the result of
+ * sending each input frame, plus that of the final flush if FF_MULTI_FIN is
+ * set. Returns 0, or the error that stopped encoding. */
+int ff_encode_multi_c(
+    AVCodecContext *ctx, AVFrame *frame, AVPacket *pkt,
+    AVFrame **in, int nb_in, int32_t *status, int flags,
+    FFPool *in_pool, FFPool *out_pool, FFMultiOutput *out
+) {
+    int i, ret;
+
+    for (i = 0; i <= nb_in; i++) {
+        if (i < nb_in) {
+            ff_frame_multi_in(in_pool, frame, in[i]);
+#if LIBAVUTIL_VERSION_INT > AV_VERSION_INT(57, 10, 101)
+            if (ctx->time_base.num && frame->time_base.num) {
+                if (frame->pts != AV_NOPTS_VALUE) {
+                    frame->pts = av_rescale_q(
+                        frame->pts, frame->time_base, ctx->time_base);
+                }
+                frame->time_base = ctx->time_base;
+            }
+#endif
+            ret = avcodec_send_frame(ctx, frame);
+            av_frame_unref(frame);
+        } else if (flags & FF_MULTI_FIN) {
+            ret = avcodec_send_frame(ctx, NULL);
+        } else {
+            break;
+        }
+        status[i] = ret;
+        if (ret < 0)
+            goto fail;
+
+        while (1) {
+            ret = avcodec_receive_packet(ctx, pkt);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                break;
+            else if (ret < 0)
+                goto fail;
+#if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(59, 4, 100)
+            if (!pkt->time_base.num)
+                pkt->time_base = ctx->time_base;
+#endif
+            ret = ff_packet_multi_out(out_pool, pkt, out);
+            if (ret < 0)
+                goto fail;
+        }
+    }
+
+    return 0;
+
+fail:
+    // Release the inputs not yet reached
+    if (i + 1 < nb_in)
+        ff_frame_multi_in_drop(in_pool, in + i + 1, nb_in - i - 1);
+    return ret;
+}
+
+/* Native driver for ff_decode_multi. Like ff_encode_multi_c, but decoding
+ * packets to frames. With FF_MULTI_IGNORE_ERRORS, packets that the decoder
+ * rejects are skipped (their status still says why). */
+int ff_decode_multi_c(
+    AVCodecContext *ctx, AVPacket *pkt, AVFrame *frame,
+    AVPacket **in, int nb_in, int32_t *status, int flags,
+    FFPool *in_pool, FFPool *out_pool, FFMultiOutput *out
+) {
+    int i, ret;
+
+    for (i = 0; i <= nb_in; i++) {
+        if (i < nb_in) {
+            ff_packet_multi_in(in_pool, pkt, in[i]);
+#if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(59, 4, 100)
+            if (ctx->time_base.num && pkt->time_base.num) {
+                av_packet_rescale_ts(pkt, pkt->time_base, ctx->time_base);
+                pkt->time_base = ctx->time_base;
+            }
+#endif
+        } else if (flags & FF_MULTI_FIN) {
+            av_packet_unref(pkt);
+        } else {
+            break;
+        }
+        ret = avcodec_send_packet(ctx, pkt);
+        av_packet_unref(pkt);
+        status[i] = ret;
+        if (ret < 0) {
+            if (flags & FF_MULTI_IGNORE_ERRORS)
+                continue;
+            goto fail;
+        }
+
+        while (1) {
+            ret = avcodec_receive_frame(ctx, frame);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                break;
+            else if (ret < 0)
+                goto fail;
+#if LIBAVUTIL_VERSION_INT > AV_VERSION_INT(57, 10, 101)
+            if (!frame->time_base.num)
+                frame->time_base = ctx->time_base;
+#endif
+            ret = ff_frame_multi_out(out_pool, frame, out);
+            if (ret < 0)
+                goto fail;
+        }
+    }
+
+    return 0;
+
+fail:
+    // Release the inputs not yet reached
+    if (i + 1 < nb_in)
+        ff_packet_multi_in_drop(in_pool, in + i + 1, nb_in - i - 1);
+    return ret;
 }
 #endif
 
@@ -47,6 +47,58 @@ int ff_buffersink_set_ch_layout(AVFilterContext *ctx, unsigned int layoutlo, uns
 }
 #endif
 
+/* Native driver for ff_filter_multi, for one source. Like ff_encode_multi_c
+ * (b-avcodec.c), but filtering frames. Unless FF_MULTI_IGNORE_SINK_TIMEBASE is
+ * set, output frames are given the time base of the buffer sink. */
+int ff_filter_multi_c(
+    AVFilterContext *buffersrc_ctx, AVFilterContext *buffersink_ctx,
+    AVFrame *frame, AVFrame **in, int nb_in, int32_t *status, int flags,
+    FFPool *in_pool, FFPool *out_pool, FFMultiOutput *out
+) {
+    int i, ret;
+    AVRational tb = av_buffersink_get_time_base(buffersink_ctx);
+
+    for (i = 0; i <= nb_in; i++) {
+        if (i < nb_in) {
+            ff_frame_multi_in(in_pool, frame, in[i]);
+            ret = av_buffersrc_add_frame_flags(
+                buffersrc_ctx, frame, AV_BUFFERSRC_FLAG_KEEP_REF);
+        } else if (flags & FF_MULTI_FIN) {
+            ret = av_buffersrc_add_frame_flags(
+                buffersrc_ctx, NULL, AV_BUFFERSRC_FLAG_KEEP_REF);
+        } else {
+            break;
+        }
+        av_frame_unref(frame);
+        status[i] = ret;
+        if (ret < 0)
+            goto fail;
+
+        while (1) {
+            ret = av_buffersink_get_frame(buffersink_ctx, frame);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                break;
+            else if (ret < 0)
+                goto fail;
+#if LIBAVUTIL_VERSION_INT > AV_VERSION_INT(57, 10, 101)
+            if (tb.num && !(flags & FF_MULTI_IGNORE_SINK_TIMEBASE))
+                frame->time_base = tb;
+#endif
+            ret = ff_frame_multi_out(out_pool, frame, out);
+            if (ret < 0)
+                goto fail;
+        }
+    }
+
+    return 0;
+
+fail:
+    // Release the inputs not yet reached
+    if (i + 1 < nb_in)
+        ff_frame_multi_in_drop(in_pool, in + i + 1, nb_in - i - 1);
+    return ret;
+}
+
 AVFilterContext *avfilter_graph_create_filter_js(const AVFilter *filt,
     const char *name, const char *args, void *opaque, AVFilterGraph *graph_ctx)
 {
@@ -43,6 +43,47 @@ B(AVDictionary *, metadata)
 
 RAT(AVStream, time_base)
 
+/* AVOutputFormat */
+A(AVOutputFormat, int, flags)
+
+/* Stream snapshot layout. Must match STREAM_SNAP in p-avformat.in.js. */
+#define STREAM_SNAPSHOT_VERSION 1
+enum {
+    STREAM_SNAP_VERSION = 0,
+    STREAM_SNAP_SET = 1, /* Unused, streams are only snapshotted */
+    STREAM_SNAP_DURATION = 2, /* 64-bit */
+    STREAM_SNAP_START_TIME = 4, /* 64-bit */
+    STREAM_SNAP_NB_FRAMES = 6, /* 64-bit */
+    STREAM_SNAP_INDEX = 8,
+    STREAM_SNAP_CODECPAR = 9,
+    STREAM_SNAP_CODEC_TYPE = 10,
+    STREAM_SNAP_CODEC_ID = 11,
+    STREAM_SNAP_TIME_BASE_NUM = 12,
+    STREAM_SNAP_TIME_BASE_DEN = 13,
+    STREAM_SNAP_DISCARD = 14,
+    STREAM_SNAP_METADATA = 15,
+    STREAM_SNAP_SIZE = 16
+};
+
+/* Fill in a snapshot of this stream, including the most commonly used fields
+ * of its codec parameters */
+void ff_stream_snapshot(AVStream *st, int32_t *snap)
+{
+    snap[STREAM_SNAP_VERSION] = STREAM_SNAPSHOT_VERSION;
+    snap[STREAM_SNAP_SET] = 0;
+    SNAP64(snap, STREAM_SNAP_DURATION, st->duration);
+    SNAP64(snap, STREAM_SNAP_START_TIME, st->start_time);
+    SNAP64(snap, STREAM_SNAP_NB_FRAMES, st->nb_frames);
+    snap[STREAM_SNAP_INDEX] = st->index;
+    snap[STREAM_SNAP_CODECPAR] = (int32_t) (intptr_t) st->codecpar;
+    snap[STREAM_SNAP_CODEC_TYPE] = st->codecpar->codec_type;
+    snap[STREAM_SNAP_CODEC_ID] = st->codecpar->codec_id;
+    snap[STREAM_SNAP_TIME_BASE_NUM] = st->time_base.num;
+    snap[STREAM_SNAP_TIME_BASE_DEN] = st->time_base.den;
+    snap[STREAM_SNAP_DISCARD] = st->discard;
+    snap[STREAM_SNAP_METADATA] = (int32_t) (intptr_t) st->metadata;
+}
+
 /* AVChapter */
 #define B(type, field) A(AVChapter, type, field)
 #define BL(type, field) AL(AVChapter, type, field)
@@ -91,6 +132,10 @@ AVFormatContext *avformat_open_input_js(const char *url, AVInputFormat *fmt,
     int err = avformat_open_input(&ret, url, fmt, options_p);
     if (err < 0)
         fprintf(stderr, "[avformat_open_input_js] %s\n", av_err2str(err));
+    /* On success, avformat_open_input has already freed the caller's
+     * dictionary and replaced it with the unused options, which nobody else
+     * can reach, so the dictionary is consumed either way */
+    av_dict_free(options_p);
     return ret;
 }
 
@@ -105,6 +150,258 @@ AVIOContext *avio_open2_js(const char *url, int flags,
     return ret;
 }
 
+/* Seek index: the keyframes of each stream, sorted by timestamp, with their
+ * byte positions. Built as packets are read (ff_read_frame_multi's seekIndex
+ * option) or by reading the whole file (ff_seek_index_scan), and exported and
+ * imported by JavaScript, so it can outlive the demuxer. */
+typedef struct FFSeekIndexEntry {
+    int64_t ts, pos;
+} FFSeekIndexEntry;
+
+typedef struct FFSeekIndexStream {
+    FFSeekIndexEntry *entries;
+    int nb_entries, size;
+} FFSeekIndexStream;
+
+typedef struct FFSeekIndex {
+    FFSeekIndexStream *streams;
+    int nb_streams;
+} FFSeekIndex;
+
+FFSeekIndex *ff_seek_index_alloc(void)
+{
+    return av_mallocz(sizeof(FFSeekIndex));
+}
+
+void ff_seek_index_free(FFSeekIndex *index)
+{
+    int i;
+    for (i = 0; i < index->nb_streams; i++)
+        av_free(index->streams[i].entries);
+    av_free(index->streams);
+    av_free(index);
+}
+
+int ff_seek_index_nb_streams(FFSeekIndex *index)
+{
+    return index->nb_streams;
+}
+
+int ff_seek_index_nb_entries(FFSeekIndex *index, int stream_index)
+{
+    if (stream_index < 0 || stream_index >= index->nb_streams)
+        return 0;
+    return index->streams[stream_index].nb_entries;
+}
+
+/* The last entry at or before ts, or -1 */
+static int ff_seek_index_search(FFSeekIndexStream *st, int64_t ts)
+{
+    int lo = 0, hi = st->nb_entries;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (st->entries[mid].ts <= ts)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo - 1;
+}
+
+int ff_seek_index_add(
+    FFSeekIndex *index, int stream_index, int64_t ts, int64_t pos
+) {
+    FFSeekIndexStream *st;
+    int i;
+
+    if (stream_index < 0)
+        return AVERROR(EINVAL);
+    if (stream_index >= index->nb_streams) {
+        FFSeekIndexStream *streams = av_realloc_array(
+            index->streams, stream_index + 1, sizeof(FFSeekIndexStream));
+        if (!streams)
+            return AVERROR(ENOMEM);
+        memset(streams + index->nb_streams, 0,
+            (stream_index + 1 - index->nb_streams) * sizeof(FFSeekIndexStream));
+        index->streams = streams;
+        index->nb_streams = stream_index + 1;
+    }
+    st = &index->streams[stream_index];
+
+    // Usually an append, as packets are read in order
+    i = ff_seek_index_search(st, ts);
+    if (i >= 0 && st->entries[i].ts == ts) {
+        st->entries[i].pos = pos;
+        return 0;
+    }
+    if (st->nb_entries >= st->size) {
+        int size = st->size ? st->size * 2 : 64;
+        FFSeekIndexEntry *entries = av_realloc_array(
+            st->entries, size, sizeof(FFSeekIndexEntry));
+        if (!entries)
+            return AVERROR(ENOMEM);
+        st->entries = entries;
+        st->size = size;
+    }
+    i++;
+    memmove(st->entries + i + 1, st->entries + i,
+        (st->nb_entries - i) * sizeof(FFSeekIndexEntry));
+    st->entries[i].ts = ts;
+    st->entries[i].pos = pos;
+    st->nb_entries++;
+    return 0;
+}
+
+/* Add this packet to the index, if it's a keyframe with a known position. The
+ * timestamp is the decoding timestamp, as av_add_index_entry and seeking by
+ * timestamp expect, or the presentation timestamp if there's no DTS. */
+static int ff_seek_index_add_packet(FFSeekIndex *index, AVPacket *pkt)
+{
+    int64_t ts = (pkt->dts != AV_NOPTS_VALUE) ? pkt->dts : pkt->pts;
+    if (!(pkt->flags & AV_PKT_FLAG_KEY) || pkt->pos < 0 ||
+        ts == AV_NOPTS_VALUE)
+        return 0;
+    return ff_seek_index_add(index, pkt->stream_index, ts, pkt->pos);
+}
+
+/* Get or set (by adding) the entries for a stream, as pairs of (timestamp,
+ * position), each as low and high 32-bit words, for JavaScript */
+void ff_seek_index_get_js(FFSeekIndex *index, int stream_index, int32_t *out)
+{
+    FFSeekIndexStream *st;
+    int i;
+    if (stream_index < 0 || stream_index >= index->nb_streams)
+        return;
+    st = &index->streams[stream_index];
+    for (i = 0; i < st->nb_entries; i++) {
+        FFSeekIndexEntry *e = &st->entries[i];
+        *out++ = (int32_t) e->ts;
+        *out++ = (int32_t) (e->ts >> 32);
+        *out++ = (int32_t) e->pos;
+        *out++ = (int32_t) (e->pos >> 32);
+    }
+}
+
+int ff_seek_index_set_js(
+    FFSeekIndex *index, int stream_index, int32_t *in, int nb_entries
+) {
+    int i, ret;
+    for (i = 0; i < nb_entries; i++, in += 4) {
+        ret = ff_seek_index_add(index, stream_index,
+            (int64_t) (((uint64_t) (uint32_t) in[1] << 32) | (uint32_t) in[0]),
+            (int64_t) (((uint64_t) (uint32_t) in[3] << 32) | (uint32_t) in[2]));
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+/* Add the index to libavformat's own per-stream index, for formats that build
+ * theirs generically from packet positions, so that their own seeking (and
+ * that of the avformat_seek_file wrappers) uses it. Other formats' indexes
+ * mean something else (e.g. MP4's sample tables), so they're left alone. */
+void ff_seek_index_apply(FFSeekIndex *index, AVFormatContext *fmt_ctx)
+{
+    int si, i;
+    if (!(fmt_ctx->iformat->flags & AVFMT_GENERIC_INDEX))
+        return;
+    for (si = 0; si < index->nb_streams && si < fmt_ctx->nb_streams; si++) {
+        FFSeekIndexStream *st = &index->streams[si];
+        for (i = 0; i < st->nb_entries; i++) {
+            av_add_index_entry(fmt_ctx->streams[si], st->entries[i].pos,
+                st->entries[i].ts, 0, 0, AVINDEX_KEYFRAME);
+        }
+    }
+}
+
+/* Seek to the last indexed keyframe at or before ts in this stream. Formats
+ * that resync from any byte (by the same test ffplay uses to decide to seek by
+ * bytes) jump straight to its position, so the seek itself reads nothing.
+ * Others seek to its timestamp, which ff_seek_index_apply may have made
+ * cheaper. With nothing indexed, this is av_seek_frame. */
+int ff_seek_index_seek(
+    FFSeekIndex *index, AVFormatContext *fmt_ctx, int stream_index,
+    int64_t ts, int flags
+) {
+    const AVInputFormat *ifmt = fmt_ctx->iformat;
+    FFSeekIndexEntry *e;
+    int i = -1;
+
+    if (stream_index < 0 || stream_index >= fmt_ctx->nb_streams)
+        return AVERROR(EINVAL);
+    if (stream_index < index->nb_streams)
+        i = ff_seek_index_search(&index->streams[stream_index], ts);
+    if (i < 0)
+        return av_seek_frame(fmt_ctx, stream_index, ts, flags | AVSEEK_FLAG_BACKWARD);
+    e = &index->streams[stream_index].entries[i];
+
+    if (!(ifmt->flags & AVFMT_NO_BYTE_SEEK) &&
+        (ifmt->flags & AVFMT_TS_DISCONT) &&
+        strcmp(ifmt->name, "ogg"))
+        return av_seek_frame(fmt_ctx, stream_index, e->pos, AVSEEK_FLAG_BYTE);
+
+    return av_seek_frame(fmt_ctx, stream_index, e->ts, flags | AVSEEK_FLAG_BACKWARD);
+}
+
+/* Read the whole file into the index, then seek back to the start. pkt is only
+ * used for reading. */
+int ff_seek_index_scan(
+    FFSeekIndex *index, AVFormatContext *fmt_ctx, AVPacket *pkt
+) {
+    int ret;
+    while ((ret = av_read_frame(fmt_ctx, pkt)) >= 0) {
+        ret = ff_seek_index_add_packet(index, pkt);
+        av_packet_unref(pkt);
+        if (ret < 0)
+            return ret;
+    }
+    if (ret != AVERROR_EOF)
+        return ret;
+    return av_seek_frame(fmt_ctx, -1,
+        (fmt_ctx->start_time != AV_NOPTS_VALUE) ? fmt_ctx->start_time : 0,
+        AVSEEK_FLAG_BACKWARD);
+}
+
+/* Native driver for ff_read_frame_multi. Reads packets into out (from the pool,
+ * if given), adding keyframes to the seek index (if given), filling in the
+ * stream's time base if the demuxer didn't set one, until limit bytes have
+ * been read (if limit is nonzero) or av_read_frame fails. Returns
+ * av_read_frame's error, or AVERROR(EAGAIN) at the limit. The whole loop is
+ * native, so the only asynchrony is a reader actually waiting for data
+ * (libavjs_wait_reader). */
+int ff_read_frame_multi_c(
+    AVFormatContext *fmt_ctx, AVPacket *pkt, int limit, FFPool *out_pool,
+    FFMultiOutput *out, FFSeekIndex *index
+) {
+    int64_t sz = 0;
+    int ret;
+
+    while (1) {
+        ret = av_read_frame(fmt_ctx, pkt);
+        if (ret < 0)
+            return ret;
+#if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(59, 4, 100)
+        if (!pkt->time_base.num)
+            pkt->time_base = fmt_ctx->streams[pkt->stream_index]->time_base;
+#endif
+        if (index) {
+            ret = ff_seek_index_add_packet(index, pkt);
+            if (ret < 0) {
+                av_packet_unref(pkt);
+                return ret;
+            }
+        }
+        sz += pkt->size;
+        ret = ff_packet_multi_out(out_pool, pkt, out);
+        if (ret < 0) {
+            av_packet_unref(pkt);
+            return ret;
+        }
+        if (limit && sz >= limit)
+            return AVERROR(EAGAIN);
+    }
+}
+
 static const int LIBAVFORMAT_VERSION_INT_V = LIBAVFORMAT_VERSION_INT;
 #undef LIBAVFORMAT_VERSION_INT
 int LIBAVFORMAT_VERSION_INT() { return LIBAVFORMAT_VERSION_INT_V; }
@@ -82,6 +82,335 @@ void ff_frame_rescale_ts_js(
         frame->pts = av_rescale_q(frame->pts, tb_src, tb_dst);
 }
 
+/* Frame snapshot layout. Must match FRAME_SNAP in p-avframe.in.js. */
+#define FRAME_SNAPSHOT_VERSION 1
+enum {
+    FRAME_SNAP_VERSION = 0,
+    FRAME_SNAP_SET = 1,
+    FRAME_SNAP_PTS = 2, /* 64-bit */
+    FRAME_SNAP_BEST_EFFORT_TIMESTAMP = 4, /* 64-bit */
+    FRAME_SNAP_DURATION = 6, /* 64-bit */
+    FRAME_SNAP_CHANNEL_LAYOUT = 8, /* 64-bit */
+    FRAME_SNAP_FORMAT = 10,
+    FRAME_SNAP_TIME_BASE_NUM = 11,
+    FRAME_SNAP_TIME_BASE_DEN = 12,
+    FRAME_SNAP_NB_SAMPLES = 13,
+    FRAME_SNAP_SAMPLE_RATE = 14,
+    FRAME_SNAP_CHANNELS = 15,
+    FRAME_SNAP_WIDTH = 16,
+    FRAME_SNAP_HEIGHT = 17,
+    FRAME_SNAP_CROP_TOP = 18,
+    FRAME_SNAP_CROP_BOTTOM = 19,
+    FRAME_SNAP_CROP_LEFT = 20,
+    FRAME_SNAP_CROP_RIGHT = 21,
+    FRAME_SNAP_FLAGS = 22,
+    FRAME_SNAP_KEY_FRAME = 23,
+    FRAME_SNAP_PICT_TYPE = 24,
+    FRAME_SNAP_SAR_NUM = 25,
+    FRAME_SNAP_SAR_DEN = 26,
+    FRAME_SNAP_LOG2_CHROMA_W = 27,
+    FRAME_SNAP_LOG2_CHROMA_H = 28,
+    FRAME_SNAP_NB_COMPONENTS = 29,
+    FRAME_SNAP_PIXDESC_FLAGS = 30,
+    FRAME_SNAP_DATA = 32, /* AV_NUM_DATA_POINTERS slots */
+    FRAME_SNAP_LINESIZE = 40, /* AV_NUM_DATA_POINTERS slots */
+    FRAME_SNAP_SIZE = 48
+};
+
+/* Bits of FRAME_SNAP_SET */
+#define FRAME_SNAP_SET_CHANNEL_LAYOUT   0x0001
+#define FRAME_SNAP_SET_CHANNELS         0x0002
+#define FRAME_SNAP_SET_FORMAT           0x0004
+#define FRAME_SNAP_SET_KEY_FRAME        0x0008
+#define FRAME_SNAP_SET_FLAGS            0x0010
+#define FRAME_SNAP_SET_PICT_TYPE        0x0020
+#define FRAME_SNAP_SET_PTS              0x0040
+#define FRAME_SNAP_SET_BEST_EFFORT      0x0080
+#define FRAME_SNAP_SET_TIME_BASE_NUM    0x0100
+#define FRAME_SNAP_SET_TIME_BASE_DEN    0x0200
+#define FRAME_SNAP_SET_NB_SAMPLES       0x0400
+#define FRAME_SNAP_SET_SAMPLE_RATE      0x0800
+#define FRAME_SNAP_SET_WIDTH            0x1000
+#define FRAME_SNAP_SET_HEIGHT           0x2000
+#define FRAME_SNAP_SET_SAR              0x4000
+#define FRAME_SNAP_SET_CROP             0x8000
+#define FRAME_SNAP_SET_DURATION         0x10000
+
+/* Fill in a snapshot of all of this frame's metadata (and its data pointers).
+ * The pixel format descriptor is included for video frames. */
+void ff_frame_snapshot(AVFrame *frame, int32_t *snap)
+{
+    const AVPixFmtDescriptor *desc = NULL;
+    int i;
+
+    snap[FRAME_SNAP_VERSION] = FRAME_SNAPSHOT_VERSION;
+    snap[FRAME_SNAP_SET] = 0;
+    SNAP64(snap, FRAME_SNAP_PTS, frame->pts);
+    SNAP64(snap, FRAME_SNAP_BEST_EFFORT_TIMESTAMP,
+        frame->best_effort_timestamp);
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 30, 100)
+    SNAP64(snap, FRAME_SNAP_DURATION, frame->duration);
+#else
+    SNAP64(snap, FRAME_SNAP_DURATION, frame->pkt_duration);
+#endif
+    SNAP64(snap, FRAME_SNAP_CHANNEL_LAYOUT, SNAP_CHL_MASK(frame));
+    snap[FRAME_SNAP_FORMAT] = frame->format;
+#if LIBAVUTIL_VERSION_INT > AV_VERSION_INT(57, 10, 101)
+    snap[FRAME_SNAP_TIME_BASE_NUM] = frame->time_base.num;
+    snap[FRAME_SNAP_TIME_BASE_DEN] = frame->time_base.den;
+#else
+    snap[FRAME_SNAP_TIME_BASE_NUM] = 1;
+    snap[FRAME_SNAP_TIME_BASE_DEN] = 1000;
+#endif
+    snap[FRAME_SNAP_NB_SAMPLES] = frame->nb_samples;
+    snap[FRAME_SNAP_SAMPLE_RATE] = frame->sample_rate;
+    snap[FRAME_SNAP_CHANNELS] = SNAP_CHL_CHANNELS(frame);
+    snap[FRAME_SNAP_WIDTH] = frame->width;
+    snap[FRAME_SNAP_HEIGHT] = frame->height;
+    snap[FRAME_SNAP_CROP_TOP] = frame->crop_top;
+    snap[FRAME_SNAP_CROP_BOTTOM] = frame->crop_bottom;
+    snap[FRAME_SNAP_CROP_LEFT] = frame->crop_left;
+    snap[FRAME_SNAP_CROP_RIGHT] = frame->crop_right;
+    snap[FRAME_SNAP_FLAGS] = frame->flags;
+#ifdef AV_FRAME_FLAG_KEY
+    snap[FRAME_SNAP_KEY_FRAME] = !!(frame->flags & AV_FRAME_FLAG_KEY);
+#else
+    snap[FRAME_SNAP_KEY_FRAME] = frame->key_frame;
+#endif
+    snap[FRAME_SNAP_PICT_TYPE] = frame->pict_type;
+    snap[FRAME_SNAP_SAR_NUM] = frame->sample_aspect_ratio.num;
+    snap[FRAME_SNAP_SAR_DEN] = frame->sample_aspect_ratio.den;
+
+    if (frame->width && frame->format >= 0)
+        desc = av_pix_fmt_desc_get(frame->format);
+    if (desc) {
+        snap[FRAME_SNAP_LOG2_CHROMA_W] = desc->log2_chroma_w;
+        snap[FRAME_SNAP_LOG2_CHROMA_H] = desc->log2_chroma_h;
+        snap[FRAME_SNAP_NB_COMPONENTS] = desc->nb_components;
+        snap[FRAME_SNAP_PIXDESC_FLAGS] = (int32_t) desc->flags;
+    } else {
+        snap[FRAME_SNAP_LOG2_CHROMA_W] =
+            snap[FRAME_SNAP_LOG2_CHROMA_H] =
+            snap[FRAME_SNAP_NB_COMPONENTS] =
+            snap[FRAME_SNAP_PIXDESC_FLAGS] = 0;
+    }
+
+    for (i = 0; i < AV_NUM_DATA_POINTERS; i++) {
+        snap[FRAME_SNAP_DATA + i] = (int32_t) (intptr_t) frame->data[i];
+        snap[FRAME_SNAP_LINESIZE + i] = frame->linesize[i];
+    }
+}
+
+/* Apply the fields of a snapshot selected by its set mask to this frame. The
+ * data pointers are never applied. */
+void ff_frame_snapshot_apply(AVFrame *frame, const int32_t *snap)
+{
+    int32_t set = snap[FRAME_SNAP_SET];
+
+    if (set & FRAME_SNAP_SET_CHANNEL_LAYOUT)
+        SNAP_CHL_MASK_S(frame, UNSNAP64(snap, FRAME_SNAP_CHANNEL_LAYOUT));
+    if (set & FRAME_SNAP_SET_CHANNELS)
+        SNAP_CHL_CHANNELS(frame) = snap[FRAME_SNAP_CHANNELS];
+    if (set & FRAME_SNAP_SET_FORMAT)
+        frame->format = snap[FRAME_SNAP_FORMAT];
+    if (set & FRAME_SNAP_SET_KEY_FRAME) {
+#ifdef AV_FRAME_FLAG_KEY
+        frame->flags = (frame->flags & ~AV_FRAME_FLAG_KEY) |
+            (snap[FRAME_SNAP_KEY_FRAME] ? AV_FRAME_FLAG_KEY : 0);
+#else
+        frame->key_frame = snap[FRAME_SNAP_KEY_FRAME];
+#endif
+    }
+    if (set & FRAME_SNAP_SET_FLAGS)
+        frame->flags = snap[FRAME_SNAP_FLAGS];
+    if (set & FRAME_SNAP_SET_PICT_TYPE)
+        frame->pict_type = snap[FRAME_SNAP_PICT_TYPE];
+    if (set & FRAME_SNAP_SET_PTS)
+        frame->pts = UNSNAP64(snap, FRAME_SNAP_PTS);
+    if (set & FRAME_SNAP_SET_BEST_EFFORT) {
+        frame->best_effort_timestamp =
+            UNSNAP64(snap, FRAME_SNAP_BEST_EFFORT_TIMESTAMP);
+    }
+    if (set & FRAME_SNAP_SET_DURATION) {
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 30, 100)
+        frame->duration = UNSNAP64(snap, FRAME_SNAP_DURATION);
+#else
+        frame->pkt_duration = UNSNAP64(snap, FRAME_SNAP_DURATION);
+#endif
+    }
+#if LIBAVUTIL_VERSION_INT > AV_VERSION_INT(57, 10, 101)
+    if (set & FRAME_SNAP_SET_TIME_BASE_NUM)
+        frame->time_base.num = snap[FRAME_SNAP_TIME_BASE_NUM];
+    if (set & FRAME_SNAP_SET_TIME_BASE_DEN)
+        frame->time_base.den = snap[FRAME_SNAP_TIME_BASE_DEN];
+#endif
+    if (set & FRAME_SNAP_SET_NB_SAMPLES)
+        frame->nb_samples = snap[FRAME_SNAP_NB_SAMPLES];
+    if (set & FRAME_SNAP_SET_SAMPLE_RATE)
+        frame->sample_rate = snap[FRAME_SNAP_SAMPLE_RATE];
+    if (set & FRAME_SNAP_SET_WIDTH)
+        frame->width = snap[FRAME_SNAP_WIDTH];
+    if (set & FRAME_SNAP_SET_HEIGHT)
+        frame->height = snap[FRAME_SNAP_HEIGHT];
+    if (set & FRAME_SNAP_SET_SAR) {
+        frame->sample_aspect_ratio.num = snap[FRAME_SNAP_SAR_NUM];
+        frame->sample_aspect_ratio.den = snap[FRAME_SNAP_SAR_DEN];
+    }
+    if (set & FRAME_SNAP_SET_CROP) {
+        frame->crop_top = (uint32_t) snap[FRAME_SNAP_CROP_TOP];
+        frame->crop_bottom = (uint32_t) snap[FRAME_SNAP_CROP_BOTTOM];
+        frame->crop_left = (uint32_t) snap[FRAME_SNAP_CROP_LEFT];
+        frame->crop_right = (uint32_t) snap[FRAME_SNAP_CROP_RIGHT];
+    }
+}
+
+/* Frame pools (see FFPool in bindings.c) */
+FFPool *ff_frame_pool_alloc(void)
+{
+    return av_mallocz(sizeof(FFPool));
+}
+
+static void ff_frame_pool_freer(void *frame)
+{
+    av_frame_free((AVFrame **) &frame);
+}
+
+void ff_frame_pool_free(FFPool *pool)
+{
+    ff_pool_free(pool, ff_frame_pool_freer);
+}
+
+/* Get an empty frame from the pool */
+AVFrame *ff_frame_pool_acquire(FFPool *pool)
+{
+    AVFrame *ret = ff_pool_get(pool);
+    if (!ret) {
+        ret = av_frame_alloc();
+        if (ret)
+            ff_pool_allocated(pool);
+    }
+    return ret;
+}
+
+/* Unreference a frame and return it to the pool */
+void ff_frame_pool_release(FFPool *pool, AVFrame *frame)
+{
+    av_frame_unref(frame);
+    if (!ff_pool_put(pool, frame))
+        av_frame_free(&frame);
+}
+
+/* Like av_frame_clone, but with the new frame from the pool */
+AVFrame *ff_frame_pool_clone(FFPool *pool, const AVFrame *src)
+{
+    AVFrame *ret = ff_frame_pool_acquire(pool);
+    if (!ret)
+        return NULL;
+    if (av_frame_ref(ret, src) < 0) {
+        ff_frame_pool_release(pool, ret);
+        return NULL;
+    }
+    return ret;
+}
+
+/* Like av_frame_get_buffer, but with all of the frame's data in a single
+ * buffer from the pool. The frame must not already have buffers. Frames with
+ * more planes than fit in data fall back to av_frame_get_buffer. */
+int ff_frame_pool_get_buffer(FFPool *pool, AVFrame *frame)
+{
+    AVBufferRef *buf;
+    int size, ret;
+
+    if (frame->width > 0 && frame->height > 0) {
+        /* Video, padded as av_frame_get_buffer would */
+        int i;
+        ret = av_image_fill_linesizes(frame->linesize, frame->format,
+            FFALIGN(frame->width, 32));
+        if (ret < 0)
+            return ret;
+        for (i = 0; i < 4 && frame->linesize[i]; i++)
+            frame->linesize[i] = FFALIGN(frame->linesize[i], 32);
+        size = av_image_fill_pointers(frame->data, frame->format,
+            FFALIGN(frame->height, 32), NULL, frame->linesize);
+        if (size < 0)
+            return size;
+        buf = ff_pool_buffer(pool, size + 16 + 32 - 1);
+        if (!buf)
+            return AVERROR(ENOMEM);
+        av_image_fill_pointers(frame->data, frame->format,
+            FFALIGN(frame->height, 32), buf->data, frame->linesize);
+
+    } else {
+        /* Audio */
+        int channels = SNAP_CHL_CHANNELS(frame);
+        if (av_sample_fmt_is_planar(frame->format) &&
+            channels > AV_NUM_DATA_POINTERS)
+            return av_frame_get_buffer(frame, 0);
+        size = av_samples_get_buffer_size(&frame->linesize[0], channels,
+            frame->nb_samples, frame->format, 0);
+        if (size < 0)
+            return size;
+        buf = ff_pool_buffer(pool, size);
+        if (!buf)
+            return AVERROR(ENOMEM);
+        av_samples_fill_arrays(frame->data, &frame->linesize[0], buf->data,
+            channels, frame->nb_samples, frame->format, 0);
+
+    }
+
+    frame->buf[0] = buf;
+    frame->extended_data = frame->data;
+    return 0;
+}
+
+void ff_frame_pool_stats(FFPool *pool, int32_t *stats)
+{
+    ff_pool_stats(pool, stats);
+}
+
+/* Move an input frame of a multi driver into frame, then release the input
+ * frame to the pool, or free it if there's no pool */
+static void ff_frame_multi_in(FFPool *pool, AVFrame *frame, AVFrame *in)
+{
+    av_frame_unref(frame);
+    av_frame_move_ref(frame, in);
+    if (pool)
+        ff_frame_pool_release(pool, in);
+    else
+        av_frame_free(&in);
+}
+
+/* Release the input frames of a multi driver that it stopped before reaching,
+ * to the pool, or free them if there's no pool */
+static void ff_frame_multi_in_drop(FFPool *pool, AVFrame **in, int nb)
+{
+    int i;
+    for (i = 0; i < nb; i++) {
+        if (pool)
+            ff_frame_pool_release(pool, in[i]);
+        else
+            av_frame_free(&in[i]);
+    }
+}
+
+/* Move frame into a new frame (from the pool, if given) in a multi driver's
+ * output */
+static int ff_frame_multi_out(FFPool *pool, AVFrame *frame, FFMultiOutput *out)
+{
+    AVFrame *ret = pool ? ff_frame_pool_acquire(pool) : av_frame_alloc();
+    if (!ret)
+        return AVERROR(ENOMEM);
+    av_frame_move_ref(ret, frame);
+    if (ff_multi_output_push(out, ret) < 0) {
+        if (pool)
+            ff_frame_pool_release(pool, ret);
+        else
+            av_frame_free(&ret);
+        return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
 /* AVPixFmtDescriptor */
 #define B(type, field) A(AVPixFmtDescriptor, type, field)
 B(uint64_t, flags)
@@ -0,0 +1,413 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Transcoding pipelines: demuxer -> decoder -> filter graph -> encoder ->
+ * muxer, run entirely in C. Everything is set up on the JavaScript side (see
+ * ff_init_pipeline), then handed to the pipeline, which owns it from then on. A
+ * stream with no decoder is copied as-is. */
+
+typedef struct FFPipelineStream {
+    int out_index; /* -1 if this input stream isn't used */
+    AVCodecContext *dec, *enc;
+    AVFilterGraph *graph;
+    AVFilterContext *src, *sink;
+    AVRational in_tb;
+} FFPipelineStream;
+
+/* Statistics, in the order given by ff_pipeline_stats */
+enum {
+    FF_PIPELINE_STATS_PACKETS_IN = 0,
+    FF_PIPELINE_STATS_BYTES_IN,
+    FF_PIPELINE_STATS_FRAMES_DECODED,
+    FF_PIPELINE_STATS_DECODE_ERRORS,
+    FF_PIPELINE_STATS_FRAMES_ENCODED,
+    FF_PIPELINE_STATS_PACKETS_OUT,
+    FF_PIPELINE_STATS_BYTES_OUT,
+    FF_PIPELINE_STATS_SIZE
+};
+
+typedef struct FFPipeline {
+    AVFormatContext *ifmt, *ofmt;
+    int nb_streams;
+    FFPipelineStream *streams;
+    AVPacket *pkt, *enc_pkt;
+    AVFrame *frame, *filt_frame;
+    int done;
+    int64_t stats[FF_PIPELINE_STATS_SIZE];
+} FFPipeline;
+
+void ff_pipeline_free(FFPipeline *p);
+
+/* Allocate a pipeline from this demuxer to this (not yet opened) muxer. The
+ * pipeline owns both from now on, even if this fails. */
+FFPipeline *ff_pipeline_alloc(AVFormatContext *ifmt, AVFormatContext *ofmt)
+{
+    FFPipeline *ret = av_mallocz(sizeof(FFPipeline));
+    int i;
+    if (!ret) {
+        avformat_close_input(&ifmt);
+        avformat_free_context(ofmt);
+        return NULL;
+    }
+    ret->ifmt = ifmt;
+    ret->ofmt = ofmt;
+
+    ret->streams = av_calloc(ifmt->nb_streams, sizeof(FFPipelineStream));
+    ret->pkt = av_packet_alloc();
+    ret->enc_pkt = av_packet_alloc();
+    ret->frame = av_frame_alloc();
+    ret->filt_frame = av_frame_alloc();
+    if (!ret->streams || !ret->pkt || !ret->enc_pkt || !ret->frame ||
+        !ret->filt_frame) {
+        ff_pipeline_free(ret);
+        return NULL;
+    }
+
+    ret->nb_streams = ifmt->nb_streams;
+    for (i = 0; i < ret->nb_streams; i++) {
+        ret->streams[i].out_index = -1;
+        ret->streams[i].in_tb = ifmt->streams[i]->time_base;
+    }
+    return ret;
+}
+
+/* Free a pipeline and everything it owns */
+void ff_pipeline_free(FFPipeline *p)
+{
+    int i;
+    if (!p)
+        return;
+    for (i = 0; i < p->nb_streams; i++) {
+        FFPipelineStream *st = &p->streams[i];
+        avcodec_free_context(&st->dec);
+        avcodec_free_context(&st->enc);
+        avfilter_graph_free(&st->graph);
+    }
+    av_free(p->streams);
+    av_packet_free(&p->pkt);
+    av_packet_free(&p->enc_pkt);
+    av_frame_free(&p->frame);
+    av_frame_free(&p->filt_frame);
+    avformat_close_input(&p->ifmt);
+    if (p->ofmt) {
+        if (!(p->ofmt->oformat->flags & AVFMT_NOFILE))
+            avio_closep(&p->ofmt->pb);
+        avformat_free_context(p->ofmt);
+    }
+    av_free(p);
+}
+
+/* Add an output stream from input stream in_index. If dec is NULL, the stream
+ * is copied, and the rest must be NULL too. Otherwise, frames are decoded by
+ * dec, filtered through graph (from src to sink), and encoded by enc, which must
+ * not yet be opened, and is opened here with enc_opts. The encoder's format is
+ * taken from the filter graph's output. The pipeline owns everything passed in,
+ * even if this fails, in which case it's freed, and neither the output nor
+ * this input stream is changed. Returns the output stream index or a negative
+ * error. */
+int ff_pipeline_add_stream(
+    FFPipeline *p, int in_index, AVCodecContext *dec, AVFilterGraph *graph,
+    AVFilterContext *src, AVFilterContext *sink, AVCodecContext *enc,
+    AVDictionary *enc_opts
+) {
+    FFPipelineStream *st;
+    AVCodecParameters *par = NULL;
+    AVStream *ost;
+    AVRational tb;
+    int ret;
+
+    if (in_index < 0 || in_index >= p->nb_streams ||
+        p->streams[in_index].out_index >= 0) {
+        ret = AVERROR(EINVAL);
+        goto fail;
+    }
+    st = &p->streams[in_index];
+
+    /* The output stream's parameters are made first, since a stream can't be
+     * removed from the output once it's been added */
+    par = avcodec_parameters_alloc();
+    if (!par) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    if (!dec) {
+        // Stream copy
+        ret = avcodec_parameters_copy(
+            par, p->ifmt->streams[in_index]->codecpar);
+        if (ret < 0)
+            goto fail;
+        par->codec_tag = 0;
+        tb = st->in_tb;
+
+    } else {
+        // The encoder takes its format from the filter graph
+        if (enc->codec_type == AVMEDIA_TYPE_VIDEO) {
+            enc->width = av_buffersink_get_w(sink);
+            enc->height = av_buffersink_get_h(sink);
+            enc->pix_fmt = av_buffersink_get_format(sink);
+            enc->sample_aspect_ratio =
+                av_buffersink_get_sample_aspect_ratio(sink);
+            if (!enc->framerate.num)
+                enc->framerate = av_buffersink_get_frame_rate(sink);
+        } else {
+            enc->sample_rate = av_buffersink_get_sample_rate(sink);
+            enc->sample_fmt = av_buffersink_get_format(sink);
+#if LIBAVUTIL_VERSION_INT > AV_VERSION_INT(57, 23, 100)
+            av_channel_layout_uninit(&enc->ch_layout);
+            ret = av_buffersink_get_ch_layout(sink, &enc->ch_layout);
+            if (ret < 0)
+                goto fail;
+#else
+            enc->channel_layout = av_buffersink_get_channel_layout(sink);
+            enc->channels = av_buffersink_get_channels(sink);
+#endif
+        }
+        if (!enc->time_base.num || !enc->time_base.den)
+            enc->time_base = av_buffersink_get_time_base(sink);
+        if (p->ofmt->oformat->flags & AVFMT_GLOBALHEADER)
+            enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+        ret = avcodec_open2(enc, enc->codec, &enc_opts);
+        if (ret < 0)
+            goto fail;
+
+        // Audio encoders usually need a fixed frame size
+        if (enc->codec_type == AVMEDIA_TYPE_AUDIO && enc->frame_size &&
+            !(enc->codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE))
+            av_buffersink_set_frame_size(sink, enc->frame_size);
+
+        ret = avcodec_parameters_from_context(par, enc);
+        if (ret < 0)
+            goto fail;
+        tb = enc->time_base;
+    }
+
+    ost = avformat_new_stream(p->ofmt, NULL);
+    if (!ost) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    avcodec_parameters_free(&ost->codecpar);
+    ost->codecpar = par;
+    ost->time_base = tb;
+    av_dict_free(&enc_opts);
+
+    st->dec = dec;
+    st->enc = enc;
+    st->graph = graph;
+    st->src = src;
+    st->sink = sink;
+    st->out_index = ost->index;
+    return ost->index;
+
+fail:
+    avcodec_parameters_free(&par);
+    avcodec_free_context(&dec);
+    avcodec_free_context(&enc);
+    avfilter_graph_free(&graph);
+    av_dict_free(&enc_opts);
+    return ret;
+}
+
+/* Open the output (if the format needs a file) and write the header */
+int ff_pipeline_open(FFPipeline *p, const char *filename)
+{
+    int ret;
+    if (!(p->ofmt->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&p->ofmt->pb, filename, AVIO_FLAG_WRITE);
+        if (ret < 0)
+            return ret;
+    }
+    return avformat_write_header(p->ofmt, NULL);
+}
+
+/* Write a packet in time base tb to the output for this stream */
+static int ff_pipeline_write(
+    FFPipeline *p, FFPipelineStream *st, AVPacket *pkt, AVRational tb
+) {
+    AVStream *ost = p->ofmt->streams[st->out_index];
+    pkt->stream_index = st->out_index;
+    pkt->pos = -1;
+    av_packet_rescale_ts(pkt, tb, ost->time_base);
+    p->stats[FF_PIPELINE_STATS_PACKETS_OUT]++;
+    p->stats[FF_PIPELINE_STATS_BYTES_OUT] += pkt->size;
+    return av_interleaved_write_frame(p->ofmt, pkt);
+}
+
+/* Encode a frame (or flush, if NULL) and write the resulting packets */
+static int ff_pipeline_encode(
+    FFPipeline *p, FFPipelineStream *st, AVFrame *frame
+) {
+    int ret = avcodec_send_frame(st->enc, frame);
+    if (ret < 0 && !(ret == AVERROR_EOF && !frame))
+        return ret;
+    if (frame)
+        p->stats[FF_PIPELINE_STATS_FRAMES_ENCODED]++;
+
+    while (1) {
+        ret = avcodec_receive_packet(st->enc, p->enc_pkt);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+            return 0;
+        if (ret < 0)
+            return ret;
+        ret = ff_pipeline_write(p, st, p->enc_pkt, st->enc->time_base);
+        av_packet_unref(p->enc_pkt);
+        if (ret < 0)
+            return ret;
+    }
+}
+
+/* Filter a frame (or flush, if NULL), and encode the results */
+static int ff_pipeline_filter(
+    FFPipeline *p, FFPipelineStream *st, AVFrame *frame
+) {
+    AVRational tb = av_buffersink_get_time_base(st->sink);
+    int ret = av_buffersrc_add_frame_flags(st->src, frame, 0);
+    if (ret < 0)
+        return ret;
+
+    while (1) {
+        ret = av_buffersink_get_frame(st->sink, p->filt_frame);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+            break;
+        if (ret < 0)
+            return ret;
+        if (p->filt_frame->pts != AV_NOPTS_VALUE) {
+            p->filt_frame->pts = av_rescale_q(
+                p->filt_frame->pts, tb, st->enc->time_base);
+        }
+        p->filt_frame->pict_type = AV_PICTURE_TYPE_NONE;
+        ret = ff_pipeline_encode(p, st, p->filt_frame);
+        av_frame_unref(p->filt_frame);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (!frame)
+        return ff_pipeline_encode(p, st, NULL);
+    return 0;
+}
+
+/* Decode a packet (or flush, if NULL), and filter the results. Like the ffmpeg
+ * CLI, undecodable data is counted and skipped, rather than failing. */
+static int ff_pipeline_decode(
+    FFPipeline *p, FFPipelineStream *st, AVPacket *pkt
+) {
+    int ret = avcodec_send_packet(st->dec, pkt);
+    if (ret < 0 && ret != AVERROR_EOF) {
+        if (ret == AVERROR(ENOMEM))
+            return ret;
+        p->stats[FF_PIPELINE_STATS_DECODE_ERRORS]++;
+    }
+
+    while (1) {
+        ret = avcodec_receive_frame(st->dec, p->frame);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+            break;
+        if (ret < 0) {
+            if (ret == AVERROR(ENOMEM))
+                return ret;
+            p->stats[FF_PIPELINE_STATS_DECODE_ERRORS]++;
+            break;
+        }
+        p->stats[FF_PIPELINE_STATS_FRAMES_DECODED]++;
+        p->frame->pts = p->frame->best_effort_timestamp;
+        ret = ff_pipeline_filter(p, st, p->frame);
+        av_frame_unref(p->frame);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (!pkt)
+        return ff_pipeline_filter(p, st, NULL);
+    return 0;
+}
+
+/* Run the pipeline until max_packets packets or max_bytes bytes have been read
+ * (if they're positive), or to the end. Returns AVERROR(EAGAIN) if a limit was
+ * reached, AVERROR_EOF at the end (after flushing everything and writing the
+ * trailer), or another error. */
+int ff_pipeline_pump(FFPipeline *p, int max_packets, int max_bytes)
+{
+    int packets = 0;
+    int64_t bytes = 0;
+    int i, ret;
+
+    if (p->done)
+        return AVERROR_EOF;
+
+    while (1) {
+        FFPipelineStream *st;
+
+        if ((max_packets > 0 && packets >= max_packets) ||
+            (max_bytes > 0 && bytes >= max_bytes))
+            return AVERROR(EAGAIN);
+
+        ret = av_read_frame(p->ifmt, p->pkt);
+        if (ret == AVERROR_EOF)
+            break;
+        if (ret < 0)
+            return ret;
+        packets++;
+        bytes += p->pkt->size;
+        p->stats[FF_PIPELINE_STATS_PACKETS_IN]++;
+        p->stats[FF_PIPELINE_STATS_BYTES_IN] += p->pkt->size;
+
+        if (p->pkt->stream_index >= p->nb_streams ||
+            p->streams[p->pkt->stream_index].out_index < 0) {
+            av_packet_unref(p->pkt);
+            continue;
+        }
+        st = &p->streams[p->pkt->stream_index];
+
+        if (st->dec)
+            ret = ff_pipeline_decode(p, st, p->pkt);
+        else
+            ret = ff_pipeline_write(p, st, p->pkt, st->in_tb);
+        av_packet_unref(p->pkt);
+        if (ret < 0)
+            return ret;
+    }
+
+    // Flush everything
+    for (i = 0; i < p->nb_streams; i++) {
+        FFPipelineStream *st = &p->streams[i];
+        if (st->out_index < 0 || !st->dec)
+            continue;
+        ret = ff_pipeline_decode(p, st, NULL);
+        if (ret < 0)
+            return ret;
+    }
+
+    p->done = 1;
+    ret = av_write_trailer(p->ofmt);
+    if (ret < 0)
+        return ret;
+    if (p->ofmt->pb)
+        avio_flush(p->ofmt->pb);
+    return AVERROR_EOF;
+}
+
+/* Get the pipeline's statistics, as FF_PIPELINE_STATS_SIZE pairs of 32-bit
+ * words, low word first */
+void ff_pipeline_stats(FFPipeline *p, int32_t *out)
+{
+    int i;
+    for (i = 0; i < FF_PIPELINE_STATS_SIZE; i++) {
+        out[i*2] = (int32_t) p->stats[i];
+        out[i*2+1] = (int32_t) (p->stats[i] >> 32);
+    }
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+
+/* Set up out (which is unreferenced first) to hold in converted to the given
+ * sample format, channel layout (mask) and sample rate. A format of -1, layout
+ * of 0 or rate of 0 keeps in's. */
+static int ff_frame_audio_setup(
+    AVFrame *out, AVFrame *in, int format, uint64_t layout, int sample_rate
+) {
+    int ret;
+
+    av_frame_unref(out);
+    ret = av_frame_copy_props(out, in);
+    if (ret < 0)
+        return ret;
+    out->format = (format >= 0) ? format : in->format;
+    out->sample_rate = (sample_rate > 0) ? sample_rate : in->sample_rate;
+#if LIBAVUTIL_VERSION_INT > AV_VERSION_INT(57, 23, 100)
+    if (layout)
+        ret = av_channel_layout_from_mask(&out->ch_layout, layout);
+    else
+        ret = av_channel_layout_copy(&out->ch_layout, &in->ch_layout);
+    if (ret < 0)
+        return ret;
+#else
+    out->channel_layout = layout ? layout : in->channel_layout;
+    out->channels = layout ? av_get_channel_layout_nb_channels(layout) :
+        in->channels;
+#endif
+    return 0;
+}
+
+/* Convert in into out, which has been set up by ff_frame_audio_setup, with the
+ * resampler *swr, which is allocated if needed. The resampler is reconfigured
+ * if the frames' parameters have changed. */
+static int ff_swr_convert(SwrContext **swr, AVFrame *out, AVFrame *in)
+{
+    int ret;
+
+    if (!*swr) {
+        *swr = swr_alloc();
+        if (!*swr)
+            return AVERROR(ENOMEM);
+    }
+
+    ret = swr_convert_frame(*swr, out, in);
+    if (ret == AVERROR_INPUT_CHANGED || ret == AVERROR_OUTPUT_CHANGED) {
+        // New parameters, so configure afresh from these frames
+        swr_close(*swr);
+        ret = swr_convert_frame(*swr, out, in);
+    }
+    return ret;
+}
+
+/* Convert the audio frame in into out (which is unreferenced first), with the
+ * given sample format and channel layout (mask), as in ff_frame_audio_setup.
+ * Sample format conversion, channel remixing and (de)interleaving are all done
+ * in one pass. A frame can't be resampled on its own without seams at its
+ * edges, so a sample rate other than in's is rejected; to resample a stream,
+ * use a resampler (ff_resampler_alloc). */
+int ff_frame_audio_convert(
+    AVFrame *out, AVFrame *in, int format, uint32_t layoutlo,
+    uint32_t layouthi, int sample_rate
+) {
+    uint64_t layout = ((uint64_t) layouthi << 32) | layoutlo;
+    SwrContext *swr;
+    int ret;
+
+    if (sample_rate > 0 && sample_rate != in->sample_rate)
+        return AVERROR(EINVAL);
+    ret = ff_frame_audio_setup(out, in, format, layout, 0);
+    if (ret < 0)
+        return ret;
+
+    swr = swr_alloc();
+    if (!swr)
+        return AVERROR(ENOMEM);
+    ret = swr_convert_frame(swr, out, in);
+    swr_free(&swr);
+    return ret;
+}
+
+/* A resampler: converts audio frames of one stream to one sample format,
+ * channel layout and sample rate, keeping its state between frames */
+typedef struct FFResampler {
+    SwrContext *swr;
+    int format;
+    uint64_t layout;
+    int sample_rate;
+
+    /* The last output frame, without its data, to set up the frames that
+     * flush the resampler */
+    AVFrame *last;
+} FFResampler;
+
+/* Allocate a resampler to the given sample format, channel layout (mask) and
+ * sample rate, as in ff_frame_audio_setup */
+FFResampler *ff_resampler_alloc(int format, uint32_t layoutlo,
+    uint32_t layouthi, int sample_rate)
+{
+    FFResampler *ret = av_mallocz(sizeof(FFResampler));
+    if (!ret)
+        return NULL;
+    ret->last = av_frame_alloc();
+    if (!ret->last) {
+        av_free(ret);
+        return NULL;
+    }
+    ret->format = format;
+    ret->layout = ((uint64_t) layouthi << 32) | layoutlo;
+    ret->sample_rate = sample_rate;
+    return ret;
+}
+
+void ff_resampler_free(FFResampler *rs)
+{
+    swr_free(&rs->swr);
+    av_frame_free(&rs->last);
+    av_free(rs);
+}
+
+/* Remember out's parameters as the resampler's last output */
+static int ff_resampler_remember(FFResampler *rs, AVFrame *out)
+{
+    AVFrame *last = rs->last;
+    int ret = ff_frame_audio_setup(last, out, -1, 0, 0);
+    last->nb_samples = out->nb_samples;
+    return ret;
+}
+
+/* Convert the frame in into out (which is unreferenced first) with this
+ * resampler. If in is NULL, out is instead given the samples still buffered in
+ * the resampler, if any. out may have no samples, if the resampler buffered
+ * them all. */
+int ff_resampler_convert(FFResampler *rs, AVFrame *out, AVFrame *in)
+{
+    AVFrame *last = rs->last;
+    int ret;
+
+    if (in) {
+        ret = ff_frame_audio_setup(out, in, rs->format, rs->layout,
+            rs->sample_rate);
+        if (ret < 0)
+            return ret;
+        ret = ff_swr_convert(&rs->swr, out, in);
+        if (ret < 0)
+            return ret;
+        return ff_resampler_remember(rs, out);
+    }
+
+    // Flushing, so continue from the last frame
+    av_frame_unref(out);
+    if (!rs->swr || !last->sample_rate)
+        return 0;
+    ret = ff_frame_audio_setup(out, last, -1, 0, 0);
+    if (ret < 0)
+        return ret;
+    out->pts = AV_NOPTS_VALUE;
+#if LIBAVUTIL_VERSION_INT > AV_VERSION_INT(57, 10, 101)
+    if (last->pts != AV_NOPTS_VALUE && last->time_base.num) {
+        out->pts = last->pts + av_rescale_q(last->nb_samples,
+            av_make_q(1, last->sample_rate), last->time_base);
+    }
+#endif
+    ret = swr_convert_frame(rs->swr, out, NULL);
+
+    // Start afresh with the next frame
+    swr_close(rs->swr);
+    av_frame_unref(last);
+    return ret;
+}
+
+/* Native driver for ff_resample_multi. Like ff_scale_multi_c (b-swscale.c),
+ * but with the resampler. Output frames with no samples are dropped, and with
+ * FF_MULTI_FIN, the resampler is flushed at the end. */
+int ff_resample_multi_c(
+    FFResampler *rs, AVFrame **in, int nb_in, int32_t *status, int flags,
+    FFPool *in_pool, FFPool *out_pool, FFMultiOutput *out
+) {
+    int i, ret;
+
+    for (i = 0; i <= nb_in; i++) {
+        AVFrame *frame;
+        if (i == nb_in && !(flags & FF_MULTI_FIN))
+            break;
+
+        frame = out_pool ? ff_frame_pool_acquire(out_pool) : av_frame_alloc();
+        if (frame)
+            ret = ff_resampler_convert(rs, frame, (i < nb_in) ? in[i] : NULL);
+        else
+            ret = AVERROR(ENOMEM);
+        status[i] = ret;
+        if (i < nb_in) {
+            if (in_pool)
+                ff_frame_pool_release(in_pool, in[i]);
+            else
+                av_frame_free(&in[i]);
+        }
+        if (ret >= 0 && frame->nb_samples > 0) {
+            if (ff_multi_output_push(out, frame) < 0)
+                ret = AVERROR(ENOMEM);
+            else
+                continue;
+        }
+        if (out_pool && frame)
+            ff_frame_pool_release(out_pool, frame);
+        else
+            av_frame_free(&frame);
+        if (ret < 0 && !(flags & FF_MULTI_IGNORE_ERRORS))
+            goto fail;
+    }
+
+    return 0;
+
+fail:
+    // Release the inputs not yet reached
+    if (i + 1 < nb_in)
+        ff_frame_multi_in_drop(in_pool, in + i + 1, nb_in - i - 1);
+    return ret;
+}
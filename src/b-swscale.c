@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+
+/* Default number of slice threads for scaling: one per core in the threaded
+ * build, and just one otherwise, since emfiberthreads can't run in parallel */
+#ifdef __EMSCRIPTEN_PTHREADS__
+#define FF_SWS_THREADS 0
+#else
+#define FF_SWS_THREADS 1
+#endif
+
+/* A scaling context, and the conversion (input and output size and format)
+ * it's set up for */
+typedef struct FFSws {
+    struct SwsContext *ctx;
+    int in_width, in_height, in_format;
+    int out_width, out_height, out_format;
+} FFSws;
+
+/* Make sure sws is set up to convert in to out. Like sws_getCachedContext, the
+ * context is reused if the conversion is unchanged, and rebuilt otherwise, but
+ * this also sets the number of slice threads. */
+static int ff_sws_setup(
+    FFSws *sws, AVFrame *out, AVFrame *in, int flags, int threads
+) {
+    struct SwsContext *ctx = sws->ctx;
+    int ret;
+
+    if (ctx &&
+        sws->in_width == in->width && sws->in_height == in->height &&
+        sws->in_format == in->format &&
+        sws->out_width == out->width && sws->out_height == out->height &&
+        sws->out_format == out->format)
+        return 0;
+
+    sws_freeContext(ctx);
+    sws->ctx = ctx = sws_alloc_context();
+    if (!ctx)
+        return AVERROR(ENOMEM);
+    av_opt_set_int(ctx, "srcw", in->width, 0);
+    av_opt_set_int(ctx, "srch", in->height, 0);
+    av_opt_set_int(ctx, "src_format", in->format, 0);
+    av_opt_set_int(ctx, "dstw", out->width, 0);
+    av_opt_set_int(ctx, "dsth", out->height, 0);
+    av_opt_set_int(ctx, "dst_format", out->format, 0);
+    av_opt_set_int(ctx, "sws_flags", flags, 0);
+    // Not supported by older versions, which just don't thread
+    av_opt_set_int(ctx, "threads", threads, 0);
+    ret = sws_init_context(ctx, NULL, NULL);
+    if (ret < 0) {
+        sws_freeContext(ctx);
+        sws->ctx = NULL;
+        return ret;
+    }
+
+    sws->in_width = in->width;
+    sws->in_height = in->height;
+    sws->in_format = in->format;
+    sws->out_width = out->width;
+    sws->out_height = out->height;
+    sws->out_format = out->format;
+    return 0;
+}
+
+/* Set up out (which is unreferenced first) to hold in converted to the given
+ * pixel format and size, and give it a buffer. A format of -1 keeps in's. If
+ * only one of width and height is given, the other is chosen to keep in's
+ * shape, and if neither is, in's size is kept. */
+static int ff_frame_video_setup(
+    AVFrame *out, AVFrame *in, int format, int width, int height
+) {
+    int ret;
+
+    if (in->width <= 0 || in->height <= 0)
+        return AVERROR(EINVAL);
+    if (width <= 0 && height <= 0) {
+        width = in->width;
+        height = in->height;
+    } else if (width <= 0) {
+        width = av_rescale(in->width, height, in->height);
+    } else if (height <= 0) {
+        height = av_rescale(in->height, width, in->width);
+    }
+
+    av_frame_unref(out);
+    ret = av_frame_copy_props(out, in);
+    if (ret < 0)
+        return ret;
+    out->format = (format >= 0) ? format : in->format;
+    out->width = FFMAX(width, 1);
+    out->height = FFMAX(height, 1);
+    if (in->sample_aspect_ratio.num) {
+        // Keep the display shape through any change in shape
+        out->sample_aspect_ratio = av_mul_q(in->sample_aspect_ratio,
+            av_make_q(out->height * in->width, out->width * in->height));
+    }
+    return av_frame_get_buffer(out, 0);
+}
+
+/* Scale in into out, which has been set up by ff_frame_video_setup, with a
+ * context set up by ff_sws_setup */
+static int ff_sws_scale(FFSws *sws, AVFrame *out, AVFrame *in)
+{
+    int ret;
+#if LIBAVUTIL_VERSION_INT > AV_VERSION_INT(57, 4, 101)
+    // Only sws_scale_frame uses slice threads
+    ret = sws_scale_frame(sws->ctx, out, in);
+#else
+    ret = sws_scale(sws->ctx, (const uint8_t * const *) in->data,
+        in->linesize, 0, in->height, out->data, out->linesize);
+#endif
+    return (ret < 0) ? ret : 0;
+}
+
+/* Scaling contexts used for converting video frames as they're copied out,
+ * most recently used first. Each is kept for one conversion, so that a few
+ * decoders or sinks can convert their frames in turn, and a context is only
+ * rebuilt when a geometry changes. */
+#define FF_FRAME_VIDEO_SWS_CACHE 4
+static FFSws ff_frame_video_sws[FF_FRAME_VIDEO_SWS_CACHE];
+
+/* Convert the video frame in into out (which is unreferenced first), with the
+ * given pixel format and size, as in ff_frame_video_setup. Format conversion
+ * and scaling are done in one pass. */
+int ff_frame_video_convert(
+    AVFrame *out, AVFrame *in, int format, int width, int height
+) {
+    FFSws sws;
+    int i, ret;
+
+    ret = ff_frame_video_setup(out, in, format, width, height);
+    if (ret < 0)
+        return ret;
+
+    // Find the matching context, or else rebuild the least recently used
+    for (i = 0; i < FF_FRAME_VIDEO_SWS_CACHE - 1; i++) {
+        FFSws *c = &ff_frame_video_sws[i];
+        if (c->ctx &&
+            c->in_width == in->width && c->in_height == in->height &&
+            c->in_format == in->format &&
+            c->out_width == out->width && c->out_height == out->height &&
+            c->out_format == out->format)
+            break;
+    }
+    sws = ff_frame_video_sws[i];
+    memmove(ff_frame_video_sws + 1, ff_frame_video_sws, i * sizeof(FFSws));
+    ret = ff_sws_setup(&sws, out, in, SWS_BILINEAR, FF_SWS_THREADS);
+    ff_frame_video_sws[0] = sws;
+    if (ret < 0)
+        return ret;
+
+    return ff_sws_scale(&sws, out, in);
+}
+
+/* A scaler: converts video frames to one pixel format and size, keeping its
+ * context between frames */
+typedef struct FFScaler {
+    FFSws sws;
+    int format, width, height, flags, threads;
+} FFScaler;
+
+/* Allocate a scaler to the given pixel format and size (as in
+ * ff_frame_video_setup), with the given SWS_* flags (bilinear if 0) and number
+ * of slice threads (0 for one per core, -1 for the default) */
+FFScaler *ff_scaler_alloc(int format, int width, int height, int flags,
+    int threads)
+{
+    FFScaler *ret = av_mallocz(sizeof(FFScaler));
+    if (!ret)
+        return NULL;
+    ret->format = format;
+    ret->width = width;
+    ret->height = height;
+    ret->flags = flags ? flags : SWS_BILINEAR;
+    ret->threads = (threads >= 0) ? threads : FF_SWS_THREADS;
+    return ret;
+}
+
+void ff_scaler_free(FFScaler *sc)
+{
+    sws_freeContext(sc->sws.ctx);
+    av_free(sc);
+}
+
+/* Convert the frame in into out (which is unreferenced first) with this
+ * scaler */
+int ff_scaler_convert(FFScaler *sc, AVFrame *out, AVFrame *in)
+{
+    int ret = ff_frame_video_setup(out, in, sc->format, sc->width, sc->height);
+    if (ret < 0)
+        return ret;
+    ret = ff_sws_setup(&sc->sws, out, in, sc->flags, sc->threads);
+    if (ret < 0)
+        return ret;
+    return ff_sws_scale(&sc->sws, out, in);
+}
+
+/* Native driver for ff_scale_multi. Like ff_filter_multi_c (b-avfilter.c), but
+ * each input frame is converted by the scaler into a new output frame. */
+int ff_scale_multi_c(
+    FFScaler *sc, AVFrame **in, int nb_in, int32_t *status, int flags,
+    FFPool *in_pool, FFPool *out_pool, FFMultiOutput *out
+) {
+    int i, ret;
+
+    for (i = 0; i < nb_in; i++) {
+        AVFrame *frame = out_pool ? ff_frame_pool_acquire(out_pool) :
+            av_frame_alloc();
+        if (frame)
+            ret = ff_scaler_convert(sc, frame, in[i]);
+        else
+            ret = AVERROR(ENOMEM);
+        status[i] = ret;
+        if (in_pool)
+            ff_frame_pool_release(in_pool, in[i]);
+        else
+            av_frame_free(&in[i]);
+        if (ret >= 0 && ff_multi_output_push(out, frame) < 0)
+            ret = AVERROR(ENOMEM);
+        if (ret < 0) {
+            if (out_pool && frame)
+                ff_frame_pool_release(out_pool, frame);
+            else
+                av_frame_free(&frame);
+            if (!(flags & FF_MULTI_IGNORE_ERRORS))
+                goto fail;
+        }
+    }
+
+    return 0;
+
+fail:
+    // Release the inputs not yet reached
+    if (i + 1 < nb_in)
+        ff_frame_multi_in_drop(in_pool, in + i + 1, nb_in - i - 1);
+    return ret;
+}
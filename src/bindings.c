@@ -17,9 +17,11 @@
 #include <string.h>
 
 #include <malloc.h>
+#include <unistd.h>
 
 #ifdef __EMSCRIPTEN_PTHREADS__
 #include <emscripten.h>
+#include <emscripten/threading.h>
 #include <pthread.h>
 #endif
 
@@ -27,8 +29,11 @@
 #include "libavformat/avformat.h"
 #include "libavfilter/avfilter.h"
 #include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
 #include "libavutil/avutil.h"
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
+#include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/version.h"
@@ -151,6 +156,175 @@ void struc ##_channel_layouthi_s(struc *a, uint32_t b) { \
 
 #endif /* Channel layout API version */
 
+/* Snapshots gather many fields of a struct into one record of int32s, so that
+ * JavaScript can read or write all of them with a single call, rather than a
+ * call per field. Each record starts with its version and (for records that
+ * can be applied back) a mask of which fields to set. 64-bit values take two
+ * 8-byte-aligned slots, low word first, so they're true int64s in memory. The
+ * layouts are mirrored in the p-*.in.js files. */
+#define SNAP64(snap, idx, val) do { \
+    int64_t snap64_ = (val); \
+    (snap)[idx] = (int32_t) snap64_; \
+    (snap)[(idx)+1] = (int32_t) (snap64_ >> 32); \
+} while (0)
+#define UNSNAP64(snap, idx) ((int64_t) ( \
+    ((uint64_t) (uint32_t) (snap)[idx]) | \
+    (((uint64_t) (uint32_t) (snap)[(idx)+1]) << 32) \
+))
+
+#if LIBAVUTIL_VERSION_INT > AV_VERSION_INT(57, 23, 100)
+/* Only native layouts have a mask. The others snapshot as 0, and keep only
+ * their channel count. */
+#define SNAP_CHL_MASK(a) \
+    ((a)->ch_layout.order == AV_CHANNEL_ORDER_NATIVE ? \
+     (a)->ch_layout.u.mask : 0)
+#define SNAP_CHL_CHANNELS(a) ((a)->ch_layout.nb_channels)
+#define SNAP_CHL_MASK_S(a, mask) do { \
+    av_channel_layout_uninit(&(a)->ch_layout); \
+    av_channel_layout_from_mask(&(a)->ch_layout, (mask)); \
+} while (0)
+#else
+#define SNAP_CHL_MASK(a) ((a)->channel_layout)
+#define SNAP_CHL_CHANNELS(a) ((a)->channels)
+#define SNAP_CHL_MASK_S(a, mask) ((a)->channel_layout = (mask))
+#endif
+
+/* Pools keep released frames or packets for reuse, rather than freeing them,
+ * and allocate data buffers from AVBufferPools keyed by size, so that a
+ * steady-state stream doesn't touch malloc. The object-specific parts are in
+ * b-avframe.c and b-avcodec.c. */
+#define FF_POOL_BUFFER_POOLS 8
+
+/* Layout of pool statistics, in int32s. Must match ff_pool_stats_fields in
+ * post.in.js. */
+enum {
+    FF_POOL_STATS_ALLOCATED = 0, /* Objects allocated over the pool's life */
+    FF_POOL_STATS_IN_USE = 1, /* Objects acquired and not yet released */
+    FF_POOL_STATS_FREE = 2, /* Objects waiting to be reused */
+    FF_POOL_STATS_REUSED = 3, /* Acquisitions satisfied by reuse */
+    FF_POOL_STATS_BUFFERS = 4, /* Data buffers taken from buffer pools */
+    FF_POOL_STATS_BUFFER_POOLS = 5, /* Buffer pools (sizes) created */
+    FF_POOL_STATS_SIZE = 6
+};
+
+typedef struct FFPool {
+    void **free;
+    int nb_free, free_size;
+    int buffer_size[FF_POOL_BUFFER_POOLS];
+    AVBufferPool *buffer_pool[FF_POOL_BUFFER_POOLS];
+    int next_buffer_pool;
+    int32_t stats[FF_POOL_STATS_SIZE];
+} FFPool;
+
+/* Get a free object from the pool, or NULL if the caller must allocate one */
+static void *ff_pool_get(FFPool *pool)
+{
+    if (!pool->nb_free)
+        return NULL;
+    pool->stats[FF_POOL_STATS_REUSED]++;
+    pool->stats[FF_POOL_STATS_IN_USE]++;
+    return pool->free[--pool->nb_free];
+}
+
+/* Account for an object that the caller allocated for the pool */
+static void ff_pool_allocated(FFPool *pool)
+{
+    pool->stats[FF_POOL_STATS_ALLOCATED]++;
+    pool->stats[FF_POOL_STATS_IN_USE]++;
+}
+
+/* Return an (already unreferenced) object to the pool. Returns 0 if the pool
+ * couldn't take it, in which case the caller must free it. */
+static int ff_pool_put(FFPool *pool, void *obj)
+{
+    if (pool->nb_free >= pool->free_size) {
+        int size = pool->free_size ? pool->free_size * 2 : 16;
+        void **free = av_realloc_array(pool->free, size, sizeof(void *));
+        if (!free)
+            return 0;
+        pool->free = free;
+        pool->free_size = size;
+    }
+    pool->free[pool->nb_free++] = obj;
+    pool->stats[FF_POOL_STATS_IN_USE]--;
+    return 1;
+}
+
+/* Get a data buffer of exactly this size from the pool's buffer pools. When
+ * all the buffer pools are in use by other sizes, the oldest is replaced;
+ * buffers still out from it stay valid until they're unreferenced. */
+static AVBufferRef *ff_pool_buffer(FFPool *pool, int size)
+{
+    AVBufferRef *ret;
+    int i;
+
+    for (i = 0; i < FF_POOL_BUFFER_POOLS; i++) {
+        if (pool->buffer_pool[i] && pool->buffer_size[i] == size)
+            break;
+    }
+    if (i == FF_POOL_BUFFER_POOLS) {
+        i = pool->next_buffer_pool;
+        pool->next_buffer_pool = (i + 1) % FF_POOL_BUFFER_POOLS;
+        av_buffer_pool_uninit(&pool->buffer_pool[i]);
+        pool->buffer_pool[i] = av_buffer_pool_init(size, NULL);
+        if (!pool->buffer_pool[i])
+            return NULL;
+        pool->buffer_size[i] = size;
+        pool->stats[FF_POOL_STATS_BUFFER_POOLS]++;
+    }
+
+    ret = av_buffer_pool_get(pool->buffer_pool[i]);
+    if (ret)
+        pool->stats[FF_POOL_STATS_BUFFERS]++;
+    return ret;
+}
+
+/* Free everything in the pool with the given freer, then the pool itself */
+static void ff_pool_free(FFPool *pool, void (*freer)(void *))
+{
+    int i;
+    for (i = 0; i < pool->nb_free; i++)
+        freer(pool->free[i]);
+    for (i = 0; i < FF_POOL_BUFFER_POOLS; i++)
+        av_buffer_pool_uninit(&pool->buffer_pool[i]);
+    av_free(pool->free);
+    av_free(pool);
+}
+
+static void ff_pool_stats(FFPool *pool, int32_t *stats)
+{
+    pool->stats[FF_POOL_STATS_FREE] = pool->nb_free;
+    memcpy(stats, pool->stats, sizeof(pool->stats));
+}
+
+/* The native multi drivers (ff_*_multi_c) run the send/receive loops of the
+ * *_multi metafunctions over a list of input pointers in one call. Their
+ * outputs go in an FFMultiOutput, which JavaScript reads as three int32s (see
+ * ff_multi_call in post.in.js). */
+typedef struct FFMultiOutput {
+    void **items;
+    int nb_items, size;
+} FFMultiOutput;
+
+/* Flags to the native multi drivers. Must match MULTI_FLAGS in post.in.js. */
+#define FF_MULTI_FIN                    0x1
+#define FF_MULTI_IGNORE_ERRORS          0x2
+#define FF_MULTI_IGNORE_SINK_TIMEBASE   0x4
+
+static int ff_multi_output_push(FFMultiOutput *out, void *item)
+{
+    if (out->nb_items >= out->size) {
+        int size = out->size ? out->size * 2 : 16;
+        void **items = av_realloc_array(out->items, size, sizeof(void *));
+        if (!items)
+            return AVERROR(ENOMEM);
+        out->items = items;
+        out->size = size;
+    }
+    out->items[out->nb_items++] = item;
+    return 0;
+}
+
 
 /* Not part of libav, just used to ensure a round trip to C for async purposes */
 void ff_nothing() {}
@@ -232,6 +406,23 @@ int av_compare_ts_js(
 #include "b-avfilter.c"
 #endif
 
+/****************************************************************
+ * Transcoding pipelines
+ ***************************************************************/
+
+#if LIBAVJS_WITH_AVFORMAT && LIBAVJS_FULL_AVCODEC && LIBAVJS_WITH_AVFILTER
+#include "b-pipeline.c"
+#endif
+
+/****************************************************************
+ * swresample
+ ***************************************************************/
+
+#if LIBAVJS_WITH_SWRESAMPLE
+#include "libswresample/swresample.h"
+#include "b-swresample.c"
+#endif
+
 /****************************************************************
  * swscale
  ***************************************************************/
@@ -248,6 +439,11 @@ int libavjs_with_swscale() {
 void sws_scale_frame() {}
 #endif
 
+#if LIBAVJS_WITH_SWSCALE
+#include "libswscale/swscale.h"
+#include "b-swscale.c"
+#endif
+
 
 /****************************************************************
  * Threading
@@ -258,38 +454,56 @@ EM_JS(void *, libavjs_main_thread, (void *ignore), {
     // Avoid exiting the runtime so we can receive normal requests
     noExitRuntime = Module.noExitRuntime = true;
 
-    // Hijack the event handler
-    var origOnmessage = onmessage;
-    onmessage = function(ev) {
-        var a;
+    // Our results are posted to another thread, so can't be heap views
+    Module.libavjsCrossThread = true;
 
+    // The ring channel to the frontend, if it asks for one
+    var ring = null;
+
+    function run(a) {
         function reply(succ, ret) {
             var transfer = [];
             if (typeof ret === "object" && ret && ret.libavjsTransfer)
                 transfer = ret.libavjsTransfer;
-            postMessage({
-                c: "libavjs_ret",
-                a: [a[0], a[1], succ, ret]
-            }, transfer);
+            var r = [a[0], a[1], succ, ret];
+            if (ring)
+                ring.send(r, transfer);
+            else
+                postMessage({c: "libavjs_ret", a: r}, transfer);
+        }
+
+        var succ = true;
+        var ret;
+        try {
+            ret = Module[a[1]].apply(Module, a.slice(2));
+        } catch (ex) {
+            succ = false;
+            ret = ex + "\n" + ex.stack;
+        }
+        if (succ && ret && ret.then) {
+            ret
+                .then(function(ret) { reply(true, ret); })
+                .catch(function(ret) { reply(false, ret + "\n" + ret.stack); });
+        } else {
+            reply(succ, ret);
         }
+    }
 
+    // Hijack the event handler
+    var origOnmessage = onmessage;
+    onmessage = function(ev) {
         if (ev.data && ev.data.c === "libavjs_run") {
-            a = ev.data.a;
-            var succ = true;
-            var ret;
-            try {
-                ret = Module[a[1]].apply(Module, a.slice(2));
-            } catch (ex) {
-                succ = false;
-                ret = ex + "\n" + ex.stack;
-            }
-            if (succ && ret && ret.then) {
-                ret
-                    .then(function(ret) { reply(true, ret); })
-                    .catch(function(ret) { reply(false, ret + "\n" + ret.stack); });
-            } else {
-                reply(succ, ret);
-            }
+            run(ev.data.a);
+
+        } else if (ev.data && ev.data.c === "libavjs_ring_init") {
+            ring = Module.libavjsRingChannel(
+                ev.data.sab, ev.data.size, 1, function(msg, transfer) {
+                    postMessage(msg, transfer);
+                }, run);
+
+        } else if (ev.data && (ev.data.c === "libavjs_ring" ||
+                               ev.data.c === "libavjs_ring_wake")) {
+            ring.posted(ev.data);
 
         } else if (ev.data && ev.data.c === "libavjs_wait_reader") {
             var name = "" + ev.data.fd;
@@ -337,6 +551,14 @@ int mallinfo_uordblks()
     return mallinfo().uordblks;
 }
 
+/* The top of the heap (the program break). Everything that libav.js's state
+ * depends on is below this, so it's the extent of the heap snapshot that
+ * ff_reset restores. */
+void *ff_heap_top()
+{
+    return sbrk(0);
+}
+
 static const int LIBAVUTIL_VERSION_INT_V = LIBAVUTIL_VERSION_INT;
 #undef LIBAVUTIL_VERSION_INT
 int LIBAVUTIL_VERSION_INT() { return LIBAVUTIL_VERSION_INT_V; }
@@ -34,6 +34,7 @@ if (/* We're in a worker */
                 if (e && e.data && e.data.config) {
                     LibAVFactory({
                         wasmurl: e.data.config.wasmurl,
+                        wasmmodule: e.data.config.wasmmodule,
                         variant: e.data.config.variant
                     }).then(res).catch(rej);
                 }
@@ -43,6 +44,9 @@ if (/* We're in a worker */
     }).then(function(lib) {
         libav = lib;
 
+        // Our results are posted to the host, so can't be heap views
+        libav.libavjsCrossThread = true;
+
         // Now we're ready for normal messages
         onmessage = function(e) {
             var id = e.data[0];
@@ -87,13 +91,27 @@ if (/* We're in a worker */
             } else reply();
         };
 
-        libav.onwrite = function(name, pos, buf) {
+        var onwrite = libav.onwrite = function(name, pos, buf) {
             /* We have to buf.slice(0) so we don't duplicate the entire heap just
              * to get one part of it in postMessage */
             buf = buf.slice(0);
             postMessage(["onwrite", "onwrite", true, [name, pos, buf]], [buf.buffer]);
         };
 
+        // Buffered writes are ours already, so are sent as one transfer
+        libav.onwritemulti = function(name, writes) {
+            if (libav.onwrite !== onwrite) {
+                // Replaced (e.g. by mkfsfhfile), so it has to see every write
+                for (var i = 0; i < writes.length; i++)
+                    libav.onwrite(name, writes[i][0], writes[i][1]);
+                return;
+            }
+            var transfer = [];
+            for (var i = 0; i < writes.length; i++)
+                transfer.push(writes[i][1].buffer);
+            postMessage(["onwritemulti", "onwritemulti", true, [name, writes]], transfer);
+        };
+
         libav.onread = function(name, pos, len) {
             postMessage(["onread", "onread", true, [name, pos, len]]);
         };
@@ -38,6 +38,22 @@
         return false;
     }
 
+    function isSIMDSupported() {
+        // (func (result v128) i32.const 0 i8x16.splat i8x16.popcnt)
+        return isWebAssemblySupported([
+            0x0, 0x61, 0x73, 0x6d, 0x1, 0x0, 0x0, 0x0, 0x1, 0x5, 0x1, 0x60,
+            0x0, 0x1, 0x7b, 0x3, 0x2, 0x1, 0x0, 0xa, 0xa, 0x1, 0x8, 0x0, 0x41,
+            0x0, 0xfd, 0xf, 0xfd, 0x62, 0xb
+        ]);
+    }
+
+    function isJSPISupported() {
+        // JSPI (JavaScript Promise Integration), in its final form
+        return typeof WebAssembly === "object" &&
+            typeof WebAssembly.Suspending === "function" &&
+            typeof WebAssembly.promising === "function";
+    }
+
 @E5 var libav;
     var nodejs = (typeof process !== "undefined");
 
@@ -64,16 +80,24 @@
     // Proxy our detection functions
     libav.isWebAssemblySupported = isWebAssemblySupported;
     libav.isThreadingSupported = isThreadingSupported;
+    libav.isSIMDSupported = isSIMDSupported;
+    libav.isJSPISupported = isJSPISupported;
 
     // Get the target that will load, given these options
     function target(opts) {
         opts = opts || {};
         var wasm = !opts.nowasm && isWebAssemblySupported();
         var thr = opts.yesthreads && wasm && !opts.nothreads && isThreadingSupported();
+        var simd = wasm && !opts.nosimd && isSIMDSupported();
+        var jspi = opts.yesjspi && simd && isJSPISupported();
         if (!wasm)
             return "asm";
         else if (thr)
             return "thr";
+        else if (jspi)
+            return "jspi";
+        else if (simd)
+            return "simd";
         else
             return "wasm";
     }
@@ -82,6 +106,7 @@
     libav.CONFIG = "@VARIANT";
     libav.DBG = "@DBG";
     libav.factories = {};
+    libav.wasmmodules = {};
 
     // Statics that are provided both by LibAV and by libav instances
     var libavStatics = {};
@@ -146,6 +171,13 @@
         }
     };
 
+    libavStatics.ff_batch_ref = function(step) {
+        return {
+            libavjsRef: step,
+            path: Array.prototype.slice.call(arguments, 1)
+        };
+    };
+
     libavStatics.AV_VERSION_INT = function(maj, min, rev) {
         return maj << 16 | min << 8 | rev;
     };
@@ -282,6 +314,10 @@
 @E5        "js";
         var ret;
 
+        // Use the precompiled module if there is one
+        var wasmmodule = opts.wasmmodule || libav.wasmmodule ||
+            libav.wasmmodules[wasmURL(opts)];
+
         var mode = "direct";
         if (t === "thr")
             mode = "threads";
@@ -353,7 +389,8 @@
                     ret.worker.postMessage({
                         config: {
                             variant: opts.variant || libav.variant,
-                            wasmurl: opts.wasmurl || libav.wasmurl
+                            wasmurl: opts.wasmurl || libav.wasmurl,
+                            wasmmodule: wasmmodule
                         }
                     });
 
@@ -369,6 +406,17 @@
                         onwrite: [function(args) {
                             if (ret.onwrite)
                                 ret.onwrite.apply(ret, args);
+                            else if (ret.onwritemulti)
+                                ret.onwritemulti(args[0], [[args[1], args[2]]]);
+                        }, null],
+                        onwritemulti: [function(args) {
+                            if (ret.onwritemulti) {
+                                ret.onwritemulti.apply(ret, args);
+                            } else if (ret.onwrite) {
+                                var writes = args[1];
+                                for (var i = 0; i < writes.length; i++)
+                                    ret.onwrite(args[0], writes[i][0], writes[i][1]);
+                            }
                         }, null],
                         onread: [function(args) {
                             try {
@@ -441,23 +489,107 @@
                 return Promise.all([]).then(function() {
                     return factory({
                         wasmurl: opts.wasmurl || libav.wasmurl,
-                        variant: opts.variant || libav.variant
+                        wasmmodule: wasmmodule,
+                        variant: opts.variant || libav.variant,
+                        pthreadPoolSize:
+                            opts.pthreadPoolSize || libav.pthreadPoolSize
                     });
                 }).then(function(x) {
                     ret = x;
 
-                    // Get the worker
-                    var pthreadT = ret.libavjs_create_main_thread();
-                    var worker = ret.PThread.pthreads[pthreadT];
-                    var ready = 0;
+                    // The libav.js thread's worker, and the ring to it if any
+                    var worker = null;
+                    var ring = null;
 
                     // Our handlers
                     var on = 1;
                     var handlers = {};
-                    var readyPromiseRes = null;
-                    var readyPromise = new Promise(function(res) {
-                        readyPromiseRes = res;
-                    });
+
+                    // Return from a command
+                    function onret(a) {
+                        var h = handlers[a[0]];
+                        if (h) {
+                            if (a[2])
+                                h[0](a[3]);
+                            else
+                                h[1](a[3]);
+                            delete handlers[a[0]];
+                        }
+                    }
+
+                    /* Start the libav.js thread. Resolves when it's ready.
+                     * Also used to restart it after a reset. */
+                    function startThread() {
+                        // Get the worker
+                        var pthreadT = ret.libavjs_create_main_thread();
+                        worker = ret.PThread.pthreads[pthreadT];
+
+                        var readyPromiseRes = null;
+                        var readyPromise = new Promise(function(res) {
+                            readyPromiseRes = res;
+                        });
+
+                        /* Optionally, pass commands and results through rings
+                         * in shared memory instead of posting them */
+                        ring = null;
+                        var ringSize = opts.ring || libav.ring;
+                        if (ringSize) {
+                            if (typeof ringSize !== "number")
+                                ringSize = 1024 * 1024;
+                            var size = 4096;
+                            while (size < ringSize)
+                                size *= 2;
+                            var sab = new SharedArrayBuffer(2 * (16 + size));
+                            worker.postMessage({
+                                c: "libavjs_ring_init",
+                                sab: sab,
+                                size: size
+                            });
+                            ring = ret.libavjsRingChannel(
+                                sab, size, 0, function(msg, transfer) {
+                                    worker.postMessage(msg, transfer);
+                                }, onret);
+                        }
+
+                        var origOnmessage = worker.onmessage;
+                        worker.onmessage = function(e) {
+                            if (e.data && e.data.c === "libavjs_ret") {
+                                onret(e.data.a);
+                            } else if (e.data && ring &&
+                                       (e.data.c === "libavjs_ring" ||
+                                        e.data.c === "libavjs_ring_wake")) {
+                                ring.posted(e.data);
+                            } else if (e.data && e.data.c === "libavjs_wait_reader") {
+                                if (ret.readerDevReady(e.data.fd)) {
+                                    worker.postMessage({
+                                        c: "libavjs_wait_reader",
+                                        fd: e.data.fd
+                                    });
+                                } else {
+                                    var name = ret.fdName(e.data.fd);
+                                    var waiters =
+                                        ret.ff_reader_dev_waiters[name];
+                                    if (!waiters) {
+                                        waiters =
+                                            ret.ff_reader_dev_waiters[name] =
+                                            [];
+                                    }
+                                    waiters.push(function() {
+                                        worker.postMessage({
+                                            c: "libavjs_wait_reader",
+                                            fd: e.data.fd
+                                        });
+                                    });
+                                }
+                            } else if (e.data && e.data.c === "libavjs_ready") {
+                                readyPromiseRes();
+                            } else {
+                                return origOnmessage.apply(this, arguments);
+                            }
+                        };
+
+                        return readyPromise;
+                    }
 
                     // And passthru functions
                     ret.c = function() {
@@ -466,53 +598,15 @@
                             var id = on++;
                             msg = [id].concat(msg);
                             handlers[id] = [res, rej];
-                            worker.postMessage({
-                                c: "libavjs_run",
-                                a: msg
-                            });
-                        });
-                    };
-
-                    var origOnmessage = worker.onmessage;
-                    worker.onmessage = function(e) {
-                        if (e.data && e.data.c === "libavjs_ret") {
-                            // Return from a command
-                            var a = e.data.a;
-                            var h = handlers[a[0]];
-                            if (h) {
-                                if (a[2])
-                                    h[0](a[3]);
-                                else
-                                    h[1](a[3]);
-                                delete handlers[a[0]];
-                            }
-                        } else if (e.data && e.data.c === "libavjs_wait_reader") {
-                            if (ret.readerDevReady(e.data.fd)) {
-                                worker.postMessage({
-                                    c: "libavjs_wait_reader",
-                                    fd: e.data.fd
-                                });
+                            if (ring) {
+                                ring.send(msg);
                             } else {
-                                var name = ret.fdName(e.data.fd);
-                                var waiters =
-                                    ret.ff_reader_dev_waiters[name];
-                                if (!waiters) {
-                                    waiters =
-                                        ret.ff_reader_dev_waiters[name] =
-                                        [];
-                                }
-                                waiters.push(function() {
-                                    worker.postMessage({
-                                        c: "libavjs_wait_reader",
-                                        fd: e.data.fd
-                                    });
+                                worker.postMessage({
+                                    c: "libavjs_run",
+                                    a: msg
                                 });
                             }
-                        } else if (e.data && e.data.c === "libavjs_ready") {
-                            readyPromiseRes();
-                        } else {
-                            return origOnmessage.apply(this, arguments);
-                        }
+                        });
                     };
 
                     // Termination is more complicated
@@ -524,7 +618,29 @@
                         });
                     };
 
-                    return readyPromise;
+                    /* Every thread's state is on the heap, including the
+                     * libav.js thread's, so to reset, stop every running
+                     * thread, reset from here, and start the libav.js thread
+                     * again. Stopping them is left to emscripten's own
+                     * PThread.terminateAllThreads. Idle threads in the pool
+                     * have no state, and threads can't always be started when
+                     * they're needed, so the pool is set aside and kept. */
+                    ret.libavjsResetThreads = function() {
+                        for (var id in handlers)
+                            handlers[id][1](new Error("libav.js was reset"));
+                        handlers = {};
+
+                        var PThread = ret.PThread;
+                        var pool = PThread.unusedWorkers.splice(0);
+                        PThread.terminateAllThreads();
+                        Array.prototype.push.apply(PThread.unusedWorkers, pool);
+                        worker = ring = null;
+
+                        ret.libavjsReset();
+                        return startThread();
+                    };
+
+                    return startThread();
                 });
 
             } else { // Direct mode
@@ -532,6 +648,7 @@
                 return Promise.all([]).then(function() {
                     return factory({
                         wasmurl: opts.wasmurl || libav.wasmurl,
+                        wasmmodule: wasmmodule,
                         variant: opts.variant || libav.variant
                     });
                 }).then(function(x) {
@@ -587,32 +704,554 @@
                 });
             }
 
+            /* Measure indirect calls from this side, so including messaging
+             * (see stats) */
+            var dispatch = {};
+            function measureDispatch(funcs) {
+                funcs.forEach(function(f) {
+                    var indirect = ret[f];
+                    var st = dispatch[f] = {
+                        calls: 0, time: 0, max_time: 0, transfers: 0
+                    };
+                    function done(start) {
+                        var time = performance.now() - start;
+                        st.time += time;
+                        if (time > st.max_time)
+                            st.max_time = time;
+                    }
+                    ret[f] = function() {
+                        st.calls++;
+                        if (mode === "worker") {
+                            for (var i = 0; i < arguments.length; i++) {
+                                var a = arguments[i];
+                                if (a && a.libavjsTransfer)
+                                    st.transfers += a.libavjsTransfer.length;
+                            }
+                        }
+                        var start = performance.now();
+                        return indirect.apply(ret, arguments).then(function(x) {
+                            done(start);
+                            return x;
+                        }, function(ex) {
+                            done(start);
+                            throw ex;
+                        });
+                    };
+                });
+            }
+
             var funcs = @FUNCS;
             var localFuncs = @LOCALFUNCS;
+            var stats = !!(opts.stats || libav.stats);
+            var statsReady = null;
 
             ret.libavjsMode = mode;
             if (mode === "worker") {
                 // All indirect
                 indirectors(funcs);
                 indirectors(localFuncs);
+                if (stats) {
+                    statsReady = ret.c("libavjsStatsEnable",
+                        funcs.concat(localFuncs));
+                    measureDispatch(funcs);
+                    measureDispatch(localFuncs);
+                }
 
             } else if (mode === "threads") {
                 // Some funcs are direct, rest are indirect
                 indirectors(funcs);
+                if (stats) {
+                    statsReady = ret.c("libavjsStatsEnable", funcs);
+                    measureDispatch(funcs);
+                    ret.libavjsStatsEnable(localFuncs);
+                }
                 directs(localFuncs);
 
             } else { // direct
                 // All direct
+                if (stats)
+                    ret.libavjsStatsEnable(funcs.concat(localFuncs));
                 directs(funcs);
                 directs(localFuncs);
 
             }
 
+            // In the threads mode, resetting involves every thread
+            if (mode === "threads") {
+                ret.ff_reset = function() {
+                    return Promise.all([]).then(ret.libavjsResetThreads);
+                };
+            }
+
+            // Instrumentation
+            ret.stats = function(sopts) {
+                var reset = !!(sopts && sopts.reset);
+                if (!stats)
+                    return Promise.resolve(null);
+
+                var p;
+                if (mode === "direct")
+                    p = Promise.resolve(ret.libavjsStatsGet(reset));
+                else
+                    p = ret.c("libavjsStatsGet", reset);
+                return p.then(function(st) {
+                    st.mode = mode;
+                    if (mode === "threads") {
+                        // Direct functions ran here
+                        Object.assign(st.functions,
+                            ret.libavjsStatsGet(reset).functions);
+                    }
+                    if (mode !== "direct") {
+                        st.dispatch = {};
+                        for (var f in dispatch) {
+                            var d = dispatch[f];
+                            if (!d.calls)
+                                continue;
+                            st.dispatch[f] = Object.assign({}, d);
+                            if (reset)
+                                d.calls = d.time = d.max_time = d.transfers = 0;
+                        }
+                    }
+                    return st;
+                });
+            };
+
             // Apply the statics
             Object.assign(ret, libavStatics);
 
-            return ret;
+            return Promise.all([statsReady]).then(function() {
+                return ret;
+            });
+        });
+    }
+
+    /* Compile the WebAssembly module that LibAV.LibAV would load with these
+     * options, so that several instances can share it rather than each
+     * fetching and compiling it. The module is remembered in
+     * LibAV.wasmmodules, so later instances use it automatically. Resolves to
+     * null if asm.js would be loaded. */
+    libav.compile = function(opts) {
+        opts = opts || {};
+        var url = wasmURL(opts);
+        if (!url)
+            return Promise.resolve(null);
+        if (libav.wasmmodules[url])
+            return Promise.resolve(libav.wasmmodules[url]);
+
+        var p;
+        if (nodejs) {
+@E6         var fsp = import("fs/promises");
+@E5         var fsp = Promise.resolve(require("fs/promises"));
+            p = fsp.then(function(fs) {
+                return fs.readFile(/^file:/.test(url) ? new URL(url) : url);
+            }).then(function(buf) {
+                return WebAssembly.compile(buf);
+            });
+
+        } else {
+            p = fetch(url).then(function(resp) {
+                if (!resp.ok)
+                    throw new Error("Failed to fetch " + url + ": " + resp.status);
+                var type = resp.headers.get("content-type") || "";
+                if (WebAssembly.compileStreaming && /wasm/.test(type))
+                    return WebAssembly.compileStreaming(resp);
+                return resp.arrayBuffer().then(function(ab) {
+                    return WebAssembly.compile(ab);
+                });
+            });
+
+        }
+
+        return p.then(function(module) {
+            return libav.wasmmodules[url] = module;
         });
+    };
+
+    // The URL of the .wasm file that LibAV.LibAV would load, or null for asm.js
+    function wasmURL(opts) {
+        var t = target(opts);
+        if (t === "asm")
+            return null;
+        return opts.wasmurl || libav.wasmurl ||
+            (opts.base || libav.base) + "/libav-@VER-" +
+            (opts.variant || libav.variant || "@VARIANT") + "@DBG." + t +
+            ".wasm";
+    }
+
+    /* Create a pool of instances sharing one compiled module, and a scheduler
+     * for running jobs on them */
+    libav.pool = function(opts) {
+        opts = Object.assign({}, opts || {});
+        var size = opts.size ||
+            (typeof navigator !== "undefined" && navigator.hardwareConcurrency) ||
+            4;
+        var concurrency = opts.concurrency || 1;
+
+        return Promise.all([]).then(function() {
+            if (opts.wasmmodule || libav.wasmmodule)
+                return opts.wasmmodule || libav.wasmmodule;
+            return libav.compile(opts);
+        }).then(function(wasmmodule) {
+            if (wasmmodule)
+                opts.wasmmodule = wasmmodule;
+            var ps = [];
+            for (var i = 0; i < size; i++)
+                ps.push(libav.LibAV(opts));
+            return Promise.all(ps);
+        }).then(function(instances) {
+            return mkpool(instances, concurrency);
+        });
+    };
+
+    // Make the pool object for these instances. Used by LibAV.pool.
+    function mkpool(instances, concurrency) {
+        var workers = instances.map(function(instance) {
+            return {
+                libav: instance,
+                queue: [],
+                running: 0,
+                completed: 0,
+                failed: 0
+            };
+        });
+        var affinities = Object.create(null);
+        var terminated = false;
+
+        // Start the next jobs on worker wi, as far as its concurrency allows
+        function pump(wi) {
+            var w = workers[wi];
+            while (w.running < concurrency && w.queue.length) (function(job) {
+                w.running++;
+                Promise.all([]).then(function() {
+                    return job.fn(w.libav, wi);
+                }).then(function(x) {
+                    w.running--;
+                    w.completed++;
+                    pump(wi);
+                    job.res(x);
+                }, function(ex) {
+                    w.running--;
+                    w.failed++;
+                    pump(wi);
+                    job.rej(ex);
+                });
+            })(w.queue.shift());
+        }
+
+        // The least loaded worker
+        function leastLoaded() {
+            var best = 0, bestDepth = 1/0;
+            for (var wi = 0; wi < workers.length; wi++) {
+                var depth = workers[wi].queue.length + workers[wi].running;
+                if (depth < bestDepth) {
+                    best = wi;
+                    bestDepth = depth;
+                }
+            }
+            return best;
+        }
+
+        var pool = {
+            size: instances.length,
+            instances: instances,
+
+            // Run a job, on the worker with its affinity, or the least loaded
+            run: function(fn, ropts) {
+                if (terminated)
+                    return Promise.reject(new Error("Pool terminated"));
+                var affinity = ropts ? ropts.affinity : void 0;
+                var wi;
+                if (typeof affinity === "undefined" || affinity === null) {
+                    wi = leastLoaded();
+                } else {
+                    affinity = "" + affinity;
+                    if (!(affinity in affinities))
+                        affinities[affinity] = leastLoaded();
+                    wi = affinities[affinity];
+                }
+                return new Promise(function(res, rej) {
+                    workers[wi].queue.push({fn: fn, res: res, rej: rej});
+                    pump(wi);
+                });
+            },
+
+            // Find the worker an affinity is bound to, or -1
+            worker: function(affinity) {
+                affinity = "" + affinity;
+                return (affinity in affinities) ? affinities[affinity] : -1;
+            },
+
+            // Forget an affinity, so its next job goes to the least loaded worker
+            release: function(affinity) {
+                delete affinities["" + affinity];
+            },
+
+            // Per-worker queue depths and counts of jobs
+            stats: function() {
+                return workers.map(function(w) {
+                    return {
+                        queued: w.queue.length,
+                        running: w.running,
+                        completed: w.completed,
+                        failed: w.failed
+                    };
+                });
+            },
+
+            // Terminate every instance, failing any jobs still queued
+            terminate: function() {
+                terminated = true;
+                workers.forEach(function(w) {
+                    var queue = w.queue;
+                    w.queue = [];
+                    queue.forEach(function(job) {
+                        job.rej(new Error("Pool terminated"));
+                    });
+                    w.libav.terminate();
+                });
+            },
+
+            // Transcode a stream in segments, in parallel on the instances
+            transcode: function(topts) {
+                return segmentedTranscode(pool, topts);
+            }
+        };
+        return pool;
+    }
+
+    /* Transcode one stream of a file in segments, split at its keyframes and
+     * transcoded in parallel on the pool's instances (with
+     * ff_transcode_segment), then concatenate and mux the segments. Resolves
+     * to the muxed output. Used by pool.transcode. */
+    function segmentedTranscode(pool, opts) {
+        var info, tb;
+
+        // Find the stream, its keyframes, and what the output format needs
+        return pool.run(function(libav) {
+            var fmt_ctx, pkt, index;
+            var ret = {};
+            return libav.ff_init_demuxer_file(
+                opts.input, opts.format
+            ).then(function(r) {
+                fmt_ctx = r[0];
+                var streams = r[1];
+                var stream = null;
+                if (typeof opts.stream_index === "number") {
+                    stream = streams[opts.stream_index];
+                } else {
+                    for (var i = 0; i < streams.length; i++) {
+                        if (streams[i].codec_type === libav.AVMEDIA_TYPE_VIDEO) {
+                            stream = streams[i];
+                            break;
+                        }
+                    }
+                }
+                if (!stream)
+                    throw new Error("Stream to transcode not found");
+                ret.stream_index = stream.index;
+                ret.time_base = [stream.time_base_num, stream.time_base_den];
+                return Promise.all([
+                    libav.av_packet_alloc(), libav.ff_seek_index_alloc()
+                ]);
+
+            }).then(function(r) {
+                pkt = r[0];
+                index = r[1];
+                return libav.ff_seek_index_scan(index, fmt_ctx, pkt);
+
+            }).then(function() {
+                return libav.ff_seek_index_entries(index, ret.stream_index);
+
+            }).then(function(entries) {
+                ret.keyframes = entries.map(function(e) { return e.ts; });
+                return libav.ff_seek_index_export(index);
+
+            }).then(function(seekIndex) {
+                ret.seekIndex = seekIndex;
+                return libav.ff_init_muxer({
+                    filename: opts.output,
+                    format_name: opts.format_name
+                }, []);
+
+            }).then(function(r) {
+                return libav.AVOutputFormat_flags(r[1]).then(function(flags) {
+                    ret.globalHeader =
+                        !!(flags & 0x40 /* AVFMT_GLOBALHEADER */);
+                    return libav.ff_free_muxer(r[0], 0);
+                });
+
+            }).then(function() {
+                return Promise.all([
+                    libav.ff_seek_index_free(index),
+                    libav.av_packet_free_js(pkt),
+                    libav.avformat_close_input_js(fmt_ctx)
+                ]);
+
+            }).then(function() {
+                return ret;
+            });
+
+        }).then(function(ret) {
+            info = ret;
+            tb = opts.time_base || info.time_base;
+
+            /* Split at the keyframes nearest after even divisions of the
+             * keyframes' time span */
+            var kf = info.keyframes;
+            var n = Math.max(1,
+                Math.min(opts.segments || pool.size, kf.length));
+            var splits = [];
+            var ki = 1;
+            for (var i = 1; i < n; i++) {
+                var target = kf[0] + (kf[kf.length - 1] - kf[0]) * i / n;
+                while (ki < kf.length && kf[ki] < target)
+                    ki++;
+                if (ki >= kf.length)
+                    break;
+                splits.push(kf[ki++]);
+            }
+
+            var options = Object.assign({}, opts.options || {});
+            if (info.globalHeader)
+                options.flags = (options.flags || "") + "+global_header";
+
+            var starts = [void 0].concat(splits);
+            return Promise.all(starts.map(function(start, si) {
+                var sopts = {
+                    format: opts.format,
+                    stream_index: info.stream_index,
+                    start: start,
+                    end: splits[si],
+                    seekIndex: info.seekIndex,
+                    decoder_options: opts.decoder_options,
+                    codec: opts.codec,
+                    ctx: opts.ctx,
+                    time_base: tb,
+                    options: options
+                };
+                return pool.run(function(libav) {
+                    return libav.ff_transcode_segment(opts.input, sopts);
+                });
+            }));
+
+        }).then(function(segments) {
+            /* Concatenate the segments. Their timestamps are the input's, so
+             * a segment only needs to be shifted if its decoding timestamps
+             * overlap the previous segment's (from mismatched encoder
+             * delays), and then its presentation timestamps are shifted by
+             * the same amount. The segments' encoders are configured alike,
+             * so they should have the same extradata; muxers generally ignore
+             * changes to it, so segments that don't are rejected. */
+            var codecpar = segments[0].codecpar;
+            var packets = [];
+            var lastDts = -1/0;
+            segments.forEach(function(seg, si) {
+                if (!sameBytes(seg.codecpar.extradata, codecpar.extradata)) {
+                    throw new Error("Segment " + si +
+                        " was encoded with different extradata");
+                }
+
+                function ts(lo, hi) {
+                    if (lo === 0 && hi === -0x80000000 /* AV_NOPTS_VALUE */)
+                        return null;
+                    return libavStatics.i64tof64(lo, hi);
+                }
+
+                var firstDts = null;
+                seg.packets.forEach(function(packet) {
+                    var dts = ts(packet.dts, packet.dtshi);
+                    if (dts !== null && (firstDts === null || dts < firstDts))
+                        firstDts = dts;
+                });
+                var shift = 0;
+                if (firstDts !== null && firstDts <= lastDts)
+                    shift = lastDts + 1 - firstDts;
+
+                seg.packets.forEach(function(packet) {
+                    var dts = ts(packet.dts, packet.dtshi);
+                    var pts = ts(packet.pts, packet.ptshi);
+                    var i64;
+                    if (dts !== null) {
+                        dts += shift;
+                        i64 = libavStatics.f64toi64(dts);
+                        packet.dts = i64[0];
+                        packet.dtshi = i64[1];
+                        lastDts = Math.max(lastDts, dts);
+                    }
+                    if (pts !== null) {
+                        i64 = libavStatics.f64toi64(pts + shift);
+                        packet.pts = i64[0];
+                        packet.ptshi = i64[1];
+                    }
+                    packet.stream_index = 0;
+                    packet.time_base_num = tb[0];
+                    packet.time_base_den = tb[1];
+                    packets.push(packet);
+                });
+            });
+
+            // And mux them
+            return pool.run(function(libav) {
+                var par, oc, pb, pkt;
+                return libav.avcodec_parameters_alloc().then(function(r) {
+                    par = r;
+                    return libav.ff_copyin_codecpar(par, codecpar);
+
+                }).then(function() {
+                    return libav.ff_init_muxer({
+                        filename: opts.output,
+                        format_name: opts.format_name,
+                        open: true,
+                        codecpars: true
+                    }, [[par, tb[0], tb[1]]]);
+
+                }).then(function(r) {
+                    oc = r[0];
+                    pb = r[2];
+                    return libav.avformat_write_header(oc, 0);
+
+                }).then(function(ret) {
+                    if (ret < 0)
+                        throw new Error("Error writing header: " + ret);
+                    return libav.av_packet_alloc();
+
+                }).then(function(r) {
+                    pkt = r;
+                    return libav.ff_write_multi(oc, pkt, packets);
+
+                }).then(function() {
+                    return libav.av_write_trailer(oc);
+
+                }).then(function() {
+                    return Promise.all([
+                        libav.ff_free_muxer(oc, pb),
+                        libav.av_packet_free_js(pkt),
+                        libav.avcodec_parameters_free_js(par)
+                    ]);
+
+                }).then(function() {
+                    return libav.readFile(opts.output);
+
+                }).then(function(data) {
+                    return libav.unlink(opts.output).then(function() {
+                        return data;
+                    });
+                });
+            });
+        });
+    }
+
+    // Whether these two byte arrays (or nulls) are the same
+    function sameBytes(a, b) {
+        if (!a || !b)
+            return a === b;
+        if (a.length !== b.length)
+            return false;
+        for (var i = 0; i < a.length; i++) {
+            if (a[i] !== b[i])
+                return false;
+        }
+        return true;
     }
 
 @E5 if (nodejs)
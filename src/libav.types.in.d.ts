@@ -165,6 +165,135 @@ declare namespace LibAV {
         side_data?: any;
     }
 
+    /**
+     * Frames as views into libav.js's heap, as returned by the "view" version
+     * of ff_copyout_frame. Only available when libav.js is running in the
+     * caller's thread.
+     */
+    export interface FrameView extends Frame {
+        /**
+         * The AVFrame holding a reference to this frame's data.
+         */
+        ptr: number;
+
+        /**
+         * Release this frame, freeing ptr. data may not be used after release.
+         */
+        release(): void;
+    }
+
+    /**
+     * An audio format to convert frames to as they're copied in or out. Any
+     * field not given is kept from the frame being converted.
+     */
+    export interface AudioFormat {
+        /**
+         * Sample format.
+         */
+        format?: number;
+
+        /**
+         * Channel layout, as a mask.
+         */
+        channel_layout?: number, channel_layouthi?: number;
+
+        /**
+         * Sample rate. Only resamplers (ff_init_resampler) can change it.
+         * Converting a frame as it's copied in or out only accepts the
+         * frame's own rate.
+         */
+        sample_rate?: number;
+    }
+
+    /**
+     * A video format to convert frames to as they're copied out. Any field not
+     * given is kept from the frame being converted, except that if only one of
+     * width and height is given, the other is chosen to keep the frame's
+     * shape.
+     */
+    export interface VideoFormat {
+        /**
+         * Pixel format.
+         */
+        format?: number;
+
+        /**
+         * Size to scale to.
+         */
+        width?: number, height?: number;
+    }
+
+    /**
+     * The format for a scaler (see ff_init_scaler).
+     */
+    export interface ScalerFormat extends VideoFormat {
+        /**
+         * SWS_* flags. Bilinear by default.
+         */
+        flags?: number;
+
+        /**
+         * Number of slice threads, or 0 for one per core. By default, one per
+         * core in the threaded build, and one otherwise.
+         */
+        threads?: number;
+    }
+
+    /**
+     * Packets as views into libav.js's heap, as returned by the "view" version
+     * of ff_copyout_packet. Only available when libav.js is running in the
+     * caller's thread.
+     */
+    export interface PacketView extends Packet {
+        /**
+         * The AVPacket holding a reference to this packet's data.
+         */
+        ptr: number;
+
+        /**
+         * Release this packet, freeing ptr. data may not be used after
+         * release.
+         */
+        release(): void;
+    }
+
+    /**
+     * Statistics of a frame or packet pool, as returned by
+     * ff_frame_pool_get_stats and ff_packet_pool_get_stats.
+     */
+    export interface PoolStats {
+        /**
+         * Number of frames/packets allocated over the pool's lifetime.
+         */
+        allocated: number;
+
+        /**
+         * Number of frames/packets acquired from the pool and not yet
+         * released.
+         */
+        in_use: number;
+
+        /**
+         * Number of frames/packets waiting in the pool to be reused.
+         */
+        free: number;
+
+        /**
+         * Number of acquisitions that reused a released frame/packet.
+         */
+        reused: number;
+
+        /**
+         * Number of data buffers taken from the pool's buffer pools.
+         */
+        buffers: number;
+
+        /**
+         * Number of buffer pools (one per buffer size) created.
+         */
+        buffer_pools: number;
+    }
+
     /**
      * Stream information, as returned by ff_init_demuxer_file.
      */
@@ -238,6 +367,24 @@ declare namespace LibAV {
         metadata?: Record<string, string>;
     }
 
+    /**
+     * Options for writer devices and writer filesystems.
+     */
+    export interface WriterDevOptions {
+        /**
+         * Buffer writes, merging contiguous writes and delivering them in
+         * blocks of up to this many bytes. Unbuffered if unset.
+         */
+        bufferSize?: number;
+
+        /**
+         * Deliver buffered writes at most this many milliseconds after
+         * they're written. Default 100. 0 to only deliver them when the
+         * buffer fills, the file is closed, or on ff_writer_dev_flush.
+         */
+        flushTime?: number;
+    }
+
     /**
      * Codec parameters, if copied out.
      */
@@ -401,11 +548,21 @@ declare namespace LibAV {
         sample_aspect_ratio_den?: number;
         sample_fmt?: number;
         sample_rate?: number;
+        thread_count?: number;
+        thread_type?: number;
         qmax?: number;
         qmin?: number;
         width?: number;
     }
 
+    /**
+     * A reference to the result of an earlier call in a batch.
+     */
+    export interface BatchRef {
+        libavjsRef: number;
+        path?: (string | number)[];
+    }
+
     /**
      * Static properties that are accessible both on the LibAV wrapper and on each
      * libav instance.
@@ -465,6 +622,16 @@ declare namespace LibAV {
             channels?: number
         }): number;
 
+        /**
+         * Make a reference to the result of an earlier call in a batch (see
+         * ff_batch). The rest of the arguments are a path into that result;
+         * for instance, `ff_batch_ref(0, 1, 0)` refers to the packets of
+         * stream 0 from an `ff_read_frame_multi` in step 0.
+         * @param step  Index of the call in the batch
+         * @param path  Path of properties into its result
+         */
+        ff_batch_ref(step: number, ...path: (string | number)[]): BatchRef;
+
         /**
          * Convert a major, minor, and revision number to the internal integer
          * version representation used in libav. Note that these version numbers
@@ -624,6 +791,61 @@ declare namespace LibAV {
         AVERROR_EOF: number;
     }
 
+    /**
+     * Statistics of calls to a single function, as measured by instrumentation
+     * (see LibAV.stats). Times are in milliseconds.
+     */
+    export interface FunctionStats {
+        calls: number;
+        time: number;
+        max_time: number;
+
+        /**
+         * Bytes in typed arrays passed in as arguments (only where the
+         * function ran).
+         */
+        bytes_in?: number;
+
+        /**
+         * Bytes in typed arrays returned (only where the function ran).
+         */
+        bytes_out?: number;
+
+        /**
+         * ArrayBuffers transferred between threads.
+         */
+        transfers: number;
+    }
+
+    /**
+     * Instrumentation statistics, from LibAV.stats.
+     */
+    export interface Stats {
+        mode: "direct" | "worker" | "threads";
+
+        /**
+         * Statistics measured where each function ran.
+         */
+        functions: Record<string, FunctionStats>;
+
+        /**
+         * In the worker and threads modes, statistics of the same calls
+         * measured from the calling side, so including messaging.
+         */
+        dispatch?: Record<string, FunctionStats>;
+
+        /**
+         * Heap usage (as allocated by malloc) and size, in bytes, and their
+         * high-water marks.
+         */
+        heap: {
+            used: number;
+            max_used: number;
+            size: number;
+            max_size: number;
+        };
+    }
+
     /**
      * A LibAV instance, created by LibAV.LibAV (*not* the LibAV wrapper itself)
      */
@@ -686,6 +908,16 @@ declare namespace LibAV {
             flags: number
         ): Promise<number>;
 
+        /**
+         * Seek to the last keyframe at or before timestamp 'ts' in
+         * 'stream_index' known to the seek index 'index'. See
+         * ff_seek_index_export.
+         */
+        ff_seek_index_seek(
+            index: number, s: number, stream_index: number,
+            tslo: number, tshi: number, flags: number
+        ): Promise<number>;
+
         /**
          * Get the depth of this component of this pixel format.
          */
@@ -697,6 +929,13 @@ declare namespace LibAV {
          */
         onwrite?: (filename: string, position: number, buffer: Uint8Array | Int8Array) => void;
 
+        /**
+         * Callback for batches of writes from buffered writer devices, as
+         * [position, buffer] pairs, in order. Set by the user. If unset,
+         * onwrite is called for each write instead.
+         */
+        onwritemulti?: (filename: string, writes: [number, Uint8Array][]) => void;
+
         /**
          * Callback for stream reader devices. Set by the user.
          */
@@ -707,6 +946,13 @@ declare namespace LibAV {
          */
         onblockread?: (filename: string, pos: number, length: number) => void;
 
+        /**
+         * Get the statistics gathered by instrumentation, if this instance
+         * was created with the stats option. Resolves to null otherwise.
+         * @param opts  If reset is set, reset the statistics after reading them
+         */
+        stats(opts?: {reset?: boolean}): Promise<Stats | null>;
+
         /**
          * Terminate the worker associated with this libav.js instance, rendering
          * it inoperable and freeing its memory.
@@ -746,6 +992,29 @@ declare namespace LibAV {
          */
         nothreads?: boolean;
 
+        /**
+         * Don't use the WebAssembly SIMD build, even if SIMD is supported.
+         */
+        nosimd?: boolean;
+
+        /**
+         * Use the JSPI build if JSPI is supported, rather than the SIMD build
+         * that suspends with Asyncify. Experimental.
+         */
+        yesjspi?: boolean;
+
+        /**
+         * In the threads mode, pass calls and their results through rings in
+         * shared memory instead of posting messages. May be the size of each
+         * ring in bytes. Ignored in other modes.
+         */
+        ring?: boolean | number;
+
+        /**
+         * Instrument calls, to gather statistics readable with LibAV.stats.
+         */
+        stats?: boolean;
+
         /**
          * Don't use ES6 modules for loading, even if libav.js was compiled as an
          * ES6 module.
@@ -776,6 +1045,171 @@ declare namespace LibAV {
          * The full URL from which to load the .wasm file.
          */
         wasmurl?: string;
+
+        /**
+         * A precompiled WebAssembly.Module to instantiate, instead of loading
+         * and compiling the .wasm file.
+         */
+        wasmmodule?: any;
+
+        /**
+         * Number of threads to start with, in the threaded build. Default one
+         * per core, plus one.
+         */
+        pthreadPoolSize?: number;
+    }
+
+    /**
+     * Options for a pool of LibAV instances.
+     */
+    export interface LibAVPoolOpts extends LibAVOpts {
+        /**
+         * Number of instances. Defaults to the hardware concurrency.
+         */
+        size?: number;
+
+        /**
+         * Number of jobs to run at once on each instance. Default 1.
+         */
+        concurrency?: number;
+    }
+
+    /**
+     * A job's options in a pool.
+     */
+    export interface LibAVPoolJobOpts {
+        /**
+         * Jobs with the same affinity key run on the same instance, until the
+         * key is released.
+         */
+        affinity?: string | number;
+    }
+
+    /**
+     * Statistics for one instance in a pool.
+     */
+    export interface LibAVPoolStats {
+        /**
+         * Jobs waiting to run.
+         */
+        queued: number;
+
+        /**
+         * Jobs running.
+         */
+        running: number;
+
+        /**
+         * Jobs that succeeded.
+         */
+        completed: number;
+
+        /**
+         * Jobs that failed.
+         */
+        failed: number;
+    }
+
+    /**
+     * A pool of LibAV instances, sharing one compiled module.
+     */
+    /**
+     * Options for segmented transcoding with a pool.
+     */
+    export interface LibAVSegmentedTranscodeOpts {
+        /**
+         * Input file, which must be available on every instance.
+         */
+        input: string;
+
+        /**
+         * Input format, if it shouldn't be probed.
+         */
+        format?: string;
+
+        /**
+         * Input stream to transcode. By default, the first video stream.
+         */
+        stream_index?: number;
+
+        /**
+         * Output file name. The output format is guessed from it, unless
+         * format_name is set.
+         */
+        output: string;
+
+        /**
+         * Output format.
+         */
+        format_name?: string;
+
+        /**
+         * Number of segments. By default, the pool's size.
+         */
+        segments?: number;
+
+        /**
+         * Options for the decoder, as in ff_init_decoder.
+         */
+        decoder_options?: Record<string, string>;
+
+        /**
+         * Encoder, and its context properties, time base, and options, as in
+         * ff_init_encoder.
+         */
+        codec: string;
+        ctx?: AVCodecContextProps;
+        time_base?: [number, number];
+        options?: Record<string, string>;
+    }
+
+    export interface LibAVPool {
+        /**
+         * Number of instances.
+         */
+        size: number;
+
+        /**
+         * The instances themselves.
+         */
+        instances: LibAV[];
+
+        /**
+         * Run a job on an instance.
+         * @param fn  The job, given the instance and its index
+         * @param opts  Job options
+         */
+        run<T>(
+            fn: (libav: LibAV, index: number) => T | Promise<T>,
+            opts?: LibAVPoolJobOpts
+        ): Promise<T>;
+
+        /**
+         * Get the index of the instance an affinity key is bound to, or -1.
+         */
+        worker(affinity: string | number): number;
+
+        /**
+         * Release an affinity key.
+         */
+        release(affinity: string | number): void;
+
+        /**
+         * Get the queue depth and job counts of each instance.
+         */
+        stats(): LibAVPoolStats[];
+
+        /**
+         * Terminate every instance, failing any queued jobs.
+         */
+        terminate(): void;
+
+        /**
+         * Transcode a stream in segments split at its keyframes, in parallel
+         * on the instances, and mux the concatenated segments.
+         * @param opts  Transcoding options
+         */
+        transcode(opts: LibAVSegmentedTranscodeOpts): Promise<Uint8Array>;
     }
 
     /**
@@ -789,6 +1223,25 @@ declare namespace LibAV {
         LibAV(opts?: LibAVOpts & {noworker?: false}): Promise<LibAV>;
         LibAV(opts: LibAVOpts & {noworker: true}): Promise<LibAV & LibAVSync>;
         LibAV(opts: LibAVOpts): Promise<LibAV | LibAV & LibAVSync>;
+
+        /**
+         * Compile the WebAssembly module that LibAV() would load. Later
+         * instances with the same .wasm file use it. Resolves to null if
+         * asm.js would be loaded.
+         * @param opts  Options
+         */
+        compile(opts?: LibAVOpts): Promise<any>;
+
+        /**
+         * Modules compiled by compile(), by the URL of their .wasm file.
+         */
+        wasmmodules: Record<string, any>;
+
+        /**
+         * Create a pool of instances sharing one compiled module.
+         * @param opts  Options
+         */
+        pool(opts?: LibAVPoolOpts): Promise<LibAVPool>;
     }
 }
 
@@ -14,7 +14,9 @@
  */
 
 /**
- * Bitstream-filter some number of packets.
+ * Bitstream-filter some number of packets. If `config.packetPool` is set,
+ * AVPacket pointers in inPackets are released to that pool, and "ptr" packets
+ * are taken from it.
  * @param bsf  AVBSFContext(s), input
  * @param pktPtr  AVPacket
  * @param inPackets  Input packets
@@ -22,22 +24,24 @@
  */
 /* @types
  * ff_bsf_multi@sync(
- *     bsf: number, pktPtr: number, inPackets: (Packet | number)[],
+ *     bsf: number, pktPtr: number, inPackets: (Packet | PacketView | number)[],
  *     config?: boolean | {
  *         fin?: boolean,
- *         copyoutPacket?: "default"
+ *         copyoutPacket?: "default",
+ *         packetPool?: number
  *     }
  * ): @promsync@Packet[]@
  * ff_bsf_multi@sync(
- *     bsf: number, pktPtr: number, inPackets: (Packet | number)[],
+ *     bsf: number, pktPtr: number, inPackets: (Packet | PacketView | number)[],
  *     config?: boolean | {
  *         fin?: boolean,
- *         copyoutPacket: "ptr"
+ *         copyoutPacket: "ptr",
+ *         packetPool?: number
  *     }
  * ): @promsync@number[]@
  */
 var ff_bsf_multi = Module.ff_bsf_multi = function(bsf, pktPtr, inPackets, config) {
-    var outPackets = [];
+    var outPackets;
     var transfer = [];
 
     if (typeof config === "boolean") {
@@ -50,44 +54,37 @@ var ff_bsf_multi = Module.ff_bsf_multi = function(bsf, pktPtr, inPackets, config
     var copyoutPacket = ff_copyout_packet;
     if (config.copyoutPacket)
         copyoutPacket = ff_copyout_packet_versions[config.copyoutPacket];
+    var ptrOut = (config.copyoutPacket === "ptr");
+    var outPool = config.packetPool || (ptrOut ? 0 : ff_internal_packet_pool());
+    var inp = ff_multi_packets_in(inPackets, config.packetPool);
+    var flags = config.fin ? MULTI_FLAGS.FIN : 0;
 
-    function handlePacket(inPacket) {
-        var ret;
-        if (inPacket !== null) {
-            ff_copyin_packet(pktPtr, inPacket);
-            ret = av_bsf_send_packet(bsf, pktPtr);
-        } else {
-            ret = av_bsf_flush(bsf);
-        }
-        if (ret < 0)
-            throw new Error("Error while feeding bitstream filter: " + ff_error(ret));
-        av_packet_unref(pktPtr);
+    var res = ff_multi_call(inp[0], function(inList, status, out) {
+        return ff_bsf_multi_c(
+            bsf, pktPtr, inList, inp[0].length, status, flags,
+            inp[1], outPool, out
+        );
+    });
 
-        while (true) {
-            ret = av_bsf_receive_packet(bsf, pktPtr);
-            if (ret === -6 /* EAGAIN */ || ret === -0x20464f45 /* AVERROR_EOF */)
-                break;
-            if (ret < 0)
-                throw new Error("Error while receiving a packet from the bitstream filter: " + ff_error(ret));
-
-            var outPacket = copyoutPacket(pktPtr);
+    if (res.ret < 0) {
+        ff_multi_packets_free(res.out, outPool);
+        if (res.status.indexOf(res.ret) >= 0)
+            throw new Error("Error while feeding bitstream filter: " + ff_error(res.ret));
+        throw new Error("Error while receiving a packet from the bitstream filter: " + ff_error(res.ret));
+    }
 
+    if (ptrOut) {
+        outPackets = res.out;
+    } else {
+        outPackets = res.out.map(function(ptr) {
+            var outPacket = copyoutPacket(ptr);
             if (outPacket && outPacket.libavjsTransfer && outPacket.libavjsTransfer.length)
                 transfer.push.apply(transfer, outPacket.libavjsTransfer);
-            outPackets.push(outPacket);
-            av_packet_unref(pktPtr);
-        }
+            return outPacket;
+        });
+        ff_multi_packets_free(res.out, outPool);
     }
 
-    // Handle each packet
-    for (var pi = 0; pi < inPackets.length; pi++) {
-        var inPacket = inPackets[pi];
-        handlePacket(inPacket);
-    }
-
-    if (config.fin)
-        handlePacket(null);
-
     outPackets.libavjsTransfer = transfer;
     return outPackets;
 };
@@ -72,6 +72,10 @@ var ff_init_encoder = Module.ff_init_encoder = function(name, opts) {
  * Metafunction to initialize a decoder with all the bells and whistles.
  * Similar to ff_init_encoder but doesn't need to initialize the frame.
  * Returns [AVCodec, AVCodecContext, AVPacket, AVFrame]
+ * Options are passed to avcodec_open2, as with ff_init_encoder, so, e.g.,
+ * `threads` and `thread_type` control threading. If `threads` isn't given, the
+ * threaded build uses a thread per core for video decoders that support
+ * threading, and everything else uses one thread.
  * @param name  libav decoder identifier or name
  * @param config  Decoder configuration. Can just be a number for codec
  *                parameters, or can be multiple configuration options.
@@ -80,7 +84,8 @@ var ff_init_encoder = Module.ff_init_encoder = function(name, opts) {
  * ff_init_decoder@sync(
  *     name: string | number, config?: number | {
  *         codecpar?: number | CodecParameters,
- *         time_base?: [number, number]
+ *         time_base?: [number, number],
+ *         options?: Record<string, string>
  *     }
  * ): @promise@[number, number, number, number]@
  */
@@ -129,7 +134,16 @@ var ff_init_decoder = Module.ff_init_decoder = function(name, config) {
     if (config.time_base)
         AVCodecContext_time_base_s(c, config.time_base[0], config.time_base[1]);
 
-    ret = avcodec_open2(c, codec, 0);
+    var options = 0;
+    var optionsIn = config.options || {};
+    for (var prop in optionsIn)
+        options = av_dict_set_js(options, prop, optionsIn[prop], 0);
+    if (!("threads" in optionsIn)) {
+        options = av_dict_set_js(options, "threads",
+            "" + ff_decoder_auto_threads(codec), 0);
+    }
+
+    ret = avcodec_open2_js(c, codec, options);
     if (ret < 0)
         throw new Error("Could not open codec: " + ff_error(ret));
 
@@ -178,7 +192,10 @@ var ff_free_decoder = Module.ff_free_decoder = function(c, pkt, frame) {
 
 /**
  * Encode some number of frames at once. Done in one go to avoid excess message
- * passing.
+ * passing. If `config.framePool` is set, AVFrame pointers in inFrames are
+ * released to that pool. If `config.packetPool` is set, "ptr" packets are
+ * taken from that pool. If `config.copyinAudio` is set, audio frames are
+ * converted natively to that format as they're copied in.
  * @param ctx  AVCodecContext
  * @param frame  AVFrame
  * @param pkt  AVPacket
@@ -187,17 +204,24 @@ var ff_free_decoder = Module.ff_free_decoder = function(c, pkt, frame) {
  */
 /* @types
  * ff_encode_multi@sync(
- *     ctx: number, frame: number, pkt: number, inFrames: (Frame | number)[],
+ *     ctx: number, frame: number, pkt: number,
+ *     inFrames: (Frame | FrameView | number)[],
  *     config?: boolean | {
  *         fin?: boolean,
- *         copyoutPacket?: "default"
+ *         copyoutPacket?: "default",
+ *         framePool?: number,
+ *         copyinAudio?: AudioFormat
  *     }
  * ): @promise@Packet[]@
  * ff_encode_multi@sync(
- *     ctx: number, frame: number, pkt: number, inFrames: (Frame | number)[],
+ *     ctx: number, frame: number, pkt: number,
+ *     inFrames: (Frame | FrameView | number)[],
  *     config: {
  *         fin?: boolean,
- *         copyoutPacket: "ptr"
+ *         copyoutPacket: "ptr",
+ *         framePool?: number,
+ *         packetPool?: number,
+ *         copyinAudio?: AudioFormat
  *     }
  * ): @promise@number[]@
  */
@@ -208,82 +232,40 @@ var ff_encode_multi = Module.ff_encode_multi = function(ctx, frame, pkt, inFrame
         config = config || {};
     }
 
-    var outPackets = [];
-    var tbNum = AVCodecContext_time_base_num(ctx);
-    var tbDen = AVCodecContext_time_base_den(ctx);
-
-    var copyoutPacket = function(ptr) {
-        var ret = ff_copyout_packet(ptr);
-        if (!ret.time_base_num) {
-            ret.time_base_num = tbNum;
-            ret.time_base_den = tbDen;
-        }
-        return ret;
-    };
-
-    if (config.copyoutPacket === "ptr") {
-        copyoutPacket = function(ptr) {
-            var ret = ff_copyout_packet_ptr(ptr);
-            if (!AVPacket_time_base_num(ret))
-                AVPacket_time_base_s(ret, tbNum, tbDen);
-            return ret;
-        };
+    var ptrOut = (config.copyoutPacket === "ptr");
+    var outPool = config.packetPool || (ptrOut ? 0 : ff_internal_packet_pool());
+    var inp = ff_multi_frames_in(inFrames, config.framePool, config.copyinAudio);
+    var flags = config.fin ? MULTI_FLAGS.FIN : 0;
+
+    var res = ff_multi_call(inp[0], function(inList, status, out) {
+        return ff_encode_multi_c(
+            ctx, frame, pkt, inList, inp[0].length, status, flags,
+            inp[1], outPool, out
+        );
+    });
+
+    if (res.ret < 0) {
+        ff_multi_packets_free(res.out, outPool);
+        if (res.status.indexOf(res.ret) >= 0)
+            throw new Error("Error sending the frame to the encoder: " + ff_error(res.ret));
+        throw new Error("Error encoding audio frame: " + ff_error(res.ret));
     }
 
-    function handleFrame(inFrame) {
-        if (inFrame !== null) {
-            ff_copyin_frame(frame, inFrame);
-            if (tbNum) {
-                if (typeof inFrame === "number") {
-                    var itbn = AVFrame_time_base_num(frame);
-                    if (itbn) {
-                        ff_frame_rescale_ts_js(
-                            frame,
-                            itbn, AVFrame_time_base_den(frame),
-                            tbNum, tbDen
-                        );
-                        AVFrame_time_base_s(frame, tbNum, tbDen);
-                    }
-                } else if (inFrame && inFrame.time_base_num) {
-                    ff_frame_rescale_ts_js(
-                        frame,
-                        inFrame.time_base_num, inFrame.time_base_den,
-                        tbNum, tbDen
-                    );
-                    AVFrame_time_base_s(frame, tbNum, tbDen);
-                }
-            }
-        }
-
-        var ret = avcodec_send_frame(ctx, inFrame?frame:0);
-        if (ret < 0)
-            throw new Error("Error sending the frame to the encoder: " + ff_error(ret));
-        if (inFrame)
-            av_frame_unref(frame);
-
-        while (true) {
-            ret = avcodec_receive_packet(ctx, pkt);
-            if (ret === -6 /* EAGAIN */ || ret === -0x20464f45 /* AVERROR_EOF */)
-                return;
-            else if (ret < 0)
-                throw new Error("Error encoding audio frame: " + ff_error(ret));
-
-            outPackets.push(copyoutPacket(pkt));
-            av_packet_unref(pkt);
-        }
-    }
-
-    inFrames.forEach(handleFrame);
-
-    if (config.fin)
-        handleFrame(null);
+    if (ptrOut)
+        return res.out;
 
+    var outPackets = res.out.map(ff_copyout_packet);
+    ff_multi_packets_free(res.out, outPool);
     return outPackets;
 };
 
 /**
  * Decode some number of packets at once. Done in one go to avoid excess
- * message passing.
+ * message passing. If `config.packetPool` is set, AVPacket pointers in
+ * inPackets are released to that pool. If `config.framePool` is set, "ptr"
+ * frames are taken from that pool. If `config.copyoutAudio` or
+ * `config.copyoutVideo` is set, audio or video frames are converted natively
+ * to that format before being copied out.
  * @param ctx  AVCodecContext
  * @param pkt  AVPacket
  * @param frame  AVFrame
@@ -292,32 +274,57 @@ var ff_encode_multi = Module.ff_encode_multi = function(ctx, frame, pkt, inFrame
  */
 /* @types
  * ff_decode_multi@sync(
- *     ctx: number, pkt: number, frame: number, inPackets: (Packet | number)[],
+ *     ctx: number, pkt: number, frame: number,
+ *     inPackets: (Packet | PacketView | number)[],
  *     config?: boolean | {
  *         fin?: boolean,
  *         ignoreErrors?: boolean,
- *         copyoutFrame?: "default" | "video" | "video_packed"
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame?: "default" | "video" | "video_packed",
+ *         packetPool?: number
  *     }
  * ): @promise@Frame[]@
  * ff_decode_multi@sync(
- *     ctx: number, pkt: number, frame: number, inPackets: (Packet | number)[],
+ *     ctx: number, pkt: number, frame: number,
+ *     inPackets: (Packet | PacketView | number)[],
  *     config: {
  *         fin?: boolean,
  *         ignoreErrors?: boolean,
- *         copyoutFrame: "ptr"
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "ptr",
+ *         packetPool?: number,
+ *         framePool?: number
  *     }
  * ): @promise@number[]@
  * ff_decode_multi@sync(
- *     ctx: number, pkt: number, frame: number, inPackets: (Packet | number)[],
+ *     ctx: number, pkt: number, frame: number,
+ *     inPackets: (Packet | PacketView | number)[],
  *     config: {
  *         fin?: boolean,
  *         ignoreErrors?: boolean,
- *         copyoutFrame: "ImageData"
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "ImageData",
+ *         packetPool?: number
  *     }
  * ): @promise@ImageData[]@
+ * ff_decode_multi@sync(
+ *     ctx: number, pkt: number, frame: number,
+ *     inPackets: (Packet | PacketView | number)[],
+ *     config: {
+ *         fin?: boolean,
+ *         ignoreErrors?: boolean,
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "view",
+ *         packetPool?: number
+ *     }
+ * ): @promise@FrameView[]@
  */
 var ff_decode_multi = Module.ff_decode_multi = function(ctx, pkt, frame, inPackets, config) {
-    var outFrames = [];
+    var outFrames;
     var transfer = [];
     if (typeof config === "boolean") {
         config = {fin: config};
@@ -325,95 +332,51 @@ var ff_decode_multi = Module.ff_decode_multi = function(ctx, pkt, frame, inPacke
         config = config || {};
     }
 
-    var tbNum = AVCodecContext_time_base_num(ctx);
-    var tbDen = AVCodecContext_time_base_den(ctx);
-
-    var copyoutFrameO = ff_copyout_frame;
-    if (config.copyoutFrame)
-        copyoutFrameO = ff_copyout_frame_versions[config.copyoutFrame];
-    var copyoutFrame = function(ptr) {
-        var ret = copyoutFrameO(ptr);
-        if (!ret.time_base_num) {
-            ret.time_base_num = tbNum;
-            ret.time_base_den = tbDen;
-        }
-        return ret;
-    };
-    if (config.copyoutFrame === "ptr") {
-        copyoutFrame = function(ptr) {
-            var ret = ff_copyout_frame_ptr(ptr);
-            if (!AVFrame_time_base_num(ret))
-                AVFrame_time_base_s(ret, tbNum, tbDen);
-            return ret;
-        };
+    var copyoutFrame = ff_copyout_frame_converting(
+        config.copyoutFrame, config.copyoutAudio, config.copyoutVideo);
+    var ptrOut = (config.copyoutFrame === "ptr");
+    var outPool = config.framePool || (ptrOut ? 0 : ff_internal_frame_pool());
+    var inp = ff_multi_packets_in(inPackets, config.packetPool);
+    var flags = (config.fin ? MULTI_FLAGS.FIN : 0) |
+        (config.ignoreErrors ? MULTI_FLAGS.IGNORE_ERRORS : 0);
+
+    var res = ff_multi_call(inp[0], function(inList, status, out) {
+        return ff_decode_multi_c(
+            ctx, pkt, frame, inList, inp[0].length, status, flags,
+            inp[1], outPool, out
+        );
+    });
+
+    var sendErr = "Error submitting the packet to the decoder: ";
+    if (res.ret < 0) {
+        ff_multi_frames_free(res.out, outPool);
+        if (!config.ignoreErrors && res.status.indexOf(res.ret) >= 0)
+            throw new Error(sendErr + ff_error(res.ret));
+        throw new Error("Error decoding audio frame: " + ff_error(res.ret));
     }
-
-    function handlePacket(inPacket) {
-        var ret;
-
-        if (inPacket !== null) {
-            ret = av_packet_make_writable(pkt);
+    if (config.ignoreErrors) {
+        res.status.forEach(function(ret) {
             if (ret < 0)
-                throw new Error("Failed to make packet writable: " + ff_error(ret));
-            ff_copyin_packet(pkt, inPacket);
-
-            if (tbNum) {
-                if (typeof inPacket === "number") {
-                    var iptbn = AVPacket_time_base_num(pkt);
-                    if (iptbn) {
-                        av_packet_rescale_ts_js(
-                            pkt,
-                            iptbn, AVPacket_time_base_den(pkt),
-                            tbNum, tbDen
-                        );
-                        AVPacket_time_base_s(pkt, tbNum, tbDen);
-                    }
-                } else if (inPacket && inPacket.time_base_num) {
-                    av_packet_rescale_ts_js(
-                        pkt,
-                        inPacket.time_base_num, inPacket.time_base_den,
-                        tbNum, tbDen
-                    );
-                    AVPacket_time_base_s(pkt, tbNum, tbDen);
-                }
-            }
-        } else {
-            av_packet_unref(pkt);
-        }
+                console.log(sendErr + ff_error(ret));
+        });
+    }
 
-        ret = avcodec_send_packet(ctx, pkt);
-        if (ret < 0) {
-            var err = "Error submitting the packet to the decoder: " + ff_error(ret);
-            if (!config.ignoreErrors)
-                throw new Error(err);
-            else {
-                console.log(err);
-                av_packet_unref(pkt);
-                return;
-            }
+    if (ptrOut) {
+        outFrames = res.out;
+        if (config.copyoutAudio || config.copyoutVideo) {
+            ff_multi_frames_convert(
+                outFrames, config.copyoutAudio, config.copyoutVideo);
         }
-        av_packet_unref(pkt);
-
-        while (true) {
-            ret = avcodec_receive_frame(ctx, frame);
-            if (ret === -6 /* EAGAIN */ || ret === -0x20464f45 /* AVERROR_EOF */)
-                return;
-            else if (ret < 0)
-                throw new Error("Error decoding audio frame: " + ff_error(ret));
-
-            var outFrame = copyoutFrame(frame);
+    } else {
+        outFrames = res.out.map(function(ptr) {
+            var outFrame = copyoutFrame(ptr);
             if (outFrame && outFrame.libavjsTransfer && outFrame.libavjsTransfer.length)
                 transfer.push.apply(transfer, outFrame.libavjsTransfer);
-            outFrames.push(outFrame);
-            av_frame_unref(frame);
-        }
+            return outFrame;
+        });
+        ff_multi_frames_free(res.out, outPool);
     }
 
-    inPackets.forEach(handlePacket);
-
-    if (config.fin)
-        handlePacket(null);
-
     outFrames.libavjsTransfer = transfer;
     return outFrames;
 };
@@ -14,9 +14,13 @@
  */
 
 /* Set the content of a packet. Necessary because we tend to strip packets of their content. */
-var ff_set_packet = Module.ff_set_packet = function(pkt, data) {
+var ff_set_packet = Module.ff_set_packet = function(pkt, data, pool) {
     if (data.length === 0) {
         av_packet_unref(pkt);
+    } else if (pool) {
+        var ret = ff_packet_pool_set_size(pool, pkt, data.length);
+        if (ret < 0)
+            throw new Error("Error allocating packet: " + ff_error(ret));
     } else {
         var size = AVPacket_size(pkt);
         if (size < data.length) {
@@ -30,31 +34,70 @@ var ff_set_packet = Module.ff_set_packet = function(pkt, data) {
     Module.HEAPU8.set(data, ptr);
 };
 
+/* Layout of packet snapshot records, in 32-bit words. Must match b-avcodec.c.
+ * 64-bit fields take two words, low word first. */
+var PACKET_SNAP = {
+    VERSION: 0,
+    SET: 1,
+    PTS: 2,
+    DTS: 4,
+    DURATION: 6,
+    POS: 8,
+    STREAM_INDEX: 10,
+    FLAGS: 11,
+    DATA: 12,
+    DATA_SIZE: 13,
+    SIDE_DATA: 14,
+    SIDE_DATA_ELEMS: 15,
+    TIME_BASE_NUM: 16,
+    TIME_BASE_DEN: 17,
+    SIZE: 18
+};
+
+// Bits of PACKET_SNAP.SET
+var PACKET_SNAP_SET = {
+    PTS: 0x01,
+    DTS: 0x02,
+    DURATION: 0x04,
+    STREAM_INDEX: 0x08,
+    FLAGS: 0x10,
+    TIME_BASE_NUM: 0x20,
+    TIME_BASE_DEN: 0x40
+};
+
+/* Take a snapshot of this packet. Returns the index of the snapshot record in
+ * Module.HEAP32. Used internally. */
+function ff_packet_snapshot_idx(pkt) {
+    var ptr = ff_snapshot_buffer("packet", PACKET_SNAP.SIZE);
+    ff_packet_snapshot(pkt, ptr);
+    return ptr >> 2;
+}
+
 /**
  * Copy out a packet.
  * @param pkt  AVPacket
  */
 /// @types ff_copyout_packet@sync(pkt: number): @promise@Packet@
 var ff_copyout_packet = Module.ff_copyout_packet = function(pkt) {
-    var data = AVPacket_data(pkt);
-    var size = AVPacket_size(pkt);
-    var data = copyout_u8(data, size);
+    var b = ff_packet_snapshot_idx(pkt);
+    var s = Module.HEAP32;
+    var data = copyout_u8(s[b + PACKET_SNAP.DATA], s[b + PACKET_SNAP.DATA_SIZE]);
     return {
         data: data,
         libavjsTransfer: [data.buffer],
-        pts: AVPacket_pts(pkt),
-        ptshi: AVPacket_ptshi(pkt),
-        dts: AVPacket_dts(pkt),
-        dtshi: AVPacket_dtshi(pkt),
-        time_base_num: AVPacket_time_base_num(pkt),
-        time_base_den: AVPacket_time_base_den(pkt),
-        stream_index: AVPacket_stream_index(pkt),
-        flags: AVPacket_flags(pkt),
-        duration: AVPacket_duration(pkt),
-        durationhi: AVPacket_durationhi(pkt),
+        pts: s[b + PACKET_SNAP.PTS],
+        ptshi: s[b + PACKET_SNAP.PTS + 1],
+        dts: s[b + PACKET_SNAP.DTS],
+        dtshi: s[b + PACKET_SNAP.DTS + 1],
+        time_base_num: s[b + PACKET_SNAP.TIME_BASE_NUM],
+        time_base_den: s[b + PACKET_SNAP.TIME_BASE_DEN],
+        stream_index: s[b + PACKET_SNAP.STREAM_INDEX],
+        flags: s[b + PACKET_SNAP.FLAGS],
+        duration: s[b + PACKET_SNAP.DURATION],
+        durationhi: s[b + PACKET_SNAP.DURATION + 1],
         side_data: ff_copyout_side_data(
-            AVPacket_side_data(pkt),
-            AVPacket_side_data_elems(pkt)
+            s[b + PACKET_SNAP.SIDE_DATA],
+            s[b + PACKET_SNAP.SIDE_DATA_ELEMS]
         )
     };
 };
@@ -79,48 +122,128 @@ var ff_copyout_side_data = Module.ff_copyout_side_data = function(side_data, sid
 /**
  * Copy "out" a packet by just copying its data into a new AVPacket.
  * @param pkt  AVPacket
+ * @param pool  Optional packet pool to take the new packet from
  */
-/// @types ff_copyout_packet_ptr@sync(pkt: number): @promise@number@
-var ff_copyout_packet_ptr = Module.ff_copyout_packet_ptr = function(pkt) {
-    var ret = av_packet_clone(pkt);
+/// @types ff_copyout_packet_ptr@sync(pkt: number, pool?: number): @promise@number@
+var ff_copyout_packet_ptr = Module.ff_copyout_packet_ptr = function(pkt, pool) {
+    var ret = pool ? ff_packet_pool_clone(pool, pkt) : av_packet_clone(pkt);
     if (!ret)
         throw new Error("Failed to clone packet");
     return ret;
 };
 
+/**
+ * Copy "out" a packet as a view into libav's heap, without copying its data.
+ * The packet is referenced (not copied) into a new AVPacket, which is
+ * available as the view's `ptr`, and stays referenced until `release` is
+ * called. Side data is copied out as usual. Only available when libav.js is
+ * running in the caller's thread.
+ * @param pkt  AVPacket
+ */
+/// @types ff_copyout_packet_view@sync(pkt: number): @promise@PacketView@
+var ff_copyout_packet_view = Module.ff_copyout_packet_view = function(pkt) {
+    ff_check_heap_view();
+    var ptr = av_packet_clone(pkt);
+    if (!ptr)
+        throw new Error("Failed to clone packet");
+    var b = ff_packet_snapshot_idx(ptr);
+    var s = Module.HEAP32;
+    var packet = {
+        ptr: ptr,
+        pts: s[b + PACKET_SNAP.PTS],
+        ptshi: s[b + PACKET_SNAP.PTS + 1],
+        dts: s[b + PACKET_SNAP.DTS],
+        dtshi: s[b + PACKET_SNAP.DTS + 1],
+        time_base_num: s[b + PACKET_SNAP.TIME_BASE_NUM],
+        time_base_den: s[b + PACKET_SNAP.TIME_BASE_DEN],
+        stream_index: s[b + PACKET_SNAP.STREAM_INDEX],
+        flags: s[b + PACKET_SNAP.FLAGS],
+        duration: s[b + PACKET_SNAP.DURATION],
+        durationhi: s[b + PACKET_SNAP.DURATION + 1],
+        side_data: ff_copyout_side_data(
+            s[b + PACKET_SNAP.SIDE_DATA],
+            s[b + PACKET_SNAP.SIDE_DATA_ELEMS]
+        )
+    };
+    return ff_heap_view(packet, [[
+        s[b + PACKET_SNAP.DATA], s[b + PACKET_SNAP.DATA_SIZE], Uint8Array
+    ]], false, function() {
+        av_packet_free_js(ptr);
+    });
+};
+
 // Versions of ff_copyout_packet
 var ff_copyout_packet_versions = {
     default: ff_copyout_packet,
-    ptr: ff_copyout_packet_ptr
+    ptr: ff_copyout_packet_ptr,
+    view: ff_copyout_packet_view
 };
 
 /**
- * Copy in a packet.
+ * Copy in a packet. If a packet pool is given, AVPacket pointers are released
+ * to it rather than freed, and new data buffers are taken from it.
  * @param pktPtr  AVPacket
- * @param packet  Packet to copy in, as either a Packet or an AVPacket pointer
+ * @param packet  Packet to copy in, as a Packet, a PacketView or an AVPacket
+ *                pointer
+ * @param pool  Optional packet pool
  */
-/// @types ff_copyin_packet@sync(pktPtr: number, packet: Packet | number): @promise@void@
-var ff_copyin_packet = Module.ff_copyin_packet = function(pktPtr, packet) {
+/// @types ff_copyin_packet@sync(pktPtr: number, packet: Packet | PacketView | number, pool?: number): @promise@void@
+var ff_copyin_packet = Module.ff_copyin_packet = function(pktPtr, packet, pool) {
     if (typeof packet === "number") {
         // Input packet is an AVPacket pointer, duplicate it
         av_packet_unref(pktPtr);
         var res = av_packet_ref(pktPtr, packet);
         if (res < 0)
             throw new Error("Failed to reference packet: " + ff_error(res));
-        av_packet_unref(packet);
-        av_packet_free_js(packet);
+        if (pool) {
+            ff_packet_pool_release(pool, packet);
+        } else {
+            av_packet_unref(packet);
+            av_packet_free_js(packet);
+        }
         return;
     }
 
-    ff_set_packet(pktPtr, packet.data);
+    if (typeof packet.ptr === "number") {
+        // This is a packet view, so reference its packet but leave it be
+        av_packet_unref(pktPtr);
+        var res = av_packet_ref(pktPtr, packet.ptr);
+        if (res < 0)
+            throw new Error("Failed to reference packet: " + ff_error(res));
+        return;
+    }
 
-    [
-        "dts", "dtshi", "duration", "durationhi", "flags", "stream_index",
-        "pts", "ptshi", "time_base_num", "time_base_den"
-    ].forEach(function(key) {
-        if (key in packet)
-            CAccessors["AVPacket_" + key + "_s"](pktPtr, packet[key]);
-    });
+    ff_set_packet(pktPtr, packet.data, pool);
+
+    // Set all the metadata through a snapshot
+    var ptr = ff_snapshot_buffer("packet", PACKET_SNAP.SIZE);
+    var s = Module.HEAP32;
+    var b = ptr >> 2;
+    var set = 0;
+    function i32(key, slot, bit) {
+        if (key in packet) {
+            s[b + slot] = packet[key];
+            set |= bit;
+        }
+    }
+    function i64(key, slot, bit) {
+        if (key in packet) {
+            s[b + slot] = packet[key];
+            s[b + slot + 1] = packet[key + "hi"] || 0;
+            set |= bit;
+        }
+    }
+    i64("dts", PACKET_SNAP.DTS, PACKET_SNAP_SET.DTS);
+    i64("duration", PACKET_SNAP.DURATION, PACKET_SNAP_SET.DURATION);
+    i32("flags", PACKET_SNAP.FLAGS, PACKET_SNAP_SET.FLAGS);
+    i32("stream_index", PACKET_SNAP.STREAM_INDEX, PACKET_SNAP_SET.STREAM_INDEX);
+    i64("pts", PACKET_SNAP.PTS, PACKET_SNAP_SET.PTS);
+    i32("time_base_num", PACKET_SNAP.TIME_BASE_NUM,
+        PACKET_SNAP_SET.TIME_BASE_NUM);
+    i32("time_base_den", PACKET_SNAP.TIME_BASE_DEN,
+        PACKET_SNAP_SET.TIME_BASE_DEN);
+    s[b + PACKET_SNAP.SET] = set;
+    ff_packet_snapshot_apply(pktPtr, ptr);
 
     ff_copyin_side_data(pktPtr, packet.side_data);
 };
@@ -138,46 +261,124 @@ var ff_copyin_side_data = Module.ff_copyin_side_data = function(pktPtr, side_dat
     });
 };
 
+/* Layout of codec parameters snapshot records, in 32-bit words. Must match
+ * b-avcodec.c. 64-bit fields take two words, low word first. */
+var CODECPAR_SNAP = {
+    VERSION: 0,
+    SET: 1,
+    BIT_RATE: 2,
+    CHANNEL_LAYOUT: 4,
+    CODEC_TYPE: 6,
+    CODEC_ID: 7,
+    CODEC_TAG: 8,
+    FORMAT: 9,
+    PROFILE: 10,
+    LEVEL: 11,
+    WIDTH: 12,
+    HEIGHT: 13,
+    COLOR_RANGE: 14,
+    COLOR_PRIMARIES: 15,
+    COLOR_TRC: 16,
+    COLOR_SPACE: 17,
+    CHROMA_LOCATION: 18,
+    SAMPLE_RATE: 19,
+    CHANNELS: 20,
+    EXTRADATA: 21,
+    EXTRADATA_SIZE: 22,
+    CODED_SIDE_DATA: 23,
+    NB_CODED_SIDE_DATA: 24,
+    FRAMERATE_NUM: 25,
+    FRAMERATE_DEN: 26,
+    SIZE: 27
+};
+
+// Bits of CODECPAR_SNAP.SET
+var CODECPAR_SNAP_SET = {
+    BIT_RATE: 0x00001,
+    CHANNEL_LAYOUT: 0x00002,
+    CHANNELS: 0x00004,
+    CHROMA_LOCATION: 0x00008,
+    CODEC_ID: 0x00010,
+    CODEC_TAG: 0x00020,
+    CODEC_TYPE: 0x00040,
+    COLOR_PRIMARIES: 0x00080,
+    COLOR_RANGE: 0x00100,
+    COLOR_SPACE: 0x00200,
+    COLOR_TRC: 0x00400,
+    FORMAT: 0x00800,
+    HEIGHT: 0x01000,
+    LEVEL: 0x02000,
+    PROFILE: 0x04000,
+    SAMPLE_RATE: 0x08000,
+    WIDTH: 0x10000,
+    FRAMERATE: 0x20000
+};
+
+/* Fields of CodecParameters that are set through the snapshot by
+ * ff_copyin_codecpar, as [key, slot, set bit, is 64-bit] */
+var ff_codecpar_snapshot_fields = [
+    ["bit_rate", CODECPAR_SNAP.BIT_RATE, CODECPAR_SNAP_SET.BIT_RATE, true],
+    ["channel_layoutmask", CODECPAR_SNAP.CHANNEL_LAYOUT,
+        CODECPAR_SNAP_SET.CHANNEL_LAYOUT, true],
+    ["channels", CODECPAR_SNAP.CHANNELS, CODECPAR_SNAP_SET.CHANNELS],
+    ["chroma_location", CODECPAR_SNAP.CHROMA_LOCATION,
+        CODECPAR_SNAP_SET.CHROMA_LOCATION],
+    ["codec_id", CODECPAR_SNAP.CODEC_ID, CODECPAR_SNAP_SET.CODEC_ID],
+    ["codec_tag", CODECPAR_SNAP.CODEC_TAG, CODECPAR_SNAP_SET.CODEC_TAG],
+    ["codec_type", CODECPAR_SNAP.CODEC_TYPE, CODECPAR_SNAP_SET.CODEC_TYPE],
+    ["color_primaries", CODECPAR_SNAP.COLOR_PRIMARIES,
+        CODECPAR_SNAP_SET.COLOR_PRIMARIES],
+    ["color_range", CODECPAR_SNAP.COLOR_RANGE, CODECPAR_SNAP_SET.COLOR_RANGE],
+    ["color_space", CODECPAR_SNAP.COLOR_SPACE, CODECPAR_SNAP_SET.COLOR_SPACE],
+    ["color_trc", CODECPAR_SNAP.COLOR_TRC, CODECPAR_SNAP_SET.COLOR_TRC],
+    ["format", CODECPAR_SNAP.FORMAT, CODECPAR_SNAP_SET.FORMAT],
+    ["height", CODECPAR_SNAP.HEIGHT, CODECPAR_SNAP_SET.HEIGHT],
+    ["level", CODECPAR_SNAP.LEVEL, CODECPAR_SNAP_SET.LEVEL],
+    ["profile", CODECPAR_SNAP.PROFILE, CODECPAR_SNAP_SET.PROFILE],
+    ["sample_rate", CODECPAR_SNAP.SAMPLE_RATE, CODECPAR_SNAP_SET.SAMPLE_RATE],
+    ["width", CODECPAR_SNAP.WIDTH, CODECPAR_SNAP_SET.WIDTH]
+];
+
 /**
  * Copy out codec parameters.
  * @param codecpar  AVCodecParameters
  */
 /// @types ff_copyout_codecpar@sync(codecpar: number): @promise@CodecParameters@
 var ff_copyout_codecpar = Module.ff_copyout_codecpar = function(codecpar) {
+    var ptr = ff_snapshot_buffer("codecpar", CODECPAR_SNAP.SIZE);
+    ff_codecpar_snapshot(codecpar, ptr);
+    var s = Module.HEAP32;
+    var b = ptr >> 2;
+    var extradata = s[b + CODECPAR_SNAP.EXTRADATA];
+    var extradata_size = s[b + CODECPAR_SNAP.EXTRADATA_SIZE];
     return {
-        bit_rate: AVCodecParameters_bit_rate(codecpar),
-        channel_layoutmask: AVCodecParameters_channel_layoutmask(codecpar),
-        channels: AVCodecParameters_channels(codecpar),
-        chroma_location: AVCodecParameters_chroma_location(codecpar),
-        codec_id: AVCodecParameters_codec_id(codecpar),
-        codec_tag: AVCodecParameters_codec_tag(codecpar),
-        codec_type: AVCodecParameters_codec_type(codecpar),
-        color_primaries: AVCodecParameters_color_primaries(codecpar),
-        color_range: AVCodecParameters_color_range(codecpar),
-        color_space: AVCodecParameters_color_space(codecpar),
-        color_trc: AVCodecParameters_color_trc(codecpar),
-        format: AVCodecParameters_format(codecpar),
-        height: AVCodecParameters_height(codecpar),
-        level: AVCodecParameters_level(codecpar),
-        profile: AVCodecParameters_profile(codecpar),
-        sample_rate: AVCodecParameters_sample_rate(codecpar),
-        width: AVCodecParameters_width(codecpar),
-        extradata: ff_copyout_codecpar_extradata(codecpar),
+        bit_rate: s[b + CODECPAR_SNAP.BIT_RATE],
+        bit_ratehi: s[b + CODECPAR_SNAP.BIT_RATE + 1],
+        channel_layoutmask: s[b + CODECPAR_SNAP.CHANNEL_LAYOUT],
+        channels: s[b + CODECPAR_SNAP.CHANNELS],
+        chroma_location: s[b + CODECPAR_SNAP.CHROMA_LOCATION],
+        codec_id: s[b + CODECPAR_SNAP.CODEC_ID],
+        codec_tag: s[b + CODECPAR_SNAP.CODEC_TAG],
+        codec_type: s[b + CODECPAR_SNAP.CODEC_TYPE],
+        color_primaries: s[b + CODECPAR_SNAP.COLOR_PRIMARIES],
+        color_range: s[b + CODECPAR_SNAP.COLOR_RANGE],
+        color_space: s[b + CODECPAR_SNAP.COLOR_SPACE],
+        color_trc: s[b + CODECPAR_SNAP.COLOR_TRC],
+        format: s[b + CODECPAR_SNAP.FORMAT],
+        height: s[b + CODECPAR_SNAP.HEIGHT],
+        level: s[b + CODECPAR_SNAP.LEVEL],
+        profile: s[b + CODECPAR_SNAP.PROFILE],
+        sample_rate: s[b + CODECPAR_SNAP.SAMPLE_RATE],
+        width: s[b + CODECPAR_SNAP.WIDTH],
+        extradata: (extradata && extradata_size) ?
+            copyout_u8(extradata, extradata_size) : null,
         coded_side_data: ff_copyout_side_data(
-            AVCodecParameters_coded_side_data(codecpar),
-            AVCodecParameters_nb_coded_side_data(codecpar)
+            s[b + CODECPAR_SNAP.CODED_SIDE_DATA],
+            s[b + CODECPAR_SNAP.NB_CODED_SIDE_DATA]
         )
     };
 };
 
-// Copy out codec parameter extradata. Used internally by ff_copyout_codecpar.
-var ff_copyout_codecpar_extradata = Module.ff_copyout_codecpar_extradata = function(codecpar) {
-    var extradata = AVCodecParameters_extradata(codecpar);
-    var extradata_size = AVCodecParameters_extradata_size(codecpar);
-    if (!extradata || !extradata_size) return null;
-    return copyout_u8(extradata, extradata_size);
-};
-
 /**
  * Copy in codec parameters.
  * @param codecparPtr  AVCodecParameters
@@ -185,15 +386,22 @@ var ff_copyout_codecpar_extradata = Module.ff_copyout_codecpar_extradata = funct
  */
 /// @types ff_copyin_codecpar@sync(codecparPtr: number, codecpar: CodecParameters): @promise@void@
 var ff_copyin_codecpar = Module.ff_copyin_codecpar = function(codecparPtr, codecpar) {
-    [
-        "bit_rate", "channel_layoutmask", "channels", "chroma_location",
-        "codec_id", "codec_tag", "codec_type", "color_primaries", "color_range",
-        "color_space", "color_trc", "format", "height", "level", "profile",
-        "sample_rate", "width"
-    ].forEach(function(key) {
-        if (key in codecpar)
-            CAccessors["AVCodecParameters_" + key + "_s"](codecparPtr, codecpar[key]);
-    });
+    var ptr = ff_snapshot_buffer("codecpar", CODECPAR_SNAP.SIZE);
+    var s = Module.HEAP32;
+    var b = ptr >> 2;
+    var set = 0;
+    for (var i = 0; i < ff_codecpar_snapshot_fields.length; i++) {
+        var field = ff_codecpar_snapshot_fields[i];
+        var key = field[0];
+        if (!(key in codecpar))
+            continue;
+        s[b + field[1]] = codecpar[key];
+        if (field[3])
+            s[b + field[1] + 1] = codecpar[key + "hi"] || 0;
+        set |= field[2];
+    }
+    s[b + CODECPAR_SNAP.SET] = set;
+    ff_codecpar_snapshot_apply(codecparPtr, ptr);
 
     ff_copyin_codecpar_extradata(codecparPtr, codecpar.extradata);
     ff_copyin_codecpar_side_data(codecparPtr, codecpar.side_data);
@@ -239,3 +447,81 @@ var ff_copyout_dict = Module.ff_copyout_dict = function(dict) {
     }
     return ret;
 };
+
+/**
+ * Release many packets to a packet pool at once.
+ * @param pool  Packet pool
+ * @param packets  AVPackets to release
+ */
+/// @types ff_packet_pool_release_multi@sync(pool: number, packets: number[]): @promise@void@
+var ff_packet_pool_release_multi = Module.ff_packet_pool_release_multi = function(pool, packets) {
+    for (var i = 0; i < packets.length; i++)
+        ff_packet_pool_release(pool, packets[i]);
+};
+
+/**
+ * Get the statistics of a packet pool.
+ * @param pool  Packet pool
+ */
+/// @types ff_packet_pool_get_stats@sync(pool: number): @promise@PoolStats@
+var ff_packet_pool_get_stats = Module.ff_packet_pool_get_stats = function(pool) {
+    return ff_pool_get_stats(ff_packet_pool_stats, pool);
+};
+
+// Packet pool used internally by the multi metafunctions
+var ff_internal_packet_pool_ptr = 0;
+
+/* Get the internal packet pool, allocating it if needed. Used internally. */
+function ff_internal_packet_pool() {
+    if (!ff_internal_packet_pool_ptr) {
+        ff_internal_packet_pool_ptr = ff_packet_pool_alloc();
+        if (!ff_internal_packet_pool_ptr)
+            throw new Error("Failed to allocate packet pool");
+    }
+    return ff_internal_packet_pool_ptr;
+}
+
+// The pool is gone after a reset
+ff_reset_hooks.push(function() {
+    ff_internal_packet_pool_ptr = 0;
+});
+
+/* Get AVPacket pointers for a native multi driver from these packets, copying
+ * in any that aren't pointers already. Returns the pointers and the pool that
+ * the driver should release them to. Used internally. */
+function ff_multi_packets_in(inPackets, pool) {
+    var ptrs = [];
+    if (!pool) {
+        // If they're all ours, they can come from (and go back to) our pool
+        pool = ff_internal_packet_pool();
+        for (var i = 0; i < inPackets.length; i++) {
+            if (typeof inPackets[i] === "number") {
+                pool = 0;
+                break;
+            }
+        }
+    }
+    for (var i = 0; i < inPackets.length; i++) {
+        var inPacket = inPackets[i];
+        if (typeof inPacket !== "number") {
+            var ptr = pool ? ff_packet_pool_acquire(pool) : av_packet_alloc();
+            if (!ptr)
+                throw new Error("Failed to allocate packet");
+            ff_copyin_packet(ptr, inPacket, pool);
+            inPacket = ptr;
+        }
+        ptrs.push(inPacket);
+    }
+    return [ptrs, pool];
+}
+
+/* Free the output packets of a native multi driver, releasing them to the
+ * pool if there is one. Used internally. */
+function ff_multi_packets_free(ptrs, pool) {
+    if (pool) {
+        ff_packet_pool_release_multi(pool, ptrs);
+    } else {
+        for (var i = 0; i < ptrs.length; i++)
+            av_packet_free_js(ptrs[i]);
+    }
+}
@@ -229,7 +229,11 @@ var ff_init_filter_graph = Module.ff_init_filter_graph = function(filters_descr,
  * Only one sink is allowed, but config is per source. Set
  * `config.ignoreSinkTimebase` to leave frames' timebase as it was, rather than
  * imposing the timebase of the buffer sink. Set `config.copyoutFrame` to use a
- * different copier than the default.
+ * different copier than the default. Set `config.framePool` to release AVFrame
+ * pointers in inFrames to that pool, and to take "ptr" frames from it. Set
+ * `config.copyinAudio` or `config.copyoutAudio` to convert audio frames
+ * natively as they're copied in or out, and `config.copyoutVideo` to convert
+ * (and scale) video frames natively as they're copied out.
  * @param srcs  AVFilterContext(s), input
  * @param buffersink_ctx  AVFilterContext, output
  * @param framePtr  AVFrame
@@ -240,57 +244,104 @@ var ff_init_filter_graph = Module.ff_init_filter_graph = function(filters_descr,
 /* @types
  * ff_filter_multi@sync(
  *     srcs: number, buffersink_ctx: number, framePtr: number,
- *     inFrames: (Frame | number)[], config?: boolean | {
+ *     inFrames: (Frame | FrameView | number)[], config?: boolean | {
  *         fin?: boolean,
  *         ignoreSinkTimebase?: boolean,
- *         copyoutFrame?: "default" | "video" | "video_packed"
+ *         copyinAudio?: AudioFormat,
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame?: "default" | "video" | "video_packed",
+ *         framePool?: number
  *     }
  * ): @promise@Frame[]@;
  * ff_filter_multi@sync(
  *     srcs: number[], buffersink_ctx: number, framePtr: number,
- *     inFrames: (Frame | number)[][], config?: boolean[] | {
+ *     inFrames: (Frame | FrameView | number)[][], config?: boolean[] | {
  *         fin?: boolean,
  *         ignoreSinkTimebase?: boolean,
- *         copyoutFrame?: "default" | "video" | "video_packed"
+ *         copyinAudio?: AudioFormat,
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame?: "default" | "video" | "video_packed",
+ *         framePool?: number
  *     }[]
  * ): @promise@Frame[]@
  * ff_filter_multi@sync(
  *     srcs: number, buffersink_ctx: number, framePtr: number,
- *     inFrames: (Frame | number)[], config: {
+ *     inFrames: (Frame | FrameView | number)[], config: {
  *         fin?: boolean,
  *         ignoreSinkTimebase?: boolean,
- *         copyoutFrame: "ptr"
+ *         copyinAudio?: AudioFormat,
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "ptr",
+ *         framePool?: number
  *     }
  * ): @promise@number[]@;
  * ff_filter_multi@sync(
  *     srcs: number[], buffersink_ctx: number, framePtr: number,
- *     inFrames: (Frame | number)[][], config: {
+ *     inFrames: (Frame | FrameView | number)[][], config: {
  *         fin?: boolean,
  *         ignoreSinkTimebase?: boolean,
- *         copyoutFrame: "ptr"
+ *         copyinAudio?: AudioFormat,
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "ptr",
+ *         framePool?: number
  *     }[]
  * ): @promise@number[]@
  * ff_filter_multi@sync(
  *     srcs: number, buffersink_ctx: number, framePtr: number,
- *     inFrames: (Frame | number)[], config: {
+ *     inFrames: (Frame | FrameView | number)[], config: {
  *         fin?: boolean,
  *         ignoreSinkTimebase?: boolean,
- *         copyoutFrame: "ImageData"
+ *         copyinAudio?: AudioFormat,
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "ImageData",
+ *         framePool?: number
  *     }
  * ): @promise@ImageData[]@;
  * ff_filter_multi@sync(
  *     srcs: number[], buffersink_ctx: number, framePtr: number,
- *     inFrames: (Frame | number)[][], config: {
+ *     inFrames: (Frame | FrameView | number)[][], config: {
  *         fin?: boolean,
  *         ignoreSinkTimebase?: boolean,
- *         copyoutFrame: "ImageData"
+ *         copyinAudio?: AudioFormat,
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "ImageData",
+ *         framePool?: number
  *     }[]
  * ): @promise@ImageData[]@
+ * ff_filter_multi@sync(
+ *     srcs: number, buffersink_ctx: number, framePtr: number,
+ *     inFrames: (Frame | FrameView | number)[], config: {
+ *         fin?: boolean,
+ *         ignoreSinkTimebase?: boolean,
+ *         copyinAudio?: AudioFormat,
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "view",
+ *         framePool?: number
+ *     }
+ * ): @promise@FrameView[]@;
+ * ff_filter_multi@sync(
+ *     srcs: number[], buffersink_ctx: number, framePtr: number,
+ *     inFrames: (Frame | FrameView | number)[][], config: {
+ *         fin?: boolean,
+ *         ignoreSinkTimebase?: boolean,
+ *         copyinAudio?: AudioFormat,
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "view",
+ *         framePool?: number
+ *     }[]
+ * ): @promise@FrameView[]@
  */
 var ff_filter_multi = Module.ff_filter_multi = function(srcs, buffersink_ctx, framePtr, inFrames, config) {
     var outFrames = [];
     var transfer = [];
-    var tbNum = -1, tbDen = -1;
 
     if (!srcs.length) {
         srcs = [srcs];
@@ -311,61 +362,71 @@ var ff_filter_multi = Module.ff_filter_multi = function(srcs, buffersink_ctx, fr
         return Math.max(a, b);
     });
 
-    function handleFrame(buffersrc_ctx, inFrame, copyoutFrame, config) {
-        if (inFrame !== null)
-            ff_copyin_frame(framePtr, inFrame);
-
-        var ret = av_buffersrc_add_frame_flags(buffersrc_ctx, inFrame ? framePtr : 0, 8 /* AV_BUFFERSRC_FLAG_KEEP_REF */);
-        if (ret < 0)
-            throw new Error("Error while feeding the audio filtergraph: " + ff_error(ret));
-        av_frame_unref(framePtr);
-
-        while (true) {
-            ret = av_buffersink_get_frame(buffersink_ctx, framePtr);
-            if (ret === -6 /* EAGAIN */ || ret === -0x20464f45 /* AVERROR_EOF */)
-                break;
-            if (ret < 0)
-                throw new Error("Error while receiving a frame from the filtergraph: " + ff_error(ret));
-
-            if (tbNum < 0) {
-                tbNum = av_buffersink_get_time_base_num(buffersink_ctx);
-                tbDen = av_buffersink_get_time_base_den(buffersink_ctx);
-            }
+    // Filter these frames from source ti, with the native driver
+    function handleFrames(ti, frames, fin) {
+        var tconfig = config[ti];
+        var ptrOut = (tconfig.copyoutFrame === "ptr");
+        var outPool = tconfig.framePool ||
+            (ptrOut ? 0 : ff_internal_frame_pool());
+        var inp = ff_multi_frames_in(frames, tconfig.framePool,
+            tconfig.copyinAudio);
+        var flags = (fin ? MULTI_FLAGS.FIN : 0) |
+            (tconfig.ignoreSinkTimebase ? MULTI_FLAGS.IGNORE_SINK_TIMEBASE : 0);
+
+        var res = ff_multi_call(inp[0], function(inList, status, out) {
+            return ff_filter_multi_c(
+                srcs[ti], buffersink_ctx, framePtr, inList, inp[0].length,
+                status, flags, inp[1], outPool, out
+            );
+        });
 
-            var outFrame = copyoutFrame(framePtr);
+        if (res.ret < 0) {
+            ff_multi_frames_free(res.out, outPool);
+            if (res.status.indexOf(res.ret) >= 0)
+                throw new Error("Error while feeding the audio filtergraph: " + ff_error(res.ret));
+            throw new Error("Error while receiving a frame from the filtergraph: " + ff_error(res.ret));
+        }
 
-            if (tbNum && !config.ignoreSinkTimebase) {
-                if (typeof outFrame === "number") {
-                    AVFrame_time_base_s(outFrame, tbNum, tbDen);
-                } else if (outFrame) {
-                    outFrame.time_base_num = tbNum;
-                    outFrame.time_base_den = tbDen;
-                }
+        if (ptrOut) {
+            if (tconfig.copyoutAudio || tconfig.copyoutVideo) {
+                ff_multi_frames_convert(
+                    res.out, tconfig.copyoutAudio, tconfig.copyoutVideo);
             }
-
+            outFrames.push.apply(outFrames, res.out);
+            return;
+        }
+        var copyoutFrame = copyoutFrames[ti];
+        res.out.forEach(function(ptr) {
+            var outFrame = copyoutFrame(ptr);
             if (outFrame && outFrame.libavjsTransfer && outFrame.libavjsTransfer.length)
                 transfer.push.apply(transfer, outFrame.libavjsTransfer);
             outFrames.push(outFrame);
-            av_frame_unref(framePtr);
-        }
+        });
+        ff_multi_frames_free(res.out, outPool);
     }
 
     // Choose a frame copier per stream
     var copyoutFrames = [];
-    for (var ti = 0; ti < inFrames.length; ti++) (function(ti) {
-        var copyoutFrame = ff_copyout_frame;
-        if (config[ti].copyoutFrame)
-            copyoutFrame = ff_copyout_frame_versions[config[ti].copyoutFrame];
-        copyoutFrames.push(copyoutFrame);
-    })(ti);
-
-    // Handle in *frame* order
-    for (var fi = 0; fi <= max; fi++) {
-        for (var ti = 0; ti < inFrames.length; ti++) {
-            var inFrame = inFrames[ti][fi];
-            if (inFrame) handleFrame(srcs[ti], inFrame, copyoutFrames[ti], config[ti]);
-            else if (config[ti].fin) handleFrame(srcs[ti], null, copyoutFrames[ti], config[ti]);
+    for (var ti = 0; ti < inFrames.length; ti++) {
+        copyoutFrames.push(ff_copyout_frame_converting(
+            config[ti].copyoutFrame, config[ti].copyoutAudio,
+            config[ti].copyoutVideo));
+    }
+
+    if (inFrames.length === 1) {
+        // Just one source, so do it all at once
+        handleFrames(0, inFrames[0], !!config[0].fin);
+
+    } else {
+        // Handle in *frame* order
+        for (var fi = 0; fi <= max; fi++) {
+            for (var ti = 0; ti < inFrames.length; ti++) {
+                var inFrame = inFrames[ti][fi];
+                if (inFrame) handleFrames(ti, [inFrame], false);
+                else if (config[ti].fin) handleFrames(ti, [], true);
+            }
         }
+
     }
 
     outFrames.libavjsTransfer = transfer;
@@ -387,31 +448,56 @@ var ff_filter_multi = Module.ff_filter_multi = function(srcs, buffersink_ctx, fr
 /* @types
  * ff_decode_filter_multi@sync(
  *     ctx: number, buffersrc_ctx: number, buffersink_ctx: number, pkt: number,
- *     frame: number, inPackets: (Packet | number)[],
+ *     frame: number, inPackets: (Packet | PacketView | number)[],
  *     config?: boolean | {
  *         fin?: boolean,
  *         ignoreErrors?: boolean,
- *         copyoutFrame?: "default" | "video" | "video_packed"
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame?: "default" | "video" | "video_packed",
+ *         framePool?: number,
+ *         packetPool?: number
  *     }
  * ): @promise@Frame[]@
  * ff_decode_filter_multi@sync(
  *     ctx: number, buffersrc_ctx: number, buffersink_ctx: number, pkt: number,
- *     frame: number, inPackets: (Packet | number)[],
+ *     frame: number, inPackets: (Packet | PacketView | number)[],
  *     config: {
  *         fin?: boolean,
  *         ignoreErrors?: boolean,
- *         copyoutFrame: "ptr"
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "ptr",
+ *         framePool?: number,
+ *         packetPool?: number
  *     }
  * ): @promise@number[]@
  * ff_decode_filter_multi@sync(
  *     ctx: number, buffersrc_ctx: number, buffersink_ctx: number, pkt: number,
- *     frame: number, inPackets: (Packet | number)[],
+ *     frame: number, inPackets: (Packet | PacketView | number)[],
  *     config: {
  *         fin?: boolean,
  *         ignoreErrors?: boolean,
- *         copyoutFrame: "ImageData"
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "ImageData",
+ *         framePool?: number,
+ *         packetPool?: number
  *     }
  * ): @promise@ImageData[]@
+ * ff_decode_filter_multi@sync(
+ *     ctx: number, buffersrc_ctx: number, buffersink_ctx: number, pkt: number,
+ *     frame: number, inPackets: (Packet | PacketView | number)[],
+ *     config: {
+ *         fin?: boolean,
+ *         ignoreErrors?: boolean,
+ *         copyoutAudio?: AudioFormat,
+ *         copyoutVideo?: VideoFormat,
+ *         copyoutFrame: "view",
+ *         framePool?: number,
+ *         packetPool?: number
+ *     }
+ * ): @promise@FrameView[]@
  */
 var ff_decode_filter_multi = Module.ff_decode_filter_multi = function(
     ctx, buffersrc_ctx, buffersink_ctx, pkt, frame, inPackets, config
@@ -426,14 +512,241 @@ var ff_decode_filter_multi = Module.ff_decode_filter_multi = function(
     var decodedFrames = ff_decode_multi(ctx, pkt, frame, inPackets, {
         fin: !!config.fin,
         ignoreErrors: !!config.ignoreErrors,
-        copyoutFrame: "ptr"
+        copyoutFrame: "ptr",
+        packetPool: config.packetPool,
+        framePool: config.framePool
     });
 
     // 2: Filter
     return ff_filter_multi(
         buffersrc_ctx, buffersink_ctx, frame, decodedFrames, {
             fin: !!config.fin,
-            copyoutFrame: config.copyoutFrame || "default"
+            copyoutFrame: config.copyoutFrame || "default",
+            copyoutAudio: config.copyoutAudio,
+            copyoutVideo: config.copyoutVideo,
+            framePool: config.framePool
         }
     );
 }
+
+/* Layout of pipeline statistics, in 64-bit words. Must match b-pipeline.c. */
+var PIPELINE_STATS = [
+    "packets_in", "bytes_in", "frames_decoded", "decode_errors",
+    "frames_encoded", "packets_out", "bytes_out"
+];
+
+/**
+ * Initialize a transcoding pipeline, which demuxes, decodes, filters, encodes,
+ * and muxes entirely within libav.js, with no data passing through
+ * JavaScript. Run it with ff_pipeline_pump, and free it with ff_pipeline_free.
+ * Returns the pipeline.
+ * @param input  Input filename, or demuxer options
+ * @param output  Muxer options
+ * @param streams  Configuration for each stream to keep. Streams with no codec
+ *                 are copied. If absent, every stream is copied.
+ */
+/* @types
+ * ff_init_pipeline@sync(
+ *     input: string | {
+ *         filename: string,
+ *         format?: string,
+ *         open_input_options?: number
+ *     },
+ *     output: {
+ *         filename: string,
+ *         format_name?: string,
+ *         device?: boolean // Create a writer device
+ *     },
+ *     streams?: {
+ *         index: number, // Input stream index
+ *         codec?: string, // Encoder name. Copy if absent.
+ *         decoder?: string | number, // Decoder, if not the default
+ *         decoder_options?: Record<string, string>, // Decoder options
+ *         ctx?: AVCodecContextProps, // Encoder properties
+ *         time_base?: [number, number], // Encoder time base
+ *         options?: Record<string, string>, // Encoder options
+ *         filter?: string // Filtergraph description
+ *     }[]
+ * ): @promsync@number@
+ */
+function ff_init_pipeline(input, output, streams) {
+    if (typeof input === "string")
+        input = {filename: input};
+    var p = 0;
+
+    return ff_init_demuxer_file(input.filename, {
+        format: input.format,
+        open_input_options: input.open_input_options
+    }).then(function(ret) {
+        var ifmt = ret[0];
+        var inStreams = ret[1];
+        if (!streams) {
+            streams = inStreams.map(function(st) {
+                return {index: st.index};
+            });
+        }
+
+        var ofmt = avformat_alloc_output_context2_js(
+            0, output.format_name || null, output.filename);
+        if (ofmt === 0) {
+            avformat_close_input_js(ifmt);
+            throw new Error("Failed to allocate output context");
+        }
+
+        // From here, the pipeline owns the demuxer and muxer
+        p = ff_pipeline_alloc(ifmt, ofmt);
+        if (p === 0)
+            throw new Error("Failed to allocate pipeline");
+
+        streams.forEach(function(cfg) {
+            var inStream = inStreams[cfg.index];
+            if (!inStream)
+                throw new Error("No input stream " + cfg.index);
+            if (!cfg.codec) {
+                ret = ff_pipeline_add_stream(p, cfg.index, 0, 0, 0, 0, 0, 0);
+                if (ret < 0)
+                    throw new Error("Failed to copy stream: " + ff_error(ret));
+                return;
+            }
+
+            var dec = 0, enc = 0, graph = 0, options = 0;
+            try {
+                // Decoder
+                var decRet = ff_init_decoder(
+                    (typeof cfg.decoder !== "undefined") ?
+                        cfg.decoder : inStream.codec_id, {
+                    codecpar: inStream.codecpar,
+                    time_base: [inStream.time_base_num, inStream.time_base_den],
+                    options: cfg.decoder_options
+                });
+                dec = decRet[1];
+                av_packet_free_js(decRet[2]);
+                av_frame_free_js(decRet[3]);
+
+                // Encoder (opened by the pipeline)
+                var codec = avcodec_find_encoder_by_name(cfg.codec);
+                if (codec === 0)
+                    throw new Error("Codec not found");
+                enc = avcodec_alloc_context3(codec);
+                if (enc === 0)
+                    throw new Error("Could not allocate codec context");
+                var ctxProps = cfg.ctx || {};
+                for (var prop in ctxProps)
+                    Module["AVCodecContext_" + prop + "_s"](enc, ctxProps[prop]);
+                if (cfg.time_base)
+                    AVCodecContext_time_base_s(enc, cfg.time_base[0], cfg.time_base[1]);
+                if (cfg.options) {
+                    for (var prop in cfg.options)
+                        options = av_dict_set_js(options, prop, cfg.options[prop], 0);
+                }
+
+                // Filter graph from the decoder to the encoder
+                var type = inStream.codec_type;
+                var time_base = [inStream.time_base_num, inStream.time_base_den];
+                var filterIn, filterOut;
+                if (type === 0 /* AVMEDIA_TYPE_VIDEO */) {
+                    var frNum = AVCodecContext_framerate_num(dec);
+                    var frDen = AVCodecContext_framerate_den(dec);
+                    filterIn = {
+                        type: type,
+                        time_base: time_base,
+                        frame_rate: (frNum && frDen) ? frNum / frDen : void 0,
+                        pix_fmt: AVCodecContext_pix_fmt(dec),
+                        width: AVCodecContext_width(dec),
+                        height: AVCodecContext_height(dec)
+                    };
+                    filterOut = {
+                        type: type,
+                        pix_fmt: ("pix_fmt" in ctxProps) ?
+                            ctxProps.pix_fmt : filterIn.pix_fmt
+                    };
+                } else {
+                    var layout = AVCodecContext_channel_layout(dec);
+                    if (!layout) {
+                        var channels = AVCodecContext_ch_layout_nb_channels(dec);
+                        layout = (channels === 1) ? 4 : ((1 << channels) - 1);
+                    }
+                    filterIn = {
+                        type: type,
+                        time_base: time_base,
+                        sample_rate: AVCodecContext_sample_rate(dec),
+                        sample_fmt: AVCodecContext_sample_fmt(dec),
+                        channel_layout: layout
+                    };
+                    filterOut = {
+                        type: type,
+                        sample_rate: ctxProps.sample_rate || filterIn.sample_rate,
+                        sample_fmt: ("sample_fmt" in ctxProps) ?
+                            ctxProps.sample_fmt : filterIn.sample_fmt,
+                        channel_layout: ctxProps.channel_layout || layout
+                    };
+                }
+                var filterRet = ff_init_filter_graph(
+                    cfg.filter || (type === 0 ? "null" : "anull"),
+                    filterIn, filterOut);
+                graph = filterRet[0];
+
+                // The pipeline takes ownership of all of it
+                ret = ff_pipeline_add_stream(
+                    p, cfg.index, dec, graph, filterRet[1], filterRet[2], enc,
+                    options);
+                dec = enc = graph = options = 0;
+                if (ret < 0)
+                    throw new Error("Failed to add stream: " + ff_error(ret));
+
+            } catch (ex) {
+                if (dec) avcodec_free_context_js(dec);
+                if (enc) avcodec_free_context_js(enc);
+                if (graph) avfilter_graph_free_js(graph);
+                if (options) av_dict_free_js(options);
+                throw ex;
+            }
+        });
+
+        // Set up the device if requested
+        if (output.device)
+            FS.mkdev(output.filename, 0x1FF, writerDev);
+
+        ret = ff_pipeline_open(p, output.filename);
+        if (ret < 0)
+            throw new Error("Failed to open output: " + ff_error(ret));
+
+        return p;
+
+    }).catch(function(ex) {
+        if (p)
+            ff_pipeline_free(p);
+        throw ex;
+
+    });
+}
+Module.ff_init_pipeline = function() {
+    var args = arguments;
+    return serially(function() {
+        return ff_init_pipeline.apply(void 0, args);
+    });
+};
+
+/**
+ * Get the statistics of a transcoding pipeline.
+ * @param p  Pipeline
+ */
+/* @types
+ * ff_pipeline_get_stats@sync(p: number): @promise@{
+ *     packets_in: number, bytes_in: number, frames_decoded: number,
+ *     decode_errors: number, frames_encoded: number, packets_out: number,
+ *     bytes_out: number
+ * }@
+ */
+var ff_pipeline_get_stats = Module.ff_pipeline_get_stats = function(p) {
+    var ptr = ff_snapshot_buffer("pipeline_stats", PIPELINE_STATS.length * 2);
+    ff_pipeline_stats(p, ptr);
+    var s = Module.HEAP32;
+    var b = ptr >> 2;
+    var ret = {};
+    for (var i = 0; i < PIPELINE_STATS.length; i++) {
+        ret[PIPELINE_STATS[i]] =
+            (s[b + i * 2] >>> 0) + (s[b + i * 2 + 1] * 0x100000000);
+    }
+    return ret;
+};
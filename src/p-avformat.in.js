@@ -13,6 +13,73 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+/* Stream-based reader devices queue the data sent to them in blocks of this
+ * size, so that sending many small chunks doesn't allocate many small arrays.
+ * Larger chunks get a block to themselves. */
+var READER_BLOCK_SIZE = 65536;
+
+/* Queue data to be read from a stream-based reader device. The data is copied,
+ * once, into the block at the end of the queue if it fits, or a new block if
+ * not. */
+function readerQueuePush(idata, data) {
+    var blocks = idata.blocks;
+    var tail = blocks[blocks.length - 1];
+    if (!tail || tail.buf.length - tail.end < data.length) {
+        if (data.length >= READER_BLOCK_SIZE) {
+            tail = {buf: data.slice(0), start: 0, end: data.length};
+            blocks.push(tail);
+            idata.size += data.length;
+            return;
+        }
+        tail = idata.spare ||
+            {buf: new Uint8Array(READER_BLOCK_SIZE), start: 0, end: 0};
+        idata.spare = null;
+        blocks.push(tail);
+    }
+    tail.buf.set(data, tail.end);
+    tail.end += data.length;
+    idata.size += data.length;
+}
+
+/* Read up to length bytes from the queue of a stream-based reader device
+ * directly into the heap at ptr. Returns the number of bytes read. */
+function readerQueueShift(idata, heap, ptr, length) {
+    var blocks = idata.blocks;
+    var rd = 0;
+    while (rd < length && blocks.length) {
+        var block = blocks[0];
+        var n = Math.min(length - rd, block.end - block.start);
+        heap.set(block.buf.subarray(block.start, block.start + n), ptr + rd);
+        block.start += n;
+        rd += n;
+        if (block.start === block.end) {
+            if (blocks.length === 1) {
+                // Reuse it in place
+                block.start = block.end = 0;
+                break;
+            }
+            blocks.shift();
+            if (block.buf.length === READER_BLOCK_SIZE) {
+                block.start = block.end = 0;
+                idata.spare = block;
+            }
+        }
+    }
+    idata.size -= rd;
+    return rd;
+}
+
+// Wake up senders waiting for the queue to drain below the high-water mark
+function readerQueueRoom(idata, force) {
+    if (!idata.roomWaiters.length ||
+        (!force && idata.size > idata.highWaterMark))
+        return;
+    var waiters = idata.roomWaiters;
+    idata.roomWaiters = [];
+    for (var i = 0; i < waiters.length; i++)
+        waiters[i]();
+}
+
 // Callbacks for stream-based reader
 var readerCallbacks = {
     open: function(stream) {
@@ -27,7 +94,7 @@ var readerCallbacks = {
     read: function(stream, buffer, offset, length, position) {
         var data = Module.readBuffers[stream.node.name];
 
-        if (!data || (data.buf.length === 0 && !data.eof)) {
+        if (!data || (data.size === 0 && !data.eof)) {
             if (Module.onread) {
                 try {
                     var rr = Module.onread(stream.node.name, position, length);
@@ -51,7 +118,7 @@ var readerCallbacks = {
         }
         if (data.errorCode)
             throw new FS.ErrnoError(data.errorCode);
-        if (data.buf.length === 0) {
+        if (data.size === 0) {
             if (data.eof) {
                 return 0;
             } else {
@@ -60,19 +127,10 @@ var readerCallbacks = {
             }
         }
 
-        var ret;
-        if (length < data.buf.length) {
-            // Cut a slice
-            ret = data.buf.subarray(0, length);
-            data.buf = data.buf.slice(length);
-        } else {
-            // Get the beginning
-            ret = data.buf;
-            data.buf = new Uint8Array(0);
-        }
-
-        (new Uint8Array(buffer.buffer)).set(ret, offset);
-        return ret.length;
+        var ret = readerQueueShift(
+            data, new Uint8Array(buffer.buffer), offset, length);
+        readerQueueRoom(data, false);
+        return ret;
     },
 
     write: function() {
@@ -84,6 +142,85 @@ var readerCallbacks = {
     }
 };
 
+/* Block reader devices cache the blocks sent to them, up to this many bytes by
+ * default, evicting the least recently used */
+var BLOCK_CACHE_SIZE = 2 * 1024 * 1024;
+
+/* The cached blocks are indexed by the spans of this many bytes that they
+ * overlap, so that finding a position doesn't scan the whole cache */
+var BLOCK_INDEX_SPAN = 65536;
+
+// Add a cached block to the index, or remove it
+function blockCacheIndex(idata, pos, len, remove) {
+    var last = Math.floor((pos + len - 1) / BLOCK_INDEX_SPAN);
+    for (var i = Math.floor(pos / BLOCK_INDEX_SPAN); i <= last; i++) {
+        var span = idata.index.get(i);
+        if (remove) {
+            span.splice(span.indexOf(pos), 1);
+            if (!span.length)
+                idata.index.delete(i);
+        } else {
+            if (!span)
+                idata.index.set(i, span = []);
+            span.push(pos);
+        }
+    }
+}
+
+/* Find the cached block of a block reader device containing this position, and
+ * if touch is set, mark it as most recently used. Returns its position, or
+ * -1. */
+function blockCacheFind(idata, position, touch) {
+    var span = idata.index.get(Math.floor(position / BLOCK_INDEX_SPAN));
+    if (!span)
+        return -1;
+    for (var i = 0; i < span.length; i++) {
+        var pos = span[i], buf = idata.cache.get(pos);
+        if (position >= pos && position < pos + buf.length) {
+            if (touch && idata.cache.size > 1) {
+                idata.cache.delete(pos);
+                idata.cache.set(pos, buf);
+            }
+            return pos;
+        }
+    }
+    return -1;
+}
+
+// Add a block to the cache of a block reader device, evicting as needed
+function blockCacheAdd(idata, pos, buf) {
+    var cache = idata.cache;
+    var old = cache.get(pos);
+    if (old) {
+        idata.cached -= old.length;
+        cache.delete(pos);
+        blockCacheIndex(idata, pos, old.length, true);
+    }
+    cache.set(pos, buf);
+    idata.cached += buf.length;
+    blockCacheIndex(idata, pos, buf.length, false);
+
+    var it = cache.keys();
+    while (idata.cached > idata.cacheSize && cache.size > 1) {
+        var epos = it.next().value;
+        var ebuf = cache.get(epos);
+        idata.cached -= ebuf.length;
+        cache.delete(epos);
+        blockCacheIndex(idata, epos, ebuf.length, true);
+        idata.evictions++;
+    }
+}
+
+// Wake everything waiting to read a block reader device
+function blockReaderWake(name, idata) {
+    idata.ready = true;
+    idata.blocked = [];
+    var waiters = Module.ff_reader_dev_waiters[name] || [];
+    delete Module.ff_reader_dev_waiters[name];
+    for (var i = 0; i < waiters.length; i++)
+        waiters[i]();
+}
+
 // Callbacks for block-based reader
 var blockReaderCallbacks = {
     open: function(stream) {
@@ -104,12 +241,14 @@ var blockReaderCallbacks = {
         if (data.errorCode)
             throw new FS.ErrnoError(data.errorCode);
 
-        var bufMin = data.position;
-        var bufMax = data.position + data.buf.length;
-        if (position < bufMin || position >= bufMax) {
+        var bufMin = blockCacheFind(data, position, true);
+        if (bufMin >= 0) {
+            data.hits++;
+        } else {
             if (position >= stream.node.ff_block_reader_dev_size)
                 return 0; // EOF
 
+            data.misses++;
             if (!Module.onblockread)
                 throw new FS.ErrnoError(ERRNO_CODES.EIO);
             try {
@@ -125,25 +264,32 @@ var blockReaderCallbacks = {
             }
 
             // If it was asynchronous, this won't be ready yet
-            bufMin = data.position;
-            bufMax = data.position + data.buf.length;
-            if (position < bufMin || position >= bufMax) {
+            bufMin = blockCacheFind(data, position, true);
+            if (bufMin < 0) {
                 data.ready = false;
+                data.blocked.push(position);
                 throw new FS.ErrnoError(ERRNO_CODES.EAGAIN);
             }
         }
 
+        var buf = data.cache.get(bufMin);
         var bufPos = position - bufMin;
         var ret;
-        if (bufPos + length < data.buf.length) {
+        if (bufPos + length < buf.length) {
             // Cut a slice
-            ret = data.buf.subarray(bufPos, bufPos + length);
+            ret = buf.subarray(bufPos, bufPos + length);
         } else {
             // Get the beginning of what was requested
-            ret = data.buf.subarray(bufPos, data.buf.length);
+            ret = buf.subarray(bufPos, buf.length);
         }
 
         (new Uint8Array(buffer.buffer)).set(ret, offset);
+
+        // Keep reading ahead
+        var ra = readaheads[stream.node.name];
+        if (ra)
+            readaheadPrefetch(stream.node.name, ra, position + ret.length);
+
         return ret.length;
     },
 
@@ -160,6 +306,99 @@ var blockReaderCallbacks = {
     }
 };
 
+/* Writer devices (and writer filesystems) may buffer their writes, per the
+ * options they were made with. Contiguous writes are merged into blocks of up
+ * to bufferSize bytes, and a write elsewhere, or a seek, seals the block.
+ * Sealed blocks are delivered in order, in batches, when they add up to
+ * bufferSize, flushTime ms after the first pending write, on close, and on
+ * ff_writer_dev_flush. A writer device's options are stored on its node, as
+ * ff_writer_opts. */
+var WRITER_FLUSH_TIME = 100;
+
+// Open buffered writers
+var bufferedWriters = [];
+
+// Seal the current block of a buffered writer, queueing it for delivery
+function writerBufferSeal(wb) {
+    var cur = wb.current;
+    if (!cur)
+        return;
+    wb.current = null;
+    wb.queue.push([cur.pos, cur.buf.subarray(0, cur.len)]);
+    wb.queued += cur.len;
+}
+
+// Deliver everything pending in a buffered writer
+function writerBufferFlush(wb) {
+    writerBufferSeal(wb);
+    if (wb.timer) {
+        clearTimeout(wb.timer);
+        wb.timer = null;
+    }
+    if (!wb.queue.length)
+        return;
+
+    var blocks = wb.queue;
+    wb.queue = [];
+    wb.queued = 0;
+    if (Module.onwritemulti) {
+        Module.onwritemulti(wb.name, blocks);
+    } else {
+        for (var i = 0; i < blocks.length; i++)
+            Module.onwrite(wb.name, blocks[i][0], blocks[i][1]);
+    }
+}
+
+// Buffer a write
+function writerBufferWrite(wb, data, position) {
+    var cur = wb.current;
+    if (cur && position !== cur.pos + cur.len) {
+        writerBufferSeal(wb);
+        cur = null;
+    }
+
+    while (data.length) {
+        if (!cur) {
+            cur = wb.current = {
+                pos: position,
+                buf: new Uint8Array(Math.min(wb.size, Math.max(data.length, 4096))),
+                len: 0
+            };
+        }
+
+        // Grow the block if there's room
+        if (cur.len + data.length > cur.buf.length && cur.buf.length < wb.size) {
+            var buf = new Uint8Array(Math.min(wb.size,
+                Math.max(cur.len + data.length, cur.buf.length * 2)));
+            buf.set(cur.buf.subarray(0, cur.len));
+            cur.buf = buf;
+        }
+
+        var len = Math.min(data.length, cur.buf.length - cur.len);
+        cur.buf.set(data.subarray(0, len), cur.len);
+        cur.len += len;
+        position += len;
+        data = data.subarray(len);
+        if (cur.len === wb.size) {
+            writerBufferSeal(wb);
+            cur = null;
+        }
+    }
+
+    if (wb.queued >= wb.size) {
+        writerBufferFlush(wb);
+    } else if (!wb.timer && wb.time > 0) {
+        wb.timer = setTimeout(function() {
+            wb.timer = null;
+            try {
+                writerBufferFlush(wb);
+            } catch (ex) {
+                console.error(ex);
+            }
+        }, wb.time);
+    }
+}
+
 // Callbacks for block-based writer
 var writerCallbacks = {
     open: function(stream) {
@@ -167,18 +406,46 @@ var writerCallbacks = {
             // Opened in read mode, which can't work
             throw new FS.ErrnoError(ERRNO_CODES.EPERM);
         }
+
+        var opts = (stream.node.mount.type === streamWriterFS) ?
+            stream.node.mount.opts : stream.node.ff_writer_opts;
+        if (opts && opts.bufferSize > 0) {
+            var wb = stream.ff_writer_buffer = {
+                name: stream.node.name,
+                size: opts.bufferSize,
+                time: (typeof opts.flushTime === "number") ?
+                    opts.flushTime : WRITER_FLUSH_TIME,
+                current: null,
+                queue: [],
+                queued: 0,
+                timer: null
+            };
+            bufferedWriters.push(wb);
+        }
     },
 
-    close: function() {},
+    close: function(stream) {
+        var wb = stream.ff_writer_buffer;
+        if (wb) {
+            bufferedWriters.splice(bufferedWriters.indexOf(wb), 1);
+            writerBufferFlush(wb);
+        }
+    },
 
     read: function() {
         throw new FS.ErrnoError(ERRNO_CODES.EIO);
     },
 
     write: function(stream, buffer, offset, length, position) {
-        if (!Module.onwrite)
+        if (!Module.onwrite && !Module.onwritemulti)
             throw new FS.ErrnoError(ERRNO_CODES.EIO);
-        Module.onwrite(stream.node.name, position, buffer.subarray(offset, offset + length));
+        var data = buffer.subarray(offset, offset + length);
+        if (stream.ff_writer_buffer)
+            writerBufferWrite(stream.ff_writer_buffer, data, position);
+        else if (Module.onwrite)
+            Module.onwrite(stream.node.name, position, data);
+        else
+            Module.onwritemulti(stream.node.name, [[position, data]]);
         return length;
     },
 
@@ -187,6 +454,8 @@ var writerCallbacks = {
             throw new FS.ErrnoError(ERRNO_CODES.EIO);
         else if (whence === 1)
             offset += stream.position;
+        if (stream.ff_writer_buffer && offset !== stream.position)
+            writerBufferSeal(stream.ff_writer_buffer);
         return offset;
     }
 };
@@ -298,16 +567,35 @@ fsBinding("mkdev");
 fsBinding("createLazyFile");
 
 /**
- * Make a reader device.
+ * Make a reader device. Data sent to it with ff_reader_dev_send is queued until
+ * it's read. If a high-water mark is given, ff_reader_dev_send resolves only
+ * once the queue has been read down to it, so a sender that waits for it
+ * can't get more than that far ahead of the reader.
  * @param name  Filename to create.
  * @param mode  Unix permissions (pointless since this is an in-memory
- *              filesystem)
+ *              filesystem), or options
+ */
+/* @types
+ * mkreaderdev@sync(
+ *     name: string, mode?: number | {
+ *         mode?: number,
+ *         highWaterMark?: number // in bytes
+ *     }
+ * ): @promise@void@
  */
-/// @types mkreaderdev@sync(name: string, mode?: number): @promise@void@
 Module.mkreaderdev = function(loc, mode) {
+    var opts = {};
+    if (typeof mode === "object" && mode) {
+        opts = mode;
+        mode = opts.mode;
+    }
     FS.mkdev(loc, mode?mode:0x1FF, readerDev);
     Module.readBuffers[loc] = {
-        buf: new Uint8Array(0),
+        blocks: [],
+        spare: null,
+        size: 0,
+        highWaterMark: opts.highWaterMark || Infinity,
+        roomWaiters: [],
         eof: false,
         errorCode: 0,
         error: null
@@ -317,12 +605,21 @@ Module.mkreaderdev = function(loc, mode) {
 
 /**
  * Make a block reader "device". Technically a file that we then hijack to have
- * our behavior.
+ * our behavior. The blocks sent to it are cached, so onblockread is only called
+ * for data that isn't in the cache.
  * @param name  Filename to create.
  * @param size  Size of the device to present.
+ * @param opts  Options
+ */
+/* @types
+ * mkblockreaderdev@sync(
+ *     name: string, size: number, opts?: {
+ *         cacheSize?: number // in bytes, default 2MiB
+ *     }
+ * ): @promise@void@
  */
-/// @types mkblockreaderdev@sync(name: string, size: number): @promise@void@
-var mkblockreaderdev = Module.mkblockreaderdev = function(name, size) {
+var mkblockreaderdev = Module.mkblockreaderdev = function(name, size, opts) {
+    opts = opts || {};
     FS.writeFile(name, new Uint8Array(0));
     var f = FS.open(name, 0);
 
@@ -340,9 +637,16 @@ var mkblockreaderdev = Module.mkblockreaderdev = function(name, size) {
     f.node.ff_block_reader_dev_size = size;
 
     Module.blockReadBuffers[name] = {
-        position: -1,
-        buf: new Uint8Array(0),
+        cache: new Map(),
+        index: new Map(),
+        cached: 0,
+        cacheSize: opts.cacheSize || BLOCK_CACHE_SIZE,
+        hits: 0,
+        misses: 0,
+        evictions: 0,
         ready: false,
+        // Positions that reads are waiting for
+        blocked: [],
         errorCode: 0,
         error: null
     };
@@ -353,10 +657,55 @@ var mkblockreaderdev = Module.mkblockreaderdev = function(name, size) {
 // Readahead devices
 var readaheads = {};
 
+// Readahead files are read in blocks of this size
+var READAHEAD_BLOCK_SIZE = 65536;
+
 // Original onblockread
 var preReadaheadOnBlockRead = null;
 
-// Passthru for readahead.
+/* Read a block of a readahead file, and cache it when it arrives, waking the
+ * readers only if it's what they're waiting for. If it fails and something is
+ * waiting for it, send the error. */
+function readaheadFetch(name, ra, block) {
+    var pos = block * ra.blockSize;
+    var f = ra.inflight[block] = {demanded: false};
+    ra.fetches++;
+    ra.file.slice(pos, pos + ra.blockSize).arrayBuffer().then(function(ab) {
+        delete ra.inflight[block];
+        ra.fetched += ab.byteLength;
+        if (readaheads[name] !== ra || !ab.byteLength)
+            return;
+        var idata = Module.blockReadBuffers[name];
+        var end = pos + ab.byteLength;
+        blockCacheAdd(idata, pos, new Uint8Array(ab));
+        if (idata.blocked.some(function(p) { return p >= pos && p < end; }))
+            blockReaderWake(name, idata);
+    }).catch(function(ex) {
+        delete ra.inflight[block];
+        if (f.demanded && readaheads[name] === ra)
+            ff_block_reader_dev_send(name, pos, null, {error: ex});
+    });
+    return f;
+}
+
+/* Read the block containing this position, and the readahead window of blocks
+ * after it, other than those already cached or being read. This is the next
+ * position expected to be read. */
+function readaheadPrefetch(name, ra, position) {
+    ra.next = position;
+    var idata = Module.blockReadBuffers[name];
+    var first = Math.floor(position / ra.blockSize);
+    var last = Math.min(first + ra.ahead,
+        Math.ceil(ra.file.size / ra.blockSize) - 1);
+    for (var b = first; b <= last; b++) {
+        if (!ra.inflight[b] && blockCacheFind(idata, b * ra.blockSize) < 0)
+            readaheadFetch(name, ra, b);
+    }
+}
+
+/* Passthru for readahead. Called for reads that missed the cache. Sequential
+ * reads double the readahead window (up to the maximum), and anything else
+ * resets it. */
 function readaheadOnBlockRead(name, position, length) {
     if (!(name in readaheads)) {
         if (preReadaheadOnBlockRead)
@@ -365,63 +714,53 @@ function readaheadOnBlockRead(name, position, length) {
     }
 
     var ra = readaheads[name];
-
-    function then() {
-        if (ra.position !== position) {
-            ra.position = position;
-            ra.buf = null;
-            ra.bufPromise = ra.file.slice(position, position + length).arrayBuffer()
-                .then(function(ret) {
-                    ra.buf = ret;
-                }).catch(function(ex) {
-                    console.error(ex + "\n" + ex.stack);
-                    ra.buf = new Uint8Array(0);
-                }).then(then);
-            return;
-        }
-
-        ff_block_reader_dev_send(name, position, new Uint8Array(ra.buf));
-
-        // Attempt to predict the next read
-        position += length;
-        ra.position = position;
-        ra.buf = null;
-        ra.bufPromise = ra.file.slice(position, position + length).arrayBuffer()
-            .then(function(ret) {
-                ra.buf = ret;
-            }).catch(function(ex) {
-                console.error(ex + "\n" + ex.stack);
-                ra.buf = new Uint8Array(0);
-            });
-    }
-
-    if (!ra.buf && ra.bufPromise)
-        ra.bufPromise.then(then);
+    if (position === ra.next)
+        ra.ahead = Math.min(Math.max(ra.ahead * 2, 1), ra.maxAhead);
     else
-        then();
+        ra.ahead = 0;
+
+    var block = Math.floor(position / ra.blockSize);
+    var f = ra.inflight[block] || readaheadFetch(name, ra, block);
+    f.demanded = true;
+    readaheadPrefetch(name, ra, position);
 }
 
 /**
- * Make a readahead device. This reads a File (or other Blob) and attempts to
- * read ahead of whatever libav actually asked for. Note that this overrides
- * onblockread, so if you want to support both kinds of files, make sure you set
- * onblockread before calling this.
+ * Make a readahead device. This reads a File (or other Blob) in blocks, which
+ * are cached as with a block reader device, and reads ahead of whatever libav
+ * actually asked for, in a window that grows as long as reading is sequential.
+ * Note that this overrides onblockread, so if you want to support both kinds of
+ * files, make sure you set onblockread before calling this.
  * @param name  Filename to create.
  * @param file  Blob or file to read.
+ * @param opts  Options
+ */
+/* @types
+ * mkreadaheadfile@sync(
+ *     name: string, file: Blob, opts?: {
+ *         cacheSize?: number, // in bytes, default 2MiB
+ *         blockSize?: number, // in bytes, default 64KiB
+ *         readahead?: number // maximum blocks to read ahead, default 8
+ *     }
+ * ): @promise@void@
  */
-/// @types mkreadaheadfile@sync(name: string, file: Blob): @promise@void@
-Module.mkreadaheadfile = function(name, file) {
+Module.mkreadaheadfile = function(name, file, opts) {
+    opts = opts || {};
     if (Module.onblockread !== readaheadOnBlockRead) {
         preReadaheadOnBlockRead = Module.onblockread;
         Module.onblockread = readaheadOnBlockRead;
     }
 
-    mkblockreaderdev(name, file.size);
+    mkblockreaderdev(name, file.size, {cacheSize: opts.cacheSize});
     readaheads[name] = {
         file: file,
-        position: -1,
-        bufPromise: null,
-        buf: null
+        blockSize: opts.blockSize || READAHEAD_BLOCK_SIZE,
+        maxAhead: (typeof opts.readahead === "number") ? opts.readahead : 8,
+        ahead: 0,
+        next: -1,
+        inflight: Object.create(null),
+        fetches: 0,
+        fetched: 0
     };
 };
 
@@ -435,14 +774,344 @@ Module.unlinkreadaheadfile = function(name) {
     delete readaheads[name];
 };
 
+/**
+ * Get the cache statistics of a block reader device (including a readahead
+ * file). Reads that hit the cache are served immediately, while misses have to
+ * wait for onblockread (or the file) to provide the data.
+ * @param name  Filename of the device.
+ */
+/* @types
+ * ff_block_reader_dev_stats@sync(name: string): @promise@{
+ *     hits: number,
+ *     misses: number,
+ *     evictions: number,
+ *     cached: number, // bytes
+ *     fetches?: number, // readahead files only: blocks read from the file
+ *     fetched?: number // readahead files only: bytes read from the file
+ * }@
+ */
+Module.ff_block_reader_dev_stats = function(name) {
+    var idata = Module.blockReadBuffers[name];
+    var ret = {
+        hits: idata.hits,
+        misses: idata.misses,
+        evictions: idata.evictions,
+        cached: idata.cached
+    };
+    var ra = readaheads[name];
+    if (ra) {
+        ret.fetches = ra.fetches;
+        ret.fetched = ra.fetched;
+    }
+    return ret;
+};
+
+/* State of the jsfetch protocol (patches/ffmpeg/07-jsfetch-protocol.diff).
+ * Each open context is in fetches. In block mode (the block_size protocol
+ * option), files are read in fixed-size blocks with range requests, and the
+ * blocks are cached per URL in caches, so that they're shared by every context
+ * reading the same URL, and reused across seeks. A URL's cache is freed when
+ * the last context reading it closes. */
+function jsfetchState() {
+    if (!Module.libavjsJSFetch)
+        Module.libavjsJSFetch = {ctr: 1, fetches: {}};
+    var jsf = Module.libavjsJSFetch;
+    if (!jsf.caches) {
+        jsf.caches = Object.create(null);
+        jsf.stats = {
+            requests: 0, bytes: 0, hits: 0, misses: 0, evictions: 0
+        };
+    }
+    return jsf;
+}
+
+/* Count requests made and bytes received by jsfetch. Used by the protocol,
+ * including in streaming mode. */
+Module.libavjsJSFetchCount = function(requests, bytes) {
+    var stats = jsfetchState().stats;
+    stats.requests += requests;
+    stats.bytes += bytes;
+};
+
+/* Get the total size from a Content-Range header, or -1 if it's unknown */
+function jsfetchRangeTotal(contentRange) {
+    var match = /\/(\d+)$/.exec(contentRange || "");
+    return match ? +match[1] : -1;
+}
+
+/* Evict least-recently-used blocks until the cache fits its size. Blocks still
+ * being fetched are never evicted. */
+function jsfetchEvict(cache) {
+    var stats = jsfetchState().stats;
+    var it = cache.blocks.entries();
+    var step;
+    while (cache.cached > cache.cacheSize && !(step = it.next()).done) {
+        var block = step.value[1];
+        if (!block.data)
+            continue;
+        cache.blocks.delete(step.value[0]);
+        cache.cached -= block.data.length;
+        stats.evictions++;
+    }
+}
+
+/* Add a fetched block to a cache */
+function jsfetchAddBlock(cache, index, block, data) {
+    block.data = data;
+    cache.cached += data.length;
+    jsfetchEvict(cache);
+}
+
+/* Get a block of a URL, from the cache or by requesting it. The block's data is
+ * set when it arrives, and its promise resolves then. */
+function jsfetchBlock(cache, index) {
+    var block = cache.blocks.get(index);
+    if (block) {
+        // Move it to the end of the LRU order
+        cache.blocks.delete(index);
+        cache.blocks.set(index, block);
+        return block;
+    }
+
+    var stats = jsfetchState().stats;
+    var start = index * cache.blockSize;
+    var end = Math.min(start + cache.blockSize, cache.filesize) - 1;
+    block = {data: null, promise: null};
+    cache.blocks.set(index, block);
+    stats.requests++;
+    block.promise = fetch(cache.url, {
+        headers: {Range: "bytes=" + start + "-" + end}
+    }).then(function(response) {
+        if (response.status !== 206)
+            throw new Error("jsfetch: " + cache.url + " does not support range requests");
+        return response.arrayBuffer();
+    }).then(function(ab) {
+        stats.bytes += ab.byteLength;
+        jsfetchAddBlock(cache, index, block, new Uint8Array(ab));
+    }).catch(function(ex) {
+        // Forget the failed block, so that it can be retried
+        if (cache.blocks.get(index) === block)
+            cache.blocks.delete(index);
+        throw ex;
+    });
+    // Prefetched blocks may never be waited for
+    block.promise.catch(function() {});
+    return block;
+}
+
+/* Open a jsfetch context in block mode. Resolves to the index of the context.
+ * If the server doesn't support range requests, the context streams instead;
+ * the protocol checks the block field to find out. */
+Module.libavjsJSFetchBlockOpen = function(url, blockSize, cacheSize, prefetch) {
+    var jsf = jsfetchState();
+    var fetchUrl = url.slice(0, 8) === "jsfetch:" ? url.slice(8) : url;
+    var key = blockSize + ":" + fetchUrl;
+    var cache = jsf.caches[key];
+    if (!cache) {
+        cache = jsf.caches[key] = {
+            key: key,
+            url: fetchUrl,
+            blockSize: blockSize,
+            cacheSize: cacheSize,
+            filesize: -1,
+            // Map iterates in insertion order, which serves as the LRU order
+            blocks: new Map(),
+            cached: 0,
+            // Number of open contexts using this cache
+            users: 0
+        };
+    }
+    // Contexts sharing a cache get the largest size any of them asked for
+    cache.cacheSize = Math.max(cache.cacheSize, cacheSize);
+    cache.users++;
+
+    var jsfo = {
+        block: true,
+        url: fetchUrl,
+        cache: cache,
+        prefetch: prefetch,
+        next: 0,
+        filesize: 0
+    };
+    var abortController = new AbortController();
+    var p = Promise.resolve(null);
+
+    if (cache.filesize < 0) {
+        // Requesting the first block also tells us the size of the file
+        jsf.stats.requests++;
+        p = fetch(fetchUrl, {
+            headers: {Range: "bytes=0-" + (blockSize - 1)},
+            signal: abortController.signal
+        }).then(function(response) {
+            var total = jsfetchRangeTotal(response.headers.get("Content-Range"));
+            if (response.status !== 206)
+                return response;
+            if (total < 0) {
+                // Can't use blocks without knowing the size, so stream it
+                abortController.abort();
+                abortController = new AbortController();
+                jsf.stats.requests++;
+                return fetch(fetchUrl, {signal: abortController.signal});
+            }
+
+            cache.filesize = total;
+            return response.arrayBuffer().then(function(ab) {
+                var block = {data: null, promise: Promise.resolve()};
+                jsf.stats.bytes += ab.byteLength;
+                cache.blocks.set(0, block);
+                jsfetchAddBlock(cache, 0, block, new Uint8Array(ab));
+                return null;
+            });
+        });
+    }
+
+    return p.then(function(response) {
+        if (response) {
+            // No range requests, so stream it
+            var contentLength = response.headers.get("Content-Length");
+            jsfo = {
+                url: fetchUrl,
+                response: response,
+                reader: response.body.getReader(),
+                abortController: abortController,
+                buf: null,
+                rej: null,
+                filesize: contentLength ? +contentLength : 0
+            };
+            jsfetchRelease(cache);
+        } else {
+            jsfo.filesize = cache.filesize;
+        }
+        var idx = jsf.ctr++;
+        jsf.fetches[idx] = jsfo;
+        return idx;
+    }).catch(function(ex) {
+        jsfetchRelease(cache);
+        throw ex;
+    });
+};
+
+/* Stop using a block cache, and free it if no other context is using it */
+function jsfetchRelease(cache) {
+    var caches = jsfetchState().caches;
+    if (--cache.users <= 0 && caches[cache.key] === cache)
+        delete caches[cache.key];
+}
+
+/* Close a jsfetch context, in either mode */
+Module.libavjsJSFetchClose = function(idx) {
+    var jsf = Module.libavjsJSFetch;
+    var jsfo = jsf && jsf.fetches[idx];
+    if (!jsfo)
+        return;
+    try {
+        if (jsfo.reader)
+            jsfo.reader.cancel();
+        if (jsfo.abortController)
+            jsfo.abortController.abort();
+    } catch (ex) {}
+    delete jsf.fetches[idx];
+    if (jsfo.block)
+        jsfetchRelease(jsfo.cache);
+};
+
+/* Request the blocks after this one that aren't already cached or requested */
+function jsfetchPrefetch(cache, index, count) {
+    var last = Math.ceil(cache.filesize / cache.blockSize) - 1;
+    for (var i = index + 1; i <= index + count && i <= last; i++) {
+        if (!cache.blocks.has(i))
+            jsfetchBlock(cache, i);
+    }
+}
+
+/* Read from a jsfetch context in block mode. Returns the number of bytes read
+ * (or an error) if the block is cached, or else a promise for it. */
+Module.libavjsJSFetchBlockRead = function(idx, ptr, size, off) {
+    var jsf = jsfetchState();
+    var jsfo = jsf.fetches[idx];
+    var cache = jsfo.cache;
+    if (off >= cache.filesize)
+        return -0x20464f45 /* AVERROR_EOF */;
+
+    var index = Math.floor(off / cache.blockSize);
+    var block = jsfetchBlock(cache, index);
+
+    // Sequential reads request the following blocks ahead of time
+    if (off === jsfo.next)
+        jsfetchPrefetch(cache, index, jsfo.prefetch);
+
+    function copy() {
+        var start = off - index * cache.blockSize;
+        var len = Math.min(size, block.data.length - start);
+        if (len <= 0)
+            return -0x20464f45 /* AVERROR_EOF */;
+        Module.HEAPU8.set(block.data.subarray(start, start + len), ptr);
+        jsfo.next = off + len;
+        return len;
+    }
+
+    if (block.data) {
+        jsf.stats.hits++;
+        return copy();
+    }
+    jsf.stats.misses++;
+    return block.promise.then(copy).catch(function(ex) {
+        Module.fsThrownError = ex;
+        console.error(ex);
+        return -11 /* ECANCELED */;
+    });
+};
+
+/**
+ * Get the statistics of the jsfetch protocol: requests made, bytes received,
+ * and, for block mode, how many reads hit or missed the block cache, and how
+ * many blocks were evicted from it.
+ */
+/* @types
+ * ff_jsfetch_stats@sync(): @promise@{
+ *     requests: number,
+ *     bytes: number,
+ *     hits: number,
+ *     misses: number,
+ *     evictions: number
+ * }@
+ */
+var ff_jsfetch_stats = Module.ff_jsfetch_stats = function() {
+    var stats = jsfetchState().stats;
+    return {
+        requests: stats.requests,
+        bytes: stats.bytes,
+        hits: stats.hits,
+        misses: stats.misses,
+        evictions: stats.evictions
+    };
+};
+
+// Writer devices, removed by ff_reset
+var writerDevs = Object.create(null);
+
+// Remember a writer device, and its buffering options
+function writerDevOpts(loc, node, opts) {
+    writerDevs[loc] = true;
+    if (opts && opts.bufferSize > 0)
+        node.ff_writer_opts = opts;
+}
+
 /**
  * Make a writer device.
  * @param name  Filename to create
  * @param mode  Unix permissions
+ * @param opts  Options. If bufferSize is set, writes are buffered and merged,
+ *              and delivered in blocks of up to that many bytes.
+ */
+/* @types
+ * mkwriterdev@sync(
+ *     name: string, mode?: number, opts?: WriterDevOptions
+ * ): @promise@void@
  */
-/// @types mkwriterdev@sync(name: string, mode?: number): @promise@void@
-var mkwriterdev = Module.mkwriterdev = function(loc, mode) {
-    FS.mkdev(loc, mode?mode:0x1FF, writerDev);
+var mkwriterdev = Module.mkwriterdev = function(loc, mode, opts) {
+    var node = FS.mkdev(loc, mode?mode:0x1FF, writerDev);
+    writerDevOpts(loc, node, opts);
     return 0;
 };
 
@@ -451,10 +1120,16 @@ var mkwriterdev = Module.mkwriterdev = function(loc, mode) {
  * seeking.
  * @param name  Filename to create
  * @param mode  Unix permissions
+ * @param opts  Options, as for mkwriterdev
  */
-/// @types mkstreamwriterdev@sync(name: string, mode?: number): @promise@void@
-Module.mkstreamwriterdev = function(loc, mode) {
-    FS.mkdev(loc, mode?mode:0x1FF, streamWriterDev);
+/* @types
+ * mkstreamwriterdev@sync(
+ *     name: string, mode?: number, opts?: WriterDevOptions
+ * ): @promise@void@
+ */
+Module.mkstreamwriterdev = function(loc, mode, opts) {
+    var node = FS.mkdev(loc, mode?mode:0x1FF, streamWriterDev);
+    writerDevOpts(loc, node, opts);
     return 0;
 };
 
@@ -463,16 +1138,34 @@ Module.mkstreamwriterdev = function(loc, mode) {
  * redirected as writers. The directory will be created for you if it doesn't
  * already exist, but it may already exist.
  * @param mountpoint  Directory to mount as a writer filesystem
+ * @param opts  Options for every file in the filesystem, as for mkwriterdev
+ */
+/* @types
+ * mountwriterfs@sync(
+ *     mountpoint: string, opts?: WriterDevOptions
+ * ): @promise@void@
  */
-/// @types mountwriterfs@sync(mountpoint: string): @promise@void@
-Module.mountwriterfs = function(mountpoint) {
+Module.mountwriterfs = function(mountpoint, opts) {
     try {
         FS.mkdir(mountpoint);
     } catch (ex) {}
-    FS.mount(streamWriterFS, {}, mountpoint);
+    FS.mount(streamWriterFS, opts || {}, mountpoint);
     return 0;
 }
 
+/**
+ * Deliver everything buffered by buffered writer devices, rather than waiting
+ * for the buffer to fill, the flush time, or the file to be closed.
+ * @param name  Filename to flush. If absent, flushes all of them.
+ */
+/// @types ff_writer_dev_flush@sync(name?: string): @promise@void@
+Module.ff_writer_dev_flush = function(name) {
+    bufferedWriters.forEach(function(wb) {
+        if (!name || wb.name === name)
+            writerBufferFlush(wb);
+    });
+};
+
 // Users waiting to read
 Module.ff_reader_dev_waiters = Object.create(null);
 
@@ -516,10 +1209,12 @@ function fsfhOnWrite(name, position, buffer) {
     }
 
     var h = fsfhs[name];
-    buffer = buffer.slice(0);
+    // Blocks from buffered writers are already ours, but heap views aren't
+    if (buffer.buffer === Module.HEAPU8.buffer)
+        buffer = buffer.slice(0);
 
     if (h.syncHandle) {
-        h.syncHandle.write(buffer.buffer, {
+        h.syncHandle.write(buffer, {
             at: position
         });
         return;
@@ -544,15 +1239,21 @@ function fsfhOnWrite(name, position, buffer) {
  * this.
  * @param name  Filename to create.
  * @param fsfh  FileSystemFileHandle corresponding to this filename.
+ * @param opts  Options, as for mkwriterdev. Buffering makes for fewer, larger
+ *              writes to the file handle.
  */
-/// @types mkfsfhfile(name: string, fsfh: FileSystemFileHandle): Promise<void>
-Module.mkfsfhfile = function(name, fsfh) {
+/* @types
+ * mkfsfhfile(
+ *     name: string, fsfh: FileSystemFileHandle, opts?: WriterDevOptions
+ * ): Promise<void>
+ */
+Module.mkfsfhfile = function(name, fsfh, opts) {
     if (Module.onwrite !== fsfhOnWrite) {
         preFSFHOnWrite = Module.onwrite;
         Module.onwrite = fsfhOnWrite;
     }
 
-    mkwriterdev(name);
+    mkwriterdev(name, 0, opts);
 
     var h = fsfhs[name] = {
         promise: Promise.all([])
@@ -589,9 +1290,77 @@ Module.unlinkfsfhfile = function(name) {
     });
 }
 
+// Remove every device, for ff_reset
+ff_reset_hooks.push(function() {
+    function unlink(name) {
+        try {
+            FS.unlink(name);
+        } catch (ex) {}
+    }
+
+    // Anything waiting for a reader device can give up
+    for (var name in Module.readBuffers) {
+        readerQueueRoom(Module.readBuffers[name], true);
+        unlink(name);
+    }
+    Module.readBuffers = Object.create(null);
+    for (var name in Module.blockReadBuffers)
+        unlink(name);
+    Module.blockReadBuffers = Object.create(null);
+    Module.ff_reader_dev_waiters = Object.create(null);
+    readaheads = {};
+    if (Module.onblockread === readaheadOnBlockRead) {
+        Module.onblockread = preReadaheadOnBlockRead;
+        preReadaheadOnBlockRead = null;
+    }
+
+    // Writers have been flushed, since ff_reset closes every file first
+    for (var name in fsfhs) {
+        try {
+            Module.unlinkfsfhfile(name).catch(console.error);
+        } catch (ex) {
+            console.error(ex);
+        }
+    }
+    if (Module.onwrite === fsfhOnWrite) {
+        Module.onwrite = preFSFHOnWrite;
+        preFSFHOnWrite = null;
+    }
+    for (var name in writerDevs)
+        unlink(name);
+    writerDevs = Object.create(null);
+
+    // Workerfs files and writer filesystems
+    FS.getMounts(FS.root.mount).forEach(function(mount) {
+        if (mount.type !== WORKERFS && mount.type !== streamWriterFS)
+            return;
+        try {
+            FS.unmount(mount.mountpoint);
+            if (mount.type === WORKERFS)
+                FS.rmdir(mount.mountpoint);
+        } catch (ex) {
+            console.error(ex);
+        }
+    });
+
+    // And jsfetch's state
+    var jsf = Module.libavjsJSFetch;
+    if (jsf) {
+        for (var idx in jsf.fetches) {
+            var jsfo = jsf.fetches[idx];
+            if (jsfo.abortController)
+                jsfo.abortController.abort();
+        }
+        delete Module.libavjsJSFetch;
+    }
+});
+
 /**
  * Send some data to a reader device. To indicate EOF, send null. To indicate an
- * error, send EOF and include an error code in the options.
+ * error, send EOF and include an error code in the options. If the device has a
+ * high-water mark and this leaves more than that much data queued, returns a
+ * promise that resolves when there's room again. The data is queued either
+ * way.
  * @param name  Filename of the reader device.
  * @param data  Data to send.
  * @param opts  Optional send options, such as an error code.
@@ -603,7 +1372,7 @@ Module.unlinkfsfhfile = function(name) {
  *         errorCode?: number,
  *         error?: any // any other error, used internally
  *     }
- * ): @promise@void@
+ * ): @promsync@void@
  */
 var ff_reader_dev_send = Module.ff_reader_dev_send = function(name, data, opts) {
     opts = opts || {};
@@ -613,11 +1382,8 @@ var ff_reader_dev_send = Module.ff_reader_dev_send = function(name, data, opts)
         // EOF or error
         idata.eof = true;
 
-    } else {
-        var newbuf = new Uint8Array(idata.buf.length + data.length);
-        newbuf.set(idata.buf);
-        newbuf.set(data, idata.buf.length);
-        idata.buf = newbuf;
+    } else if (data.length) {
+        readerQueuePush(idata, data);
 
     }
 
@@ -635,6 +1401,24 @@ var ff_reader_dev_send = Module.ff_reader_dev_send = function(name, data, opts)
     delete Module.ff_reader_dev_waiters[name];
     for (var i = 0; i < waiters.length; i++)
         waiters[i]();
+
+    // Nothing more will be read after EOF, so no need to wait for room
+    if (idata.eof) {
+        readerQueueRoom(idata, true);
+    } else if (idata.size > idata.highWaterMark) {
+        return new Promise(function(res) {
+            idata.roomWaiters.push(res);
+        });
+    }
+};
+
+/**
+ * Get the number of bytes sent to a reader device but not yet read.
+ * @param name  Filename of the reader device.
+ */
+/// @types ff_reader_dev_buffered@sync(name: string): @promise@number@
+Module.ff_reader_dev_buffered = function(name) {
+    return Module.readBuffers[name].size;
 };
 
 /**
@@ -659,25 +1443,17 @@ var ff_reader_dev_send = Module.ff_reader_dev_send = function(name, data, opts)
 var ff_block_reader_dev_send = Module.ff_block_reader_dev_send = function(name, pos, data, opts) {
     opts = opts || {};
     var idata = Module.blockReadBuffers[name];
-    idata.position = pos;
-    idata.buf = data;
-    idata.ready = true;
+    if (data && data.length)
+        blockCacheAdd(idata, pos, data);
     idata.errorCode = 0;
     idata.error = null;
 
-    if (data === null)
-        idata.buf = new Uint8Array(0);
-
     if (typeof opts.errorCode === "number")
         idata.errorCode = opts.errorCode;
     if (opts.error)
         idata.error = opts.error;
 
-    // Wake up waiters
-    var waiters = Module.ff_reader_dev_waiters[name] || [];
-    delete Module.ff_reader_dev_waiters[name];
-    for (var i = 0; i < waiters.length; i++)
-        waiters[i]();
+    blockReaderWake(name, idata);
 };
 
 /**
@@ -732,6 +1508,7 @@ Module.fdName = function(fd) {
  *         format_name?: string, // libav name
  *         filename?: string,
  *         device?: boolean, // Create a writer device
+ *         deviceOpts?: WriterDevOptions, // Options for the writer device
  *         open?: boolean, // Open the file for writing
  *         codecpars?: boolean // Streams is in terms of codecpars, not codecctx
  *     },
@@ -767,7 +1544,7 @@ var ff_init_muxer = Module.ff_init_muxer = function(opts, streamCtxs) {
 
     // Set up the device if requested
     if (opts.device)
-        FS.mkdev(opts.filename, 0x1FF, writerDev);
+        mkwriterdev(opts.filename, 0, opts.deviceOpts);
 
     // Open the actual file if requested
     var pb = null;
@@ -793,19 +1570,42 @@ var ff_free_muxer = Module.ff_free_muxer = function(oc, pb) {
         avio_close(pb);
 };
 
+/* Layout of stream snapshot records, in 32-bit words. Must match b-avformat.c.
+ * 64-bit fields take two words, low word first. */
+var STREAM_SNAP = {
+    VERSION: 0,
+    SET: 1,
+    DURATION: 2,
+    START_TIME: 4,
+    NB_FRAMES: 6,
+    INDEX: 8,
+    CODECPAR: 9,
+    CODEC_TYPE: 10,
+    CODEC_ID: 11,
+    TIME_BASE_NUM: 12,
+    TIME_BASE_DEN: 13,
+    DISCARD: 14,
+    METADATA: 15,
+    SIZE: 16
+};
+
 /**
  * Initialize a demuxer from a file and format context, and get the list of
  * codecs/types.
  * Returns [AVFormatContext, Stream[]]
  * @param filename  Filename to open
  * @param opts  Options to use when opening. If a string, then the string
- *              format.
+ *              format. options are set in the open_input_options dictionary
+ *              (allocating it if needed), and are passed to the demuxer and
+ *              protocol (e.g., {block_size: "65536"} for jsfetch). The
+ *              dictionary is freed by the open.
  */
 /* @types
  * ff_init_demuxer_file@sync(
  *     filename: string, opts?: string | {
  *         format?: string,
- *         open_input_options?: number
+ *         open_input_options?: number,
+ *         options?: Record<string, string>
  *     }
  * ): @promsync@[number, Stream[]]@
  */
@@ -817,10 +1617,16 @@ function ff_init_demuxer_file(filename, opts) {
     else if (typeof opts === "undefined")
         opts = {};
 
+    var options = opts.open_input_options || 0;
+    if (opts.options) {
+        for (var prop in opts.options)
+            options = av_dict_set_js(options, prop, opts.options[prop], 0);
+    }
+
     return avformat_open_input_js(
         filename,
         opts.format||null,
-        opts.open_input_options||null
+        options||null
     ).then(function(ret) {
         fmt_ctx = ret;
         if (fmt_ctx === 0)
@@ -831,27 +1637,32 @@ function ff_init_demuxer_file(filename, opts) {
     }).then(function() {
         var nb_streams = AVFormatContext_nb_streams(fmt_ctx);
         var streams = [];
+        var snapPtr = ff_snapshot_buffer("stream", STREAM_SNAP.SIZE);
+        var b = snapPtr >> 2;
         for (var i = 0; i < nb_streams; i++) {
             var inStream = AVFormatContext_streams_a(fmt_ctx, i);
             var outStream = {
                 ptr: inStream,
                 index: i
             };
+            ff_stream_snapshot(inStream, snapPtr);
+            var s = Module.HEAP32;
 
             // Codec info
-            var codecpar = AVStream_codecpar(inStream);
-            outStream.codecpar = codecpar;
-            outStream.codec_type = AVCodecParameters_codec_type(codecpar);
-            outStream.codec_id = AVCodecParameters_codec_id(codecpar);
+            outStream.codecpar = s[b + STREAM_SNAP.CODECPAR];
+            outStream.codec_type = s[b + STREAM_SNAP.CODEC_TYPE];
+            outStream.codec_id = s[b + STREAM_SNAP.CODEC_ID];
 
             // Duration and related
-            outStream.time_base_num = AVStream_time_base_num(inStream);
-            outStream.time_base_den = AVStream_time_base_den(inStream);
-            outStream.duration_time_base = AVStream_duration(inStream) + (AVStream_durationhi(inStream)*0x100000000);
+            outStream.time_base_num = s[b + STREAM_SNAP.TIME_BASE_NUM];
+            outStream.time_base_den = s[b + STREAM_SNAP.TIME_BASE_DEN];
+            outStream.duration_time_base =
+                (s[b + STREAM_SNAP.DURATION] >>> 0) +
+                (s[b + STREAM_SNAP.DURATION + 1] * 0x100000000);
             outStream.duration = outStream.duration_time_base * outStream.time_base_num / outStream.time_base_den;
 
             // Metadata
-            var md = AVStream_metadata(inStream);
+            var md = s[b + STREAM_SNAP.METADATA];
             if (md)
                 outStream.metadata = ff_copyout_dict(md);
 
@@ -911,14 +1722,25 @@ var ff_get_demuxer_chapters = Module.ff_get_demuxer_chapters = function(fmt_ctx)
  * @param pkt  AVPacket
  * @param inPackets  Packets to write
  * @param interleave  Set to false to *not* use the interleaved writer.
- *                    Interleaving is the default.
+ *                    Interleaving is the default. May instead be an object of
+ *                    options, in which `packetPool` is a pool to release
+ *                    AVPacket pointers in inPackets to.
  */
 /* @types
  * ff_write_multi@sync(
- *     oc: number, pkt: number, inPackets: (Packet | number)[], interleave?: boolean
+ *     oc: number, pkt: number, inPackets: (Packet | PacketView | number)[],
+ *     interleave?: boolean | {
+ *         interleave?: boolean,
+ *         packetPool?: number
+ *     }
  * ): @promise@void@
  */
 var ff_write_multi = Module.ff_write_multi = function(oc, pkt, inPackets, interleave) {
+    var opts = {};
+    if (typeof interleave === "object") {
+        opts = interleave;
+        interleave = opts.interleave;
+    }
     var step = av_interleaved_write_frame;
     if (interleave === false) step = av_write_frame;
     var tbs = {};
@@ -927,7 +1749,7 @@ var ff_write_multi = Module.ff_write_multi = function(oc, pkt, inPackets, interl
         var ret = av_packet_make_writable(pkt);
         if (ret < 0)
             throw new Error("Error making packet writable: " + ff_error(ret));
-        ff_copyin_packet(pkt, inPacket);
+        ff_copyin_packet(pkt, inPacket, opts.packetPool);
 
         var sti = inPacket.stream_index || 0;
         var iptbNum, iptbDen;
@@ -970,6 +1792,9 @@ var ff_write_multi = Module.ff_write_multi = function(oc, pkt, inPackets, interl
  * packets], where the result indicates whether an error was encountered, an
  * EOF, or simply limits (EAGAIN), and packets is a dictionary indexed by the
  * stream number in which each element is an array of packets from that stream.
+ * If `opts.packetPool` is set, "ptr" packets are taken from that pool. If
+ * `opts.seekIndex` is set (from `ff_seek_index_alloc`), the keyframes read are
+ * added to that seek index.
  * @param fmt_ctx  AVFormatContext
  * @param pkt  AVPacket
  * @param opts  Other options
@@ -979,6 +1804,7 @@ var ff_write_multi = Module.ff_write_multi = function(oc, pkt, inPackets, interl
  *     fmt_ctx: number, pkt: number, opts?: {
  *         limit?: number, // OUTPUT limit, in bytes
  *         unify?: boolean, // If true, unify the packets into a single stream (called 0), so that the output is in the same order as the input
+ *         seekIndex?: number, // Seek index to add the keyframes read to
  *         copyoutPacket?: "default" // Version of ff_copyout_packet to use
  *     }
  * ): @promsync@[number, Record<number, Packet[]>]@
@@ -986,14 +1812,24 @@ var ff_write_multi = Module.ff_write_multi = function(oc, pkt, inPackets, interl
  *     fmt_ctx: number, pkt: number, opts: {
  *         limit?: number, // OUTPUT limit, in bytes
  *         unify?: boolean, // If true, unify the packets into a single stream (called 0), so that the output is in the same order as the input
- *         copyoutPacket: "ptr" // Version of ff_copyout_packet to use
+ *         seekIndex?: number, // Seek index to add the keyframes read to
+ *         copyoutPacket: "ptr", // Version of ff_copyout_packet to use
+ *         packetPool?: number // Pool to take packets from
  *     }
  * ): @promsync@[number, Record<number, number[]>]@
+ * ff_read_frame_multi@sync(
+ *     fmt_ctx: number, pkt: number, opts: {
+ *         limit?: number, // OUTPUT limit, in bytes
+ *         unify?: boolean, // If true, unify the packets into a single stream (called 0), so that the output is in the same order as the input
+ *         seekIndex?: number, // Seek index to add the keyframes read to
+ *         copyoutPacket: "view" // Version of ff_copyout_packet to use
+ *     }
+ * ): @promsync@[number, Record<number, PacketView[]>]@
  */
 function ff_read_frame_multi(fmt_ctx, pkt, opts) {
-    var sz = 0;
     var outPackets = {};
     var tbs = {};
+    var transfer = [];
 
     if (typeof opts === "number")
         opts = {limit: opts};
@@ -1003,27 +1839,52 @@ function ff_read_frame_multi(fmt_ctx, pkt, opts) {
     var copyoutPacket = ff_copyout_packet;
     if (opts.copyoutPacket)
         copyoutPacket = ff_copyout_packet_versions[opts.copyoutPacket];
+    var ptrOut = (opts.copyoutPacket === "ptr");
+    var outPool = opts.packetPool || (ptrOut ? 0 : ff_internal_packet_pool());
+
+    /* The reading loop is native (ff_read_frame_multi_c), so this is one call
+     * however many packets are read. Its FFMultiOutput isn't a snapshot
+     * buffer, since other calls may run while a reader waits for data. */
+    var out = malloc(12);
+    if (out === 0)
+        throw new Error("Failed to malloc");
+    Module.HEAP32.fill(0, out >> 2, (out >> 2) + 3);
+
+    return ff_read_frame_multi_c(
+        fmt_ctx, pkt, opts.limit || 0, outPool, out, opts.seekIndex || 0
+    ).then(function(ret) {
+        var s = Module.HEAP32;
+        var ob = out >> 2;
+        var ptrs = [];
+        if (s[ob]) {
+            var ib = s[ob] >> 2;
+            ptrs = Array.prototype.slice.call(s.subarray(ib, ib + s[ob + 1]));
+            free(s[ob]);
+            s[ob] = 0;
+        }
 
-    function step() {
-        // Read the frame
-        return av_read_frame(fmt_ctx, pkt).then(function(ret) {
-            if (ret < 0)
-                return [ret, outPackets];
-
-            // And copy it out
-            var packet = copyoutPacket(pkt);
-            var stri = AVPacket_stream_index(pkt);
+        if (ret === -11 /* ECANCELED */ && Module.fsThrownError) {
+            // An error from a reader, passed through
+            ff_multi_packets_free(ptrs, outPool);
+            throw Module.fsThrownError;
+        }
 
-            // Get the time base correct
-            var ptbNum, ptbDen;
-            if (typeof packet === "number") {
-                ptbNum = AVPacket_time_base_num(packet);
-                ptbDen = AVPacket_time_base_den(packet);
+        // Copy them out, in order
+        for (var i = 0; i < ptrs.length; i++) {
+            var packet, stri;
+            if (ptrOut) {
+                packet = ptrs[i];
+                stri = AVPacket_stream_index(packet);
             } else {
-                ptbNum = packet.time_base_num;
-                ptbDen = packet.time_base_den;
+                packet = copyoutPacket(ptrs[i]);
+                stri = packet.stream_index;
+                if (packet.libavjsTransfer && packet.libavjsTransfer.length)
+                    transfer.push.apply(transfer, packet.libavjsTransfer);
             }
-            if (!ptbNum) {
+
+            /* The native driver sets the time base, but older packets don't
+             * have one */
+            if (!ptrOut && !packet.time_base_num) {
                 var tb = tbs[stri];
                 if (!tb) {
                     var str = AVFormatContext_streams_a(fmt_ctx, stri);
@@ -1032,29 +1893,28 @@ function ff_read_frame_multi(fmt_ctx, pkt, opts) {
                         AVStream_time_base_den(str)
                     ];
                 }
-                if (typeof packet === "number") {
-                    AVPacket_time_base_s(packet, tb[0], tb[1]);
-                } else {
-                    packet.time_base_num = tb[0];
-                    packet.time_base_den = tb[1];
-                }
+                packet.time_base_num = tb[0];
+                packet.time_base_den = tb[1];
             }
 
-            // Put it in the output
             var idx = unify ? 0 : stri;
             if (!(idx in outPackets))
                 outPackets[idx] = [];
             outPackets[idx].push(packet);
-            sz += AVPacket_size(pkt);
-            av_packet_unref(pkt);
-            if (opts.limit && sz >= opts.limit)
-                return [-6 /* EAGAIN */, outPackets];
-
-            return Promise.all([]).then(step);
-        });
-    }
-
-    return step();
+        }
+        if (!ptrOut)
+            ff_multi_packets_free(ptrs, outPool);
+
+        var res = [ret, outPackets];
+        res.libavjsTransfer = transfer;
+        return res;
+    }).finally(function() {
+        // Whether or not the driver succeeded
+        var list = Module.HEAP32[out >> 2];
+        if (list)
+            free(list);
+        free(out);
+    });
 }
 Module.ff_read_frame_multi = function() {
     var args = arguments;
@@ -1088,11 +1948,413 @@ Module.ff_read_frame_multi = function() {
  *         limit?: number, // OUTPUT limit, in bytes
  *         devLimit?: number, // INPUT limit, in bytes (don't read if less than this much data is available)
  *         unify?: boolean, // If true, unify the packets into a single stream (called 0), so that the output is in the same order as the input
- *         copyoutPacket: "ptr" // Version of ff_copyout_packet to use
+ *         copyoutPacket: "ptr", // Version of ff_copyout_packet to use
+ *         packetPool?: number // Pool to take packets from
  *     }
  * ): @promsync@[number, Record<number, number[]>]@
+ * ff_read_frame_multi@sync(
+ *     fmt_ctx: number, pkt: number, opts: {
+ *         limit?: number, // OUTPUT limit, in bytes
+ *         unify?: boolean, // If true, unify the packets into a single stream (called 0), so that the output is in the same order as the input
+ *         copyoutPacket: "view" // Version of ff_copyout_packet to use
+ *     }
+ * ): @promsync@[number, Record<number, PacketView[]>]@
  */
 Module.ff_read_multi = function(fmt_ctx, pkt, devfile, opts) {
     console.log("[libav.js] ff_read_multi is deprecated. Use ff_read_frame_multi.");
     return Module.ff_read_frame_multi(fmt_ctx, pkt, opts);
 };
+
+// Magic number and version of exported seek indexes
+var SEEK_INDEX_MAGIC = [0x4c, 0x4a, 0x53, 0x49 /* LJSI */];
+var SEEK_INDEX_VERSION = 1;
+
+/**
+ * Export a seek index as a compact binary blob, to be cached alongside the
+ * media and given to `ff_seek_index_import`. For each stream, the entries are
+ * stored as variable-length differences from the previous entry, so an entry
+ * is typically a few bytes.
+ * @param index  Seek index
+ */
+/// @types ff_seek_index_export@sync(index: number): @promise@Uint8Array@
+var ff_seek_index_export = Module.ff_seek_index_export = function(index) {
+    var out = SEEK_INDEX_MAGIC.concat([SEEK_INDEX_VERSION]);
+
+    // Unsigned and signed (zigzag) variable-length integers, up to 2^53
+    function uvar(x) {
+        while (x >= 0x80) {
+            out.push((x % 0x80) | 0x80);
+            x = Math.floor(x / 0x80);
+        }
+        out.push(x);
+    }
+    function svar(x) {
+        uvar(x < 0 ? -x * 2 - 1 : x * 2);
+    }
+
+    var nbStreams = ff_seek_index_nb_streams(index);
+    uvar(nbStreams);
+    for (var si = 0; si < nbStreams; si++) {
+        var nb = ff_seek_index_nb_entries(index, si);
+        uvar(nb);
+        if (!nb)
+            continue;
+        var prevTs = 0, prevPos = 0;
+        ff_seek_index_read(index, si, nb).forEach(function(e) {
+            svar(e.ts - prevTs);
+            svar(e.pos - prevPos);
+            prevTs = e.ts;
+            prevPos = e.pos;
+        });
+    }
+
+    return new Uint8Array(out);
+};
+
+// Read the nb entries of this stream of a seek index. Used internally.
+function ff_seek_index_read(index, stream_index, nb) {
+    var buf = malloc(nb * 16);
+    if (buf === 0)
+        throw new Error("Failed to malloc");
+    ff_seek_index_get_js(index, stream_index, buf);
+    var s = Module.HEAP32.slice(buf >> 2, (buf >> 2) + nb * 4);
+    free(buf);
+
+    var ret = [];
+    for (var i = 0; i < nb * 4; i += 4) {
+        ret.push({
+            ts: s[i + 1] * 0x100000000 + (s[i] >>> 0),
+            pos: s[i + 3] * 0x100000000 + (s[i + 2] >>> 0)
+        });
+    }
+    return ret;
+}
+
+/**
+ * Get the entries of one stream of a seek index, i.e., the timestamps (in the
+ * stream's time base) and byte positions of its keyframes, in order.
+ * @param index  Seek index
+ * @param stream_index  Stream to get the entries of
+ */
+/* @types
+ * ff_seek_index_entries@sync(
+ *     index: number, stream_index: number
+ * ): @promise@{ts: number, pos: number}[]@
+ */
+var ff_seek_index_entries = Module.ff_seek_index_entries = function(index, stream_index) {
+    var nb = ff_seek_index_nb_entries(index, stream_index);
+    return nb ? ff_seek_index_read(index, stream_index, nb) : [];
+};
+
+/**
+ * Import a seek index exported by `ff_seek_index_export`, giving a new seek
+ * index (to be freed with `ff_seek_index_free`). If a demuxer is given, the
+ * index is also added to libavformat's own index where the format allows it,
+ * so that its own seeks use it.
+ * @param data  Exported seek index
+ * @param fmt_ctx  AVFormatContext (optional)
+ */
+/// @types ff_seek_index_import@sync(data: Uint8Array, fmt_ctx?: number): @promise@number@
+var ff_seek_index_import = Module.ff_seek_index_import = function(data, fmt_ctx) {
+    var p = 0;
+    for (var i = 0; i < SEEK_INDEX_MAGIC.length; i++) {
+        if (data[p++] !== SEEK_INDEX_MAGIC[i])
+            throw new Error("Not a libav.js seek index");
+    }
+    if (data[p++] !== SEEK_INDEX_VERSION)
+        throw new Error("Unsupported seek index version");
+
+    function uvar() {
+        var x = 0, mul = 1, b;
+        do {
+            if (p >= data.length)
+                throw new Error("Truncated seek index");
+            b = data[p++];
+            x += (b & 0x7f) * mul;
+            mul *= 0x80;
+        } while (b & 0x80);
+        return x;
+    }
+    function svar() {
+        var x = uvar();
+        return (x % 2) ? -(x + 1) / 2 : x / 2;
+    }
+
+    var index = ff_seek_index_alloc();
+    if (index === 0)
+        throw new Error("Failed to allocate seek index");
+    try {
+        var nbStreams = uvar();
+        for (var si = 0; si < nbStreams; si++) {
+            var nb = uvar();
+            if (!nb)
+                continue;
+            var entries = new Int32Array(nb * 4);
+            var ts = 0, pos = 0;
+            for (var ei = 0; ei < nb * 4; ei += 4) {
+                ts += svar();
+                pos += svar();
+                entries[ei] = ts % 0x100000000;
+                entries[ei + 1] = Math.floor(ts / 0x100000000);
+                entries[ei + 2] = pos % 0x100000000;
+                entries[ei + 3] = Math.floor(pos / 0x100000000);
+            }
+            var buf = malloc(entries.byteLength);
+            if (buf === 0)
+                throw new Error("Failed to malloc");
+            Module.HEAP32.set(entries, buf >> 2);
+            var ret = ff_seek_index_set_js(index, si, buf, nb);
+            free(buf);
+            if (ret < 0)
+                throw new Error("Failed to import seek index: " + ff_error(ret));
+        }
+    } catch (ex) {
+        ff_seek_index_free(index);
+        throw ex;
+    }
+
+    if (fmt_ctx)
+        ff_seek_index_apply(index, fmt_ctx);
+    return index;
+};
+
+/**
+ * Transcode one segment of one stream of a file, for segmented transcoding
+ * (`pool.transcode` in the frontend). The segment is the frames with
+ * presentation timestamps from `opts.start` (inclusive) to `opts.end`
+ * (exclusive), which should both be keyframes, or from the start or to the end
+ * of the stream if they aren't set. The demuxer is sought to `opts.start` with
+ * `avformat_seek_file_max`, with `opts.seekIndex` (from
+ * `ff_seek_index_export`) added to libavformat's own index where the format
+ * allows. The frames are encoded by a new encoder with closed GOPs, so the
+ * encoded segment can be concatenated with its neighbors. Timestamps are kept,
+ * rescaled to `opts.time_base` if it's set.
+ * Returns the encoded packets, the encoder's codec parameters, and the number
+ * of frames encoded.
+ * @param filename  File to transcode from
+ * @param opts  Segment, decoder and encoder options
+ */
+/* @types
+ * ff_transcode_segment@sync(
+ *     filename: string, opts: {
+ *         format?: string, // Input format
+ *         stream_index: number,
+ *         start?: number, // In the stream's time base
+ *         end?: number,
+ *         seekIndex?: Uint8Array,
+ *         decoder_options?: Record<string, string>,
+ *         codec: string,
+ *         ctx?: AVCodecContextProps,
+ *         time_base?: [number, number],
+ *         options?: Record<string, string>
+ *     }
+ * ): @promise@{packets: Packet[], codecpar: CodecParameters, frames: number}@
+ */
+function ff_transcode_segment(filename, opts) {
+    var si = opts.stream_index;
+    var hasStart = (typeof opts.start === "number");
+    var hasEnd = (typeof opts.end === "number");
+    var fmt_ctx = 0, dec = null, enc = null;
+    var framePool = 0, packetPool = 0;
+    var inTb, outTb;
+    var packets = [], transfer = [];
+    var nbFrames = 0, sawEnd = false, done = false;
+
+    function i64(lo, hi) {
+        if (lo === 0 && hi === -0x80000000 /* AV_NOPTS_VALUE */)
+            return null;
+        return hi * 0x100000000 + (lo >>> 0);
+    }
+
+    function cleanup() {
+        if (enc)
+            ff_free_encoder(enc[1], enc[2], enc[3]);
+        if (dec)
+            ff_free_decoder(dec[1], dec[2], dec[3]);
+        if (framePool)
+            ff_frame_pool_free(framePool);
+        if (packetPool)
+            ff_packet_pool_free(packetPool);
+        if (fmt_ctx)
+            avformat_close_input_js(fmt_ctx);
+    }
+
+    // Sort one read's packets into those to decode and those to drop
+    function sortPackets(all, feed, drop) {
+        for (var idx in all) {
+            if (+idx !== si) {
+                drop.push.apply(drop, all[idx]);
+                continue;
+            }
+            all[idx].forEach(function(p) {
+                if (done) {
+                    drop.push(p);
+                    return;
+                }
+                if (hasEnd) {
+                    var ts = i64(AVPacket_pts(p), AVPacket_ptshi(p));
+                    if (ts === null)
+                        ts = i64(AVPacket_dts(p), AVPacket_dtshi(p));
+                    if (sawEnd && (ts === null || ts >= opts.end)) {
+                        // Past the next keyframe and its leading frames
+                        done = true;
+                        drop.push(p);
+                        return;
+                    }
+                    if (ts !== null && ts >= opts.end &&
+                        (AVPacket_flags(p) & 1 /* AV_PKT_FLAG_KEY */))
+                        sawEnd = true;
+                }
+                feed.push(p);
+            });
+        }
+    }
+
+    // Open the encoder, with the size and format of the first frame
+    function openEncoder(frame) {
+        var ctx = {
+            width: AVFrame_width(frame),
+            height: AVFrame_height(frame),
+            pix_fmt: AVFrame_format(frame)
+        };
+        var options = {};
+        var prop;
+        for (prop in (opts.ctx || {}))
+            ctx[prop] = opts.ctx[prop];
+        for (prop in (opts.options || {}))
+            options[prop] = opts.options[prop];
+        options.flags = (options.flags || "") + "+cgop";
+        /* Not Module.ff_init_encoder, which is wrapped in direct mode, but it
+         * sets its properties through this */
+        enc = ff_init_encoder.call(Module, opts.codec, {
+            ctx: ctx,
+            time_base: outTb,
+            options: options
+        });
+    }
+
+    function step() {
+        return ff_read_frame_multi(fmt_ctx, dec[2], {
+            limit: 1048576,
+            copyoutPacket: "ptr",
+            packetPool: packetPool
+        }).then(function(res) {
+            var eof = (res[0] === -0x20464f45 /* AVERROR_EOF */);
+            if (res[0] < 0 && res[0] !== -ERRNO_CODES.EAGAIN && !eof)
+                throw new Error("Error reading: " + ff_error(res[0]));
+
+            var feed = [], drop = [];
+            sortPackets(res[1], feed, drop);
+            if (drop.length)
+                ff_packet_pool_release_multi(packetPool, drop);
+            var fin = done || eof;
+
+            var frames = ff_decode_multi(dec[1], dec[2], dec[3], feed, {
+                fin: fin,
+                ignoreErrors: true,
+                copyoutFrame: "ptr",
+                framePool: framePool,
+                packetPool: packetPool
+            });
+
+            // Keep only this segment's frames
+            var keep = [], dropFrames = [];
+            frames.forEach(function(f) {
+                var pts = i64(AVFrame_pts(f), AVFrame_ptshi(f));
+                if (pts === null) {
+                    pts = i64(AVFrame_best_effort_timestamp(f),
+                        AVFrame_best_effort_timestamphi(f));
+                }
+                if (pts !== null &&
+                    ((hasStart && pts < opts.start) ||
+                     (hasEnd && pts >= opts.end))) {
+                    dropFrames.push(f);
+                    return;
+                }
+                if (pts !== null && outTb !== inTb) {
+                    pts = Math.round(
+                        pts * inTb[0] * outTb[1] / (inTb[1] * outTb[0]));
+                }
+                if (pts !== null) {
+                    AVFrame_pts_s(f, ~~pts);
+                    AVFrame_ptshi_s(f, Math.floor(pts / 0x100000000));
+                }
+                keep.push(f);
+            });
+            if (dropFrames.length)
+                ff_frame_pool_release_multi(framePool, dropFrames);
+
+            if (keep.length && !enc)
+                openEncoder(keep[0]);
+            if (enc && (keep.length || fin)) {
+                var out = ff_encode_multi(enc[1], enc[2], enc[3], keep, {
+                    fin: fin,
+                    framePool: framePool
+                });
+                nbFrames += keep.length;
+                out.forEach(function(packet) {
+                    packets.push(packet);
+                    transfer.push(packet.data.buffer);
+                });
+            }
+
+            if (!fin)
+                return step();
+            if (!enc)
+                throw new Error("No frames in segment");
+
+            var par = avcodec_parameters_alloc();
+            if (par === 0)
+                throw new Error("Failed to allocate codec parameters");
+            avcodec_parameters_from_context(par, enc[1]);
+            var codecpar = ff_copyout_codecpar(par);
+            avcodec_parameters_free_js(par);
+
+            var ret = {packets: packets, codecpar: codecpar, frames: nbFrames};
+            ret.libavjsTransfer = transfer;
+            return ret;
+        });
+    }
+
+    return ff_init_demuxer_file(filename, opts.format).then(function(ret) {
+        fmt_ctx = ret[0];
+        var stream = ret[1][si];
+        if (!stream)
+            throw new Error("No stream " + si);
+        inTb = [stream.time_base_num, stream.time_base_den];
+        outTb = opts.time_base || inTb;
+        dec = ff_init_decoder(stream.codec_id, {
+            codecpar: stream.codecpar,
+            options: opts.decoder_options
+        });
+        framePool = ff_frame_pool_alloc();
+        packetPool = ff_packet_pool_alloc();
+        if (framePool === 0 || packetPool === 0)
+            throw new Error("Failed to allocate pools");
+
+        if (!hasStart)
+            return 0;
+        if (opts.seekIndex)
+            ff_seek_index_free(ff_seek_index_import(opts.seekIndex, fmt_ctx));
+        return avformat_seek_file_max(fmt_ctx, si,
+            ~~opts.start, Math.floor(opts.start / 0x100000000), 0);
+
+    }).then(function(ret) {
+        if (ret < 0)
+            throw new Error("Error seeking: " + ff_error(ret));
+        return step();
+
+    }).then(function(ret) {
+        cleanup();
+        return ret;
+    }, function(ex) {
+        cleanup();
+        throw ex;
+    });
+}
+Module.ff_transcode_segment = function() {
+    var args = arguments;
+    return serially(function() {
+        return ff_transcode_segment.apply(void 0, args);
+    });
+};
@@ -13,156 +13,245 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+/* Layout of frame snapshot records, in 32-bit words. Must match b-avframe.c.
+ * 64-bit fields take two words, low word first. */
+var FRAME_SNAP = {
+    VERSION: 0,
+    SET: 1,
+    PTS: 2,
+    BEST_EFFORT_TIMESTAMP: 4,
+    DURATION: 6,
+    CHANNEL_LAYOUT: 8,
+    FORMAT: 10,
+    TIME_BASE_NUM: 11,
+    TIME_BASE_DEN: 12,
+    NB_SAMPLES: 13,
+    SAMPLE_RATE: 14,
+    CHANNELS: 15,
+    WIDTH: 16,
+    HEIGHT: 17,
+    CROP_TOP: 18,
+    CROP_BOTTOM: 19,
+    CROP_LEFT: 20,
+    CROP_RIGHT: 21,
+    FLAGS: 22,
+    KEY_FRAME: 23,
+    PICT_TYPE: 24,
+    SAR_NUM: 25,
+    SAR_DEN: 26,
+    LOG2_CHROMA_W: 27,
+    LOG2_CHROMA_H: 28,
+    NB_COMPONENTS: 29,
+    PIXDESC_FLAGS: 30,
+    DATA: 32,
+    LINESIZE: 40,
+    SIZE: 48
+};
+
+// Bits of FRAME_SNAP.SET
+var FRAME_SNAP_SET = {
+    CHANNEL_LAYOUT: 0x0001,
+    CHANNELS: 0x0002,
+    FORMAT: 0x0004,
+    KEY_FRAME: 0x0008,
+    FLAGS: 0x0010,
+    PICT_TYPE: 0x0020,
+    PTS: 0x0040,
+    BEST_EFFORT: 0x0080,
+    TIME_BASE_NUM: 0x0100,
+    TIME_BASE_DEN: 0x0200,
+    NB_SAMPLES: 0x0400,
+    SAMPLE_RATE: 0x0800,
+    WIDTH: 0x1000,
+    HEIGHT: 0x2000,
+    SAR: 0x4000,
+    CROP: 0x8000,
+    DURATION: 0x10000
+};
+
+/* Take a snapshot of this frame. Returns the index of the snapshot record in
+ * Module.HEAP32. Used internally. */
+function ff_frame_snapshot_idx(frame) {
+    var ptr = ff_snapshot_buffer("frame", FRAME_SNAP.SIZE);
+    ff_frame_snapshot(frame, ptr);
+    return ptr >> 2;
+}
+
+// Copiers for each audio sample format, by format number
+var ff_sample_fmt_copyout = [
+    copyout_u8, copyout_s16, copyout_s32, copyout_f32, copyout_f64, // U8 to DBL
+    copyout_u8, copyout_s16, copyout_s32, copyout_f32, copyout_f64, // U8P to DBLP
+    copyout_s64, copyout_s64 // S64, S64P
+];
+var ff_sample_fmt_copyin = [
+    copyin_u8, copyin_s16, copyin_s32, copyin_f32, copyin_f64,
+    copyin_u8, copyin_s16, copyin_s32, copyin_f32, copyin_f64,
+    copyin_s64, copyin_s64
+];
+
+// Is this audio sample format planar? Used internally.
+function ff_sample_fmt_planar(format) {
+    return (format >= 5 /* U8P */ && format <= 9 /* DBLP */) ||
+        format === 11 /* S64P */;
+}
+
 /**
- * Copy out a frame.
+ * Copy out a frame. If `convert` is given, the frame is first converted
+ * natively: audio frames (with libswresample) to that sample format, channel
+ * layout and sample rate, and video frames (with libswscale) to that pixel
+ * format and size, as given; any not given are kept.
  * @param frame  AVFrame
+ * @param convert  Optional format to convert to
  */
-/// @types ff_copyout_frame@sync(frame: number): @promise@Frame@
-var ff_copyout_frame = Module.ff_copyout_frame = function(frame) {
-    var nb_samples = AVFrame_nb_samples(frame);
+/* @types
+ * ff_copyout_frame@sync(
+ *     frame: number, convert?: AudioFormat | VideoFormat
+ * ): @promise@Frame@
+ */
+var ff_copyout_frame = Module.ff_copyout_frame = function(frame, convert) {
+    if (convert)
+        return ff_frame_converted(frame, convert, convert, ff_copyout_frame);
+    var b = ff_frame_snapshot_idx(frame);
+    var s = Module.HEAP32;
+    var nb_samples = s[b + FRAME_SNAP.NB_SAMPLES];
     if (nb_samples === 0) {
         // Maybe a video frame?
-        var width = AVFrame_width(frame);
-        if (width)
-            return ff_copyout_frame_video_width(frame, width);
+        if (s[b + FRAME_SNAP.WIDTH])
+            return ff_copyout_frame_video_snap(b);
     }
-    var channels = AVFrame_channels(frame);
-    var format = AVFrame_format(frame);
+    var channels = s[b + FRAME_SNAP.CHANNELS];
+    var format = s[b + FRAME_SNAP.FORMAT];
     var transfer = [];
-    var outFrame = {
-        data: null,
-        libavjsTransfer: transfer,
-        channel_layout: AVFrame_channel_layout(frame),
-        channels: channels,
-        format: format,
-        nb_samples: nb_samples,
-        pts: AVFrame_pts(frame),
-        ptshi: AVFrame_ptshi(frame),
-        best_effort_timestamp: AVFrame_best_effort_timestamp(frame),
-        best_effort_timestamphi: AVFrame_best_effort_timestamphi(frame),
-        time_base_num: AVFrame_time_base_num(frame),
-        time_base_den: AVFrame_time_base_den(frame),
-        sample_rate: AVFrame_sample_rate(frame)
-    };
+    var outFrame = ff_frame_snapshot_audio_meta(b);
+    outFrame.libavjsTransfer = transfer;
 
-    // FIXME: Need to support *every* format here
-    if (format >= 5 /* U8P */) {
+    var copyout = ff_sample_fmt_copyout[format];
+    if (!copyout)
+        return outFrame;
+    if (ff_sample_fmt_planar(format)) {
         // Planar format, multiple data pointers
         var data = [];
         for (var ci = 0; ci < channels; ci++) {
-            var inData = AVFrame_data_a(frame, ci);
-            var outData = null;
-            switch (format) {
-                case 5: // U8P
-                    outData = copyout_u8(inData, nb_samples);
-                    break;
-
-                case 6: // S16P
-                    outData = copyout_s16(inData, nb_samples);
-                    break;
-
-                case 7: // S32P
-                    outData = copyout_s32(inData, nb_samples);
-                    break;
-
-                case 8: // FLT
-                    outData = copyout_f32(inData, nb_samples);
-                    break;
-            }
-
-            if (outData) {
-                data.push(outData);
-                transfer.push(outData.buffer);
-            }
+            var inData = (ci < 8 /* AV_NUM_DATA_POINTERS */) ?
+                s[b + FRAME_SNAP.DATA + ci] :
+                AVFrame_data_a(frame, ci);
+            var outData = copyout(inData, nb_samples);
+            data.push(outData);
+            transfer.push(outData.buffer);
         }
         outFrame.data = data;
 
     } else {
-        var ct = channels*nb_samples;
-        var inData = AVFrame_data_a(frame, 0);
-        var outData = null;
-        switch (format) {
-            case 0: // U8
-                outData = copyout_u8(inData, ct);
-                break;
-
-            case 1: // S16
-                outData = copyout_s16(inData, ct);
-                break;
-
-            case 2: // S32
-                outData = copyout_s32(inData, ct);
-                break;
-
-            case 3: // FLT
-                outData = copyout_f32(inData, ct);
-                break;
-        }
-
-        if (outData) {
-            outFrame.data = outData;
-            transfer.push(outData.buffer);
-        }
+        var outData = copyout(s[b + FRAME_SNAP.DATA], channels*nb_samples);
+        outFrame.data = outData;
+        transfer.push(outData.buffer);
 
     }
 
     return outFrame;
 };
 
+/* Get the metadata of a copied-out audio frame from a frame snapshot. Used
+ * internally. */
+function ff_frame_snapshot_audio_meta(b) {
+    var s = Module.HEAP32;
+    return {
+        data: null,
+        channel_layout: s[b + FRAME_SNAP.CHANNEL_LAYOUT],
+        channels: s[b + FRAME_SNAP.CHANNELS],
+        format: s[b + FRAME_SNAP.FORMAT],
+        nb_samples: s[b + FRAME_SNAP.NB_SAMPLES],
+        pts: s[b + FRAME_SNAP.PTS],
+        ptshi: s[b + FRAME_SNAP.PTS + 1],
+        best_effort_timestamp: s[b + FRAME_SNAP.BEST_EFFORT_TIMESTAMP],
+        best_effort_timestamphi: s[b + FRAME_SNAP.BEST_EFFORT_TIMESTAMP + 1],
+        time_base_num: s[b + FRAME_SNAP.TIME_BASE_NUM],
+        time_base_den: s[b + FRAME_SNAP.TIME_BASE_DEN],
+        sample_rate: s[b + FRAME_SNAP.SAMPLE_RATE]
+    };
+}
+
 /**
  * Copy out a video frame. `ff_copyout_frame` will copy out a video frame if a
  * video frame is found, but this may be faster if you know it's a video frame.
+ * If `convert` is given, the frame is first converted natively (with
+ * libswscale) to that pixel format and size.
  * @param frame  AVFrame
+ * @param convert  Optional format to convert to
  */
-/// @types ff_copyout_frame_video@sync(frame: number): @promise@Frame@
-var ff_copyout_frame_video = Module.ff_copyout_frame_video = function(frame) {
-    return ff_copyout_frame_video_width(frame, AVFrame_width(frame));
+/* @types
+ * ff_copyout_frame_video@sync(
+ *     frame: number, convert?: VideoFormat
+ * ): @promise@Frame@
+ */
+var ff_copyout_frame_video = Module.ff_copyout_frame_video = function(frame, convert) {
+    if (convert)
+        return ff_frame_converted(frame, null, convert, ff_copyout_frame_video);
+    return ff_copyout_frame_video_snap(ff_frame_snapshot_idx(frame));
 };
 
-// Copy out a video frame. Used internally by ff_copyout_frame.
-var ff_copyout_frame_video_width = Module.ff_copyout_frame_video = function(frame, width) {
-    var height = AVFrame_height(frame);
-    var format = AVFrame_format(frame);
-    var desc = av_pix_fmt_desc_get(format);
-    var log2ch = AVPixFmtDescriptor_log2_chroma_h(desc);
-    var layout = [];
-    var transfer = [];
-    var outFrame = {
+/* Get the metadata common to all copied-out video frames from a frame
+ * snapshot. Used internally. */
+function ff_frame_snapshot_video_meta(b) {
+    var s = Module.HEAP32;
+    return {
         data: null,
-        layout: layout,
-        libavjsTransfer: transfer,
-        width: width,
-        height: height,
-        crop: {
-            top: AVFrame_crop_top(frame),
-            bottom: AVFrame_crop_bottom(frame),
-            left: AVFrame_crop_left(frame),
-            right: AVFrame_crop_right(frame)
-        },
-        format: AVFrame_format(frame),
-        flags: AVFrame_flags(frame),
-        key_frame: AVFrame_key_frame(frame),
-        pict_type: AVFrame_pict_type(frame),
-        pts: AVFrame_pts(frame),
-        ptshi: AVFrame_ptshi(frame),
-        best_effort_timestamp: AVFrame_best_effort_timestamp(frame),
-        best_effort_timestamphi: AVFrame_best_effort_timestamphi(frame),
-        time_base_num: AVFrame_time_base_num(frame),
-        time_base_den: AVFrame_time_base_den(frame),
+        width: s[b + FRAME_SNAP.WIDTH],
+        height: s[b + FRAME_SNAP.HEIGHT],
+        format: s[b + FRAME_SNAP.FORMAT],
+        flags: s[b + FRAME_SNAP.FLAGS],
+        key_frame: s[b + FRAME_SNAP.KEY_FRAME],
+        pict_type: s[b + FRAME_SNAP.PICT_TYPE],
+        pts: s[b + FRAME_SNAP.PTS],
+        ptshi: s[b + FRAME_SNAP.PTS + 1],
+        best_effort_timestamp: s[b + FRAME_SNAP.BEST_EFFORT_TIMESTAMP],
+        best_effort_timestamphi: s[b + FRAME_SNAP.BEST_EFFORT_TIMESTAMP + 1],
+        time_base_num: s[b + FRAME_SNAP.TIME_BASE_NUM],
+        time_base_den: s[b + FRAME_SNAP.TIME_BASE_DEN],
         sample_aspect_ratio: [
-            AVFrame_sample_aspect_ratio_num(frame),
-            AVFrame_sample_aspect_ratio_den(frame)
+            s[b + FRAME_SNAP.SAR_NUM],
+            s[b + FRAME_SNAP.SAR_DEN]
         ]
     };
+}
+
+// Copy out a video frame from its snapshot. Used internally by ff_copyout_frame.
+function ff_copyout_frame_video_snap(b) {
+    var outFrame = ff_frame_snapshot_video_meta(b);
+    var range = ff_frame_snapshot_video_range(b, outFrame);
+    var transfer = [];
+
+    // Copy out that segment of data
+    outFrame.data = Module.HEAPU8.slice(range[0], range[1]);
+    transfer.push(outFrame.data.buffer);
+    outFrame.libavjsTransfer = transfer;
+
+    return outFrame;
+}
+
+/* Figure out the range of the heap that a video frame's data occupies, from
+ * its snapshot, and describe its layout and cropping in outFrame. Returns the
+ * range as [low, high]. Used internally. */
+function ff_frame_snapshot_video_range(b, outFrame) {
+    var s = Module.HEAP32;
+    var height = s[b + FRAME_SNAP.HEIGHT];
+    var log2ch = s[b + FRAME_SNAP.LOG2_CHROMA_H];
+    var layout = outFrame.layout = [];
+    outFrame.crop = {
+        top: s[b + FRAME_SNAP.CROP_TOP],
+        bottom: s[b + FRAME_SNAP.CROP_BOTTOM],
+        left: s[b + FRAME_SNAP.CROP_LEFT],
+        right: s[b + FRAME_SNAP.CROP_RIGHT]
+    };
 
     // Figure out the data range
     var dataLo = 1/0;
     var dataHi = 0;
     for (var p = 0; p < 8 /* AV_NUM_DATA_POINTERS */; p++) {
-        var linesize = AVFrame_linesize_a(frame, p);
+        var linesize = s[b + FRAME_SNAP.LINESIZE + p];
         if (!linesize)
             break;
-        var plane = AVFrame_data_a(frame, p);
+        var plane = s[b + FRAME_SNAP.DATA + p];
         if (plane < dataLo)
             dataLo = plane;
         var h = height;
@@ -173,24 +262,19 @@ var ff_copyout_frame_video_width = Module.ff_copyout_frame_video = function(fram
             dataHi = plane;
     }
 
-    // Copy out that segment of data
-    outFrame.data = Module.HEAPU8.slice(dataLo, dataHi);
-    transfer.push(outFrame.data.buffer);
-
     // And describe the layout
     for (var p = 0; p < 8; p++) {
-        var linesize = AVFrame_linesize_a(frame, p);
+        var linesize = s[b + FRAME_SNAP.LINESIZE + p];
         if (!linesize)
             break;
-        var plane = AVFrame_data_a(frame, p);
         layout.push({
-            offset: plane - dataLo,
+            offset: s[b + FRAME_SNAP.DATA + p] - dataLo,
             stride: linesize
         });
     }
 
-    return outFrame;
-};
+    return [dataLo, dataHi];
+}
 
 /**
  * Get the size of a packed video frame in its native format.
@@ -198,64 +282,71 @@ var ff_copyout_frame_video_width = Module.ff_copyout_frame_video = function(fram
  */
 /// @types ff_frame_video_packed_size@sync(frame: number): @promise@Frame@
 var ff_frame_video_packed_size = Module.ff_frame_video_packed_size = function(frame) {
-    // FIXME: duplication
-    var width = AVFrame_width(frame);
-    var height = AVFrame_height(frame);
-    var format = AVFrame_format(frame);
-    var desc = av_pix_fmt_desc_get(format);
+    return ff_frame_video_packed_size_snap(ff_frame_snapshot_idx(frame));
+};
+
+// Get the packed size of a frame from its snapshot. Used internally.
+function ff_frame_video_packed_size_snap(b) {
+    var s = Module.HEAP32;
+    var width = s[b + FRAME_SNAP.WIDTH];
+    var height = s[b + FRAME_SNAP.HEIGHT];
 
     // VERY simple bpp, assuming all components are 8-bit
     var bpp = 1;
-    if (!(AVPixFmtDescriptor_flags(desc) & 0x10) /* planar */)
-        bpp *= AVPixFmtDescriptor_nb_components(desc);
+    if (!(s[b + FRAME_SNAP.PIXDESC_FLAGS] & 0x10) /* planar */)
+        bpp *= s[b + FRAME_SNAP.NB_COMPONENTS];
 
     var dataSz = 0;
     for (var i = 0; i < 8 /* AV_NUM_DATA_POINTERS */; i++) {
-        var linesize = AVFrame_linesize_a(frame, i);
-        if (!linesize)
+        if (!s[b + FRAME_SNAP.LINESIZE + i])
             break;
         var w = width * bpp;
         var h = height;
         if (i === 1 || i === 2) {
-            w >>= AVPixFmtDescriptor_log2_chroma_w(desc);
-            h >>= AVPixFmtDescriptor_log2_chroma_h(desc);
+            w >>= s[b + FRAME_SNAP.LOG2_CHROMA_W];
+            h >>= s[b + FRAME_SNAP.LOG2_CHROMA_H];
         }
         dataSz += w * h;
     }
 
     return dataSz;
-};
+}
 
-/* Copy out just the packed data from this frame, into the given buffer. Used
- * internally. */
-function ff_copyout_frame_data_packed(data, layout, frame) {
-    var width = AVFrame_width(frame);
-    var height = AVFrame_height(frame);
-    var format = AVFrame_format(frame);
-    var desc = av_pix_fmt_desc_get(format);
+/* Copy out just the packed data from this frame snapshot, into the given
+ * buffer. Used internally. */
+function ff_copyout_frame_data_packed(data, layout, b) {
+    var s = Module.HEAP32;
+    var width = s[b + FRAME_SNAP.WIDTH];
+    var height = s[b + FRAME_SNAP.HEIGHT];
 
     // VERY simple bpp, assuming all components are 8-bit
     var bpp = 1;
-    if (!(AVPixFmtDescriptor_flags(desc) & 0x10) /* planar */)
-        bpp *= AVPixFmtDescriptor_nb_components(desc);
+    if (!(s[b + FRAME_SNAP.PIXDESC_FLAGS] & 0x10) /* planar */)
+        bpp *= s[b + FRAME_SNAP.NB_COMPONENTS];
 
     // Copy it out
     var dIdx = 0;
     for (var i = 0; i < 8 /* AV_NUM_DATA_POINTERS */; i++) {
-        var linesize = AVFrame_linesize_a(frame, i);
+        var linesize = s[b + FRAME_SNAP.LINESIZE + i];
         if (!linesize)
             break;
-        var inData = AVFrame_data_a(frame, i);
+        var inData = s[b + FRAME_SNAP.DATA + i];
         var w = width * bpp;
         var h = height;
         if (i === 1 || i === 2) {
-            w >>= AVPixFmtDescriptor_log2_chroma_w(desc);
-            h >>= AVPixFmtDescriptor_log2_chroma_h(desc);
+            w >>= s[b + FRAME_SNAP.LOG2_CHROMA_W];
+            h >>= s[b + FRAME_SNAP.LOG2_CHROMA_H];
         }
         layout.push({
             offset: dIdx,
             stride: w
         });
+        if (linesize === w) {
+            // Already packed, so copy the whole plane at once
+            data.set(Module.HEAPU8.subarray(inData, inData + w * h), dIdx);
+            dIdx += w * h;
+            continue;
+        }
         for (var y = 0; y < h; y++) {
             var line = inData + y * linesize;
             data.set(
@@ -268,56 +359,65 @@ function ff_copyout_frame_data_packed(data, layout, frame) {
 };
 
 /**
- * Copy out a video frame, as a single packed Uint8Array.
+ * Copy out a video frame, as a single packed Uint8Array. If `convert` is
+ * given, the frame is first converted natively (with libswscale) to that pixel
+ * format and size.
  * @param frame  AVFrame
+ * @param convert  Optional format to convert to
  */
-/// @types ff_copyout_frame_video_packed@sync(frame: number): @promise@Frame@
-var ff_copyout_frame_video_packed = Module.ff_copyout_frame_video_packed = function(frame) {
-    var data = new Uint8Array(ff_frame_video_packed_size(frame));
+/* @types
+ * ff_copyout_frame_video_packed@sync(
+ *     frame: number, convert?: VideoFormat
+ * ): @promise@Frame@
+ */
+var ff_copyout_frame_video_packed = Module.ff_copyout_frame_video_packed = function(frame, convert) {
+    if (convert) {
+        return ff_frame_converted(
+            frame, null, convert, ff_copyout_frame_video_packed);
+    }
+    var b = ff_frame_snapshot_idx(frame);
+    var data = new Uint8Array(ff_frame_video_packed_size_snap(b));
     var layout = [];
-    ff_copyout_frame_data_packed(data, layout, frame);
-
-    var outFrame = {
-        data: data,
-        libavjsTransfer: [data.buffer],
-        width: AVFrame_width(frame),
-        height: AVFrame_height(frame),
-        format: AVFrame_format(frame),
-        flags: AVFrame_flags(frame),
-        key_frame: AVFrame_key_frame(frame),
-        pict_type: AVFrame_pict_type(frame),
-        pts: AVFrame_pts(frame),
-        ptshi: AVFrame_ptshi(frame),
-        best_effort_timestamp: AVFrame_best_effort_timestamp(frame),
-        best_effort_timestamphi: AVFrame_best_effort_timestamphi(frame),
-        time_base_num: AVFrame_time_base_num(frame),
-        time_base_den: AVFrame_time_base_den(frame),
-        sample_aspect_ratio: [
-            AVFrame_sample_aspect_ratio_num(frame),
-            AVFrame_sample_aspect_ratio_den(frame)
-        ]
-    };
+    ff_copyout_frame_data_packed(data, layout, b);
 
+    var outFrame = ff_frame_snapshot_video_meta(b);
+    outFrame.data = data;
+    outFrame.libavjsTransfer = [data.buffer];
     return outFrame;
 };
 
 /**
- * Copy out a video frame as an ImageData. The video frame *must* be RGBA for
- * this to work as expected (though some ImageData will be returned for any
- * frame).
+ * Copy out a video frame as an ImageData. If libswscale is available, frames
+ * that aren't RGBA are converted to RGBA natively, and if `convert` is given,
+ * the frame is scaled to that size (its format is ignored, as an ImageData is
+ * always RGBA). Without libswscale, the video frame *must* be RGBA for this to
+ * work as expected (though some ImageData will be returned for any frame).
  * @param frame  AVFrame
+ * @param convert  Optional size to scale to
  */
 /* @types
  * ff_copyout_frame_video_imagedata@sync(
- *     frame: number
+ *     frame: number, convert?: VideoFormat
  * ): @promise@ImageData@
  */
-var ff_copyout_frame_video_imagedata = Module.ff_copyout_frame_video_imagedata = function(frame) {
-    var width = AVFrame_width(frame);
-    var height = AVFrame_height(frame);
-    var id = new ImageData(width, height);
+var ff_copyout_frame_video_imagedata = Module.ff_copyout_frame_video_imagedata = function(frame, convert) {
+    var b = ff_frame_snapshot_idx(frame);
+    if (typeof ff_frame_video_convert !== "undefined" &&
+        (convert || Module.HEAP32[b + FRAME_SNAP.FORMAT] !== 26 /* RGBA */)) {
+        var rgba = {format: 26 /* RGBA */};
+        if (convert) {
+            rgba.width = convert.width;
+            rgba.height = convert.height;
+        }
+        return ff_frame_converted(
+            frame, null, rgba, ff_copyout_frame_video_imagedata);
+    }
+    var id = new ImageData(
+        Module.HEAP32[b + FRAME_SNAP.WIDTH],
+        Module.HEAP32[b + FRAME_SNAP.HEIGHT]
+    );
     var layout = [];
-    ff_copyout_frame_data_packed(id.data, layout, frame);
+    ff_copyout_frame_data_packed(id.data, layout, b);
     id.libavjsTransfer = [id.data.buffer];
     return id;
 };
@@ -325,43 +425,314 @@ var ff_copyout_frame_video_imagedata = Module.ff_copyout_frame_video_imagedata =
 /**
  * Copy "out" a video frame by just allocating another frame in libav.
  * @param frame  AVFrame
+ * @param pool  Optional frame pool to take the new frame from
  */
-var ff_copyout_frame_ptr = Module.ff_copyout_frame_ptr = function(frame) {
-    var ret = av_frame_clone(frame);
+/// @types ff_copyout_frame_ptr@sync(frame: number, pool?: number): @promise@number@
+var ff_copyout_frame_ptr = Module.ff_copyout_frame_ptr = function(frame, pool) {
+    var ret = pool ? ff_frame_pool_clone(pool, frame) : av_frame_clone(frame);
     if (!ret)
         throw new Error("Failed to allocate new frame");
     return ret;
 };
 
+/* Convert an audio frame natively (with libswresample) into out, which is
+ * unreferenced first. Used internally. */
+function ff_frame_audio_convert_js(out, frame, convert) {
+    if (typeof ff_frame_audio_convert === "undefined")
+        throw new Error("Converting audio requires libswresample");
+    if (convert.sample_rate &&
+        convert.sample_rate !== AVFrame_sample_rate(frame)) {
+        throw new Error("Frames can't be resampled one at a time; " +
+            "use a resampler (ff_init_resampler)");
+    }
+    var ret = ff_frame_audio_convert(
+        out, frame,
+        (typeof convert.format === "number") ? convert.format : -1,
+        convert.channel_layout || 0, convert.channel_layouthi || 0,
+        convert.sample_rate || 0
+    );
+    if (ret < 0)
+        throw new Error("Failed to convert audio: " + ff_error(ret));
+}
+
+/* Convert a video frame natively (with libswscale) into out, which is
+ * unreferenced first. Used internally. */
+function ff_frame_video_convert_js(out, frame, convert) {
+    if (typeof ff_frame_video_convert === "undefined")
+        throw new Error("Converting video requires libswscale");
+    var ret = ff_frame_video_convert(
+        out, frame,
+        (typeof convert.format === "number") ? convert.format : -1,
+        convert.width || 0, convert.height || 0
+    );
+    if (ret < 0)
+        throw new Error("Failed to convert video: " + ff_error(ret));
+}
+
+/* Copy out a frame with copyout, first converting it to audio if it's an audio
+ * frame, or to video if it's a video frame. Either may be null, to leave that
+ * kind of frame as it is. Used internally. */
+function ff_frame_converted(frame, audio, video, copyout) {
+    var isAudio = !!AVFrame_nb_samples(frame);
+    var convert = isAudio ? audio : video;
+    if (!convert)
+        return copyout(frame);
+    var pool = ff_internal_frame_pool();
+    var tmp = ff_frame_pool_acquire(pool);
+    if (!tmp)
+        throw new Error("Failed to allocate frame");
+    try {
+        if (isAudio)
+            ff_frame_audio_convert_js(tmp, frame, convert);
+        else
+            ff_frame_video_convert_js(tmp, frame, convert);
+        return copyout(tmp);
+    } finally {
+        ff_frame_pool_release(pool, tmp);
+    }
+}
+
+/* Get the frame copier for the copyoutFrame option of the multi
+ * metafunctions, converting audio and video frames first if audio or video is
+ * given. Used internally. */
+function ff_copyout_frame_converting(copyoutFrame, audio, video) {
+    var copyout = ff_copyout_frame_versions[copyoutFrame || "default"];
+    if (copyoutFrame === "ImageData") {
+        // Always RGBA, so only the size is used
+        if (!video)
+            return copyout;
+        return function(frame) {
+            return ff_copyout_frame_video_imagedata(frame, video);
+        };
+    }
+    if (!audio && !video)
+        return copyout;
+    return function(frame) {
+        return ff_frame_converted(frame, audio, video, copyout);
+    };
+}
+
+/* Convert the frames among these AVFrame pointers in place, to audio if
+ * they're audio frames, or to video if they're video frames. Used internally
+ * by the multi metafunctions. */
+function ff_multi_frames_convert(ptrs, audio, video) {
+    var pool = ff_internal_frame_pool();
+    for (var i = 0; i < ptrs.length; i++) {
+        var isAudio = !!AVFrame_nb_samples(ptrs[i]);
+        var convert = isAudio ? audio : video;
+        if (!convert)
+            continue;
+        var tmp = ff_frame_pool_acquire(pool);
+        if (!tmp)
+            throw new Error("Failed to allocate frame");
+        try {
+            if (isAudio)
+                ff_frame_audio_convert_js(tmp, ptrs[i], convert);
+            else
+                ff_frame_video_convert_js(tmp, ptrs[i], convert);
+        } catch (ex) {
+            ff_frame_pool_release(pool, tmp);
+            throw ex;
+        }
+        // Moves tmp into ptrs[i] and releases it
+        ff_copyin_frame(ptrs[i], tmp, pool);
+    }
+}
+
+// Typed array types for the audio sample formats, by format number
+var ff_sample_fmt_arrays = (function() {
+    var s64 = (typeof BigInt64Array !== "undefined") ? BigInt64Array : null;
+    return [
+        Uint8Array, Int16Array, Int32Array, Float32Array, Float64Array, // U8 to DBL
+        Uint8Array, Int16Array, Int32Array, Float32Array, Float64Array, // U8P to DBLP
+        s64, s64 // S64, S64P
+    ];
+})();
+
+/**
+ * Copy "out" a frame as views into libav's heap, without copying its data. The
+ * frame is referenced (not copied) into a new AVFrame, which is available as
+ * the view's `ptr`, and stays referenced until `release` is called. `data` may
+ * be reread at any time before release, and will be correct even if the heap
+ * has been resized. Only available when libav.js is running in the caller's
+ * thread.
+ * @param frame  AVFrame
+ */
+/// @types ff_copyout_frame_view@sync(frame: number): @promise@FrameView@
+var ff_copyout_frame_view = Module.ff_copyout_frame_view = function(frame) {
+    ff_check_heap_view();
+    var ptr = av_frame_clone(frame);
+    if (!ptr)
+        throw new Error("Failed to allocate new frame");
+    var b = ff_frame_snapshot_idx(ptr);
+    var s = Module.HEAP32;
+    var outFrame, ranges = [], planar = false;
+
+    if (s[b + FRAME_SNAP.NB_SAMPLES] === 0 && s[b + FRAME_SNAP.WIDTH]) {
+        // Video
+        outFrame = ff_frame_snapshot_video_meta(b);
+        var range = ff_frame_snapshot_video_range(b, outFrame);
+        ranges.push([range[0], range[1] - range[0], Uint8Array]);
+
+    } else {
+        // Audio
+        outFrame = ff_frame_snapshot_audio_meta(b);
+        var format = outFrame.format;
+        var Arr = ff_sample_fmt_arrays[format];
+        if (Arr) {
+            if (ff_sample_fmt_planar(format)) {
+                planar = true;
+                for (var ci = 0; ci < outFrame.channels && ci < 8; ci++) {
+                    ranges.push([
+                        s[b + FRAME_SNAP.DATA + ci], outFrame.nb_samples, Arr
+                    ]);
+                }
+            } else {
+                ranges.push([
+                    s[b + FRAME_SNAP.DATA],
+                    outFrame.channels * outFrame.nb_samples, Arr
+                ]);
+            }
+        }
+
+    }
+
+    outFrame.ptr = ptr;
+    delete outFrame.data;
+    return ff_heap_view(outFrame, ranges, planar, function() {
+        av_frame_free_js(ptr);
+    });
+};
+
 // All of the versions of ff_copyout_frame
 var ff_copyout_frame_versions = {
     default: ff_copyout_frame,
     video: ff_copyout_frame_video,
     video_packed: ff_copyout_frame_video_packed,
     ImageData: ff_copyout_frame_video_imagedata,
-    ptr: ff_copyout_frame_ptr
+    ptr: ff_copyout_frame_ptr,
+    view: ff_copyout_frame_view
 };
 
+/* Fill in the settable fields of a frame snapshot from a Frame, and apply them
+ * to framePtr. nb_samples is only given for audio frames. Used internally by
+ * ff_copyin_frame. */
+function ff_frame_snapshot_copyin(framePtr, frame, nb_samples) {
+    var ptr = ff_snapshot_buffer("frame", FRAME_SNAP.SIZE);
+    var s = Module.HEAP32;
+    var b = ptr >> 2;
+    var set = 0;
+
+    function i32(key, slot, bit) {
+        if (key in frame) {
+            s[b + slot] = frame[key];
+            set |= bit;
+        }
+    }
+
+    function i64(key, slot, bit) {
+        if (key in frame) {
+            s[b + slot] = frame[key];
+            s[b + slot + 1] = frame[key + "hi"] || 0;
+            set |= bit;
+        }
+    }
+
+    if (typeof nb_samples !== "number") {
+        i32("height", FRAME_SNAP.HEIGHT, FRAME_SNAP_SET.HEIGHT);
+        i32("width", FRAME_SNAP.WIDTH, FRAME_SNAP_SET.WIDTH);
+        i32("key_frame", FRAME_SNAP.KEY_FRAME, FRAME_SNAP_SET.KEY_FRAME);
+        i32("flags", FRAME_SNAP.FLAGS, FRAME_SNAP_SET.FLAGS);
+        i32("pict_type", FRAME_SNAP.PICT_TYPE, FRAME_SNAP_SET.PICT_TYPE);
+        if ("sample_aspect_ratio" in frame) {
+            s[b + FRAME_SNAP.SAR_NUM] = frame.sample_aspect_ratio[0];
+            s[b + FRAME_SNAP.SAR_DEN] = frame.sample_aspect_ratio[1];
+            set |= FRAME_SNAP_SET.SAR;
+        }
+        var crop = frame.crop || {top: 0, bottom: 0, left: 0, right: 0};
+        s[b + FRAME_SNAP.CROP_TOP] = crop.top;
+        s[b + FRAME_SNAP.CROP_BOTTOM] = crop.bottom;
+        s[b + FRAME_SNAP.CROP_LEFT] = crop.left;
+        s[b + FRAME_SNAP.CROP_RIGHT] = crop.right;
+        set |= FRAME_SNAP_SET.CROP;
+
+    } else {
+        i64("channel_layout", FRAME_SNAP.CHANNEL_LAYOUT,
+            FRAME_SNAP_SET.CHANNEL_LAYOUT);
+        i32("channels", FRAME_SNAP.CHANNELS, FRAME_SNAP_SET.CHANNELS);
+        i32("sample_rate", FRAME_SNAP.SAMPLE_RATE, FRAME_SNAP_SET.SAMPLE_RATE);
+        s[b + FRAME_SNAP.NB_SAMPLES] = nb_samples;
+        set |= FRAME_SNAP_SET.NB_SAMPLES;
+
+    }
+
+    i32("format", FRAME_SNAP.FORMAT, FRAME_SNAP_SET.FORMAT);
+    i64("pts", FRAME_SNAP.PTS, FRAME_SNAP_SET.PTS);
+    i64("best_effort_timestamp", FRAME_SNAP.BEST_EFFORT_TIMESTAMP,
+        FRAME_SNAP_SET.BEST_EFFORT);
+    i32("time_base_num", FRAME_SNAP.TIME_BASE_NUM,
+        FRAME_SNAP_SET.TIME_BASE_NUM);
+    i32("time_base_den", FRAME_SNAP.TIME_BASE_DEN,
+        FRAME_SNAP_SET.TIME_BASE_DEN);
+
+    s[b + FRAME_SNAP.SET] = set;
+    ff_frame_snapshot_apply(framePtr, ptr);
+}
+
 /**
- * Copy in a frame.
+ * Copy in a frame. If a frame pool is given, AVFrame pointers are released to
+ * it rather than freed, and new data buffers are taken from it. If `convert`
+ * is given, an audio Frame is converted natively (with libswresample) to that
+ * sample format, channel layout and sample rate as it's copied in.
  * @param framePtr  AVFrame
- * @param frame  Frame to copy in, as either a Frame or an AVFrame pointer
+ * @param frame  Frame to copy in, as a Frame, a FrameView or an AVFrame pointer
+ * @param pool  Optional frame pool
+ * @param convert  Optional format to convert audio to
  */
-/// @types ff_copyin_frame@sync(framePtr: number, frame: Frame | number): @promise@void@
-var ff_copyin_frame = Module.ff_copyin_frame = function(framePtr, frame) {
+/// @types ff_copyin_frame@sync(framePtr: number, frame: Frame | FrameView | number, pool?: number, convert?: AudioFormat): @promise@void@
+var ff_copyin_frame = Module.ff_copyin_frame = function(framePtr, frame, pool, convert) {
+    if (convert && typeof frame === "object" && typeof frame.ptr !== "number" &&
+        !frame.width) {
+        // Copy it in as it is, then convert it
+        var tmpPool = pool || ff_internal_frame_pool();
+        var tmp = ff_frame_pool_acquire(tmpPool);
+        if (!tmp)
+            throw new Error("Failed to allocate frame");
+        try {
+            ff_copyin_frame(tmp, frame, tmpPool);
+            ff_frame_audio_convert_js(framePtr, tmp, convert);
+        } finally {
+            ff_frame_pool_release(tmpPool, tmp);
+        }
+        return;
+    }
+
     if (typeof frame === "number") {
         // This is a frame pointer, not a libav.js Frame
         av_frame_unref(framePtr);
         var ret = av_frame_ref(framePtr, frame);
         if (ret < 0)
             throw new Error("Failed to reference frame data: " + ff_error(ret));
-        av_frame_unref(frame);
-        av_frame_free_js(frame);
+        if (pool) {
+            ff_frame_pool_release(pool, frame);
+        } else {
+            av_frame_unref(frame);
+            av_frame_free_js(frame);
+        }
+        return;
+    }
+
+    if (typeof frame.ptr === "number") {
+        // This is a frame view, so reference its frame but leave it be
+        av_frame_unref(framePtr);
+        var ret = av_frame_ref(framePtr, frame.ptr);
+        if (ret < 0)
+            throw new Error("Failed to reference frame data: " + ff_error(ret));
         return;
     }
 
     if (frame.width)
-        return ff_copyin_frame_video(framePtr, frame);
+        return ff_copyin_frame_video(framePtr, frame, pool);
 
     var format = frame.format;
     var channels = frame.channels;
@@ -375,17 +746,9 @@ var ff_copyin_frame = Module.ff_copyin_frame = function(framePtr, frame) {
         }
     }
 
-    [
-        "channel_layout", "channels", "format", "pts", "ptshi", "sample_rate",
-        "best_effort_timestamp", "best_effort_timestamphi",
-        "time_base_num", "time_base_den"
-    ].forEach(function(key) {
-        if (key in frame)
-            CAccessors["AVFrame_" + key + "_s"](framePtr, frame[key]);
-    });
-
+    var planar = ff_sample_fmt_planar(format);
     var nb_samples;
-    if (format >= 5 /* U8P */) {
+    if (planar) {
         // Planar, so nb_samples is out of data[0]
         nb_samples = frame.data[0].length;
     } else {
@@ -393,97 +756,54 @@ var ff_copyin_frame = Module.ff_copyin_frame = function(framePtr, frame) {
         nb_samples = frame.data.length / channels;
     }
 
-    AVFrame_nb_samples_s(framePtr, nb_samples);
+    ff_frame_snapshot_copyin(framePtr, frame, nb_samples);
+    ff_frame_get_buffer(framePtr, pool);
 
-    // We may or may not need to actually allocate
-    if (av_frame_make_writable(framePtr) < 0) {
-        var ret = av_frame_get_buffer(framePtr, 0);
-        if (ret < 0)
-            throw new Error("Failed to allocate frame buffers: " + ff_error(ret));
-    }
+    // Get the (possibly new) data pointers
+    var b = ff_frame_snapshot_idx(framePtr);
+    var s = Module.HEAP32;
+    var copyin = ff_sample_fmt_copyin[format];
+    if (!copyin)
+        return;
 
-    if (format >= 5 /* U8P */) {
+    if (planar) {
         // A planar format
         for (var ci = 0; ci < channels; ci++) {
-            var data = AVFrame_data_a(framePtr, ci);
-            var inData = frame.data[ci];
-            switch (format) {
-                case 5: // U8P
-                    copyin_u8(data, inData);
-                    break;
-
-                case 6: // S16P
-                    copyin_s16(data, inData);
-                    break;
-
-                case 7: // S32P
-                    copyin_s32(data, inData);
-                    break;
-
-                case 8: // FLT
-                    copyin_f32(data, inData);
-                    break;
-            }
+            var data = (ci < 8 /* AV_NUM_DATA_POINTERS */) ?
+                s[b + FRAME_SNAP.DATA + ci] :
+                AVFrame_data_a(framePtr, ci);
+            copyin(data, frame.data[ci]);
         }
 
     } else {
-        var data = AVFrame_data_a(framePtr, 0);
-        var inData = frame.data;
-
-        // FIXME: Need to support *every* format here
-        switch (format) {
-            case 0: // U8
-                copyin_u8(data, inData);
-                break;
-
-            case 1: // S16
-                copyin_s16(data, inData);
-                break;
-
-            case 2: // S32
-                copyin_s32(data, inData);
-                break;
-
-            case 3: // FLT
-                copyin_f32(data, inData);
-                break;
-        }
+        copyin(s[b + FRAME_SNAP.DATA], frame.data);
 
     }
 };
 
-// Copy in a video frame. Used internally by ff_copyin_frame.
-var ff_copyin_frame_video = Module.ff_copyin_frame_video = function(framePtr, frame) {
-    [
-        "format", "height", "key_frame", "flags", "pict_type", "pts", "ptshi", "width",
-        "best_effort_timestamp", "best_effort_timestamphi",
-        "time_base_num", "time_base_den"
-    ].forEach(function(key) {
-        if (key in frame)
-            CAccessors["AVFrame_" + key + "_s"](framePtr, frame[key]);
-    });
-
-    if ("sample_aspect_ratio" in frame) {
-        AVFrame_sample_aspect_ratio_s(framePtr, frame.sample_aspect_ratio[0],
-            frame.sample_aspect_ratio[1]);
-    }
-
-    var crop = frame.crop || {top: 0, bottom: 0, left: 0, right: 0};
-    AVFrame_crop_top_s(framePtr, crop.top);
-    AVFrame_crop_bottom_s(framePtr, crop.bottom);
-    AVFrame_crop_left_s(framePtr, crop.left);
-    AVFrame_crop_right_s(framePtr, crop.right);
-
-    var desc = av_pix_fmt_desc_get(frame.format);
-    var log2cw = AVPixFmtDescriptor_log2_chroma_w(desc);
-    var log2ch = AVPixFmtDescriptor_log2_chroma_h(desc);
-
+/* Make sure a frame being copied in has writable buffers, allocating them
+ * (from the pool, if given) if needed. Used internally. */
+function ff_frame_get_buffer(framePtr, pool) {
     // We may or may not need to actually allocate
     if (av_frame_make_writable(framePtr) < 0) {
-        var ret = av_frame_get_buffer(framePtr, 0);
+        var ret = pool ?
+            ff_frame_pool_get_buffer(pool, framePtr) :
+            av_frame_get_buffer(framePtr, 0);
         if (ret < 0)
             throw new Error("Failed to allocate frame buffers: " + ff_error(ret));
     }
+}
+
+// Copy in a video frame. Used internally by ff_copyin_frame.
+var ff_copyin_frame_video = Module.ff_copyin_frame_video = function(framePtr, frame, pool) {
+    ff_frame_snapshot_copyin(framePtr, frame);
+    ff_frame_get_buffer(framePtr, pool);
+
+    // Get the data pointers and the pixel format descriptor
+    var b = ff_frame_snapshot_idx(framePtr);
+    var s = Module.HEAP32;
+    var log2cw = s[b + FRAME_SNAP.LOG2_CHROMA_W];
+    var log2ch = s[b + FRAME_SNAP.LOG2_CHROMA_H];
 
     // If layout is not provided, assume packed
     var layout = frame.layout;
@@ -492,13 +812,12 @@ var ff_copyin_frame_video = Module.ff_copyin_frame_video = function(framePtr, fr
 
         // VERY simple bpp, assuming all components are 8-bit
         var bpp = 1;
-        if (!(AVPixFmtDescriptor_flags(desc) & 0x10) /* planar */)
-            bpp *= AVPixFmtDescriptor_nb_components(desc);
+        if (!(s[b + FRAME_SNAP.PIXDESC_FLAGS] & 0x10) /* planar */)
+            bpp *= s[b + FRAME_SNAP.NB_COMPONENTS];
 
         var off = 0;
         for (var p = 0; p < 8 /* AV_NUM_DATA_POINTERS */; p++) {
-            var linesize = AVFrame_linesize_a(framePtr, p);
-            if (!linesize)
+            if (!s[b + FRAME_SNAP.LINESIZE + p])
                 break;
             var w = frame.width;
             var h = frame.height;
@@ -517,8 +836,8 @@ var ff_copyin_frame_video = Module.ff_copyin_frame_video = function(framePtr, fr
     // Copy it in
     for (var p = 0; p < layout.length; p++) {
         var lplane = layout[p];
-        var linesize = AVFrame_linesize_a(framePtr, p);
-        var data = AVFrame_data_a(framePtr, p);
+        var linesize = s[b + FRAME_SNAP.LINESIZE + p];
+        var data = s[b + FRAME_SNAP.DATA + p];
         var h = frame.height;
         if (p === 1 || p === 2)
             h >>= log2ch;
@@ -535,3 +854,129 @@ var ff_copyin_frame_video = Module.ff_copyin_frame_video = function(framePtr, fr
         }
     }
 };
+
+/**
+ * Release many frames to a frame pool at once.
+ * @param pool  Frame pool
+ * @param frames  AVFrames to release
+ */
+/// @types ff_frame_pool_release_multi@sync(pool: number, frames: number[]): @promise@void@
+var ff_frame_pool_release_multi = Module.ff_frame_pool_release_multi = function(pool, frames) {
+    for (var i = 0; i < frames.length; i++)
+        ff_frame_pool_release(pool, frames[i]);
+};
+
+/**
+ * Get the statistics of a frame pool.
+ * @param pool  Frame pool
+ */
+/// @types ff_frame_pool_get_stats@sync(pool: number): @promise@PoolStats@
+var ff_frame_pool_get_stats = Module.ff_frame_pool_get_stats = function(pool) {
+    return ff_pool_get_stats(ff_frame_pool_stats, pool);
+};
+
+// Frame pool used internally by the multi metafunctions
+var ff_internal_frame_pool_ptr = 0;
+
+/* Get the internal frame pool, allocating it if needed. Used internally. */
+function ff_internal_frame_pool() {
+    if (!ff_internal_frame_pool_ptr) {
+        ff_internal_frame_pool_ptr = ff_frame_pool_alloc();
+        if (!ff_internal_frame_pool_ptr)
+            throw new Error("Failed to allocate frame pool");
+    }
+    return ff_internal_frame_pool_ptr;
+}
+
+// The pool is gone after a reset
+ff_reset_hooks.push(function() {
+    ff_internal_frame_pool_ptr = 0;
+});
+
+/* Get AVFrame pointers for a native multi driver from these frames, copying in
+ * (and converting, if convert is given) any that aren't pointers already.
+ * Returns the pointers and the pool that the driver should release them to.
+ * Used internally. */
+function ff_multi_frames_in(inFrames, pool, convert) {
+    var ptrs = [];
+    if (!pool) {
+        // If they're all ours, they can come from (and go back to) our pool
+        pool = ff_internal_frame_pool();
+        for (var i = 0; i < inFrames.length; i++) {
+            if (typeof inFrames[i] === "number") {
+                pool = 0;
+                break;
+            }
+        }
+    }
+    for (var i = 0; i < inFrames.length; i++) {
+        var inFrame = inFrames[i];
+        if (typeof inFrame !== "number") {
+            var ptr = pool ? ff_frame_pool_acquire(pool) : av_frame_alloc();
+            if (!ptr)
+                throw new Error("Failed to allocate frame");
+            ff_copyin_frame(ptr, inFrame, pool, convert);
+            inFrame = ptr;
+        }
+        ptrs.push(inFrame);
+    }
+    return [ptrs, pool];
+}
+
+/* Free the output frames of a native multi driver, releasing them to the pool
+ * if there is one. Used internally. */
+function ff_multi_frames_free(ptrs, pool) {
+    if (pool) {
+        ff_frame_pool_release_multi(pool, ptrs);
+    } else {
+        for (var i = 0; i < ptrs.length; i++)
+            av_frame_free_js(ptrs[i]);
+    }
+}
+
+/* Convert frames with the native multi driver of a scaler or resampler, then
+ * copy them out as config says. driver is called with the input list, its
+ * length, status, flags, the input and output pools, and the output. Used
+ * internally by ff_scale_multi and ff_resample_multi. */
+function ff_convert_multi(inFrames, config, driver, errMsg) {
+    var outFrames;
+    var transfer = [];
+    var ptrOut = (config.copyoutFrame === "ptr");
+    var outPool = config.framePool || (ptrOut ? 0 : ff_internal_frame_pool());
+    var inp = ff_multi_frames_in(inFrames, config.framePool);
+    var flags = (config.fin ? MULTI_FLAGS.FIN : 0) |
+        (config.ignoreErrors ? MULTI_FLAGS.IGNORE_ERRORS : 0);
+
+    var res = ff_multi_call(inp[0], function(inList, status, out) {
+        return driver(
+            inList, inp[0].length, status, flags, inp[1], outPool, out);
+    });
+
+    if (res.ret < 0) {
+        ff_multi_frames_free(res.out, outPool);
+        throw new Error(errMsg + ff_error(res.ret));
+    }
+    if (config.ignoreErrors) {
+        res.status.forEach(function(ret) {
+            if (ret < 0)
+                console.log(errMsg + ff_error(ret));
+        });
+    }
+
+    if (ptrOut) {
+        outFrames = res.out;
+    } else {
+        var copyoutFrame =
+            ff_copyout_frame_versions[config.copyoutFrame || "default"];
+        outFrames = res.out.map(function(ptr) {
+            var outFrame = copyoutFrame(ptr);
+            if (outFrame && outFrame.libavjsTransfer && outFrame.libavjsTransfer.length)
+                transfer.push.apply(transfer, outFrame.libavjsTransfer);
+            return outFrame;
+        });
+        ff_multi_frames_free(res.out, outPool);
+    }
+
+    outFrames.libavjsTransfer = transfer;
+    return outFrames;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/**
+ * Initialize a resampler, which converts the audio frames of one stream to one
+ * sample format, channel layout and sample rate, keeping its state between
+ * frames. Any of these not given are kept from the input frames. Converted
+ * frames keep the timestamps of the frames they were converted from. Free the
+ * resampler with ff_resampler_free.
+ * @param format  Format to convert to
+ */
+/// @types ff_init_resampler@sync(format?: AudioFormat): @promise@number@
+var ff_init_resampler = Module.ff_init_resampler = function(format) {
+    format = format || {};
+    var ret = ff_resampler_alloc(
+        (typeof format.format === "number") ? format.format : -1,
+        format.channel_layout || 0, format.channel_layouthi || 0,
+        format.sample_rate || 0
+    );
+    if (!ret)
+        throw new Error("Failed to allocate resampler");
+    return ret;
+};
+
+/**
+ * Convert some number of audio frames at once with a resampler, in one call.
+ * When resampling, the resampler buffers some samples, so the output may have
+ * fewer frames than the input; set `config.fin` at the end of the stream to
+ * flush them. After that, the resampler starts afresh. If `config.framePool`
+ * is set, AVFrame pointers in inFrames are released to that pool, and "ptr"
+ * frames are taken from it (otherwise, pointers are freed). Set
+ * `config.copyoutFrame` to use a different copier than the default.
+ * @param resampler  Resampler, from ff_init_resampler
+ * @param inFrames  Frames to convert
+ * @param config  Options. May be "true" to indicate end of stream.
+ */
+/* @types
+ * ff_resample_multi@sync(
+ *     resampler: number, inFrames: (Frame | FrameView | number)[],
+ *     config?: boolean | {
+ *         fin?: boolean,
+ *         ignoreErrors?: boolean,
+ *         copyoutFrame?: "default",
+ *         framePool?: number
+ *     }
+ * ): @promise@Frame[]@
+ * ff_resample_multi@sync(
+ *     resampler: number, inFrames: (Frame | FrameView | number)[],
+ *     config: {
+ *         fin?: boolean,
+ *         ignoreErrors?: boolean,
+ *         copyoutFrame: "ptr",
+ *         framePool?: number
+ *     }
+ * ): @promise@number[]@
+ * ff_resample_multi@sync(
+ *     resampler: number, inFrames: (Frame | FrameView | number)[],
+ *     config: {
+ *         fin?: boolean,
+ *         ignoreErrors?: boolean,
+ *         copyoutFrame: "view",
+ *         framePool?: number
+ *     }
+ * ): @promise@FrameView[]@
+ */
+var ff_resample_multi = Module.ff_resample_multi = function(resampler, inFrames, config) {
+    if (typeof config === "boolean") {
+        config = {fin: config};
+    } else {
+        config = config || {};
+    }
+    return ff_convert_multi(inFrames, config, function(inList, n, status,
+        flags, inPool, outPool, out) {
+        return ff_resample_multi_c(
+            resampler, inList, n, status, flags, inPool, outPool, out);
+    }, "Error resampling frame: ");
+};
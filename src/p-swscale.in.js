@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/**
+ * Initialize a scaler, which converts video frames to one pixel format and
+ * size, keeping its scaling context between frames and only rebuilding it when
+ * the input frames' format or size changes. Any of format, width and height
+ * not given are kept from the input frames, except that if only one of width
+ * and height is given, the other is chosen to keep the frames' shape.
+ * `flags` are SWS_* flags (bilinear by default), and `threads` is the number
+ * of slice threads (0 for one per core), which by default is one per core in
+ * the threaded build and one otherwise. Free the scaler with ff_scaler_free.
+ * @param format  Format to convert to
+ */
+/// @types ff_init_scaler@sync(format?: ScalerFormat): @promise@number@
+var ff_init_scaler = Module.ff_init_scaler = function(format) {
+    format = format || {};
+    var ret = ff_scaler_alloc(
+        (typeof format.format === "number") ? format.format : -1,
+        format.width || 0, format.height || 0, format.flags || 0,
+        (typeof format.threads === "number") ? format.threads : -1
+    );
+    if (!ret)
+        throw new Error("Failed to allocate scaler");
+    return ret;
+};
+
+/**
+ * Convert some number of video frames at once with a scaler, in one call. If
+ * `config.framePool` is set, AVFrame pointers in inFrames are released to that
+ * pool, and "ptr" frames are taken from it (otherwise, pointers are freed).
+ * Set `config.copyoutFrame` to use a different copier than the default.
+ * @param scaler  Scaler, from ff_init_scaler
+ * @param inFrames  Frames to convert
+ * @param config  Options
+ */
+/* @types
+ * ff_scale_multi@sync(
+ *     scaler: number, inFrames: (Frame | FrameView | number)[],
+ *     config?: {
+ *         ignoreErrors?: boolean,
+ *         copyoutFrame?: "default" | "video" | "video_packed",
+ *         framePool?: number
+ *     }
+ * ): @promise@Frame[]@
+ * ff_scale_multi@sync(
+ *     scaler: number, inFrames: (Frame | FrameView | number)[],
+ *     config: {
+ *         ignoreErrors?: boolean,
+ *         copyoutFrame: "ptr",
+ *         framePool?: number
+ *     }
+ * ): @promise@number[]@
+ * ff_scale_multi@sync(
+ *     scaler: number, inFrames: (Frame | FrameView | number)[],
+ *     config: {
+ *         ignoreErrors?: boolean,
+ *         copyoutFrame: "ImageData",
+ *         framePool?: number
+ *     }
+ * ): @promise@ImageData[]@
+ * ff_scale_multi@sync(
+ *     scaler: number, inFrames: (Frame | FrameView | number)[],
+ *     config: {
+ *         ignoreErrors?: boolean,
+ *         copyoutFrame: "view",
+ *         framePool?: number
+ *     }
+ * ): @promise@FrameView[]@
+ */
+var ff_scale_multi = Module.ff_scale_multi = function(scaler, inFrames, config) {
+    config = config || {};
+    return ff_convert_multi(inFrames, config, function(inList, n, status, flags,
+        inPool, outPool, out) {
+        return ff_scale_multi_c(
+            scaler, inList, n, status, flags, inPool, outPool, out);
+    }, "Error scaling frame: ");
+};
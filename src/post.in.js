@@ -47,6 +47,480 @@ var ERRNO_CODES = {
  * if we're a Worker */
 var CAccessors = {};
 
+/* Buffers for snapshot records (see bindings.c), one per kind of record. These
+ * are allocated on first use and never freed. */
+var snapshotBuffers = {};
+
+/* Get the buffer for a kind of snapshot record, of the given size in 32-bit
+ * words. Used internally. */
+function ff_snapshot_buffer(kind, size) {
+    var ptr = snapshotBuffers[kind];
+    if (!ptr) {
+        ptr = snapshotBuffers[kind] = malloc(size * 4);
+        if (ptr === 0)
+            throw new Error("Failed to malloc");
+    }
+    return ptr;
+}
+
+/* Flags to the native multi drivers (ff_*_multi_c). Must match bindings.c. */
+var MULTI_FLAGS = {
+    FIN: 0x1,
+    IGNORE_ERRORS: 0x2,
+    IGNORE_SINK_TIMEBASE: 0x4
+};
+
+/* Call a native multi driver over these input pointers. call is given the
+ * input list, the status list and the FFMultiOutput (see bindings.c), and must
+ * pass them to the driver. Returns the driver's result, the status of each
+ * input (and last, of the end of stream), and the output pointers. Used
+ * internally. */
+function ff_multi_call(inPtrs, call) {
+    var n = inPtrs.length;
+    var inList = malloc(n * 8 + 4);
+    if (inList === 0)
+        throw new Error("Failed to malloc");
+    var out = ff_snapshot_buffer("multi_out", 3);
+    var s = Module.HEAP32;
+    var b = inList >> 2;
+    var ob = out >> 2;
+    for (var i = 0; i < n; i++)
+        s[b + i] = inPtrs[i];
+    for (var i = 0; i <= n; i++)
+        s[b + n + i] = 0;
+    s[ob] = s[ob + 1] = s[ob + 2] = 0;
+
+    var ret = call(inList, inList + n * 4, out);
+
+    s = Module.HEAP32;
+    var status = Array.prototype.slice.call(s.subarray(b + n, b + n * 2 + 1));
+    var items = [];
+    if (s[ob]) {
+        var ib = s[ob] >> 2;
+        items = Array.prototype.slice.call(s.subarray(ib, ib + s[ob + 1]));
+        free(s[ob]);
+    }
+    free(inList);
+    return {ret: ret, status: status, out: items};
+}
+
+/* Fields of pool statistics records (see FFPool in bindings.c), in order */
+var ff_pool_stats_fields = [
+    "allocated", "in_use", "free", "reused", "buffers", "buffer_pools"
+];
+
+/* Get the statistics of a frame or packet pool as an object, using the given
+ * C statistics function. Used internally. */
+function ff_pool_get_stats(statsFunc, pool) {
+    var ptr = ff_snapshot_buffer("pool_stats", ff_pool_stats_fields.length);
+    statsFunc(pool, ptr);
+    var s = Module.HEAP32;
+    var b = ptr >> 2;
+    var ret = {};
+    for (var i = 0; i < ff_pool_stats_fields.length; i++)
+        ret[ff_pool_stats_fields[i]] = s[b + i];
+    return ret;
+}
+
+/* Make obj a view over the heap. obj.data becomes a typed array (or an array of
+ * typed arrays if planar) over the given ranges, each of which is [pointer,
+ * length, typed array constructor]. Resizing the heap detaches the old buffer,
+ * so the views are recreated whenever the heap's buffer changes. obj.release
+ * calls the given release function, after which the views are no longer
+ * available. Used internally by the "view" copyout versions. */
+function ff_heap_view(obj, ranges, planar, release) {
+    var buffer = null;
+    var data = null;
+    var released = false;
+    Object.defineProperty(obj, "data", {
+        enumerable: true,
+        get: function() {
+            if (released)
+                throw new Error("View used after being released");
+            if (buffer !== Module.HEAPU8.buffer) {
+                buffer = Module.HEAPU8.buffer;
+                data = ranges.map(function(range) {
+                    return new range[2](buffer, range[0], range[1]);
+                });
+                if (!planar)
+                    data = data[0] || null;
+            }
+            return data;
+        }
+    });
+    obj.release = function() {
+        if (released)
+            return;
+        released = true;
+        buffer = data = null;
+        release();
+    };
+    return obj;
+}
+
+/* Throw if views over the heap can't be given to the caller, because results
+ * are being posted to another thread. Used internally. */
+function ff_check_heap_view() {
+    if (Module.libavjsCrossThread) {
+        throw new Error(
+            "Views are only available when libav.js is running in the " +
+            "caller's thread");
+    }
+}
+
+/* Shared-memory transport for the threads mode. Commands to the libav.js thread
+ * and their results are passed through a pair of single-producer,
+ * single-consumer rings in a SharedArrayBuffer, instead of one postMessage
+ * each. Each ring has a header of four 32-bit words (see RING_*), followed by
+ * its data, the size of which is a power of two. The positions are byte counts
+ * which wrap at 2^32. */
+var RING_WRITE = 0, RING_READ = 1, RING_SLEEP = 2, RING_HEADER = 16;
+
+/* The consumer's sleep state, in RING_SLEEP. A consumer that can
+ * Atomics.waitAsync is notified on RING_WRITE; one that can't must be sent a
+ * "libavjs_ring_wake" message. */
+var RING_AWAKE = 0, RING_WAITING = 1, RING_DOORBELL = 2;
+
+// Value tags in ring messages
+var RING_UNDEFINED = 0, RING_NULL = 1, RING_FALSE = 2, RING_TRUE = 3,
+    RING_INT = 4, RING_NUMBER = 5, RING_STRING = 6, RING_ARRAY = 7,
+    RING_OBJECT = 8, RING_TYPED_ARRAY = 9, RING_ARRAY_BUFFER = 10;
+
+// Typed arrays that can be passed through rings, by index
+var ringTypedArrays = [
+    Int8Array, Uint8Array, Uint8ClampedArray, Int16Array, Uint16Array,
+    Int32Array, Uint32Array, Float32Array, Float64Array
+];
+if (typeof BigInt64Array !== "undefined")
+    ringTypedArrays.push(BigInt64Array, BigUint64Array);
+
+// One ring, at this offset in a SharedArrayBuffer
+function LibAVRing(sab, offset, size) {
+    this.hdr = new Int32Array(sab, offset, RING_HEADER / 4);
+    this.data = new Uint8Array(sab, offset + RING_HEADER, size);
+    this.size = size;
+    this.mask = size - 1;
+    this.buf = new Uint8Array(1024);
+}
+
+LibAVRing.prototype.put = function(pos, src, len) {
+    var idx = pos & this.mask;
+    var first = Math.min(len, this.size - idx);
+    this.data.set(src.subarray(0, first), idx);
+    if (first < len)
+        this.data.set(src.subarray(first, len), 0);
+};
+
+LibAVRing.prototype.get = function(pos, dst, len) {
+    var idx = pos & this.mask;
+    var first = Math.min(len, this.size - idx);
+    dst.set(this.data.subarray(idx, idx + first));
+    if (first < len)
+        dst.set(this.data.subarray(0, len - first), first);
+};
+
+/* Write a message, the first four bytes of which must be its length. Returns
+ * false if there isn't room. */
+LibAVRing.prototype.write = function(msg, len) {
+    var w = this.hdr[RING_WRITE];
+    var r = Atomics.load(this.hdr, RING_READ);
+    if (this.size - ((w - r) >>> 0) < len)
+        return false;
+    this.put(w, msg, len);
+    Atomics.store(this.hdr, RING_WRITE, (w + len) | 0);
+    return true;
+};
+
+/* Read a message, or return null if there isn't one. The message is only valid
+ * until the next read. */
+LibAVRing.prototype.read = function() {
+    var r = this.hdr[RING_READ];
+    if (Atomics.load(this.hdr, RING_WRITE) === r)
+        return null;
+    var lenBuf = new Uint8Array(4);
+    this.get(r, lenBuf, 4);
+    var len = new DataView(lenBuf.buffer).getUint32(0, true);
+    if (this.buf.length < len)
+        this.buf = new Uint8Array(Math.max(len, this.buf.length * 2));
+    this.get(r, this.buf, len);
+    Atomics.store(this.hdr, RING_READ, (r + len) | 0);
+    return this.buf.subarray(0, len);
+};
+
+LibAVRing.prototype.empty = function() {
+    return Atomics.load(this.hdr, RING_WRITE) === this.hdr[RING_READ];
+};
+
+/* Encoder for ring messages. Only plain data (and typed arrays) can be encoded;
+ * anything else throws, and the message is posted instead. */
+function LibAVRingEncoder() {
+    this.u8 = new Uint8Array(1024);
+    this.dv = new DataView(this.u8.buffer);
+    this.pos = 0;
+    this.te = new TextEncoder();
+}
+
+LibAVRingEncoder.prototype.reserve = function(len) {
+    if (this.pos + len <= this.u8.length)
+        return;
+    var u8 = new Uint8Array(Math.max(this.pos + len, this.u8.length * 2));
+    u8.set(this.u8.subarray(0, this.pos));
+    this.u8 = u8;
+    this.dv = new DataView(u8.buffer);
+};
+
+LibAVRingEncoder.prototype.tag = function(tag, u32) {
+    this.reserve(5);
+    this.u8[this.pos] = tag;
+    this.dv.setUint32(this.pos + 1, u32, true);
+    this.pos += 5;
+};
+
+LibAVRingEncoder.prototype.value = function(v) {
+    switch (typeof v) {
+        case "undefined":
+            this.tag(RING_UNDEFINED, 0);
+            return;
+
+        case "boolean":
+            this.tag(v ? RING_TRUE : RING_FALSE, 0);
+            return;
+
+        case "number":
+            if ((v | 0) === v && (v || 1 / v > 0)) {
+                this.tag(RING_INT, v);
+            } else {
+                this.tag(RING_NUMBER, 0);
+                this.reserve(8);
+                this.dv.setFloat64(this.pos, v, true);
+                this.pos += 8;
+            }
+            return;
+
+        case "string":
+            this.reserve(5 + v.length * 3);
+            var start = this.pos;
+            this.pos += 5;
+            var res = this.te.encodeInto(v, this.u8.subarray(this.pos));
+            this.pos += res.written;
+            this.u8[start] = RING_STRING;
+            this.dv.setUint32(start + 1, res.written, true);
+            return;
+
+        case "object":
+            break;
+
+        default:
+            throw new TypeError("Unsupported type " + typeof v);
+    }
+
+    if (v === null) {
+        this.tag(RING_NULL, 0);
+
+    } else if (v instanceof Array) {
+        this.tag(RING_ARRAY, v.length);
+        for (var i = 0; i < v.length; i++)
+            this.value(v[i]);
+
+    } else if (ArrayBuffer.isView(v)) {
+        var kind = ringTypedArrays.indexOf(v.constructor);
+        if (kind < 0)
+            throw new TypeError("Unsupported view type");
+        this.tag(RING_TYPED_ARRAY, kind);
+        this.bytes(new Uint8Array(v.buffer, v.byteOffset, v.byteLength));
+
+    } else if (v instanceof ArrayBuffer) {
+        this.tag(RING_ARRAY_BUFFER, 0);
+        this.bytes(new Uint8Array(v));
+
+    } else {
+        var proto = Object.getPrototypeOf(v);
+        if (proto !== Object.prototype && proto !== null)
+            throw new TypeError("Unsupported object type");
+        var keys = Object.keys(v);
+        this.tag(RING_OBJECT, keys.length);
+        for (var i = 0; i < keys.length; i++) {
+            this.value(keys[i]);
+            this.value(v[keys[i]]);
+        }
+
+    }
+};
+
+LibAVRingEncoder.prototype.bytes = function(u8) {
+    this.reserve(4 + u8.length);
+    this.dv.setUint32(this.pos, u8.length, true);
+    this.u8.set(u8, this.pos + 4);
+    this.pos += 4 + u8.length;
+};
+
+/* Encode a message with this sequence number. The encoded message is the first
+ * (returned) bytes of this.u8. */
+LibAVRingEncoder.prototype.message = function(seq, msg) {
+    this.pos = 8;
+    this.value(msg);
+    this.dv.setUint32(0, this.pos, true);
+    this.dv.setUint32(4, seq, true);
+    return this.pos;
+};
+
+// Decode a message from a ring. Returns [sequence number, message].
+function ff_ring_decode(u8) {
+    var dv = new DataView(u8.buffer, u8.byteOffset, u8.byteLength);
+    var td = new TextDecoder();
+    var pos = 8;
+
+    function value() {
+        var tag = u8[pos];
+        var u32 = dv.getUint32(pos + 1, true);
+        pos += 5;
+        switch (tag) {
+            case RING_UNDEFINED: return void 0;
+            case RING_NULL: return null;
+            case RING_FALSE: return false;
+            case RING_TRUE: return true;
+            case RING_INT: return u32 | 0;
+
+            case RING_NUMBER:
+                pos += 8;
+                return dv.getFloat64(pos - 8, true);
+
+            case RING_STRING:
+                pos += u32;
+                return td.decode(u8.subarray(pos - u32, pos));
+
+            case RING_ARRAY:
+                var arr = new Array(u32);
+                for (var i = 0; i < u32; i++)
+                    arr[i] = value();
+                return arr;
+
+            case RING_OBJECT:
+                var obj = {};
+                for (var i = 0; i < u32; i++) {
+                    var key = value();
+                    obj[key] = value();
+                }
+                return obj;
+
+            case RING_TYPED_ARRAY:
+                var ab = bytes();
+                return new ringTypedArrays[u32](ab);
+
+            case RING_ARRAY_BUFFER:
+                return bytes();
+
+            default:
+                throw new Error("Corrupt ring message");
+        }
+    }
+
+    function bytes() {
+        var len = dv.getUint32(pos, true);
+        pos += 4 + len;
+        return u8.slice(pos - len, pos).buffer;
+    }
+
+    return [dv.getUint32(4, true), value()];
+}
+
+/* A channel over a pair of rings in sab, each of the given size. The two ends
+ * are side 0 (the frontend) and side 1 (the libav.js thread). post is used to
+ * post messages that can't be sent through the ring, and onmessage receives
+ * messages, in the order they were sent, regardless of how they were sent.
+ * Messages posted by the other side ({c: "libavjs_ring", ...} and
+ * {c: "libavjs_ring_wake"}) must be passed to posted. */
+Module.libavjsRingChannel = function(sab, size, side, post, onmessage) {
+    var bytes = RING_HEADER + size;
+    var out = new LibAVRing(sab, side ? bytes : 0, size);
+    var inp = new LibAVRing(sab, side ? 0 : bytes, size);
+    var enc = new LibAVRingEncoder();
+    var sendSeq = 0, recvSeq = 0;
+    var pending = {};
+    var canWaitAsync = (typeof Atomics.waitAsync === "function");
+    var waiting = false;
+    var draining = false;
+    var written = 0;
+
+    function drain() {
+        if (draining)
+            return;
+        draining = true;
+        try {
+            while (true) {
+                var msg;
+                while ((msg = inp.read()) !== null) {
+                    msg = ff_ring_decode(msg);
+                    pending[msg[0]] = msg[1];
+                }
+
+                while (recvSeq in pending) {
+                    msg = pending[recvSeq];
+                    delete pending[recvSeq];
+                    recvSeq = (recvSeq + 1) >>> 0;
+                    onmessage(msg);
+                }
+
+                /* Go to sleep, unless more arrived in the meantime. The write
+                 * position is loaded once, and waited on below, so that a
+                 * write after this check ends the wait at once. */
+                Atomics.store(inp.hdr, RING_SLEEP,
+                    canWaitAsync ? RING_WAITING : RING_DOORBELL);
+                written = Atomics.load(inp.hdr, RING_WRITE);
+                if (written !== inp.hdr[RING_READ]) {
+                    Atomics.store(inp.hdr, RING_SLEEP, RING_AWAKE);
+                    continue;
+                }
+                break;
+            }
+        } finally {
+            draining = false;
+        }
+
+        if (canWaitAsync && !waiting) {
+            var w = Atomics.waitAsync(inp.hdr, RING_WRITE, written);
+            if (w.async) {
+                waiting = true;
+                w.value.then(function() {
+                    waiting = false;
+                    drain();
+                });
+            } else {
+                drain();
+            }
+        }
+    }
+
+    drain();
+
+    return {
+        send: function(msg, transfer) {
+            var seq = sendSeq;
+            sendSeq = (sendSeq + 1) >>> 0;
+            var len = -1;
+            try {
+                len = enc.message(seq, msg);
+            } catch (ex) {}
+            if (len >= 0 && out.write(enc.u8, len)) {
+                // Wake the other side if needed
+                var sleep = Atomics.exchange(out.hdr, RING_SLEEP, RING_AWAKE);
+                if (sleep === RING_WAITING)
+                    Atomics.notify(out.hdr, RING_WRITE);
+                else if (sleep === RING_DOORBELL)
+                    post({c: "libavjs_ring_wake"});
+            } else {
+                post({c: "libavjs_ring", s: seq, a: msg}, transfer);
+            }
+        },
+
+        posted: function(data) {
+            if (data.c === "libavjs_ring")
+                pending[data.s] = data.a;
+            drain();
+        }
+    };
+};
+
 /**
  * Allocate and copy in a 32-bit int list.
  * @param list  List of numbers to copy in
@@ -113,4 +587,358 @@ var ff_free_string_array = Module.ff_free_string_array = function(ptr) {
     free(ptr);
 };
 
+/* Resolve references to earlier results (see ff_batch) in a batched call's
+ * arguments. Only copies the parts of v that actually contain references. */
+function ff_batch_resolve(v, results) {
+    if (typeof v !== "object" || v === null || ArrayBuffer.isView(v) ||
+        v instanceof ArrayBuffer)
+        return v;
+
+    if (typeof v.libavjsRef === "number") {
+        if (v.libavjsRef < 0 || v.libavjsRef >= results.length)
+            throw new Error("Reference to a step that hasn't run: " + v.libavjsRef);
+        var ret = results[v.libavjsRef];
+        var path = v.path || [];
+        for (var i = 0; i < path.length; i++)
+            ret = ret[path[i]];
+        return ret;
+    }
+
+    var out = v;
+    var keys = Object.keys(v);
+    for (var i = 0; i < keys.length; i++) {
+        var el = v[keys[i]];
+        var rel = ff_batch_resolve(el, results);
+        if (rel !== el) {
+            if (out === v)
+                out = (v instanceof Array) ? v.slice(0) : Object.assign({}, v);
+            out[keys[i]] = rel;
+        }
+    }
+    return out;
+}
+
+/* Call f on every value in v, looking into arrays and plain objects (but not
+ * typed arrays), but only so deep. Used by ff_batch. */
+function ff_batch_walk(v, depth, f) {
+    f(v);
+    if (depth <= 0 || typeof v !== "object" || v === null ||
+        ArrayBuffer.isView(v) || v instanceof ArrayBuffer)
+        return;
+    var keys = Object.keys(v);
+    for (var i = 0; i < keys.length; i++)
+        ff_batch_walk(v[keys[i]], depth - 1, f);
+}
+
+/* Free the frames or packets that a failed batch's calls returned as pointers
+ * (with the "ptr" copyout), except those passed on to later calls, which took
+ * them over. */
+function ff_batch_free(calls, results, args) {
+    for (var si = 0; si < results.length; si++) {
+        var opts = null;
+        ff_batch_walk(calls[si], 2, function(v) {
+            if (v && (v.copyoutFrame === "ptr" || v.copyoutPacket === "ptr"))
+                opts = v;
+        });
+        if (!opts || !results[si])
+            continue;
+
+        var passed = [];
+        for (var ai = si + 1; ai < args.length; ai++) {
+            ff_batch_walk(args[ai], 4, function(v) {
+                if (typeof v === "number")
+                    passed.push(v);
+            });
+        }
+
+        // ff_read_frame_multi's packets are in its second element
+        var out = results[si];
+        if (calls[si][0] === "ff_read_frame_multi")
+            out = out[1];
+        var ptrs = [];
+        ff_batch_walk(out, 3, function(v) {
+            if (typeof v === "number" && v > 0 && passed.indexOf(v) < 0 &&
+                ptrs.indexOf(v) < 0)
+                ptrs.push(v);
+        });
+        if (opts.copyoutPacket === "ptr")
+            ff_multi_packets_free(ptrs, opts.packetPool || 0);
+        else
+            ff_multi_frames_free(ptrs, opts.framePool || 0);
+    }
+}
+
+/**
+ * Perform a sequence of calls, in order, as a single call. Each call is an
+ * array of the function name and its arguments. Arguments may refer to the
+ * results of earlier calls in the same batch with ff_batch_ref, anywhere in
+ * their structure, so that, e.g., the packets read by one call can be decoded
+ * by the next without ever leaving libav.js's thread.
+ * @param calls  Calls to perform
+ * @param returns  What to return, usually containing references. If unset,
+ *                 the result of the last call is returned.
+ * If a call fails, frames and packets returned as pointers by earlier calls,
+ * and not passed on to later calls, are freed.
+ */
+/// @types ff_batch@sync(calls: [string, ...any[]][], returns?: any): @promsync@any@
+var ff_batch = Module.ff_batch = function(calls, returns) {
+    var results = [];
+    var args = [];
+    var step = 0;
+
+    function finish() {
+        if (typeof returns === "undefined")
+            return results[results.length - 1];
+
+        var ret = ff_batch_resolve(returns, results);
+        if (!ret || typeof ret !== "object")
+            return ret;
+
+        /* Transfer the buffers that the calls marked as transferable, but only
+         * those in what we're actually returning */
+        var transferable = new Set();
+        for (var i = 0; i < results.length; i++) {
+            var r = results[i];
+            if (r && r.libavjsTransfer)
+                r.libavjsTransfer.forEach(function(b) { transferable.add(b); });
+        }
+        var transfer = [];
+        ff_batch_walk(ret, 6, function(v) {
+            if (v && ArrayBuffer.isView(v) && transferable.has(v.buffer)) {
+                transferable.delete(v.buffer);
+                transfer.push(v.buffer);
+            }
+        });
+        if (transfer.length) {
+            // Don't change a call's own result
+            ret = (ret instanceof Array) ? ret.slice(0) : Object.assign({}, ret);
+            ret.libavjsTransfer = transfer;
+        }
+        return ret;
+    }
+
+    function fail(ex) {
+        try {
+            ff_batch_free(calls, results, args);
+        } catch (fex) {
+            console.error(fex);
+        }
+        throw new Error("Error in batched call " + step + " (" +
+            calls[step][0] + "): " + (ex && ex.message || ex));
+    }
+
+    // Run synchronously until a call is asynchronous
+    function run() {
+        for (; step < calls.length; step++) {
+            var call = calls[step];
+            var ret;
+            try {
+                // In direct mode, Module[name] is wrapped in a promise
+                var func = Module[call[0] + "_sync"] || Module[call[0]];
+                if (typeof func !== "function")
+                    throw new Error("No such function");
+                args[step] = ff_batch_resolve(call.slice(1), results);
+                ret = func.apply(Module, args[step]);
+            } catch (ex) {
+                fail(ex);
+            }
+            if (ret && typeof ret === "object" && ret.then) {
+                return ret.catch(fail).then(function(ret) {
+                    results.push(ret);
+                    step++;
+                    return run();
+                });
+            }
+            results.push(ret);
+        }
+        return finish();
+    }
+
+    return run();
+};
+
+/* Instrumentation (see stats in the frontend). null unless enabled, in which
+ * case the functions being measured have been replaced by measuring wrappers,
+ * so that it costs nothing when disabled. */
+var libavjsStats = null;
+
+/* Count the bytes in the typed arrays in v, looking into arrays and plain
+ * objects (such as frames and packets, and lists of them), but only so deep.
+ * Used internally. */
+function libavjsStatsBytes(v, depth) {
+    if (typeof v !== "object" || v === null)
+        return 0;
+    if (ArrayBuffer.isView(v) || v instanceof ArrayBuffer)
+        return v.byteLength;
+    if (depth >= 5)
+        return 0;
+    var ret = 0;
+    if (v instanceof Array) {
+        for (var i = 0; i < v.length; i++)
+            ret += libavjsStatsBytes(v[i], depth + 1);
+    } else if (Object.getPrototypeOf(v) === Object.prototype) {
+        for (var k in v)
+            ret += libavjsStatsBytes(v[k], depth + 1);
+    }
+    return ret;
+}
+
+// Make a measuring wrapper for this function. Used internally.
+function libavjsStatsWrap(name, real) {
+    var st = libavjsStats.functions[name] = {
+        calls: 0, time: 0, max_time: 0, bytes_in: 0, bytes_out: 0,
+        transfers: 0
+    };
+
+    function done(start, ret) {
+        var time = performance.now() - start;
+        st.time += time;
+        if (time > st.max_time)
+            st.max_time = time;
+        st.bytes_out += libavjsStatsBytes(ret, 0);
+        if (Module.libavjsCrossThread && ret && ret.libavjsTransfer)
+            st.transfers += ret.libavjsTransfer.length;
+
+        var heap = libavjsStats.heap;
+        heap.used = mallinfo_uordblks();
+        if (heap.used > heap.max_used)
+            heap.max_used = heap.used;
+        heap.size = Module.HEAPU8.length;
+        if (heap.size > heap.max_size)
+            heap.max_size = heap.size;
+    }
+
+    return function() {
+        st.calls++;
+        for (var i = 0; i < arguments.length; i++)
+            st.bytes_in += libavjsStatsBytes(arguments[i], 1);
+        var start = performance.now();
+        var ret = real.apply(this, arguments);
+        if (ret && typeof ret === "object" && ret.then) {
+            return ret.then(function(ret) {
+                done(start, ret);
+                return ret;
+            }, function(ex) {
+                done(start, null);
+                throw ex;
+            });
+        }
+        done(start, ret);
+        return ret;
+    };
+}
+
+/* Enable instrumentation of these functions. Used by the frontend, before it
+ * wraps the functions itself. */
+Module.libavjsStatsEnable = function(funcs) {
+    if (!libavjsStats) {
+        libavjsStats = {
+            functions: {},
+            heap: {used: 0, max_used: 0, size: 0, max_size: 0}
+        };
+    }
+    for (var i = 0; i < funcs.length; i++) {
+        var name = funcs[i];
+        var real = Module[name];
+        if (typeof real === "function" && !libavjsStats.functions[name])
+            Module[name] = libavjsStatsWrap(name, real);
+    }
+};
+
+/* Get the instrumentation statistics, and optionally reset them. Only
+ * functions that have been called are included. Used by the frontend. */
+Module.libavjsStatsGet = function(reset) {
+    if (!libavjsStats)
+        return null;
+    var ret = {functions: {}, heap: Object.assign({}, libavjsStats.heap)};
+    for (var name in libavjsStats.functions) {
+        var st = libavjsStats.functions[name];
+        if (!st.calls)
+            continue;
+        ret.functions[name] = Object.assign({}, st);
+        if (reset) {
+            st.calls = st.time = st.max_time = st.bytes_in = st.bytes_out =
+                st.transfers = 0;
+        }
+    }
+    if (reset) {
+        var heap = libavjsStats.heap;
+        heap.max_used = heap.used;
+        heap.max_size = heap.size;
+    }
+    return ret;
+};
+
+/* Functions to reset the state of each component, run by ff_reset (below)
+ * after closing every file, but before restoring the heap. Components add to
+ * this. */
+var ff_reset_hooks = [function() {
+    snapshotBuffers = {};
+    Module.fsThrownError = null;
+}];
+
+/* The heap as it was when the runtime finished initializing, up to the heap
+ * top, restored by ff_reset */
+var heapSnapshot = null;
+
+(Module.postRun = Module.postRun || []).push(function() {
+    heapSnapshot = Module.HEAPU8.slice(0, ff_heap_top());
+});
+
+/* Reset libav.js to the state it was in when it started: close every open
+ * file, run the reset hooks (removing devices, and forgetting JS state that
+ * refers to the heap), and restore the heap. Restoring the heap frees everything
+ * that was allocated since, so pointers from before are invalid. Nothing else
+ * may be running, including any thread. Used by ff_reset, and in the threads
+ * mode, by the frontend, on the main thread, once it has stopped every other
+ * thread. */
+Module.libavjsReset = function() {
+    if (!heapSnapshot)
+        throw new Error("libav.js has not finished starting");
+    /* With JSPI, a suspended call leaves no Asyncify data, but any call that
+     * may suspend is serialized */
+    if ((typeof Asyncify !== "undefined" && Asyncify.currData) ||
+        serializationPromise)
+        throw new Error("Cannot reset while a call is in progress");
+
+    /* Close everything but stdin, stdout, and stderr, which also flushes
+     * buffered writers */
+    for (var fd = 3; fd < FS.streams.length; fd++) {
+        var stream = FS.streams[fd];
+        if (stream) {
+            try {
+                FS.close(stream);
+            } catch (ex) {
+                console.error(ex);
+            }
+        }
+    }
+
+    for (var i = 0; i < ff_reset_hooks.length; i++)
+        ff_reset_hooks[i]();
+
+    var top = ff_heap_top();
+    var heap = Module.HEAPU8;
+    heap.set(heapSnapshot);
+    if (top > heapSnapshot.length)
+        heap.fill(0, heapSnapshot.length, top);
+};
+
+/**
+ * Reset this instance to a clean state, as if it had just been created, which
+ * is much faster than creating a new instance. Everything allocated in libav
+ * (contexts, frames, packets, etc.) is freed, all device files (reader,
+ * block reader, readahead, writer, FileSystemFileHandle, and workerfs files)
+ * are removed, and every open file is closed. Other files in the in-memory
+ * filesystem are kept. No other calls may be in progress.
+ */
+/// @types ff_reset@sync(): @promise@void@
+var ff_reset = Module.ff_reset = function() {
+    if (typeof ENVIRONMENT_IS_PTHREAD !== "undefined" && ENVIRONMENT_IS_PTHREAD)
+        throw new Error("ff_reset must be called through the frontend");
+    if (typeof PThread !== "undefined" && PThread.runningWorkers.length)
+        throw new Error("Cannot reset while threads are running");
+    Module.libavjsReset();
+};
+
 @FUNCS
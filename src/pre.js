@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2019-2024 Yahweasel and contributors
+ * Copyright (C) 2019-2025 Yahweasel and contributors
  *
  * Permission to use, copy, modify, and/or distribute this software for any
  * purpose with or without fee is hereby granted.
@@ -35,3 +35,21 @@ Module.locateFile = function(path, prefix) {
     // Otherwise, use the default
     return prefix + path;
 }
+
+/* Number of threads to start with the threaded build (PTHREAD_POOL_SIZE in the
+ * Makefile). By default, one per core, plus one for libav.js itself. */
+if (typeof Module.pthreadPoolSize !== "number") {
+    Module.pthreadPoolSize = 1 + (
+        (typeof navigator !== "undefined" && navigator.hardwareConcurrency) ||
+        4);
+}
+
+// Instantiate a precompiled module, if we were given one
+if (Module.wasmmodule) {
+    Module.instantiateWasm = function(imports, successCallback) {
+        WebAssembly.instantiate(Module.wasmmodule, imports).then(function(instance) {
+            successCallback(instance, Module.wasmmodule);
+        }).catch(abort);
+        return {};
+    };
+}
@@ -28,16 +28,17 @@ LibAVTestHarness = {
     libAVOpts: null,
     libav: null,
 
-    loadTests: async function(list) {
+    loadTests: async function(list, dir) {
         const AsyncFunction = (async function(){}).constructor;
+        dir = dir || "tests";
 
         this.tests = [];
         for (const test of list) {
             let js;
             if (typeof process !== "undefined") {
-                js = await fs.readFile(`tests/${test}`, "utf8");
+                js = await fs.readFile(`${dir}/${test}`, "utf8");
             } else {
-                const resp = await fetch(`tests/${test}`);
+                const resp = await fetch(`${dir}/${test}`);
                 const ab = await resp.arrayBuffer();
                 const tdec = new TextDecoder();
                 js = tdec.decode(new Uint8Array(ab));
@@ -72,7 +73,7 @@ LibAVTestHarness = {
     LibAV: async function(opts, variant) {
         if (typeof LibAV === "undefined") {
             // Load a variant
-            const toImport = `../dist/libav-all.dbg.` +
+            const toImport = this.options.toImport || `../dist/libav-all.dbg.` +
                 "mjs";
             LibAV = (await import(toImport)).default;
 
@@ -1,6 +1,6 @@
 #!/usr/bin/env node
 /*
- * Copyright (C) 2023, 2024 Yahweasel and contributors
+ * Copyright (C) 2023-2025 Yahweasel and contributors
  *
  * Permission to use, copy, modify, and/or distribute this software for any
  * purpose with or without fee is hereby granted.
@@ -25,12 +25,32 @@ for (const arg of process.argv.slice(2)) {
             options.coverage = true;
             break;
 
+        case "--jspi":
+            options.jspi = true;
+            break;
+
         default:
             console.error(`Unrecognized argument ${arg}`);
             process.exit(1);
     }
 }
 
+/* With --jspi, if JSPI isn't enabled but this version of Node supports it
+ * behind a flag, rerun with the flag */
+if (options.jspi) {
+    delete options.jspi;
+    const cp = require("child_process");
+    const flag = "--experimental-wasm-jspi";
+    if (typeof WebAssembly.Suspending !== "function" &&
+        cp.spawnSync(process.execPath, [flag, "-e", "0"]).status === 0) {
+        const child = cp.spawnSync(process.execPath,
+            [flag, __filename].concat(
+                process.argv.slice(2).filter(x => x !== "--jspi")),
+            {stdio: "inherit"});
+        process.exit(child.status === null ? 1 : child.status);
+    }
+}
+
 const harness = require("./harness.js");
 Object.assign(harness.options, options);
 async function main() {
@@ -38,8 +58,12 @@ async function main() {
         process.stderr.write("\x1b[K" + x + "\r");
     };
     await harness.loadTests(require("./suite.json"));
+    // With JSPI, also test the JSPI build
+    const jspi = typeof WebAssembly.Suspending === "function";
     process.exit(await harness.runTests([
         null,
+        ...(jspi ? [{yesjspi: true}] : []),
+        {nosimd: true},
         {nowasm: true}
     ]) ? 1 : 0);
 }
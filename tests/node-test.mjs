@@ -41,7 +41,11 @@ harness.printStatus = x => {
     process.stderr.write("\x1b[K" + x + "\r");
 };
 await harness.loadTests(JSON.parse(await fs.readFile("./suite.json", "utf8")));
+// With JSPI, also test the JSPI build
+const jspi = typeof WebAssembly.Suspending === "function";
 process.exit(await harness.runTests([
     null,
+    ...(jspi ? [{yesjspi: true}] : []),
+    {nosimd: true},
     {nowasm: true}
 ]) ? 1 : 0);
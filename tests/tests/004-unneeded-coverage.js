@@ -38,7 +38,7 @@ if (h.data.coverage) {
         "AVCodecContext_sample_aspect_ratio_s", "AVStream_time_base_s",
         "AVPacketSideData_data", "AVPacketSideData_size",
         "AVPacketSideData_type", "ff_nothing", "calloc", "free", "malloc",
-        "mallinfo_uordblks", "libavjs_with_swscale",
+        "mallinfo_uordblks", "ff_heap_top", "libavjs_with_swscale",
         "libavjs_create_main_thread", "ffmpeg_main", "ffprobe_main", "ff_error",
         "ff_set_packet", "ff_malloc_int32_list", "ff_malloc_int64_list",
 
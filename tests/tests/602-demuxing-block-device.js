@@ -21,8 +21,16 @@ const buf = await h.readCachedFile("bbb.webm");
 let rd = 0;
 await libav.mkblockreaderdev("tmp.webm", buf.length);
 
+/* Blocks are cached, so nothing that's been sent should ever be asked for
+ * again */
+const sent = [];
 const origOnBlockRead = libav.onblockread;
 libav.onblockread = function(name, position, length) {
+    for (const [start, end] of sent) {
+        if (position >= start && position < end)
+            throw new Error(`Read of ${position} wasn't served from the cache`);
+    }
+    sent.push([position, position + length]);
     libav.ff_block_reader_dev_send(name, position, buf.slice(position, position + length));
 };
 
@@ -69,6 +77,10 @@ const frames = await libav.ff_decode_multi(c, pkt, frame, packets, true);
 await libav.ff_free_decoder(c, pkt, frame);
 await libav.avformat_close_input_js(fmt_ctx);
 
+const stats = await libav.ff_block_reader_dev_stats("tmp.webm");
+if (stats.misses < sent.length || !stats.hits)
+    throw new Error(`Unexpected cache statistics ${JSON.stringify(stats)}`);
+
 await libav.unlink("tmp.webm");
 if (origOnBlockRead)
     libav.onblockread = origOnBlockRead;
@@ -15,12 +15,13 @@
 
 // Muxing to a device
 
-async function main() {
-    const libav = await h.LibAV();
+// Mux to a device, giving the output and the number of onwrite calls
+async function mux(libav, deviceOpts) {
     let output = new Uint8Array(0);
+    let calls = 0;
 
-    let oldOnWrite = libav.onwrite;
     libav.onwrite = function(name, pos, buf) {
+        calls++;
         let newLen = pos + buf.length;
         if (output.length < newLen) {
             let newOutput = new Uint8Array(newLen);
@@ -43,7 +44,12 @@ async function main() {
         });
 
     const [oc, fmt, pb, [st]] = await libav.ff_init_muxer(
-        {filename: "tmp.ogg", open: true, device: true}, [[c, 1, 48000]]);
+        {filename: "tmp.ogg", open: true, device: true, deviceOpts},
+        [[c, 1, 48000]]);
+
+    // Bitexact, so that the Ogg serial number is the same for both runs
+    await libav.AVFormatContext_flags_s(oc,
+        (await libav.AVFormatContext_flags(oc)) | 0x400 /* BITEXACT */);
 
     await libav.avformat_write_header(oc, 0)
 
@@ -80,6 +86,29 @@ async function main() {
     await libav.ff_free_encoder(c, frame, pkt);
 
     await libav.unlink("tmp.ogg");
+    return {output, calls};
+}
+
+async function main() {
+    const libav = await h.LibAV();
+    let oldOnWrite = libav.onwrite;
+
+    const unbuffered = await mux(libav);
+
+    // Buffered writes should be merged into far fewer calls, with the same data
+    const buffered = await mux(libav, {bufferSize: 65536, flushTime: 0});
+    if (buffered.calls >= unbuffered.calls) {
+        throw new Error(
+            `Buffered writer made ${buffered.calls} onwrite calls, ` +
+            `unbuffered ${unbuffered.calls}`);
+    }
+    if (buffered.output.length !== unbuffered.output.length)
+        throw new Error("Buffered writer wrote a different amount of data");
+    for (let i = 0; i < buffered.output.length; i++) {
+        if (buffered.output[i] !== unbuffered.output[i])
+            throw new Error(`Buffered writer's output differs at ${i}`);
+    }
+
     if (oldOnWrite)
         libav.onwrite = oldOnWrite;
     else
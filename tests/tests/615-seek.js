@@ -62,3 +62,10 @@ await testSeek(3 * 60, 4 * 60, "av_seek_frame");
 
 await libav.av_packet_free_js(pkt);
 await libav.avformat_close_input_js(fmt_ctx);
+
+/* Seeking back and forth is served by the readahead file's cache, so no part of
+ * the file should have been read twice */
+const size = (await h.readCachedFile("bitrate.webm")).length;
+const stats = await libav.ff_block_reader_dev_stats("bitrate.webm");
+if (stats.fetched > size || stats.evictions || !stats.hits)
+    throw new Error(`Unexpected cache statistics ${JSON.stringify(stats)}`);
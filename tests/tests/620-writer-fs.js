@@ -22,21 +22,6 @@ const libav = await h.LibAV();
 
 const oldOnWrite = libav.onwrite;
 
-// Collect all the file data
-const files = Object.create(null);
-libav.onwrite = function(name, pos, buf) {
-    buf = new Uint8Array(buf.slice(0).buffer);
-    if (!files[name])
-        files[name] = new Uint8Array(0);
-    let file = files[name];
-    if (file.length < pos + buf.length) {
-        const newFile = new Uint8Array(pos + buf.length);
-        newFile.set(file);
-        files[name] = file = newFile;
-    }
-    file.set(buf, pos);
-};
-
 // Get a shorter file
 await libav.ffmpeg(
     "-nostdin", "-loglevel", "quiet",
@@ -45,13 +30,48 @@ await libav.ffmpeg(
     "tmp.webm"
 );
 
-// Convert to a sequence of JPEGs
-await libav.mountwriterfs("/wfs");
-await libav.ffmpeg(
-    "-nostdin", "-loglevel", "quiet",
-    "-i", "tmp.webm", "/wfs/%06d.png"
-);
-await libav.unmount("/wfs");
+// Convert to a sequence of PNGs in a writer filesystem, collecting all the file
+// data, and counting onwrite calls
+async function convert(opts) {
+    const files = Object.create(null);
+    let calls = 0;
+    libav.onwrite = function(name, pos, buf) {
+        calls++;
+        buf = new Uint8Array(buf.slice(0).buffer);
+        if (!files[name])
+            files[name] = new Uint8Array(0);
+        let file = files[name];
+        if (file.length < pos + buf.length) {
+            const newFile = new Uint8Array(pos + buf.length);
+            newFile.set(file);
+            files[name] = file = newFile;
+        }
+        file.set(buf, pos);
+    };
+
+    await libav.mountwriterfs("/wfs", opts);
+    await libav.ffmpeg(
+        "-nostdin", "-loglevel", "quiet",
+        "-i", "tmp.webm", "/wfs/%06d.png"
+    );
+    await libav.unmount("/wfs");
+    return {files, calls};
+}
+
+const {files, calls} = await convert();
+
+// Buffered, each file should be written in far fewer calls, identically
+const buffered = await convert({bufferSize: 1024 * 1024, flushTime: 0});
+if (buffered.calls >= calls) {
+    throw new Error(
+        `Buffered writer filesystem made ${buffered.calls} onwrite calls, ` +
+        `unbuffered ${calls}`);
+}
+for (const name in files) {
+    const a = files[name], b = buffered.files[name];
+    if (!b || a.length !== b.length || a.some((x, i) => x !== b[i]))
+        throw new Error(`Buffered writer filesystem wrote ${name} differently`);
+}
 
 // Then write them
 for (const name in files)
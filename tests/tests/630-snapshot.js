@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Check that snapshot-based copyout and copyin agree with the field accessors
+
+const libav = await h.LibAV();
+
+function compare(what, a, b) {
+    for (const key in b) {
+        if (a[key] !== b[key])
+            throw new Error(`${what} ${key} mismatch: ${a[key]} !== ${b[key]}`);
+    }
+}
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+let stream = null;
+for (const s of streams) {
+    if (s.codec_type === libav.AVMEDIA_TYPE_AUDIO) {
+        stream = s;
+        break;
+    }
+}
+if (!stream)
+    throw new Error("Could not find audio track");
+
+// Streams
+compare("Stream", stream, {
+    codecpar: await libav.AVStream_codecpar(stream.ptr),
+    time_base_num: await libav.AVStream_time_base_num(stream.ptr),
+    time_base_den: await libav.AVStream_time_base_den(stream.ptr)
+});
+
+// Codec parameters
+const codecpar = await libav.ff_copyout_codecpar(stream.codecpar);
+compare("Codec parameters", codecpar, {
+    codec_id: await libav.AVCodecParameters_codec_id(stream.codecpar),
+    codec_type: await libav.AVCodecParameters_codec_type(stream.codecpar),
+    sample_rate: await libav.AVCodecParameters_sample_rate(stream.codecpar),
+    channels: await libav.AVCodecParameters_channels(stream.codecpar),
+    format: await libav.AVCodecParameters_format(stream.codecpar)
+});
+
+const [, c, pkt, frame] = await libav.ff_init_decoder(
+    stream.codec_id, stream.codecpar);
+const [res, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt, {
+    copyoutPacket: "ptr"
+});
+if (res !== libav.AVERROR_EOF)
+    throw new Error("Failed to read packets");
+await libav.avformat_close_input_js(fmt_ctx);
+
+// The snapshot record should be versioned
+{
+    const snap = await libav.malloc(64 * 4);
+    await libav.ff_packet_snapshot(packets[stream.index][0], snap);
+    const rec = await libav.copyout_s32(snap, 2);
+    await libav.free(snap);
+    if (rec[0] !== 1)
+        throw new Error(`Unexpected packet snapshot version ${rec[0]}`);
+}
+
+// Packets
+for (const p of packets[stream.index]) {
+    const packet = await libav.ff_copyout_packet(p);
+    compare("Packet", packet, {
+        pts: await libav.AVPacket_pts(p),
+        ptshi: await libav.AVPacket_ptshi(p),
+        dts: await libav.AVPacket_dts(p),
+        dtshi: await libav.AVPacket_dtshi(p),
+        duration: await libav.AVPacket_duration(p),
+        durationhi: await libav.AVPacket_durationhi(p),
+        stream_index: await libav.AVPacket_stream_index(p),
+        flags: await libav.AVPacket_flags(p),
+        time_base_num: await libav.AVPacket_time_base_num(p),
+        time_base_den: await libav.AVPacket_time_base_den(p)
+    });
+    if (packet.data.length !== await libav.AVPacket_size(p))
+        throw new Error("Packet size mismatch");
+
+    // And round trip it
+    await libav.ff_copyin_packet(pkt, packet);
+    compare("Copied-in packet", await libav.ff_copyout_packet(pkt), {
+        pts: packet.pts, ptshi: packet.ptshi,
+        dts: packet.dts, dtshi: packet.dtshi,
+        duration: packet.duration,
+        stream_index: packet.stream_index,
+        flags: packet.flags
+    });
+    await libav.av_packet_unref(pkt);
+}
+
+// Frames
+const frames = await libav.ff_decode_multi(
+    c, pkt, frame, packets[stream.index], {
+        fin: true,
+        copyoutFrame: "ptr"
+    });
+if (!frames.length)
+    throw new Error("No frames decoded");
+for (const f of frames) {
+    const outFrame = await libav.ff_copyout_frame(f);
+    compare("Frame", outFrame, {
+        format: await libav.AVFrame_format(f),
+        nb_samples: await libav.AVFrame_nb_samples(f),
+        sample_rate: await libav.AVFrame_sample_rate(f),
+        channels: await libav.AVFrame_channels(f),
+        channel_layout: await libav.AVFrame_channel_layout(f),
+        pts: await libav.AVFrame_pts(f),
+        ptshi: await libav.AVFrame_ptshi(f),
+        time_base_num: await libav.AVFrame_time_base_num(f),
+        time_base_den: await libav.AVFrame_time_base_den(f)
+    });
+
+    // Round trip it through copyin
+    await libav.av_frame_unref(frame);
+    await libav.ff_copyin_frame(frame, outFrame);
+    const rtFrame = await libav.ff_copyout_frame(frame);
+    compare("Copied-in frame", rtFrame, {
+        format: outFrame.format,
+        nb_samples: outFrame.nb_samples,
+        sample_rate: outFrame.sample_rate,
+        channels: outFrame.channels,
+        channel_layout: outFrame.channel_layout,
+        pts: outFrame.pts,
+        ptshi: outFrame.ptshi
+    });
+    for (let ci = 0; ci < outFrame.data.length; ci++) {
+        const a = outFrame.data[ci], b = rtFrame.data[ci];
+        for (let i = 0; i < a.length; i++) {
+            if (a[i] !== b[i])
+                throw new Error("Copied-in frame data mismatch");
+        }
+    }
+
+    await libav.av_frame_free_js(f);
+}
+
+await libav.ff_free_decoder(c, pkt, frame);
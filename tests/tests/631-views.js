@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Read, decode, and filter using views into the heap instead of copies
+
+const libav = await h.LibAV();
+
+// Views are only available in the same thread
+if (libav.libavjsMode !== "direct")
+    return;
+
+function sameData(what, a, b) {
+    if (!(a instanceof Array)) {
+        a = [a];
+        b = [b];
+    }
+    if (a.length !== b.length)
+        throw new Error(`${what} plane count mismatch`);
+    for (let p = 0; p < a.length; p++) {
+        if (a[p].length !== b[p].length)
+            throw new Error(`${what} length mismatch`);
+        for (let i = 0; i < a[p].length; i++) {
+            if (a[p][i] !== b[p][i])
+                throw new Error(`${what} data mismatch`);
+        }
+    }
+}
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+let streamIdx = -1;
+for (let i = 0; i < streams.length; i++) {
+    if (streams[i].codec_type === libav.AVMEDIA_TYPE_AUDIO) {
+        streamIdx = i;
+        break;
+    }
+}
+if (streamIdx < 0)
+    throw new Error("Could not find audio track");
+
+const [, c, pkt, frame] = await libav.ff_init_decoder(
+    "libopus", streams[streamIdx].codecpar);
+await libav.AVCodecContext_sample_fmt_s(c, libav.AV_SAMPLE_FMT_FLT);
+const [res, allPackets] = await libav.ff_read_frame_multi(fmt_ctx, pkt, {
+    copyoutPacket: "view"
+});
+if (res !== libav.AVERROR_EOF)
+    throw new Error("Failed to read packets");
+await libav.avformat_close_input_js(fmt_ctx);
+
+// Release the packets we won't use
+for (const idx in allPackets) {
+    if (+idx !== streamIdx)
+        allPackets[idx].forEach(p => p.release());
+}
+const packets = allPackets[streamIdx];
+if (!packets || !packets.length)
+    throw new Error("No packets found for the appropriate stream");
+
+// The views should show the same data as a copy
+for (const p of packets) {
+    if (typeof p.ptr !== "number" || typeof p.release !== "function")
+        throw new Error("copyoutPacket view didn't return a view!");
+    sameData("Packet", p.data, (await libav.ff_copyout_packet(p.ptr)).data);
+}
+
+// Decode them, as views
+const frames = await libav.ff_decode_multi(c, pkt, frame, packets, {
+    fin: true,
+    copyoutFrame: "view"
+});
+if (!frames.length)
+    throw new Error("No frames decoded");
+const copies = [];
+for (const f of frames) {
+    const copy = await libav.ff_copyout_frame(f.ptr);
+    sameData("Frame", f.data, copy.data);
+    copies.push(copy);
+}
+
+// Grow the heap, and make sure the views survive
+const big = await libav.malloc(64 * 1024 * 1024);
+if (!big)
+    throw new Error("Failed to grow the heap");
+await libav.free(big);
+for (let i = 0; i < frames.length; i++)
+    sameData("Frame after heap growth", frames[i].data, copies[i].data);
+
+// Filter the views, as views
+const [filter_graph, buffersrc_ctx, buffersink_ctx] =
+    await libav.ff_init_filter_graph("anull", {
+        sample_rate: 48000,
+        sample_fmt: libav.AV_SAMPLE_FMT_FLT,
+        channel_layout: 3
+    }, {
+        sample_rate: 48000,
+        sample_fmt: libav.AV_SAMPLE_FMT_FLT,
+        channel_layout: 3
+    });
+const filterFrames = await libav.ff_filter_multi(
+    buffersrc_ctx, buffersink_ctx, frame, frames, {
+        fin: true,
+        copyoutFrame: "view"
+    });
+await libav.avfilter_graph_free_js(filter_graph);
+await libav.ff_free_decoder(c, pkt, frame);
+
+// Copying in a view shouldn't have released it
+sameData("Frame after filtering", frames[0].data, copies[0].data);
+
+// Check for correctness
+await h.utils.compareAudio("bbb.webm", filterFrames);
+
+// Release everything, after which the views shouldn't be usable
+for (const x of packets.concat(frames, filterFrames))
+    x.release();
+let threw = false;
+try {
+    frames[0].data;
+} catch (ex) {
+    threw = true;
+}
+if (!threw)
+    throw new Error("Frame view usable after release");
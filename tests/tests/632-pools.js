@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Read and decode with frames and packets from pools
+
+const libav = await h.LibAV();
+
+const framePool = await libav.ff_frame_pool_alloc();
+const packetPool = await libav.ff_packet_pool_alloc();
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+let streamIdx = -1;
+for (let i = 0; i < streams.length; i++) {
+    if (streams[i].codec_type === libav.AVMEDIA_TYPE_AUDIO) {
+        streamIdx = i;
+        break;
+    }
+}
+if (streamIdx < 0)
+    throw new Error("Could not find audio track");
+
+const [, c, pkt, frame] = await libav.ff_init_decoder(
+    "libopus", streams[streamIdx].codecpar);
+await libav.AVCodecContext_sample_fmt_s(c, libav.AV_SAMPLE_FMT_FLT);
+
+// Read and decode a bit at a time, so that the pools get reused
+const frames = [];
+while (true) {
+    const [res, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt, {
+        limit: 4096,
+        copyoutPacket: "ptr",
+        packetPool
+    });
+    for (const idx in packets) {
+        if (+idx !== streamIdx)
+            await libav.ff_packet_pool_release_multi(packetPool, packets[idx]);
+    }
+
+    const fin = (res === libav.AVERROR_EOF);
+    const framePtrs = await libav.ff_decode_multi(
+        c, pkt, frame, packets[streamIdx] || [], {
+            fin,
+            copyoutFrame: "ptr",
+            framePool,
+            packetPool
+        });
+    for (const f of framePtrs)
+        frames.push(await libav.ff_copyout_frame(f));
+    await libav.ff_frame_pool_release_multi(framePool, framePtrs);
+
+    if (fin)
+        break;
+    if (res !== -libav.EAGAIN)
+        throw new Error("Failed to read packets");
+}
+await libav.avformat_close_input_js(fmt_ctx);
+
+for (const [name, stats] of [
+    ["Packet", await libav.ff_packet_pool_get_stats(packetPool)],
+    ["Frame", await libav.ff_frame_pool_get_stats(framePool)]
+]) {
+    if (stats.in_use !== 0)
+        throw new Error(`${name} pool leaked ${stats.in_use} objects`);
+    if (!stats.reused)
+        throw new Error(`${name} pool wasn't reused (${JSON.stringify(stats)})`);
+    if (stats.free !== stats.allocated)
+        throw new Error(`${name} pool lost objects (${JSON.stringify(stats)})`);
+}
+
+await h.utils.compareAudio("bbb.webm", frames);
+
+// Copy frames in with buffers from the pool
+for (const f of frames.slice(0, 16)) {
+    await libav.av_frame_unref(frame);
+    await libav.ff_copyin_frame(frame, f, framePool);
+    const rt = await libav.ff_copyout_frame(frame);
+    for (let i = 0; i < f.data.length; i++) {
+        if (rt.data[i] !== f.data[i])
+            throw new Error("Pooled copyin data mismatch");
+    }
+}
+await libav.av_frame_unref(frame);
+{
+    const stats = await libav.ff_frame_pool_get_stats(framePool);
+    if (stats.buffers < 16)
+        throw new Error("Pooled copyin didn't use the pool's buffers");
+    if (stats.buffer_pools > 8)
+        throw new Error("Too many buffer pools created");
+}
+
+// Frames not reached when encoding fails partway through go back to the pool
+{
+    const [, c, frame, pkt, frameSize] =
+        await libav.ff_init_encoder("libopus", {
+            ctx: {
+                bit_rate: 128000,
+                sample_fmt: libav.AV_SAMPLE_FMT_FLT,
+                sample_rate: 48000,
+                channel_layout: 4
+            },
+            time_base: [1, 48000]
+        });
+    // The second frame is too large, so the encoder rejects it
+    const frames = [1, 2, 1, 1].map((n, i) => ({
+        data: new Float32Array(frameSize * n),
+        channel_layout: 4,
+        format: libav.AV_SAMPLE_FMT_FLT,
+        pts: i * frameSize,
+        sample_rate: 48000
+    }));
+    let threw = false;
+    try {
+        await libav.ff_encode_multi(c, frame, pkt, frames, {framePool});
+    } catch (ex) {
+        threw = true;
+    }
+    if (!threw)
+        throw new Error("Encoding an oversized frame didn't fail");
+    const stats = await libav.ff_frame_pool_get_stats(framePool);
+    if (stats.in_use !== 0)
+        throw new Error(`Failed encode leaked ${stats.in_use} frames`);
+    await libav.ff_free_encoder(c, frame, pkt);
+}
+
+await libav.ff_free_decoder(c, pkt, frame);
+await libav.ff_frame_pool_free(framePool);
+await libav.ff_packet_pool_free(packetPool);
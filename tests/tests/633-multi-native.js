@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Edge cases of the natively-driven multi functions
+
+const libav = await h.LibAV();
+
+const framePool = await libav.ff_frame_pool_alloc();
+const packetPool = await libav.ff_packet_pool_alloc();
+
+const [, c, frame, pkt, frame_size] =
+    await libav.ff_init_encoder("libopus", {
+        ctx: {
+            bit_rate: 128000,
+            sample_fmt: libav.AV_SAMPLE_FMT_FLT,
+            sample_rate: 48000,
+            channel_layout: 4,
+            channels: 1
+        },
+        time_base: [1, 48000]
+    });
+
+// Make a tone, half as objects and half as pointers from the pool
+let t = 0;
+const tincr = 2 * Math.PI * 440 / 48000;
+const frames = [];
+for (let i = 0; i < 100; i++) {
+    const samples = new Float32Array(frame_size);
+    for (let j = 0; j < frame_size; j++) {
+        samples[j] = Math.sin(t);
+        t += tincr;
+    }
+    const f = {
+        data: samples,
+        channel_layout: 4,
+        format: libav.AV_SAMPLE_FMT_FLT,
+        pts: i * frame_size,
+        sample_rate: 48000
+    };
+    if (i % 2) {
+        const ptr = await libav.ff_frame_pool_acquire(framePool);
+        await libav.ff_copyin_frame(ptr, f);
+        frames.push(ptr);
+    } else {
+        frames.push(f);
+    }
+}
+
+// Encode them in a few batches, as pointers
+let packets = [];
+for (let i = 0; i < frames.length; i += 30) {
+    const fin = (i + 30 >= frames.length);
+    packets = packets.concat(await libav.ff_encode_multi(
+        c, frame, pkt, frames.slice(i, i + 30), {
+            fin,
+            copyoutPacket: "ptr",
+            framePool,
+            packetPool
+        }));
+}
+await libav.ff_free_encoder(c, frame, pkt);
+if (packets.length < frames.length)
+    throw new Error(`Only ${packets.length} packets for ${frames.length} frames`);
+
+{
+    // All the input frames were consumed, and all the packets are ours
+    const fstats = await libav.ff_frame_pool_get_stats(framePool);
+    if (fstats.in_use !== 0)
+        throw new Error(`Encoding leaked ${fstats.in_use} frames`);
+    const pstats = await libav.ff_packet_pool_get_stats(packetPool);
+    if (pstats.in_use !== packets.length)
+        throw new Error(`${pstats.in_use} packets in use, expected ${packets.length}`);
+}
+
+// The timestamps should be in order
+let lastPts = -Infinity;
+for (const p of packets) {
+    const copy = await libav.ff_copyout_packet(p);
+    if (copy.pts <= lastPts)
+        throw new Error("Packet timestamps out of order");
+    lastPts = copy.pts;
+}
+
+// Decode them, with some garbage in the middle
+const garbage = {data: new Uint8Array(64).fill(0xFF)};
+const dpackets = packets.slice(0, 50).concat([garbage], packets.slice(50));
+{
+    const [, c, pkt, frame] = await libav.ff_init_decoder("libopus");
+    const outFrames = await libav.ff_decode_multi(c, pkt, frame, dpackets, {
+        fin: true,
+        ignoreErrors: true,
+        packetPool
+    });
+    await libav.ff_free_decoder(c, pkt, frame);
+    if (outFrames.length < frames.length)
+        throw new Error(`Only ${outFrames.length} frames decoded from ${frames.length}`);
+    for (const f of outFrames) {
+        if (f.nb_samples !== frame_size)
+            throw new Error("Unexpected decoded frame");
+    }
+}
+
+{
+    const pstats = await libav.ff_packet_pool_get_stats(packetPool);
+    if (pstats.in_use !== 0)
+        throw new Error(`Decoding leaked ${pstats.in_use} packets`);
+}
+
+await libav.ff_frame_pool_free(framePool);
+await libav.ff_packet_pool_free(packetPool);
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Calls through the shared-memory ring transport of the threads mode
+
+/* A small ring, so that some calls and results don't fit and have to be
+ * posted, and still need to be in order */
+const opts = {yesthreads: true, ring: 4096};
+if (h.libAVOpts) Object.assign(opts, h.libAVOpts);
+const libav = await h.LibAV(opts);
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+let streamIdx = -1;
+for (let i = 0; i < streams.length; i++) {
+    if (streams[i].codec_type === libav.AVMEDIA_TYPE_AUDIO) {
+        streamIdx = i;
+        break;
+    }
+}
+if (streamIdx < 0)
+    throw new Error("Could not find audio track");
+
+const [, c, pkt, frame] = await libav.ff_init_decoder(
+    streams[streamIdx].codec_id, streams[streamIdx].codecpar);
+await libav.AVCodecContext_sample_fmt_s(c, libav.AV_SAMPLE_FMT_FLT);
+
+const [res, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt);
+if (res !== libav.AVERROR_EOF)
+    throw new Error("Failed to read packets");
+await libav.avformat_close_input_js(fmt_ctx);
+
+// Decode one packet per call, with all of the calls in flight at once
+const ps = packets[streamIdx].map(
+    p => libav.ff_decode_multi(c, pkt, frame, [p]));
+ps.push(libav.ff_decode_multi(c, pkt, frame, [], true));
+const frames = [].concat(...(await Promise.all(ps)));
+await libav.ff_free_decoder(c, pkt, frame);
+
+await h.utils.compareAudio("bbb.webm", frames);
+
+// Simple results and errors should be passed back too
+const small = await libav.av_get_bytes_per_sample(libav.AV_SAMPLE_FMT_FLT);
+if (small !== 4)
+    throw new Error(`av_get_bytes_per_sample gave ${small}`);
+let threw = false;
+try {
+    await libav.ff_init_decoder("not a codec");
+} catch (ex) {
+    threw = true;
+}
+if (!threw)
+    throw new Error("Error not passed back");
+
+libav.terminate();
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Read, decode, and filter in a single batched call
+
+const libav = await h.LibAV();
+const ref = libav.ff_batch_ref;
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+let streamIdx = -1;
+for (let i = 0; i < streams.length; i++) {
+    if (streams[i].codec_type === libav.AVMEDIA_TYPE_AUDIO) {
+        streamIdx = i;
+        break;
+    }
+}
+if (streamIdx < 0)
+    throw new Error("Could not find audio track");
+
+const [, c, pkt, frame] = await libav.ff_init_decoder(
+    "libopus", streams[streamIdx].codecpar);
+await libav.AVCodecContext_sample_fmt_s(c, libav.AV_SAMPLE_FMT_FLT);
+
+const [filter_graph, buffersrc_ctx, buffersink_ctx] =
+    await libav.ff_init_filter_graph("anull", {
+        sample_rate: 48000,
+        sample_fmt: libav.AV_SAMPLE_FMT_FLT,
+        channel_layout: 3
+    }, {
+        sample_rate: 48000,
+        sample_fmt: libav.AV_SAMPLE_FMT_FLT,
+        channel_layout: 3
+    });
+
+const {res, frames} = await libav.ff_batch([
+    ["ff_read_frame_multi", fmt_ctx, pkt],
+    ["ff_decode_multi", c, pkt, frame, ref(0, 1, streamIdx), {
+        fin: true,
+        copyoutFrame: "ptr"
+    }],
+    ["ff_filter_multi", buffersrc_ctx, buffersink_ctx, frame, ref(1), true]
+], {res: ref(0, 0), frames: ref(2)});
+
+if (res !== libav.AVERROR_EOF)
+    throw new Error("Failed to read packets");
+await h.utils.compareAudio("bbb.webm", frames);
+
+// By default, just the last result comes back
+const closed = await libav.ff_batch([
+    ["avfilter_graph_free_js", filter_graph],
+    ["avformat_close_input_js", fmt_ctx],
+    ["av_get_bytes_per_sample", libav.AV_SAMPLE_FMT_FLT]
+]);
+if (closed !== 4)
+    throw new Error(`Batch returned ${closed} instead of its last result`);
+
+// Failures name the failed call
+let threw = false;
+try {
+    await libav.ff_batch([
+        ["av_get_bytes_per_sample", libav.AV_SAMPLE_FMT_FLT],
+        ["ff_init_decoder", "not a codec"]
+    ]);
+} catch (ex) {
+    threw = true;
+    if (!/ff_init_decoder/.test("" + (ex.message || ex)))
+        throw new Error(`Unexpected error ${ex}`);
+}
+if (!threw)
+    throw new Error("Batch didn't fail");
+
+// And free the pointers that earlier calls returned
+{
+    const [fmt_ctx] = await libav.ff_init_demuxer_file("bbb.webm");
+    const packetPool = await libav.ff_packet_pool_alloc();
+    let threw = false;
+    try {
+        await libav.ff_batch([
+            ["ff_read_frame_multi", fmt_ctx, pkt, {
+                limit: 65536,
+                copyoutPacket: "ptr",
+                packetPool
+            }],
+            ["ff_init_decoder", "not a codec"]
+        ]);
+    } catch (ex) {
+        threw = true;
+    }
+    if (!threw)
+        throw new Error("Batch didn't fail");
+    const stats = await libav.ff_packet_pool_get_stats(packetPool);
+    if (!stats.allocated)
+        throw new Error("Batch didn't read any packets");
+    if (stats.in_use !== 0)
+        throw new Error(`Failed batch leaked ${stats.in_use} packets`);
+    await libav.avformat_close_input_js(fmt_ctx);
+    await libav.ff_packet_pool_free(packetPool);
+}
+
+await libav.ff_free_decoder(c, pkt, frame);
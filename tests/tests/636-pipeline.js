@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Transcoding and copying with native pipelines
+
+const libav = await h.LibAV();
+
+function audioIndex(streams) {
+    for (let i = 0; i < streams.length; i++) {
+        if (streams[i].codec_type === libav.AVMEDIA_TYPE_AUDIO)
+            return i;
+    }
+    throw new Error("Could not find audio track");
+}
+
+// Decode the audio of a file for comparison
+async function decode(filename) {
+    const [fmt_ctx, streams] = await libav.ff_init_demuxer_file(filename);
+    const idx = audioIndex(streams);
+    const [, c, pkt, frame] = await libav.ff_init_decoder(
+        "libopus", streams[idx].codecpar);
+    await libav.AVCodecContext_sample_fmt_s(c, libav.AV_SAMPLE_FMT_FLT);
+    const [res, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt);
+    if (res !== libav.AVERROR_EOF)
+        throw new Error(`Failed to read ${filename}`);
+    const frames = await libav.ff_decode_multi(
+        c, pkt, frame, packets[idx], true);
+    await libav.ff_free_decoder(c, pkt, frame);
+    await libav.avformat_close_input_js(fmt_ctx);
+    return frames;
+}
+
+const [probe, inStreams] = await libav.ff_init_demuxer_file("bbb.webm");
+const idx = audioIndex(inStreams);
+await libav.avformat_close_input_js(probe);
+
+// Transcode, a few packets at a time
+const p = await libav.ff_init_pipeline("bbb.webm", {filename: "tmp-636.ogg"}, [{
+    index: idx,
+    codec: "libopus",
+    decoder: "libopus",
+    ctx: {
+        bit_rate: 128000,
+        sample_fmt: libav.AV_SAMPLE_FMT_FLT,
+        sample_rate: 48000,
+        channel_layout: 3
+    },
+    time_base: [1, 48000]
+}]);
+let res, pumps = 0;
+do {
+    res = await libav.ff_pipeline_pump(p, 16, 0);
+    pumps++;
+} while (res === -libav.EAGAIN);
+if (res !== libav.AVERROR_EOF)
+    throw new Error(`Pipeline failed: ${await libav.ff_error(res)}`);
+if (pumps < 2)
+    throw new Error("Pipeline ignored its packet limit");
+if (await libav.ff_pipeline_pump(p, 0, 0) !== libav.AVERROR_EOF)
+    throw new Error("Finished pipeline didn't stay finished");
+
+const stats = await libav.ff_pipeline_get_stats(p);
+if (!stats.frames_decoded || !stats.frames_encoded || !stats.packets_out ||
+    stats.decode_errors)
+    throw new Error(`Unexpected pipeline statistics ${JSON.stringify(stats)}`);
+await libav.ff_pipeline_free(p);
+
+await h.utils.compareAudio("bbb.webm", await decode("tmp-636.ogg"));
+await libav.unlink("tmp-636.ogg");
+
+// Copy, in one go
+const cp = await libav.ff_init_pipeline(
+    "bbb.webm", {filename: "tmp-636.webm"}, [{index: idx}]);
+res = await libav.ff_pipeline_pump(cp, 0, 0);
+if (res !== libav.AVERROR_EOF)
+    throw new Error(`Copy pipeline failed: ${await libav.ff_error(res)}`);
+const cstats = await libav.ff_pipeline_get_stats(cp);
+if (cstats.frames_decoded || !cstats.packets_out)
+    throw new Error(`Unexpected copy statistics ${JSON.stringify(cstats)}`);
+await libav.ff_pipeline_free(cp);
+
+await h.utils.compareAudio("bbb.webm", await decode("tmp-636.webm"));
+await libav.unlink("tmp-636.webm");
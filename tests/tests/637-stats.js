@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+// Instrumentation of calls
+
+const opts = {stats: true};
+if (h.libAVOpts) Object.assign(opts, h.libAVOpts);
+const libav = await h.LibAV(opts);
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+let streamIdx = -1;
+for (let i = 0; i < streams.length; i++) {
+    if (streams[i].codec_type === libav.AVMEDIA_TYPE_AUDIO) {
+        streamIdx = i;
+        break;
+    }
+}
+if (streamIdx < 0)
+    throw new Error("Could not find audio track");
+
+const [, c, pkt, frame] = await libav.ff_init_decoder(
+    streams[streamIdx].codec_id, streams[streamIdx].codecpar);
+await libav.AVCodecContext_sample_fmt_s(c, libav.AV_SAMPLE_FMT_FLT);
+
+const [, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt);
+await libav.avformat_close_input_js(fmt_ctx);
+let packetBytes = 0;
+for (const p of packets[streamIdx])
+    packetBytes += p.data.length;
+
+// Clear out the setup
+await libav.stats({reset: true});
+
+const frames = await libav.ff_decode_multi(
+    c, pkt, frame, packets[streamIdx], true);
+await libav.ff_free_decoder(c, pkt, frame);
+await h.utils.compareAudio("bbb.webm", frames);
+
+const stats = await libav.stats({reset: true});
+if (stats.mode !== libav.libavjsMode)
+    throw new Error(`Stats are for mode ${stats.mode}`);
+
+const dec = stats.functions.ff_decode_multi;
+if (!dec || dec.calls !== 1)
+    throw new Error("ff_decode_multi wasn't counted");
+if (dec.time <= 0 || dec.max_time !== dec.time)
+    throw new Error(`Bad time for ff_decode_multi: ${dec.time}, ${dec.max_time}`);
+if (dec.bytes_in < packetBytes)
+    throw new Error(`ff_decode_multi took ${dec.bytes_in} bytes in, not ${packetBytes}`);
+let frameBytes = 0;
+for (const f of frames) {
+    for (const d of [].concat(f.data))
+        frameBytes += d.byteLength;
+}
+if (dec.bytes_out < frameBytes)
+    throw new Error(`ff_decode_multi gave ${dec.bytes_out} bytes out, not ${frameBytes}`);
+if (stats.functions.ff_read_frame_multi)
+    throw new Error("Stats weren't reset");
+
+if (libav.libavjsMode === "direct") {
+    if (stats.dispatch)
+        throw new Error("Dispatch stats in direct mode");
+} else {
+    const d = stats.dispatch && stats.dispatch.ff_decode_multi;
+    if (!d || d.calls !== 1)
+        throw new Error("ff_decode_multi wasn't dispatched");
+}
+
+if (!(stats.heap.used > 0) || stats.heap.max_used < stats.heap.used ||
+    stats.heap.max_size < stats.heap.size)
+    throw new Error(`Bad heap statistics ${JSON.stringify(stats.heap)}`);
+
+// Everything was reset
+const empty = await libav.stats();
+if (Object.keys(empty.functions).length)
+    throw new Error(`Stats after reset: ${Object.keys(empty.functions)}`);
+
+libav.terminate();
+
+// And without instrumentation, there are no stats
+if (await (await h.LibAV()).stats() !== null)
+    throw new Error("Stats without instrumentation");
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/* Streaming many small chunks through a reader device with a high-water mark,
+ * as from a live source. The chunks are MPEG-TS packet-sized. */
+
+const libav = await h.LibAV();
+const buf = await h.readCachedFile("bbb.webm");
+const chunkSize = 188;
+const highWaterMark = 16384;
+
+await libav.mkreaderdev("tmp-638.webm", {highWaterMark});
+
+// Send it all, waiting for room whenever the queue is full
+let maxBuffered = 0;
+const sending = (async () => {
+    let idx = 0;
+    for (let pos = 0; pos < buf.length; pos += chunkSize, idx++) {
+        await libav.ff_reader_dev_send(
+            "tmp-638.webm", buf.slice(pos, pos + chunkSize));
+        if (idx % 64 === 0) {
+            maxBuffered = Math.max(maxBuffered,
+                await libav.ff_reader_dev_buffered("tmp-638.webm"));
+        }
+    }
+    await libav.ff_reader_dev_send("tmp-638.webm", null);
+})();
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("tmp-638.webm");
+const pkt = await libav.av_packet_alloc();
+const packets = {};
+while (true) {
+    const [res, rdPackets] =
+        await libav.ff_read_frame_multi(fmt_ctx, pkt, {limit: 4096});
+    for (const idx in rdPackets)
+        packets[idx] = (packets[idx] || []).concat(rdPackets[idx]);
+    if (res === libav.AVERROR_EOF)
+        break;
+    else if (res < 0 && res !== -libav.EAGAIN)
+        throw new Error("Error reading: " + res);
+}
+await sending;
+const stream = streams.find(x => x.codec_type === libav.AVMEDIA_TYPE_AUDIO);
+const [, c, dpkt, frame] = await libav.ff_init_decoder(
+    stream.codec_id, stream.codecpar);
+await libav.AVCodecContext_sample_fmt_s(c, libav.AV_SAMPLE_FMT_FLT);
+await libav.avformat_close_input_js(fmt_ctx);
+await libav.unlink("tmp-638.webm");
+
+/* The sender can only have got ahead of the reader by the high-water mark, plus
+ * the chunk that went over it */
+if (maxBuffered > highWaterMark + chunkSize)
+    throw new Error(`${maxBuffered} bytes were queued`);
+
+// Compare to demuxing the whole file
+const [ref_fmt_ctx] = await libav.ff_init_demuxer_file("bbb.webm");
+const [, refPackets] = await libav.ff_read_frame_multi(ref_fmt_ctx, pkt);
+await libav.avformat_close_input_js(ref_fmt_ctx);
+for (const idx in refPackets) {
+    const a = refPackets[idx], b = packets[idx] || [];
+    if (a.length !== b.length)
+        throw new Error(`Stream ${idx}: ${b.length} packets instead of ${a.length}`);
+    for (let i = 0; i < a.length; i++) {
+        if (a[i].data.length !== b[i].data.length ||
+            a[i].pts !== b[i].pts)
+            throw new Error(`Stream ${idx}, packet ${i} differs`);
+        for (let j = 0; j < a[i].data.length; j++) {
+            if (a[i].data[j] !== b[i].data[j])
+                throw new Error(`Stream ${idx}, packet ${i} differs`);
+        }
+    }
+}
+
+// And make sure the audio is right
+const frames = await libav.ff_decode_multi(
+    c, dpkt, frame, packets[stream.index], true);
+await libav.ff_free_decoder(c, dpkt, frame);
+await libav.av_packet_free_js(pkt);
+await h.utils.compareAudio("bbb.webm", frames);
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+// Test of jsfetch's block mode: range requests into a cache shared by contexts
+
+// This test requires fetch, so only works with the web test framework
+if (typeof document === "undefined")
+    return;
+
+const testLoc = new URL(document.location.href);
+testLoc.pathname = testLoc.pathname.replace(/\/[^\/]*$/, "/");
+const url = `${testLoc.toString()}/files/bbb_bitrate.webm`;
+
+// Block mode needs range requests (tools/cors-server.py supports them)
+{
+    const response = await fetch(url, {headers: {Range: "bytes=0-0"}});
+    await response.arrayBuffer();
+    if (response.status !== 206)
+        return;
+}
+const filesize = (await h.readCachedFile("bbb_bitrate.webm")).length;
+
+const libav = await h.LibAV();
+
+function diff(a, b) {
+    const ret = {};
+    for (const k in a)
+        ret[k] = b[k] - a[k];
+    return ret;
+}
+
+// Open, seek around, and close, giving the change in statistics
+async function seeks(opts) {
+    const before = await libav.ff_jsfetch_stats();
+    const [fmt_ctx, streams] =
+        await libav.ff_init_demuxer_file(`jsfetch:${url}`, opts);
+    const pkt = await libav.av_packet_alloc();
+    const tb = streams[0].time_base_den / streams[0].time_base_num;
+
+    for (const [min, max] of [[3 * 60, 4 * 60], [60, 2 * 60], [0, 60]]) {
+        await libav.av_seek_frame(fmt_ctx, 0, (min + max) / 2 * tb, 0, 0);
+        await libav.av_read_frame(fmt_ctx, pkt);
+        const packet = await libav.ff_copyout_packet(pkt);
+        await libav.av_packet_unref(pkt);
+        const time = packet.pts / tb;
+        if (time < min || time > max)
+            throw new Error(`Failed to seek between ${min} and ${max}`);
+    }
+
+    await libav.av_packet_free_js(pkt);
+    await libav.avformat_close_input_js(fmt_ctx);
+    return diff(before, await libav.ff_jsfetch_stats());
+}
+
+const streaming = await seeks();
+if (streaming.requests < 3)
+    throw new Error(`Streaming made only ${streaming.requests} requests for three seeks`);
+
+const blocks = await seeks({options: {block_size: "65536"}});
+if (blocks.bytes > filesize) {
+    throw new Error(
+        `Block mode transferred ${blocks.bytes} bytes of a ${filesize}-byte file`);
+}
+if (blocks.evictions)
+    throw new Error("Evicted blocks from a cache larger than the file");
+
+// A second context on the same URL reads entirely from the cache
+const cached = await seeks({options: {block_size: "65536"}});
+if (cached.requests || cached.bytes || cached.misses || !cached.hits) {
+    throw new Error(
+        `Second context wasn't served by the cache: ${JSON.stringify(cached)}`);
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/* ff_read_frame_multi reads in a single native call: check it against reading
+ * packet by packet, with limits and each copyout version, and that errors from
+ * a reader device are still passed through */
+
+const libav = await h.LibAV();
+const pkt = await libav.av_packet_alloc();
+
+// Reference: one packet at a time
+const ref = [];
+{
+    const [fmt_ctx] = await libav.ff_init_demuxer_file("bbb.webm");
+    while (await libav.av_read_frame(fmt_ctx, pkt) >= 0) {
+        ref.push(await libav.ff_copyout_packet(pkt));
+        await libav.av_packet_unref(pkt);
+    }
+    await libav.avformat_close_input_js(fmt_ctx);
+}
+
+function compare(packet, i, what) {
+    const r = ref[i];
+    if (!r)
+        throw new Error(`${what}: extra packet ${i}`);
+    if (packet.stream_index !== r.stream_index || packet.pts !== r.pts ||
+        packet.dts !== r.dts || packet.flags !== r.flags ||
+        packet.time_base_num !== r.time_base_num ||
+        packet.time_base_den !== r.time_base_den ||
+        packet.data.length !== r.data.length)
+        throw new Error(`${what}: packet ${i} differs`);
+    for (let j = 0; j < r.data.length; j++) {
+        if (packet.data[j] !== r.data[j])
+            throw new Error(`${what}: packet ${i} data differs at ${j}`);
+    }
+}
+
+// Read in batches of this limit, giving all the packets in order
+async function readAll(limit, copyoutPacket) {
+    const [fmt_ctx] = await libav.ff_init_demuxer_file("bbb.webm");
+    const packets = [];
+    let res, calls = 0;
+    do {
+        let rd;
+        [res, rd] = await libav.ff_read_frame_multi(fmt_ctx, pkt, {
+            limit, unify: true, copyoutPacket
+        });
+        calls++;
+        if (res < 0 && res !== -libav.EAGAIN && res !== libav.AVERROR_EOF)
+            throw new Error(`Error reading: ${res}`);
+        packets.push.apply(packets, rd[0] || []);
+    } while (res !== libav.AVERROR_EOF);
+    await libav.avformat_close_input_js(fmt_ctx);
+    return {packets, calls};
+}
+
+// Unlimited: everything in one batch
+{
+    const {packets, calls} = await readAll(0);
+    if (calls !== 1)
+        throw new Error(`Unlimited read took ${calls} calls`);
+    if (packets.length !== ref.length)
+        throw new Error(`Read ${packets.length} packets instead of ${ref.length}`);
+    packets.forEach((p, i) => compare(p, i, "unlimited"));
+}
+
+// Limited: each batch stops at the first packet that reaches the limit
+{
+    const {packets, calls} = await readAll(65536);
+    if (calls < 2)
+        throw new Error("Limited read didn't stop at the limit");
+    if (packets.length !== ref.length)
+        throw new Error(`Read ${packets.length} packets instead of ${ref.length}`);
+    packets.forEach((p, i) => compare(p, i, "limited"));
+}
+
+// Pointers, separated by stream
+{
+    const [fmt_ctx] = await libav.ff_init_demuxer_file("bbb.webm");
+    const [res, rd] = await libav.ff_read_frame_multi(fmt_ctx, pkt, {
+        copyoutPacket: "ptr"
+    });
+    await libav.avformat_close_input_js(fmt_ctx);
+    if (res !== libav.AVERROR_EOF)
+        throw new Error(`Error reading: ${res}`);
+    for (const idx in rd) {
+        const refStream = ref.filter(x => x.stream_index === +idx);
+        if (rd[idx].length !== refStream.length)
+            throw new Error(`Stream ${idx}: wrong number of pointers`);
+        for (let i = 0; i < rd[idx].length; i++) {
+            const packet = await libav.ff_copyout_packet(rd[idx][i]);
+            await libav.av_packet_free_js(rd[idx][i]);
+            if (packet.pts !== refStream[i].pts ||
+                packet.data.length !== refStream[i].data.length)
+                throw new Error(`Stream ${idx}: pointer ${i} differs`);
+        }
+    }
+}
+
+// Errors from a reader are still thrown
+{
+    const buf = await h.readCachedFile("bbb.webm");
+    await libav.mkblockreaderdev("tmp-640.webm", buf.length);
+    let fail = false;
+    libav.onblockread = function(name, pos, len) {
+        if (fail) {
+            libav.ff_block_reader_dev_send(name, pos, null,
+                {error: new Error("passthru")});
+        } else {
+            libav.ff_block_reader_dev_send(name, pos,
+                buf.slice(pos, pos + len));
+        }
+    };
+    const [fmt_ctx] = await libav.ff_init_demuxer_file("tmp-640.webm");
+    fail = true;
+    let threw = false;
+    try {
+        await libav.ff_read_frame_multi(fmt_ctx, pkt);
+    } catch (ex) {
+        if (ex.message !== "passthru")
+            throw ex;
+        threw = true;
+    }
+    if (!threw)
+        throw new Error("Reader error was not passed through");
+    await libav.avformat_close_input_js(fmt_ctx);
+    await libav.unlink("tmp-640.webm");
+    delete libav.onblockread;
+}
+
+await libav.av_packet_free_js(pkt);
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Seek indexes: built while reading and by scanning, exported and imported,
+ * and used to seek */
+
+const libav = await h.LibAV();
+const pkt = await libav.av_packet_alloc();
+
+function sameData(a, b) {
+    if (a.length !== b.length)
+        return false;
+    for (let i = 0; i < a.length; i++) {
+        if (a[i] !== b[i])
+            return false;
+    }
+    return true;
+}
+
+// Build an index while reading
+let fmt_ctx, streams;
+[fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+const readIndex = await libav.ff_seek_index_alloc();
+const [res, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt, {
+    seekIndex: readIndex
+});
+if (res !== libav.AVERROR_EOF)
+    throw new Error(`Error reading: ${res}`);
+await libav.avformat_close_input_js(fmt_ctx);
+
+const stream = streams.find(x => x.codec_type === libav.AVMEDIA_TYPE_AUDIO);
+if (!stream)
+    throw new Error("Couldn't find audio stream");
+const keyframes = packets[stream.index].filter(x => x.flags & 1 /* KEY */);
+if (await libav.ff_seek_index_nb_entries(readIndex, stream.index) !==
+    keyframes.length)
+    throw new Error("Seek index doesn't have every keyframe");
+
+// Scanning should give the same index, and leave the demuxer at the start
+[fmt_ctx] = await libav.ff_init_demuxer_file("bbb.webm");
+const scanIndex = await libav.ff_seek_index_alloc();
+await libav.ff_seek_index_scan(scanIndex, fmt_ctx, pkt);
+const exported = await libav.ff_seek_index_export(readIndex);
+if (!sameData(await libav.ff_seek_index_export(scanIndex), exported))
+    throw new Error("Scanned seek index differs from read seek index");
+{
+    const [, rd] = await libav.ff_read_frame_multi(fmt_ctx, pkt, {
+        limit: 1, unify: true
+    });
+    if (rd[0][0].pts !== packets[rd[0][0].stream_index][0].pts)
+        throw new Error("Scanning didn't seek back to the start");
+}
+await libav.avformat_close_input_js(fmt_ctx);
+await libav.ff_seek_index_free(scanIndex);
+await libav.ff_seek_index_free(readIndex);
+
+// The export should be compact, and survive a round trip
+if (exported.length > keyframes.length * 8)
+    throw new Error(`Exported seek index is ${exported.length} bytes`);
+let threw = false;
+try {
+    await libav.ff_seek_index_import(exported.slice(0, exported.length - 1));
+} catch (ex) {
+    threw = true;
+}
+if (!threw)
+    throw new Error("Truncated seek index was imported");
+
+// Seek with an imported index
+[fmt_ctx] = await libav.ff_init_demuxer_file("bbb.webm");
+const index = await libav.ff_seek_index_import(exported, fmt_ctx);
+if (!sameData(await libav.ff_seek_index_export(index), exported))
+    throw new Error("Imported seek index differs");
+
+const second = stream.time_base_den / stream.time_base_num;
+for (const target of [
+    keyframes[Math.floor(keyframes.length / 2)].pts + 1,
+    keyframes[Math.floor(keyframes.length / 4)].pts,
+    keyframes[keyframes.length - 1].pts + 1
+]) {
+    // The keyframe it should land on
+    let expect = keyframes[0];
+    for (const k of keyframes) {
+        if (k.pts <= target)
+            expect = k;
+    }
+
+    const ret = await libav.ff_seek_index_seek(
+        index, fmt_ctx, stream.index, target, 0, 0);
+    if (ret < 0)
+        throw new Error(`Error seeking: ${ret}`);
+
+    let got = null;
+    while (!got) {
+        const [res, rd] = await libav.ff_read_frame_multi(fmt_ctx, pkt, {
+            limit: 1
+        });
+        if (rd[stream.index])
+            got = rd[stream.index][0];
+        else if (res === libav.AVERROR_EOF)
+            throw new Error(`Nothing read after seeking to ${target}`);
+    }
+    /* Formats that can seek by bytes land exactly on it, but others seek by
+     * timestamp, and may land a little earlier */
+    if (got.pts > target || got.pts < expect.pts - second)
+        throw new Error(`Seeking to ${target} gave ${got.pts}, not ${expect.pts}`);
+}
+
+await libav.ff_seek_index_free(index);
+await libav.avformat_close_input_js(fmt_ctx);
+await libav.av_packet_free_js(pkt);
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Native audio conversion on copyout and copyin: sample formats (including
+ * doubles and S64) and interleaving, but not sample rates */
+
+const libav = await h.LibAV();
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+const stream = streams.find(x => x.codec_type === libav.AVMEDIA_TYPE_AUDIO);
+if (!stream)
+    throw new Error("Couldn't find audio stream");
+const pkt = await libav.av_packet_alloc();
+const [res, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt);
+if (res !== libav.AVERROR_EOF)
+    throw new Error(await libav.ff_error(res));
+await libav.avformat_close_input_js(fmt_ctx);
+const audioPackets = packets[stream.index].slice(0, 50);
+
+async function decode(copyoutAudio) {
+    const [, c, pkt, frame] =
+        await libav.ff_init_decoder(stream.codec_id, stream.codecpar);
+    await libav.AVCodecContext_sample_fmt_s(c, libav.AV_SAMPLE_FMT_FLT);
+    const frames = await libav.ff_decode_multi(c, pkt, frame, audioPackets, {
+        fin: true, copyoutAudio
+    });
+    await libav.ff_free_decoder(c, pkt, frame);
+    return frames;
+}
+
+// Reference: interleaved float, as decoded
+const ref = await decode();
+if (ref[0].format !== libav.AV_SAMPLE_FMT_FLT)
+    throw new Error("Expected interleaved float");
+const channels = ref[0].channels;
+
+function check(what, frames, get) {
+    if (frames.length !== ref.length)
+        throw new Error(`${what}: ${frames.length} frames, not ${ref.length}`);
+    for (let fi = 0; fi < ref.length; fi++) {
+        const r = ref[fi], f = frames[fi];
+        if (f.nb_samples !== r.nb_samples || f.pts !== r.pts)
+            throw new Error(`${what}: frame ${fi} differs`);
+        for (let i = 0; i < r.nb_samples; i++) {
+            for (let ch = 0; ch < channels; ch++) {
+                const x = r.data[i * channels + ch];
+                if (!get(f, i, ch, x))
+                    throw new Error(`${what}: frame ${fi} sample ${i} differs`);
+            }
+        }
+    }
+}
+
+// Deinterleaving, exactly
+check("FLTP", await decode({format: libav.AV_SAMPLE_FMT_FLTP}),
+    (f, i, ch, x) => f.data[ch][i] === x);
+
+// Doubles, exactly
+check("DBL", await decode({format: libav.AV_SAMPLE_FMT_DBL}),
+    (f, i, ch, x) => f.data instanceof Float64Array &&
+        f.data[i * channels + ch] === x);
+check("DBLP", await decode({format: libav.AV_SAMPLE_FMT_DBLP}),
+    (f, i, ch, x) => f.data[ch][i] === x);
+
+// Integers, to within rounding (and clipping)
+const clip = x => Math.max(-1, Math.min(1, x));
+check("S16P", await decode({format: libav.AV_SAMPLE_FMT_S16P}),
+    (f, i, ch, x) => Math.abs(f.data[ch][i] - clip(x) * 32768) <= 1);
+if (typeof BigInt64Array !== "undefined") {
+    check("S64", await decode({format: libav.AV_SAMPLE_FMT_S64}),
+        (f, i, ch, x) => f.data instanceof BigInt64Array &&
+            Math.abs(Number(f.data[i * channels + ch]) - clip(x) * 2 ** 63) <=
+                2 ** 40);
+}
+
+// Downmixing to mono
+{
+    const frames = await decode({channel_layout: 4 /* mono */});
+    if (frames[0].channels !== 1 || frames[0].data.length !== frames[0].nb_samples)
+        throw new Error("Downmixing to mono didn't give one channel");
+}
+
+// The frame's own sample rate is fine, but resampling is left to resamplers
+check("Same rate", await decode({sample_rate: ref[0].sample_rate}),
+    (f, i, ch, x) => f.data[i * channels + ch] === x);
+{
+    let threw = false;
+    try {
+        await decode({sample_rate: 24000});
+    } catch (ex) {
+        threw = true;
+    }
+    if (!threw)
+        throw new Error("Resampling on copyout wasn't rejected");
+}
+
+// Copying in, converting to planar S32
+{
+    const framePtr = await libav.av_frame_alloc();
+    await libav.ff_copyin_frame(framePtr, ref[0], 0, {
+        format: libav.AV_SAMPLE_FMT_S32P
+    });
+    const f = await libav.ff_copyout_frame(framePtr);
+    if (f.format !== libav.AV_SAMPLE_FMT_S32P || f.data.length !== channels ||
+        f.nb_samples !== ref[0].nb_samples)
+        throw new Error("Copying in didn't convert");
+    for (let i = 0; i < f.nb_samples; i++) {
+        const x = clip(ref[0].data[i * channels]);
+        if (Math.abs(f.data[0][i] - x * 2147483648) > 256)
+            throw new Error(`Copied in sample ${i} differs`);
+    }
+
+    // And copying out doubles without conversion
+    await libav.ff_copyin_frame(framePtr, {
+        format: libav.AV_SAMPLE_FMT_DBLP,
+        channel_layout: 3,
+        sample_rate: 48000,
+        data: [new Float64Array([0.5, -0.25]), new Float64Array([1, 0])]
+    });
+    const d = await libav.ff_copyout_frame(framePtr);
+    if (d.data[0][1] !== -0.25 || d.data[1][0] !== 1)
+        throw new Error("Doubles weren't copied in and out");
+    await libav.av_frame_free_js(framePtr);
+}
+
+await libav.av_packet_free_js(pkt);
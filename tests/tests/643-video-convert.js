@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/* Native video conversion and scaling on copyout: packed, ImageData and ptr
+ * output, compared against scaling each frame by hand */
+
+const libav = await h.LibAV();
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+const stream = streams.find(x => x.codec_type === libav.AVMEDIA_TYPE_VIDEO);
+if (!stream)
+    throw new Error("Couldn't find video stream");
+const pkt = await libav.av_packet_alloc();
+const [res, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt);
+if (res !== libav.AVERROR_EOF)
+    throw new Error(await libav.ff_error(res));
+await libav.avformat_close_input_js(fmt_ctx);
+const videoPackets = packets[stream.index].slice(0, 10);
+
+async function decode(config) {
+    const [, c, pkt, frame] =
+        await libav.ff_init_decoder(stream.codec_id, stream.codecpar);
+    const frames = await libav.ff_decode_multi(c, pkt, frame, videoPackets,
+        Object.assign({fin: true}, config));
+    await libav.ff_free_decoder(c, pkt, frame);
+    return frames;
+}
+
+// Reference: decode, then scale each frame to RGBA by hand
+const ptrs = await decode({copyoutFrame: "ptr"});
+const width = await libav.AVFrame_width(ptrs[0]);
+const height = await libav.AVFrame_height(ptrs[0]);
+const sws = await libav.sws_getContext(
+    width, height, await libav.AVFrame_format(ptrs[0]),
+    160, 90, libav.AV_PIX_FMT_RGBA,
+    2 /* SWS_BILINEAR */, 0, 0, 0);
+const scaleFrame = await libav.av_frame_alloc();
+const ref = [];
+for (const ptr of ptrs) {
+    await libav.av_frame_unref(scaleFrame);
+    await libav.sws_scale_frame(sws, scaleFrame, ptr);
+    ref.push(await libav.ff_copyout_frame_video_packed(scaleFrame));
+    await libav.av_frame_free_js(ptr);
+}
+await libav.av_frame_free_js(scaleFrame);
+await libav.sws_freeContext(sws);
+
+// Converting and scaling on copyout should give the same pictures
+const rgba = {format: libav.AV_PIX_FMT_RGBA, width: 160, height: 90};
+const frames = await decode({copyoutFrame: "video_packed", copyoutVideo: rgba});
+if (frames.length !== ref.length)
+    throw new Error(`${frames.length} frames, not ${ref.length}`);
+for (let fi = 0; fi < ref.length; fi++) {
+    const r = ref[fi], f = frames[fi];
+    if (f.format !== libav.AV_PIX_FMT_RGBA || f.width !== 160 ||
+        f.height !== 90 || f.pts !== r.pts)
+        throw new Error(`Frame ${fi} wasn't converted`);
+    if (f.data.length !== r.data.length)
+        throw new Error(`Frame ${fi} has the wrong size`);
+    for (let i = 0; i < r.data.length; i++) {
+        if (Math.abs(f.data[i] - r.data[i]) > 1)
+            throw new Error(`Frame ${fi} differs at ${i}`);
+    }
+}
+
+// Giving just the width keeps the shape
+{
+    const frames = await decode({
+        copyoutFrame: "video", copyoutVideo: {width: 160}
+    });
+    const expHeight = Math.round(height * 160 / width);
+    if (frames[0].width !== 160 || frames[0].height !== expHeight)
+        throw new Error(`Scaled to ${frames[0].width}x${frames[0].height}`);
+}
+
+// ptr frames are converted in place
+{
+    const ptrs = await decode({copyoutFrame: "ptr", copyoutVideo: rgba});
+    if (await libav.AVFrame_format(ptrs[0]) !== libav.AV_PIX_FMT_RGBA ||
+        await libav.AVFrame_width(ptrs[0]) !== 160)
+        throw new Error("ptr frames weren't converted");
+    for (const ptr of ptrs)
+        await libav.av_frame_free_js(ptr);
+}
+
+// ImageData is converted to RGBA even without a format
+if (typeof ImageData !== "undefined") {
+    const ids = await decode({
+        copyoutFrame: "ImageData", copyoutVideo: {width: 160, height: 90}
+    });
+    for (let i = 0; i < ref[0].data.length; i++) {
+        if (Math.abs(ids[0].data[i] - ref[0].data[i]) > 1)
+            throw new Error(`ImageData differs at ${i}`);
+    }
+}
+
+await libav.av_packet_free_js(pkt);
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/* Scalers and resamplers: batches of pointers and of Frames, pooled output,
+ * changes of geometry and flushing */
+
+const libav = await h.LibAV();
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+const pkt = await libav.av_packet_alloc();
+const [res, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt);
+if (res !== libav.AVERROR_EOF)
+    throw new Error(await libav.ff_error(res));
+await libav.avformat_close_input_js(fmt_ctx);
+
+async function decode(type, count, config) {
+    const stream = streams.find(x => x.codec_type === type);
+    const [, c, pkt, frame] =
+        await libav.ff_init_decoder(stream.codec_id, stream.codecpar);
+    if (type === libav.AVMEDIA_TYPE_AUDIO)
+        await libav.AVCodecContext_sample_fmt_s(c, libav.AV_SAMPLE_FMT_FLT);
+    const frames = await libav.ff_decode_multi(c, pkt, frame,
+        packets[stream.index].slice(0, count),
+        Object.assign({fin: true}, config));
+    await libav.ff_free_decoder(c, pkt, frame);
+    return frames;
+}
+
+// Scaling: the same pictures as converting on copyout
+const rgba = {format: libav.AV_PIX_FMT_RGBA, width: 160, height: 90};
+const ref = await decode(libav.AVMEDIA_TYPE_VIDEO, 10, {
+    copyoutFrame: "video_packed", copyoutVideo: rgba
+});
+const scaler = await libav.ff_init_scaler(rgba);
+{
+    const ptrs = await decode(libav.AVMEDIA_TYPE_VIDEO, 10, {copyoutFrame: "ptr"});
+    const frames = await libav.ff_scale_multi(scaler, ptrs, {
+        copyoutFrame: "video_packed"
+    });
+    if (frames.length !== ref.length)
+        throw new Error(`Scaled ${frames.length} frames, not ${ref.length}`);
+    for (let fi = 0; fi < ref.length; fi++) {
+        const r = ref[fi], f = frames[fi];
+        if (f.width !== 160 || f.height !== 90 || f.pts !== r.pts)
+            throw new Error(`Scaled frame ${fi} is wrong`);
+        for (let i = 0; i < r.data.length; i++) {
+            if (Math.abs(f.data[i] - r.data[i]) > 1)
+                throw new Error(`Scaled frame ${fi} differs at ${i}`);
+        }
+    }
+}
+
+// Several renditions of the same Frames, with output into a pool
+{
+    const frames = await decode(libav.AVMEDIA_TYPE_VIDEO, 5);
+    const pool = await libav.ff_frame_pool_alloc();
+    const small = await libav.ff_init_scaler({width: 64, threads: 1});
+    for (const [sc, width] of [[scaler, 160], [small, 64]]) {
+        const ptrs = await libav.ff_scale_multi(sc, frames, {
+            copyoutFrame: "ptr", framePool: pool
+        });
+        if (ptrs.length !== frames.length)
+            throw new Error("Wrong number of pooled frames");
+        for (const ptr of ptrs) {
+            if (await libav.AVFrame_width(ptr) !== width)
+                throw new Error(`Pooled frame isn't ${width} wide`);
+        }
+        await libav.ff_frame_pool_release_multi(pool, ptrs);
+    }
+
+    // A change of input geometry rebuilds the scaler's context
+    const scaled = await libav.ff_scale_multi(scaler, frames);
+    const rescaled = await libav.ff_scale_multi(small, scaled);
+    if (rescaled[0].width !== 64 ||
+        rescaled[0].height !== Math.round(90 * 64 / 160))
+        throw new Error("Rescaling gave the wrong size");
+    if (rescaled[0].format !== libav.AV_PIX_FMT_RGBA)
+        throw new Error("Rescaling changed the format");
+
+    await libav.ff_scaler_free(small);
+    await libav.ff_frame_pool_free(pool);
+}
+await libav.ff_scaler_free(scaler);
+
+// Resampling in batches, flushed at the end, keeps all the samples
+{
+    const frames = await decode(libav.AVMEDIA_TYPE_AUDIO, 50);
+    const resampler = await libav.ff_init_resampler({
+        format: libav.AV_SAMPLE_FMT_FLTP, sample_rate: 24000
+    });
+    const half = frames.length >> 1;
+    const out = (await libav.ff_resample_multi(
+        resampler, frames.slice(0, half))).concat(
+        await libav.ff_resample_multi(resampler, frames.slice(half), true));
+    let inSamples = 0, outSamples = 0;
+    for (const f of frames)
+        inSamples += f.nb_samples;
+    for (const f of out) {
+        if (f.format !== libav.AV_SAMPLE_FMT_FLTP || f.sample_rate !== 24000)
+            throw new Error("Resampled frame has the wrong format");
+        outSamples += f.nb_samples;
+    }
+    const expect = inSamples * 24000 / frames[0].sample_rate;
+    if (Math.abs(outSamples - expect) > 2)
+        throw new Error(`Resampling gave ${outSamples} samples, not ${expect}`);
+    await libav.ff_resampler_free(resampler);
+}
+
+await libav.av_packet_free_js(pkt);
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+// Pools of instances
+
+await h.LibAV();
+const buf = await h.readCachedFile("bbb.webm");
+
+const pool = await LibAV.pool(
+    Object.assign({}, h.libAVOpts || {}, {size: 2}));
+try {
+    if (pool.size !== 2 || pool.instances.length !== 2)
+        throw new Error(`Pool has ${pool.size} instances, expected 2`);
+
+    // Give each instance the file
+    await Promise.all(pool.instances.map(function(libav) {
+        return libav.writeFile("tmp.webm", buf);
+    }));
+
+    // Independent jobs should be spread across the instances
+    const used = [0, 0];
+    const probes = [];
+    for (let i = 0; i < 4; i++) {
+        probes.push(pool.run(async function(libav, idx) {
+            used[idx]++;
+            const [fmt_ctx, streams] =
+                await libav.ff_init_demuxer_file("tmp.webm");
+            await libav.avformat_close_input_js(fmt_ctx);
+            return streams.length;
+        }));
+    }
+
+    let stats = pool.stats();
+    if (stats[0].queued + stats[0].running !== 2 ||
+        stats[1].queued + stats[1].running !== 2) {
+        throw new Error(
+            "Jobs not spread across instances: " + JSON.stringify(stats));
+    }
+
+    const nbStreams = await Promise.all(probes);
+    if (!nbStreams[0] || nbStreams.some(x => x !== nbStreams[0]))
+        throw new Error("Probes disagree: " + nbStreams);
+    if (used[0] !== 2 || used[1] !== 2)
+        throw new Error("Jobs ran on the wrong instances: " + used);
+
+    // Jobs with the same affinity should share an instance's state
+    const [fmt_ctx, pkt, owner] = await pool.run(async function(libav, idx) {
+        const [fmt_ctx] = await libav.ff_init_demuxer_file("tmp.webm");
+        const pkt = await libav.av_packet_alloc();
+        return [fmt_ctx, pkt, idx];
+    }, {affinity: "demux"});
+    if (pool.worker("demux") !== owner)
+        throw new Error("Affinity not bound to its first instance");
+
+    const reads = [];
+    for (let i = 0; i < 4; i++) {
+        reads.push(pool.run(async function(libav, idx) {
+            if (idx !== owner)
+                throw new Error("Job with affinity ran on the wrong instance");
+            const [res, packets] = await libav.ff_read_frame_multi(
+                fmt_ctx, pkt, {limit: 1024});
+            if (res !== 0 && res !== -libav.EAGAIN && res !== libav.AVERROR_EOF)
+                throw new Error("Error reading: " + res);
+            return Object.keys(packets).length;
+        }, {affinity: "demux"}));
+    }
+    await Promise.all(reads);
+
+    await pool.run(async function(libav) {
+        await libav.av_packet_free_js(pkt);
+        await libav.avformat_close_input_js(fmt_ctx);
+    }, {affinity: "demux"});
+    pool.release("demux");
+    if (pool.worker("demux") !== -1)
+        throw new Error("Affinity not released");
+
+    // Failures are counted, and don't stop the instance
+    let failed = false;
+    try {
+        await pool.run(function() {
+            throw new Error("Expected failure");
+        });
+    } catch (ex) {
+        failed = true;
+    }
+    if (!failed)
+        throw new Error("Failing job did not fail");
+
+    stats = pool.stats();
+    let completed = 0, nbFailed = 0;
+    for (const s of stats) {
+        if (s.queued || s.running)
+            throw new Error("Jobs left over: " + JSON.stringify(stats));
+        completed += s.completed;
+        nbFailed += s.failed;
+    }
+    if (completed !== 10 || nbFailed !== 1)
+        throw new Error("Wrong job counts: " + JSON.stringify(stats));
+
+    await Promise.all(pool.instances.map(function(libav) {
+        return libav.unlink("tmp.webm");
+    }));
+
+} finally {
+    pool.terminate();
+}
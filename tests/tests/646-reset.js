@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+// Resetting an instance
+
+const libav = await h.LibAV(Object.assign({}, h.libAVOpts || {}));
+const startUsed = await libav.mallinfo_uordblks();
+
+// Probe the file, returning the number of streams
+async function probe() {
+    const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+    await libav.avformat_close_input_js(fmt_ctx);
+    return streams.length;
+}
+const nbStreams = await probe();
+
+// Leave a mess: open contexts, loose frames and packets, and devices
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+const stream = streams.find(x => x.codec_type === libav.AVMEDIA_TYPE_AUDIO);
+const [, c, pkt, frame] = await libav.ff_init_decoder(
+    stream.codec_id, stream.codecpar);
+const [, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt,
+    {limit: 65536, copyoutPacket: "ptr"});
+for (let i = 0; i < 16; i++)
+    await libav.av_frame_alloc();
+await libav.mkreaderdev("reader");
+await libav.ff_reader_dev_send("reader", new Uint8Array(1024));
+await libav.mkwriterdev("writer");
+await libav.writeFile("keep.txt", new Uint8Array([1, 2, 3]));
+
+if (await libav.mallinfo_uordblks() <= startUsed)
+    throw new Error("Nothing was allocated");
+
+await libav.ff_reset();
+
+const used = await libav.mallinfo_uordblks();
+if (used !== startUsed)
+    throw new Error(`After reset, ${used} bytes in use, expected ${startUsed}`);
+
+// Devices are gone, but ordinary files are kept
+for (const name of ["reader", "writer", "bbb.webm"]) {
+    let exists = true;
+    try {
+        await libav.unlink(name);
+    } catch (ex) {
+        exists = false;
+    }
+    if (exists)
+        throw new Error(`${name} survived the reset`);
+}
+const keep = await libav.readFile("keep.txt");
+if (keep.length !== 3)
+    throw new Error("Ordinary file lost in the reset");
+await libav.unlink("keep.txt");
+
+// And the instance still works
+for (const f of h.files)
+    await libav.mkreadaheadfile(f.name, f.content);
+if (await probe() !== nbStreams)
+    throw new Error("Instance broken after reset");
+
+// Reset again, now that nothing is left
+await libav.ff_reset();
+if (await libav.mallinfo_uordblks() !== startUsed)
+    throw new Error("Second reset leaked");
+
+libav.terminate();
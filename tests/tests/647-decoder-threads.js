@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+// Decoder threading options
+
+const libav = await h.LibAV();
+
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+const stream = streams.find(x => x.codec_type === libav.AVMEDIA_TYPE_VIDEO);
+if (!stream)
+    throw new Error("Couldn't find video stream");
+const pkt = await libav.av_packet_alloc();
+const [, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt,
+    {limit: 256 * 1024});
+await libav.av_packet_free_js(pkt);
+await libav.avformat_close_input_js(fmt_ctx);
+const videoPackets = packets[stream.index];
+
+// Decode with these options, returning the frames and the context's threading
+async function decode(options) {
+    const [, c, pkt, frame] = await libav.ff_init_decoder(stream.codec_id, {
+        codecpar: stream.codecpar,
+        options
+    });
+    const threads = {
+        count: await libav.AVCodecContext_thread_count(c),
+        type: await libav.AVCodecContext_thread_type(c)
+    };
+    const frames = await libav.ff_decode_multi(c, pkt, frame, videoPackets,
+        true);
+    await libav.ff_free_decoder(c, pkt, frame);
+    return {frames, threads};
+}
+
+// By default, only the threaded build uses more than one thread
+const auto = await decode();
+if (auto.threads.count < 1 ||
+    (libav.libavjsMode !== "threads" && auto.threads.count !== 1)) {
+    throw new Error(`Default decoder threads: ${auto.threads.count}`);
+}
+
+// Options are applied
+const slice = await decode({threads: "2", thread_type: "slice"});
+if (slice.threads.count !== 2 || slice.threads.type !== 2 /* SLICE */) {
+    throw new Error("Decoder threading options not applied: " +
+        JSON.stringify(slice.threads));
+}
+
+// And threading doesn't change the output
+if (!auto.frames.length || slice.frames.length !== auto.frames.length) {
+    throw new Error(`Decoded ${slice.frames.length} frames with slice ` +
+        `threads, ${auto.frames.length} by default`);
+}
+for (let fi = 0; fi < auto.frames.length; fi++) {
+    const a = auto.frames[fi].data, b = slice.frames[fi].data;
+    if (a.length !== b.length)
+        throw new Error(`Frame ${fi} differs with slice threads`);
+    for (let i = 0; i < a.length; i++) {
+        if (a[i] !== b[i])
+            throw new Error(`Frame ${fi} differs with slice threads`);
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Segmented transcoding on a pool
+
+if (!h.options.includeSlow)
+    return;
+
+const libav = await h.LibAV();
+const buf = await h.readCachedFile("bbb.webm");
+
+// The timestamps of the video packets of a file, in presentation order
+async function videoTimestamps(file) {
+    const [fmt_ctx, streams] = await libav.ff_init_demuxer_file(file);
+    const stream = streams.find(
+        x => x.codec_type === libav.AVMEDIA_TYPE_VIDEO);
+    const pkt = await libav.av_packet_alloc();
+    const [res, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt);
+    await libav.av_packet_free_js(pkt);
+    await libav.avformat_close_input_js(fmt_ctx);
+    if (res !== libav.AVERROR_EOF)
+        throw new Error("Error reading: " + res);
+    const ps = packets[stream.index];
+    for (let i = 1; i < ps.length; i++) {
+        if (libav.i64tof64(ps[i].dts, ps[i].dtshi) <
+            libav.i64tof64(ps[i - 1].dts, ps[i - 1].dtshi))
+            throw new Error(`Decoding timestamps of ${file} go backwards`);
+    }
+    return ps.map(x => libav.i64tof64(x.pts, x.ptshi)).sort((a, b) => a - b);
+}
+
+// Count the keyframes, to know how many segments there can be
+const [fmt_ctx, streams] = await libav.ff_init_demuxer_file("bbb.webm");
+const stream = streams.find(x => x.codec_type === libav.AVMEDIA_TYPE_VIDEO);
+const pkt = await libav.av_packet_alloc();
+const index = await libav.ff_seek_index_alloc();
+await libav.ff_seek_index_scan(index, fmt_ctx, pkt);
+const keyframes = await libav.ff_seek_index_entries(index, stream.index);
+if (!keyframes.length)
+    throw new Error("No keyframes indexed");
+for (let i = 1; i < keyframes.length; i++) {
+    if (keyframes[i].ts <= keyframes[i - 1].ts)
+        throw new Error("Seek index entries out of order");
+}
+await libav.ff_seek_index_free(index);
+await libav.av_packet_free_js(pkt);
+await libav.avformat_close_input_js(fmt_ctx);
+
+const pool = await LibAV.pool(
+    Object.assign({}, h.libAVOpts || {}, {size: 2}));
+let output;
+try {
+    await Promise.all(pool.instances.map(function(libav) {
+        return libav.writeFile("tmp-in.webm", buf);
+    }));
+
+    output = await pool.transcode({
+        input: "tmp-in.webm",
+        output: "tmp.webm",
+        segments: 4,
+        codec: "libvpx",
+        ctx: {bit_rate: 10000000},
+        options: {deadline: "realtime", "cpu-used": "8"}
+    });
+
+    // With more than one segment, both instances should have transcoded
+    const stats = pool.stats();
+    if (keyframes.length > 1 && stats.some(s => !s.completed)) {
+        throw new Error(
+            "Segments not spread across instances: " + JSON.stringify(stats));
+    }
+    if (stats.some(s => s.failed))
+        throw new Error("Jobs failed: " + JSON.stringify(stats));
+
+} finally {
+    pool.terminate();
+}
+
+await libav.writeFile("tmp.webm", output);
+
+// Every frame should be there, exactly once, with its original timestamp
+const inTs = await videoTimestamps("bbb.webm");
+const outTs = await videoTimestamps("tmp.webm");
+if (inTs.length !== outTs.length) {
+    throw new Error(
+        `Transcoded ${outTs.length} frames, expected ${inTs.length}`);
+}
+for (let i = 0; i < inTs.length; i++) {
+    if (inTs[i] !== outTs[i])
+        throw new Error(`Frame ${i} has timestamp ${outTs[i]}, expected ${inTs[i]}`);
+}
+
+await h.utils.compareVideo("bbb.webm", "tmp.webm");
+await libav.unlink("tmp.webm");
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/* The ring transport's consumer going to sleep while the producer writes: a
+ * write just after the consumer has checked that its ring is empty must still
+ * wake it */
+
+const libav = await h.LibAV();
+if (typeof libav.libavjsRingChannel !== "function" ||
+    typeof Atomics.waitAsync !== "function") {
+    // Only available where the instance is on this thread
+    return;
+}
+
+const size = 4096;
+const sab = new SharedArrayBuffer(2 * (16 + size));
+const received = [];
+let sent = 0;
+let producer = null;
+const consumer = libav.libavjsRingChannel(
+    sab, size, 1, msg => producer.posted(msg), msg => received.push(msg));
+producer = libav.libavjsRingChannel(
+    sab, size, 0, msg => consumer.posted(msg), () => {});
+
+// Wait for this many messages to be received
+async function waitFor(count) {
+    const start = Date.now();
+    while (received.length < count) {
+        if (Date.now() - start > 2000) {
+            throw new Error(
+                `Received ${received.length} of ${count} messages`);
+        }
+        await new Promise(res => setTimeout(res, 1));
+    }
+}
+
+/* The consumer's ring is at the start of sab. When the consumer loads its
+ * write position while going to sleep, write another message right after. */
+const origLoad = Atomics.load;
+let inject = 0;
+Atomics.load = function(arr, idx) {
+    const ret = origLoad(arr, idx);
+    if (inject && arr.buffer === sab && arr.byteOffset === 0 &&
+        idx === 0 /* RING_WRITE */ &&
+        origLoad(arr, 2 /* RING_SLEEP */) !== 0 /* RING_AWAKE */) {
+        inject--;
+        producer.send({n: sent++});
+    }
+    return ret;
+};
+
+try {
+    for (let i = 0; i < 16; i++) {
+        // This message and the injected one
+        const count = sent + 2;
+        inject = 1;
+        producer.send({n: sent++});
+        await waitFor(count);
+        // And with the consumer already asleep
+        await new Promise(res => setTimeout(res, 1));
+    }
+} finally {
+    Atomics.load = origLoad;
+}
+
+for (let i = 0; i < received.length; i++) {
+    if (received[i].n !== i)
+        throw new Error(`Message ${i} received as ${received[i].n}`);
+}
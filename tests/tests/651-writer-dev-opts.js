@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+// Writer devices' options, and writes with only onwritemulti set
+
+const libav = await h.LibAV();
+
+const oldOnWrite = libav.onwrite;
+const oldOnWriteMulti = libav.onwritemulti;
+delete libav.onwrite;
+
+let output, calls;
+libav.onwritemulti = function(name, writes) {
+    calls++;
+    for (const [pos, buf] of writes) {
+        if (output.length < pos + buf.length) {
+            const newOutput = new Uint8Array(pos + buf.length);
+            newOutput.set(output);
+            output = newOutput;
+        }
+        output.set(buf, pos);
+    }
+};
+
+// Two devices with the same name in different directories
+await libav.mkwriterdev("/tmp/tmp.webm", 0, {bufferSize: 1024 * 1024, flushTime: 0});
+await libav.mkwriterdev("/tmp.webm");
+
+async function write(filename) {
+    output = new Uint8Array(0);
+    calls = 0;
+    await libav.ffmpeg(
+        "-nostdin", "-loglevel", "quiet",
+        "-i", "bbb.webm",
+        "-map", "0:a", "-c", "copy", "-t", "2",
+        "-fflags", "+bitexact", "-f", "webm", "-y", filename
+    );
+    return {output, calls};
+}
+
+// Unbuffered, so every write goes through onwritemulti
+const unbuffered = await write("/tmp.webm");
+if (unbuffered.calls < 2)
+    throw new Error(`Unbuffered writer made only ${unbuffered.calls} calls`);
+
+// The other device keeps its own options
+const buffered = await write("/tmp/tmp.webm");
+if (buffered.calls >= unbuffered.calls) {
+    throw new Error(
+        `Buffered writer made ${buffered.calls} onwritemulti calls, ` +
+        `unbuffered ${unbuffered.calls}`);
+}
+if (buffered.output.length !== unbuffered.output.length ||
+    buffered.output.some((x, i) => x !== unbuffered.output[i]))
+    throw new Error("Buffered writer wrote different data");
+
+await libav.unlink("/tmp/tmp.webm");
+await libav.unlink("/tmp.webm");
+
+if (oldOnWrite)
+    libav.onwrite = oldOnWrite;
+if (oldOnWriteMulti)
+    libav.onwritemulti = oldOnWriteMulti;
+else
+    delete libav.onwritemulti;
@@ -18,10 +18,12 @@ const fs = require("fs/promises");
 
 const s = JSON.stringify;
 
+/* Use: mk-exports.js <variant> [async]
+ * Gives the exported functions of the variant, or with "async", only the names
+ * of those that may suspend, for JSPI_EXPORTS. */
 async function main() {
     const variant = process.argv[2];
-    const version = process.argv[3];
-    const jsSuffix = process.argv[4];
+    const asyncOnly = (process.argv[3] === "async");
 
     const funcs = JSON.parse(await fs.readFile("funcs.json", "utf8"));
     const exports = ["_emfiberthreads_timeout_expiry"];
@@ -29,6 +31,18 @@ async function main() {
         await fs.readFile(`configs/configs/${variant}/components.txt`, "utf8")
     ).trim().split("\n");
 
+    if (asyncOnly) {
+        const asyncExports = [];
+        for (const component of components) {
+            for (const decl of funcs[component].functions) {
+                if (decl[3] && decl[3].async)
+                    asyncExports.push(decl[0]);
+            }
+        }
+        process.stdout.write(JSON.stringify(asyncExports));
+        return;
+    }
+
     for (const component of components) {
         const fc = funcs[component];
 
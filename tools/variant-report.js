@@ -0,0 +1,228 @@
+#!/usr/bin/env node
+/*
+ * Copyright (C) 2025 Yahweasel and contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Report the size and speed of built variants, as CSV. For each variant and
+ * each of the wasm, simd, and jspi targets, gives the size of the .wasm file,
+ * and how many times faster than realtime it decodes the audio and video of
+ * tests/files/bbb_input.webm, and re-encodes them (with libopus and libvpx),
+ * where the variant supports it. Blank if not. The jspi target is only
+ * reported if JSPI is enabled (node --experimental-wasm-jspi). Use:
+ *   tools/variant-report.js <variant>...
+ * tools/variant-report.sh builds the variants and writes the report to docs/.
+ */
+
+const fs = require("fs");
+const path = require("path");
+
+const root = path.join(__dirname, "..");
+const sample = path.join(root, "tests", "files", "bbb_input.webm");
+
+// How many video frames to encode; video encoding is slow
+const videoEncodeFrames = 120;
+
+function loadLibAV(variant) {
+    LibAV = {base: path.join(root, "dist")};
+    require(path.join(root, "dist", `libav-${variant}.js`));
+    return LibAV;
+}
+
+// Try each of these decoders in turn
+async function initDecoder(libav, stream, names) {
+    for (const name of [stream.codec_id].concat(names)) {
+        try {
+            return await libav.ff_init_decoder(name, {
+                codecpar: stream.codecpar,
+                time_base: [stream.time_base_num, stream.time_base_den]
+            });
+        } catch (ex) {}
+    }
+    return null;
+}
+
+// Decode a stream, giving the time taken and the frames
+async function decode(libav, stream, packets, names) {
+    const dec = await initDecoder(libav, stream, names);
+    if (!dec)
+        return null;
+    const [, c, pkt, frame] = dec;
+    if (stream.codec_type === libav.AVMEDIA_TYPE_AUDIO)
+        await libav.AVCodecContext_sample_fmt_s(c, libav.AV_SAMPLE_FMT_FLT);
+
+    const start = performance.now();
+    const frames = await libav.ff_decode_multi(c, pkt, frame, packets, {
+        fin: true,
+        copyoutFrame: "ptr"
+    });
+    const time = (performance.now() - start) / 1000;
+
+    await libav.ff_free_decoder(c, pkt, frame);
+    return {time, frames};
+}
+
+// Encode frames, giving the time taken
+async function encode(libav, codec, ctx, frames) {
+    let enc;
+    try {
+        enc = await libav.ff_init_encoder(codec, {ctx, time_base: [1, 1000]});
+    } catch (ex) {
+        return null;
+    }
+    const [, c, frame, pkt, frameSize] = enc;
+
+    let inFrames = frames;
+    if (frameSize) {
+        // Reframe the audio to the encoder's frame size (outside the timing)
+        const graph = await libav.ff_init_filter_graph("anull", {
+            sample_rate: 48000,
+            sample_fmt: libav.AV_SAMPLE_FMT_FLT,
+            channel_layout: 3
+        }, {
+            sample_rate: 48000,
+            sample_fmt: libav.AV_SAMPLE_FMT_FLT,
+            channel_layout: 3,
+            frame_size: frameSize
+        });
+        inFrames = await libav.ff_filter_multi(
+            graph[1], graph[2], frame, frames, {
+                fin: true,
+                copyoutFrame: "ptr"
+            }
+        );
+        await libav.avfilter_graph_free_js(graph[0]);
+    }
+
+    const start = performance.now();
+    await libav.ff_encode_multi(c, frame, pkt, inFrames, {
+        fin: true,
+        copyoutPacket: "ptr"
+    }).then(ps => Promise.all(ps.map(p => libav.av_packet_free_js(p))));
+    const time = (performance.now() - start) / 1000;
+
+    if (inFrames !== frames) {
+        for (const f of inFrames)
+            await libav.av_frame_free_js(f);
+    }
+    await libav.ff_free_encoder(c, frame, pkt);
+    return time;
+}
+
+async function report(variant, target) {
+    const wasmFile = path.join(root, "dist",
+        `libav-${LibAV.VER}-${variant}.${target}.wasm`);
+    if (!fs.existsSync(wasmFile))
+        return null;
+    const row = {
+        variant, target,
+        size: Math.round(fs.statSync(wasmFile).size / 1024)
+    };
+
+    const opts = {
+        nosimd: target === "wasm",
+        yesjspi: target === "jspi",
+        noworker: true
+    };
+    if (LibAV.target(opts) !== target)
+        return null;
+    const libav = await LibAV.LibAV(opts);
+    await libav.writeFile("sample.webm", fs.readFileSync(sample));
+
+    let fmt_ctx, streams;
+    try {
+        [fmt_ctx, streams] = await libav.ff_init_demuxer_file("sample.webm");
+    } catch (ex) {
+        // Can't even demux it
+        libav.terminate();
+        return row;
+    }
+    const pkt = await libav.av_packet_alloc();
+    const [, packets] = await libav.ff_read_frame_multi(fmt_ctx, pkt);
+    await libav.av_packet_free_js(pkt);
+    await libav.avformat_close_input_js(fmt_ctx);
+
+    for (const stream of streams) {
+        const audio = stream.codec_type === libav.AVMEDIA_TYPE_AUDIO;
+        const pfx = audio ? "audio" : "video";
+        const dec = await decode(libav, stream, packets[stream.index] || [],
+            audio ? ["libopus"] : ["libvpx"]);
+        if (!dec)
+            continue;
+        row[`${pfx}_decode`] = stream.duration / dec.time;
+
+        // Re-encode
+        let frames = dec.frames;
+        let duration = stream.duration;
+        if (!audio && frames.length > videoEncodeFrames) {
+            for (const f of frames.slice(videoEncodeFrames))
+                await libav.av_frame_free_js(f);
+            frames = frames.slice(0, videoEncodeFrames);
+            duration = stream.duration * videoEncodeFrames / dec.frames.length;
+        }
+        let time;
+        if (audio) {
+            time = await encode(libav, "libopus", {
+                bit_rate: 128000,
+                sample_fmt: libav.AV_SAMPLE_FMT_FLT,
+                sample_rate: 48000,
+                channel_layout: 3
+            }, frames);
+        } else {
+            const width = await libav.AVFrame_width(frames[0]);
+            const height = await libav.AVFrame_height(frames[0]);
+            time = await encode(libav, "libvpx", {
+                bit_rate: 2000000,
+                pix_fmt: libav.AV_PIX_FMT_YUV420P,
+                width, height
+            }, frames);
+        }
+        if (time)
+            row[`${pfx}_encode`] = duration / time;
+        for (const f of frames)
+            await libav.av_frame_free_js(f);
+    }
+
+    libav.terminate();
+    return row;
+}
+
+async function main() {
+    const variants = process.argv.slice(2);
+    if (!variants.length) {
+        console.error("Use: variant-report.js <variant>...");
+        process.exit(1);
+    }
+
+    const cols = ["audio_decode", "audio_encode", "video_decode", "video_encode"];
+    console.log("Variant,Target,Size (KiB)," +
+        "Audio decode (x realtime),Audio encode (x realtime)," +
+        "Video decode (x realtime),Video encode (x realtime)");
+    for (const variant of variants) {
+        loadLibAV(variant);
+        for (const target of ["wasm", "simd", "jspi"]) {
+            const row = await report(variant, target);
+            if (!row)
+                continue;
+            console.log([row.variant, row.target, row.size].concat(
+                cols.map(c => row[c] ? row[c].toFixed(1) : "")
+            ).join(","));
+        }
+    }
+}
+
+main().catch(ex => {
+    console.error(ex);
+    process.exit(1);
+});
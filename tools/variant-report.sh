@@ -0,0 +1,58 @@
+#!/bin/sh
+# Copyright (C) 2025 Yahweasel and contributors
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+# WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+# OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+# CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+# Build variants (by default, the release variants) with the optimization
+# profile in $PROFILE (size or speed) and $LTO, and report their sizes and
+# speeds in docs/variant-report-<profile>.csv. Profiles share build
+# directories, so this cleans first.
+# Use: PROFILE=speed LTO=1 tools/variant-report.sh [variant...]
+
+set -ex
+cd "$(dirname "$0")/.."
+PROFILE="${PROFILE:-size}"
+LTO="${LTO:-}"
+VERSION="$(make print-version)"
+variants="$*"
+if [ -z "$variants" ]
+then
+    variants="$(make -s print-release-variants)"
+fi
+
+make clean
+make extract
+
+targets=
+for i in $variants
+do
+    targets="$targets dist/libav-$i.js"
+    targets="$targets dist/libav-$VERSION-$i.wasm.js"
+    targets="$targets dist/libav-$VERSION-$i.simd.js"
+    targets="$targets dist/libav-$VERSION-$i.jspi.js"
+done
+make PROFILE="$PROFILE" LTO="$LTO" $targets -j9 -k
+
+# Report the jspi target if this version of Node can enable JSPI
+jspiflag=
+if node --experimental-wasm-jspi -e 0 > /dev/null 2>&1
+then
+    jspiflag=--experimental-wasm-jspi
+fi
+
+name="$PROFILE"
+test -z "$LTO" || name="$name-lto"
+(
+    printf 'Version:,%s,Profile:,%s,OPTFLAGS:,%s\n' \
+        "$VERSION" "$name" "$(make -s PROFILE="$PROFILE" LTO="$LTO" print-optflags)"
+    node $jspiflag ./tools/variant-report.js $variants
+) > docs/variant-report-$name.csv